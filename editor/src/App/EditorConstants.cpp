@@ -5,6 +5,7 @@ namespace kokko
 namespace editor
 {
 const char* const EditorConstants::EditorResourcePath = "editor/res";
+const char* const EditorConstants::TextureCachePath = "cache/textures";
 const char* const EditorConstants::VirtualMountEditor = "editor";
 const char* const EditorConstants::UserSettingsFilePath = "editor_user_settings.yml";
 const char* const EditorConstants::AssetDirectoryName = "Assets";
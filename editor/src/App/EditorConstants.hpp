@@ -13,6 +13,9 @@ public:
 	// Asset Library
 	static const char* const EditorResourcePath;
 
+	// Cooked texture cache, relative to the working directory
+	static const char* const TextureCachePath;
+
 	// Virtual filesystem
 
 	static const char* const VirtualMountEditor;
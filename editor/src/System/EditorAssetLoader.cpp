@@ -1,15 +1,24 @@
 #include "EditorAssetLoader.hpp"
 
+#include <cstdio>
+#include <filesystem>
+
+#include "Core/Hash.hpp"
+
 #include "Resources/AssetLibrary.hpp"
+#include "Resources/TextureCooker.hpp"
 
 #include "System/Filesystem.hpp"
 
+#include "App/EditorConstants.hpp"
+
 namespace kokko
 {
 namespace editor
 {
 
 EditorAssetLoader::EditorAssetLoader(Allocator* allocator, Filesystem* filesystem, AssetLibrary* assetLibrary) :
+	allocator(allocator),
 	filesystem(filesystem),
 	assetLibrary(assetLibrary),
 	pathString(allocator)
@@ -30,6 +39,14 @@ AssetLoader::LoadResult EditorAssetLoader::LoadAsset(const Uid& uid, Array<uint8
 
 			output.Resize(result.assetStart);
 			memcpy(output.GetData(), metadata, result.metadataSize);
+
+			if (metadata->compression != TextureCompression::None &&
+				LoadCookedTexture(*asset, *metadata, output))
+			{
+				result.success = true;
+				result.assetSize = output.GetCount() - result.assetStart;
+				return result;
+			}
 		}
 
 		const String& pathStr = asset->GetVirtualPath();
@@ -44,6 +61,58 @@ AssetLoader::LoadResult EditorAssetLoader::LoadAsset(const Uid& uid, Array<uint8
 	return LoadResult();
 }
 
+bool EditorAssetLoader::LoadCookedTexture(
+	const AssetInfo& asset, const TextureAssetMetadata& metadata, Array<uint8_t>& output)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	// Cache file name is keyed by the UID, source content and import settings,
+	// so changing either the file or the settings results in a new cook
+	uint64_t cacheKey = HashValue64(&metadata, sizeof(metadata), asset.GetContentHash());
+
+	char uidStr[Uid::StringLength + 1];
+	asset.GetUid().WriteTo(uidStr);
+	uidStr[Uid::StringLength] = '\0';
+
+	char cacheFileName[Uid::StringLength + 32];
+	snprintf(cacheFileName, sizeof(cacheFileName), "%s_%016llx.ktex", uidStr,
+		static_cast<unsigned long long>(cacheKey));
+
+	std::filesystem::path cacheDir(EditorConstants::TextureCachePath);
+	std::string cachePath = (cacheDir / cacheFileName).string();
+
+	size_t assetStart = output.GetCount();
+
+	if (filesystem->ReadBinary(cachePath.c_str(), output))
+	{
+		auto cachedView = output.GetSubView(assetStart, output.GetCount());
+		CookedTextureHeader header;
+		if (TextureCooker::ParseCookedTextureHeader(cachedView, header))
+			return true;
+
+		KK_LOG_WARN("Invalid cooked texture cache file {}, cooking again", cachePath.c_str());
+		output.Resize(assetStart);
+	}
+
+	Array<uint8_t> sourceBytes(allocator);
+	if (filesystem->ReadBinary(asset.GetVirtualPath().GetCStr(), sourceBytes) == false)
+		return false;
+
+	Array<uint8_t> cookedBytes(allocator);
+	if (TextureCooker::CookTexture(allocator, sourceBytes.GetView(), metadata, cookedBytes) == false)
+		return false;
+
+	std::error_code error;
+	std::filesystem::create_directories(cacheDir, error);
+
+	if (error || filesystem->Write(cachePath.c_str(), cookedBytes.GetView(), false) == false)
+		KK_LOG_WARN("Couldn't write cooked texture cache file {}", cachePath.c_str());
+
+	output.InsertBack(cookedBytes.GetData(), cookedBytes.GetCount());
+
+	return true;
+}
+
 Optional<Uid> EditorAssetLoader::GetAssetUidByVirtualPath(const ConstStringView& path)
 {
 	pathString.Assign(path);
@@ -8,9 +8,12 @@ namespace kokko
 {
 
 class Allocator;
+class AssetInfo;
 class AssetLibrary;
 class Filesystem;
 
+struct TextureAssetMetadata;
+
 namespace editor
 {
 
@@ -26,6 +29,9 @@ public:
 	virtual bool GetNextUpdatedAssetUid(AssetType typeFilter, Uid& uid) override;
 
 private:
+	bool LoadCookedTexture(const AssetInfo& asset, const TextureAssetMetadata& metadata, Array<uint8_t>& output);
+
+	Allocator* allocator;
 	Filesystem* filesystem;
 	AssetLibrary* assetLibrary;
 
@@ -140,9 +140,6 @@ void AssetView::DrawMaterial(EditorContext& context, const AssetInfo* asset)
 		}
 	}
 
-	if (edited)
-		materialManager->UpdateUniformsToGPU(materialId);
-	
 	if (ImGui::CollapsingHeader("Textures", ImGuiTreeNodeFlags_DefaultOpen))
 	{
 		for (auto& texture : uniforms.GetTextureUniforms())
@@ -174,6 +171,9 @@ void AssetView::DrawMaterial(EditorContext& context, const AssetInfo* asset)
 
 	if (edited)
 	{
+		// Uniform buffer can also contain texture handles, so update after texture changes too
+		materialManager->MarkUniformsDirty(materialId);
+
 		// Serialize
 		MaterialSerializer serializer(allocator, materialManager, shaderManager, textureManager);
 
@@ -325,7 +325,7 @@ bool AssetView::DrawMaterialShaderDropTarget(EditorContext& context, kokko::Mate
 			auto asset = context.assetLibrary->FindAssetByUid(assetUid);
 			if (asset != nullptr && asset->GetType() == AssetType::Shader)
 			{
-				ShaderId shaderId = shaderManager->FindShaderByUid(assetUid);
+				ShaderId shaderId = shaderManager->WaitForShader(shaderManager->FindShaderByUid(assetUid));
 				if (shaderId != ShaderId::Null)
 				{
 					materialManager->SetMaterialShader(materialId, shaderId);
@@ -412,6 +412,24 @@ void AssetView::DrawTexture(EditorContext& context, const AssetInfo* asset)
 	changed |= ImGui::Checkbox("Generate mipmaps", &metadata.generateMipmaps);
 	changed |= ImGui::Checkbox("Prefer linear color", &metadata.preferLinear);
 
+	static const char* const compressionNames[] = { "None", "BC1", "BC3", "BC4", "BC5", "BC7" };
+	size_t compressionIndex = static_cast<size_t>(metadata.compression);
+
+	if (ImGui::BeginCombo("Compression", compressionNames[compressionIndex]))
+	{
+		for (size_t i = 0; i < KOKKO_ARRAY_ITEMS(compressionNames); ++i)
+		{
+			bool isSelected = (compressionIndex == i);
+			if (ImGui::Selectable(compressionNames[i], &isSelected))
+			{
+				metadata.compression = static_cast<TextureCompression>(i);
+				changed = true;
+			}
+		}
+
+		ImGui::EndCombo();
+	}
+
 	if (changed)
 	{
 		context.assetLibrary->UpdateTextureMetadata(asset->GetUid(), metadata);
@@ -44,6 +44,10 @@ void DebugView::Update(EditorContext& context)
 
 			ImGui::Checkbox("Vertical sync", &engineSettings->verticalSync);
 
+			kokko::ModelLoadOptions& modelOptions = engineSettings->modelLoadOptions;
+			ImGui::Checkbox("Reorder model geometry on load", &modelOptions.reorderGeometry);
+			ImGui::Checkbox("Compact vertex format on load", &modelOptions.compactVertexFormat);
+
 			kokko::RenderDebugSettings& features = engineSettings->renderDebug;
 
 			bool drawBounds = features.IsFeatureEnabled(kokko::RenderDebugFeatureFlag::DrawBounds);
@@ -54,6 +58,37 @@ void DebugView::Update(EditorContext& context)
 			if (ImGui::Checkbox("Draw mesh normals", &drawNormals))
 				features.SetFeatureEnabled(kokko::RenderDebugFeatureFlag::DrawNormals, drawNormals);
 
+			bool occlusionCulling = features.IsFeatureEnabled(kokko::RenderDebugFeatureFlag::OcclusionCulling);
+			if (ImGui::Checkbox("GPU occlusion culling", &occlusionCulling))
+				features.SetFeatureEnabled(kokko::RenderDebugFeatureFlag::OcclusionCulling, occlusionCulling);
+
+			bool softwareOcclusion = features.IsFeatureEnabled(kokko::RenderDebugFeatureFlag::SoftwareOcclusionCulling);
+			if (ImGui::Checkbox("CPU occlusion culling", &softwareOcclusion))
+				features.SetFeatureEnabled(kokko::RenderDebugFeatureFlag::SoftwareOcclusionCulling, softwareOcclusion);
+
+			bool shadowCaching = features.IsFeatureEnabled(kokko::RenderDebugFeatureFlag::ShadowCascadeCaching);
+			if (ImGui::Checkbox("Shadow cascade caching", &shadowCaching))
+				features.SetFeatureEnabled(kokko::RenderDebugFeatureFlag::ShadowCascadeCaching, shadowCaching);
+
+			static const char* const ssaoResolutionNames[] = { "Full", "Half", "Quarter" };
+			size_t ssaoResolutionIndex = static_cast<size_t>(features.GetSsaoResolution());
+
+			if (ImGui::BeginCombo("SSAO resolution", ssaoResolutionNames[ssaoResolutionIndex]))
+			{
+				for (size_t i = 0; i < KOKKO_ARRAY_ITEMS(ssaoResolutionNames); ++i)
+				{
+					bool isSelected = (ssaoResolutionIndex == i);
+					if (ImGui::Selectable(ssaoResolutionNames[i], &isSelected))
+						features.SetSsaoResolution(static_cast<kokko::SsaoResolution>(i));
+				}
+
+				ImGui::EndCombo();
+			}
+
+			bool ssaoTemporal = features.IsFeatureEnabled(kokko::RenderDebugFeatureFlag::SsaoTemporalAccumulation);
+			if (ImGui::Checkbox("SSAO temporal accumulation", &ssaoTemporal))
+				features.SetFeatureEnabled(kokko::RenderDebugFeatureFlag::SsaoTemporalAccumulation, ssaoTemporal);
+
 			if (ImGui::Button("Capture profile"))
 			{
 				debug->RequestBeginProfileSession();
@@ -374,6 +374,10 @@ void EntityView::DrawMeshComponent(EditorContext& context)
 				ImGui::PopID();
 			}
 
+			bool occluder = meshComponentSystem->IsOccluder(meshComponent);
+			if (ImGui::Checkbox("Occluder", &occluder))
+				meshComponentSystem->SetOccluder(meshComponent, occluder);
+
 			if (componentVisible == false)
 				meshComponentSystem->RemoveComponent(meshComponent);
 		}
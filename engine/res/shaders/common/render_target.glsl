@@ -0,0 +1,8 @@
+// Pooled render targets can be larger than the area that was rendered to. Maps texture
+// coordinates over the rendered area to coordinates of the whole texture, clamped to
+// the edge texels of the rendered area.
+vec2 render_target_uv(sampler2D target, vec2 uv, vec2 rendered_size)
+{
+	vec2 texture_size = vec2(textureSize(target, 0));
+	return clamp(uv * rendered_size, vec2(0.5), rendered_size - 0.5) / texture_size;
+}
@@ -3,19 +3,31 @@
 #stage vertex
 #include "engine/shaders/debug/debug_vector_uniform.glsl"
 
-layout(location = 0) in vec3 position;
+layout(location = VERTEX_ATTR_INDEX_POS) in vec3 position;
+layout(location = VERTEX_ATTR_INDEX_COL0) in vec4 color;
+
+out VS_TO_FS
+{
+	vec4 color;
+}
+vs_out;
 
 void main()
 {
+	vs_out.color = color;
 	gl_Position = transform * vec4(position, 1.0);
 }
 
 #stage fragment
-#include "engine/shaders/debug/debug_vector_uniform.glsl"
+in VS_TO_FS
+{
+	vec4 color;
+}
+fs_in;
 
 out vec4 output_color;
 
 void main()
 {
-	output_color = base_color;
+	output_color = fs_in.color;
 }
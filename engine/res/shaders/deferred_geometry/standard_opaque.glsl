@@ -5,6 +5,7 @@
 #property color_tint vec3
 #property metalness float
 #property roughness float
+#bindless_textures
 
 #stage vertex
 #include "engine/shaders/common/constants.glsl"
@@ -39,10 +40,6 @@ in VS_TO_FS {
 	vec2 tex_coord;
 } fs_in;
 
-uniform sampler2D albedo_map;
-uniform sampler2D normal_map;
-uniform sampler2D roughness_map;
-
 // Normal mapping without precomputed tangents:
 // http://www.thetenthplanet.de/archives/1180
 
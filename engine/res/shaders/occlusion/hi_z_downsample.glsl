@@ -0,0 +1,50 @@
+#version 450
+#property source_texture tex2d
+
+#stage compute
+#include "engine/shaders/common/constants.glsl"
+
+#define GROUP_SIZE_HI_Z 8
+
+layout(local_size_x = GROUP_SIZE_HI_Z, local_size_y = GROUP_SIZE_HI_Z) in;
+
+layout(std140, binding = BLOCK_BINDING_OBJECT) uniform HiZDownsampleBlock
+{
+	ivec2 source_size;
+	ivec2 dest_size;
+	int source_level;
+} uniforms;
+
+uniform sampler2D source_texture;
+
+layout(r32f, binding = 0) uniform writeonly image2D dest_image;
+
+void main()
+{
+	ivec2 dest = ivec2(gl_GlobalInvocationID.xy);
+
+	if (dest.x >= uniforms.dest_size.x || dest.y >= uniforms.dest_size.y)
+		return;
+
+	// The last row and column also cover the extra texel of odd sized sources
+	ivec2 odd = uniforms.source_size & 1;
+	ivec2 last = ivec2(equal(dest, uniforms.dest_size - 1));
+	ivec2 footprint = ivec2(2) + odd * last;
+
+	ivec2 source_base = dest * 2;
+	ivec2 source_max = uniforms.source_size - 1;
+
+	// Reverse depth, keep the farthest depth which has the smallest value
+	float depth = 1.0;
+
+	for (int y = 0; y < footprint.y; ++y)
+	{
+		for (int x = 0; x < footprint.x; ++x)
+		{
+			ivec2 source = min(source_base + ivec2(x, y), source_max);
+			depth = min(depth, texelFetch(source_texture, source, uniforms.source_level).r);
+		}
+	}
+
+	imageStore(dest_image, dest, vec4(depth));
+}
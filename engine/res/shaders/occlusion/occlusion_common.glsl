@@ -0,0 +1,46 @@
+
+#define GROUP_SIZE_HI_Z 8
+#define GROUP_SIZE_CULL 64
+
+struct DrawBounds
+{
+	vec3 center;
+	uint object_index;
+	vec3 extents;
+	uint padding;
+};
+
+// Matches the layout of indexed indirect draw parameters
+struct DrawCommand
+{
+	uint count;
+	uint instance_count;
+	uint first_index;
+	int base_vertex;
+	uint base_instance;
+};
+
+layout(std140, binding = BLOCK_BINDING_OBJECT) uniform OcclusionCullBlock
+{
+	mat4x4 view_projection;
+	ivec2 depth_size;
+	int hi_z_level_count;
+	uint draw_count;
+} uniforms;
+
+layout(std430, binding = 0) buffer DrawBoundsBlock
+{
+	DrawBounds draw_bounds[];
+};
+
+// First draw_count commands are for the early pass, the rest for the late pass
+layout(std430, binding = 1) buffer DrawCommandBlock
+{
+	DrawCommand draw_commands[];
+};
+
+// Visibility from the previous frame, indexed by mesh component
+layout(std430, binding = 2) buffer ObjectVisibilityBlock
+{
+	uint object_visibility[];
+};
@@ -0,0 +1,19 @@
+#version 450
+
+#stage compute
+#include "engine/shaders/common/constants.glsl"
+#include "engine/shaders/occlusion/occlusion_common.glsl"
+
+layout(local_size_x = GROUP_SIZE_CULL) in;
+
+void main()
+{
+	uint draw = gl_GlobalInvocationID.x;
+
+	if (draw < uniforms.draw_count)
+	{
+		// Draw everything that was visible last frame, it's likely to still be visible
+		uint object_index = draw_bounds[draw].object_index;
+		draw_commands[draw].instance_count = object_visibility[object_index] != 0 ? 1 : 0;
+	}
+}
@@ -0,0 +1,72 @@
+#version 450
+#property hi_z_texture tex2d
+
+#stage compute
+#include "engine/shaders/common/constants.glsl"
+#include "engine/shaders/occlusion/occlusion_common.glsl"
+
+layout(local_size_x = GROUP_SIZE_CULL) in;
+
+uniform sampler2D hi_z_texture;
+
+bool is_visible(vec3 center, vec3 extents)
+{
+	vec2 ndc_min = vec2(1.0);
+	vec2 ndc_max = vec2(-1.0);
+	float nearest_depth = 0.0;
+
+	for (int i = 0; i < 8; ++i)
+	{
+		vec3 corner_sign = vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+		vec4 clip = uniforms.view_projection * vec4(center + extents * corner_sign, 1.0);
+
+		// Box intersects the near plane, so it can't be occluded
+		if (clip.w <= 0.0)
+			return true;
+
+		vec3 ndc = clip.xyz / clip.w;
+		ndc_min = min(ndc_min, ndc.xy);
+		ndc_max = max(ndc_max, ndc.xy);
+
+		// Reverse depth, larger values are closer to the camera
+		nearest_depth = max(nearest_depth, ndc.z);
+	}
+
+	vec2 pixel_min = clamp(ndc_min * 0.5 + 0.5, 0.0, 1.0) * vec2(uniforms.depth_size);
+	vec2 pixel_max = clamp(ndc_max * 0.5 + 0.5, 0.0, 1.0) * vec2(uniforms.depth_size);
+	vec2 pixel_size = pixel_max - pixel_min;
+
+	// Pick the level where the rectangle covers at most 2x2 texels,
+	// level 0 of the pyramid is already half the size of the depth buffer
+	float size_level = ceil(log2(max(max(pixel_size.x, pixel_size.y), 1.0)));
+	int level = clamp(int(size_level) - 1, 0, uniforms.hi_z_level_count - 1);
+
+	ivec2 level_max = textureSize(hi_z_texture, level) - 1;
+	ivec2 texel_min = min(ivec2(pixel_min) >> (level + 1), level_max);
+	ivec2 texel_max = min(ivec2(pixel_max) >> (level + 1), level_max);
+
+	float depth_00 = texelFetch(hi_z_texture, texel_min, level).r;
+	float depth_10 = texelFetch(hi_z_texture, ivec2(texel_max.x, texel_min.y), level).r;
+	float depth_01 = texelFetch(hi_z_texture, ivec2(texel_min.x, texel_max.y), level).r;
+	float depth_11 = texelFetch(hi_z_texture, texel_max, level).r;
+	float farthest_depth = min(min(depth_00, depth_10), min(depth_01, depth_11));
+
+	return nearest_depth >= farthest_depth;
+}
+
+void main()
+{
+	uint draw = gl_GlobalInvocationID.x;
+
+	if (draw < uniforms.draw_count)
+	{
+		DrawBounds bounds = draw_bounds[draw];
+		bool visible = is_visible(bounds.center, bounds.extents);
+
+		// Objects drawn in the early pass are already in the depth buffer
+		bool drawn_early = draw_commands[draw].instance_count != 0;
+		draw_commands[uniforms.draw_count + draw].instance_count = visible && drawn_early == false ? 1 : 0;
+
+		object_visibility[bounds.object_index] = visible ? 1 : 0;
+	}
+}
@@ -1,11 +1,11 @@
-vec3 sample_box(sampler2D src_tex, vec2 tex_scale, vec2 uv, float delta)
+vec3 sample_box(sampler2D src_tex, vec2 src_size, vec2 uv, float delta)
 {
-	vec4 o = tex_scale.xyxy * vec4(-delta, -delta, delta, delta);
+	vec4 o = vec4(-delta, -delta, delta, delta) / src_size.xyxy;
 	vec3 s =
-		texture(src_tex, uv + o.xy).rgb +
-		texture(src_tex, uv + o.zy).rgb +
-		texture(src_tex, uv + o.xw).rgb +
-		texture(src_tex, uv + o.zw).rgb;
+		texture(src_tex, render_target_uv(src_tex, uv + o.xy, src_size)).rgb +
+		texture(src_tex, render_target_uv(src_tex, uv + o.zy, src_size)).rgb +
+		texture(src_tex, render_target_uv(src_tex, uv + o.xw, src_size)).rgb +
+		texture(src_tex, render_target_uv(src_tex, uv + o.zw, src_size)).rgb;
 
 	return s * 0.25;
 }
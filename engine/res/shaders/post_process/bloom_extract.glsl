@@ -18,6 +18,7 @@ void main()
 
 #stage fragment
 #include "engine/shaders/common/constants.glsl"
+#include "engine/shaders/common/render_target.glsl"
 #include "engine/shaders/post_process/bloom_common.glsl"
 
 in VS_TO_FS
@@ -31,7 +32,7 @@ uniform sampler2D source_map;
 
 layout(std140, binding = BLOCK_BINDING_OBJECT) uniform BloomExtractBlock
 {
-	vec2 texture_scale;
+	vec2 source_size;
 	float threshold;
     float soft_threshold;
 };
@@ -50,5 +51,5 @@ vec3 prefilter(vec3 c)
 
 void main()
 {
-    color = prefilter(sample_box(source_map, texture_scale, fs_in.tex_coord, 1.0));
+    color = prefilter(sample_box(source_map, source_size, fs_in.tex_coord, 1.0));
 }
@@ -18,6 +18,7 @@ void main()
 
 #stage fragment
 #include "engine/shaders/common/constants.glsl"
+#include "engine/shaders/common/render_target.glsl"
 
 in VS_TO_FS
 {
@@ -31,7 +32,7 @@ uniform sampler2D source_map;
 layout(std140, binding = BLOCK_BINDING_OBJECT) uniform BloomUpsampleBlock
 {
     float kernel[25];
-	vec2 texture_scale;
+	vec2 source_size;
     int kernel_extent;
 };
 
@@ -44,8 +45,8 @@ void main()
         for (int x = -kernel_extent; x <= kernel_extent; ++x)
         {
             int index = (y + kernel_extent) * kernel_width + (x + kernel_extent);
-            vec2 coordinates = fs_in.tex_coord + vec2(x, y) * texture_scale;
-            sum += texture(source_map, coordinates).rgb * kernel[index];
+            vec2 coordinates = fs_in.tex_coord + vec2(x, y) / source_size;
+            sum += texture(source_map, render_target_uv(source_map, coordinates, source_size)).rgb * kernel[index];
         }
     }
 
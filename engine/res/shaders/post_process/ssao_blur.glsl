@@ -20,6 +20,7 @@ void main()
 
 #stage fragment
 #include "engine/shaders/common/constants.glsl"
+#include "engine/shaders/common/render_target.glsl"
 
 in VS_TO_FS
 {
@@ -32,7 +33,7 @@ uniform sampler2D occlusion_map;
 
 layout(std140, binding = BLOCK_BINDING_OBJECT) uniform SsaoBlurBlock
 {
-	vec2 texture_scale;
+	vec2 occlusion_size;
 };
 
 void main()
@@ -40,8 +41,13 @@ void main()
 	float acc = 0.0;
 
 	for (int x = -2; x < 2; ++x)
+	{
 		for (int y = -2; y < 2; ++y)
-			acc += texture(occlusion_map, vec2(x, y) * texture_scale + fs_in.tex_coord).r;
+		{
+			vec2 sample_uv = vec2(x, y) / occlusion_size + fs_in.tex_coord;
+			acc += texture(occlusion_map, render_target_uv(occlusion_map, sample_uv, occlusion_size)).r;
+		}
+	}
 
 	color = acc / 16.0;
 }
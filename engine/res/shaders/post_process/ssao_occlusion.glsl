@@ -57,7 +57,7 @@ void main()
 	float occlusion = 0.0;
 	for (int i = 0; i < kernel_size; ++i)
 	{
-		vec3 sample_pos_v = TBN * kernel[i] * sample_radius + surface_pos;
+		vec3 sample_pos_v = TBN * kernel[kernel_offset + i] * sample_radius + surface_pos;
 		vec4 sample_pos_c = perspective_mat * vec4(sample_pos_v, 1.0);
 		vec2 sample_uv = sample_pos_c.xy / sample_pos_c.w * 0.5 + 0.5;
 		
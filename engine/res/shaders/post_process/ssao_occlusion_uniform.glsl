@@ -9,4 +9,5 @@ layout(std140, binding = BLOCK_BINDING_OBJECT) uniform SsaoOcclusionBlock
 	vec2 noise_scale;
 	float sample_radius;
     int kernel_size;
+    int kernel_offset;
 };
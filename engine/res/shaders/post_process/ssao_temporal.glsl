@@ -0,0 +1,70 @@
+#version 450
+#property occlusion_map tex2d
+#property history_map tex2d
+#property g_depth tex2d
+
+#stage vertex
+#include "engine/shaders/common/constants.glsl"
+#include "engine/shaders/post_process/ssao_temporal_uniform.glsl"
+
+layout(location = 0) in vec3 ndc_pos;
+
+out VS_TO_FS
+{
+	vec2 tex_coord;
+	vec3 eye_dir;
+}
+vs_out;
+
+void main()
+{
+	vs_out.tex_coord = ndc_pos.xy * 0.5 + vec2(0.5, 0.5);
+	vs_out.eye_dir = vec3((2.0 * half_near_plane * vs_out.tex_coord) - half_near_plane, -1.0);
+	gl_Position = vec4(ndc_pos, 1.0);
+}
+
+#stage fragment
+#include "engine/shaders/common/constants.glsl"
+#include "engine/shaders/common/g_buffer_io.glsl"
+#include "engine/shaders/common/render_target.glsl"
+#include "engine/shaders/post_process/ssao_temporal_uniform.glsl"
+
+in VS_TO_FS
+{
+	vec2 tex_coord;
+	vec3 eye_dir;
+} fs_in;
+
+// Accumulated occlusion in r, view space depth in g
+out vec2 color;
+
+uniform sampler2D occlusion_map;
+uniform sampler2D history_map;
+uniform sampler2D g_depth;
+
+// Relative depth difference at which history is rejected
+const float depth_tolerance = 0.05;
+
+void main()
+{
+	float occlusion = texture(occlusion_map, render_target_uv(occlusion_map, fs_in.tex_coord, occlusion_size)).r;
+
+	float window_z = texture(g_depth, fs_in.tex_coord).r;
+	vec3 surface_pos = view_pos_from_depth(window_z, perspective_mat, fs_in.eye_dir);
+
+	// w of the previous clip space position is the depth in the previous view
+	vec4 prev_pos_c = reprojection_mat * vec4(surface_pos, 1.0);
+	vec2 prev_uv = prev_pos_c.xy / prev_pos_c.w * 0.5 + 0.5;
+
+	bool inside = all(greaterThanEqual(prev_uv, vec2(0.0))) && all(lessThanEqual(prev_uv, vec2(1.0)));
+
+	if (history_valid != 0 && inside)
+	{
+		vec2 history = texture(history_map, prev_uv).rg;
+
+		if (abs(history.g - prev_pos_c.w) < prev_pos_c.w * depth_tolerance)
+			occlusion = mix(occlusion, history.r, history_weight);
+	}
+
+	color = vec2(occlusion, -surface_pos.z);
+}
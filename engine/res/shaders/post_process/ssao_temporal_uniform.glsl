@@ -0,0 +1,10 @@
+
+layout(std140, binding = BLOCK_BINDING_OBJECT) uniform SsaoTemporalBlock
+{
+	mat4x4 perspective_mat;
+	mat4x4 reprojection_mat;
+	vec2 half_near_plane;
+	float history_weight;
+	int history_valid;
+	vec2 occlusion_size;
+};
@@ -0,0 +1,71 @@
+#version 450
+#property occlusion_map tex2d
+#property g_depth tex2d
+
+#stage vertex
+#include "engine/shaders/common/constants.glsl"
+
+layout(location = 0) in vec3 ndc_pos;
+
+out VS_TO_FS
+{
+	vec2 tex_coord;
+}
+vs_out;
+
+void main()
+{
+	vs_out.tex_coord = ndc_pos.xy * 0.5 + vec2(0.5, 0.5);
+	gl_Position = vec4(ndc_pos, 1.0);
+}
+
+#stage fragment
+#include "engine/shaders/common/constants.glsl"
+#include "engine/shaders/common/g_buffer_io.glsl"
+#include "engine/shaders/common/render_target.glsl"
+
+in VS_TO_FS
+{
+	vec2 tex_coord;
+} fs_in;
+
+out float color;
+
+uniform sampler2D occlusion_map;
+uniform sampler2D g_depth;
+
+layout(std140, binding = BLOCK_BINDING_OBJECT) uniform SsaoUpsampleBlock
+{
+	mat4x4 perspective_mat;
+	vec2 occlusion_size;
+};
+
+// Relative depth difference at which a sample weight falls to 1/e
+const float depth_sharpness = 0.05;
+
+// Blurs the occlusion map and upsamples it to the full resolution. Samples are
+// weighted by their depth difference to the output pixel, so occlusion doesn't
+// bleed over depth discontinuities.
+void main()
+{
+	float center_z = view_z_from_depth(texture(g_depth, fs_in.tex_coord).r, perspective_mat);
+	float depth_scale = 1.0 / max(abs(center_z) * depth_sharpness, 0.0001);
+
+	float acc = 0.0;
+	float weight_sum = 0.0;
+
+	for (int x = -2; x < 2; ++x)
+	{
+		for (int y = -2; y < 2; ++y)
+		{
+			vec2 sample_uv = (vec2(x, y) + 0.5) / occlusion_size + fs_in.tex_coord;
+			float sample_z = view_z_from_depth(texture(g_depth, sample_uv).r, perspective_mat);
+			float weight = exp(-abs(sample_z - center_z) * depth_scale) + 0.0001;
+
+			acc += texture(occlusion_map, render_target_uv(occlusion_map, sample_uv, occlusion_size)).r * weight;
+			weight_sum += weight;
+		}
+	}
+
+	color = acc / weight_sum;
+}
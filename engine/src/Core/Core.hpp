@@ -17,9 +17,11 @@
 #include "Debug/InstrumentationTimer.hpp"
 #define KOKKO_PROFILE_SCOPE(name) ::kokko::InstrumentationTimer KK_UNIQUE_NAME(instrTimer, __LINE__)(name)
 #define KOKKO_PROFILE_FUNCTION() KOKKO_PROFILE_SCOPE(KOKKO_FUNC_SIG)
+#define KOKKO_PROFILE_COUNTER(name, value) ::kokko::InstrumentationTimer::WriteCounter(name, static_cast<double>(value))
 #else
 #define KOKKO_PROFILE_SCOPE(name)
 #define KOKKO_PROFILE_FUNCTION()
+#define KOKKO_PROFILE_COUNTER(name, value)
 #endif
 
 #include "System/Log.hpp"
@@ -1,12 +1,251 @@
 #include "Core/HashMap.hpp"
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
 #include "doctest/doctest.h"
 
+#include "Core/Hash.hpp"
 #include "Core/String.hpp"
 
 namespace kokko
 {
 
+namespace
+{
+
+// The linear probing map that HashMap replaced, kept only as a benchmark baseline.
+// Empty slots are marked with a zero key, and the zero key itself is stored separately.
+// Removal shifts later entries back so that probe chains have no gaps.
+class LinearProbingMap
+{
+public:
+	using KeyValuePair = Pair<uint32_t, uint32_t>;
+
+	explicit LinearProbingMap(Allocator* allocator) :
+		allocator(allocator),
+		data(nullptr),
+		population(0),
+		allocated(0),
+		zeroUsed(false),
+		zeroPair{}
+	{
+	}
+
+	~LinearProbingMap()
+	{
+		allocator->Deallocate(data);
+	}
+
+	LinearProbingMap(const LinearProbingMap&) = delete;
+	LinearProbingMap& operator=(const LinearProbingMap&) = delete;
+
+	KeyValuePair* Lookup(uint32_t key)
+	{
+		if (key == 0)
+			return zeroUsed ? &zeroPair : nullptr;
+
+		if (data == nullptr)
+			return nullptr;
+
+		for (size_t i = GetIndex(HashKey(key));; i = GetIndex(i + 1))
+		{
+			KeyValuePair* pair = data + i;
+			if (pair->first == key)
+				return pair;
+			if (pair->first == 0)
+				return nullptr;
+		}
+	}
+
+	KeyValuePair* Insert(uint32_t key)
+	{
+		if (data == nullptr)
+			ReserveInternal(16);
+
+		if (key == 0)
+		{
+			if (zeroUsed == false)
+			{
+				zeroUsed = true;
+				++population;
+				if (population * 4 >= allocated * 3)
+					ReserveInternal(allocated * 2);
+			}
+
+			return &zeroPair;
+		}
+
+		for (;;)
+		{
+			for (size_t i = GetIndex(HashKey(key));; i = GetIndex(i + 1))
+			{
+				KeyValuePair* pair = data + i;
+				if (pair->first == key)
+					return pair;
+
+				if (pair->first == 0)
+				{
+					if ((population + 1) * 4 >= allocated * 3)
+					{
+						ReserveInternal(allocated * 2);
+						break; // Find the slot again in the new table
+					}
+
+					++population;
+					pair->first = key;
+					pair->second = 0;
+					return pair;
+				}
+			}
+		}
+	}
+
+	void Remove(KeyValuePair* pair)
+	{
+		if (pair == &zeroPair)
+		{
+			zeroUsed = false;
+			zeroPair.second = 0;
+			population--;
+			return;
+		}
+
+		for (size_t i = GetIndex(pair - data + 1);; i = GetIndex(i + 1))
+		{
+			KeyValuePair* neighbor = data + i;
+			if (neighbor->first == 0)
+			{
+				pair->first = 0;
+				pair->second = 0;
+				population--;
+				return;
+			}
+
+			KeyValuePair* ideal = data + GetIndex(HashKey(neighbor->first));
+			if (GetOffset(ideal, pair) < GetOffset(ideal, neighbor))
+			{
+				*pair = *neighbor;
+				pair = neighbor;
+			}
+		}
+	}
+
+private:
+	static uint32_t HashKey(uint32_t key) { return kokko::Hash32<uint32_t>()(key, 0u); }
+
+	size_t GetIndex(size_t hash) const { return hash & (allocated - 1); }
+
+	size_t GetOffset(KeyValuePair* a, KeyValuePair* b) const
+	{
+		return b >= a ? b - a : allocated + b - a;
+	}
+
+	void ReserveInternal(size_t desiredCount)
+	{
+		size_t newSize = desiredCount * sizeof(KeyValuePair);
+		KeyValuePair* newData = static_cast<KeyValuePair*>(allocator->Allocate(newSize, KOKKO_FUNC_SIG));
+		std::memset(newData, 0, newSize);
+
+		KeyValuePair* oldData = data;
+		size_t oldCount = allocated;
+		allocated = desiredCount;
+
+		for (size_t oldIndex = 0; oldIndex < oldCount; ++oldIndex)
+		{
+			const KeyValuePair& existing = oldData[oldIndex];
+			if (existing.first == 0)
+				continue;
+
+			for (size_t i = GetIndex(HashKey(existing.first));; i = GetIndex(i + 1))
+			{
+				if (newData[i].first == 0)
+				{
+					newData[i] = existing;
+					break;
+				}
+			}
+		}
+
+		allocator->Deallocate(oldData);
+		data = newData;
+	}
+
+	Allocator* allocator;
+	KeyValuePair* data;
+	size_t population;
+	size_t allocated;
+	bool zeroUsed;
+	KeyValuePair zeroPair;
+};
+
+using BenchmarkMap = HashMap<uint32_t, uint32_t>;
+using BenchmarkStdMap = std::unordered_map<uint32_t, uint32_t>;
+
+void BenchmarkInsert(BenchmarkMap& map, uint32_t key, uint32_t value) { map.Insert(key)->second = value; }
+void BenchmarkInsert(LinearProbingMap& map, uint32_t key, uint32_t value) { map.Insert(key)->second = value; }
+void BenchmarkInsert(BenchmarkStdMap& map, uint32_t key, uint32_t value) { map[key] = value; }
+
+bool BenchmarkLookup(BenchmarkMap& map, uint32_t key) { return map.Lookup(key) != nullptr; }
+bool BenchmarkLookup(LinearProbingMap& map, uint32_t key) { return map.Lookup(key) != nullptr; }
+bool BenchmarkLookup(BenchmarkStdMap& map, uint32_t key) { return map.find(key) != map.end(); }
+
+void BenchmarkErase(BenchmarkMap& map, uint32_t key)
+{
+	if (auto pair = map.Lookup(key))
+		map.Remove(pair);
+}
+
+void BenchmarkErase(LinearProbingMap& map, uint32_t key)
+{
+	if (auto pair = map.Lookup(key))
+		map.Remove(pair);
+}
+
+void BenchmarkErase(BenchmarkStdMap& map, uint32_t key) { map.erase(key); }
+
+// Multiplying by an odd constant is a bijection, so the keys are unique but not sequential
+uint32_t BenchmarkKey(uint32_t index) { return index * 2654435761u; }
+
+template <typename MapType>
+void RunHashMapBenchmark(const char* name, MapType& map, uint32_t count)
+{
+	using Clock = std::chrono::steady_clock;
+
+	auto toNanosPerOp = [count](Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::nano>(duration).count() / count;
+	};
+
+	Clock::time_point start = Clock::now();
+
+	for (uint32_t i = 0; i < count; ++i)
+		BenchmarkInsert(map, BenchmarkKey(i), i);
+
+	Clock::time_point insertEnd = Clock::now();
+
+	// Half of the lookups hit, half miss
+	uint32_t found = 0;
+	for (uint32_t i = 0; i < count; ++i)
+		found += BenchmarkLookup(map, BenchmarkKey(i / 2 + (i % 2) * count)) ? 1 : 0;
+
+	Clock::time_point lookupEnd = Clock::now();
+
+	for (uint32_t i = 0; i < count; ++i)
+		BenchmarkErase(map, BenchmarkKey(i));
+
+	Clock::time_point eraseEnd = Clock::now();
+
+	CHECK(found == count / 2 + count % 2);
+
+	std::printf("%-14s %9u entries: insert %7.1f ns, lookup %7.1f ns, erase %7.1f ns\n", name, count,
+		toNanosPerOp(insertEnd - start), toNanosPerOp(lookupEnd - insertEnd), toNanosPerOp(eraseEnd - lookupEnd));
+}
+
+} // namespace
+
 TEST_CASE("HashMap.LookupAndModify")
 {
 	Allocator* allocator = Allocator::GetDefault();
@@ -198,4 +437,98 @@ TEST_CASE("HashMap.IteratorEmpty")
 	CHECK(count == 0);
 }
 
+TEST_CASE("HashMap.RemoveDuringIteration")
+{
+	Allocator* allocator = Allocator::GetDefault();
+	HashMap<int, int> map(allocator);
+
+	constexpr int count = 1000;
+	for (int i = 0; i < count; ++i)
+		map.Insert(i)->second = i;
+
+	for (auto itr = map.begin(), end = map.end(); itr != end; ++itr)
+	{
+		if (itr->first % 3 == 0)
+			map.Remove(itr);
+	}
+
+	int visited = 0;
+	for (auto& pair : map)
+	{
+		CHECK(pair.first % 3 != 0);
+		visited += 1;
+	}
+
+	CHECK(visited == count - (count + 2) / 3);
+	CHECK(map.GetCount() == static_cast<size_t>(visited));
+
+	for (int i = 0; i < count; ++i)
+		CHECK((map.Lookup(i) != nullptr) == (i % 3 != 0));
+}
+
+TEST_CASE("HashMap.InsertAndRemoveMany")
+{
+	Allocator* allocator = Allocator::GetDefault();
+	HashMap<uint32_t, uint32_t> map(allocator);
+
+	constexpr uint32_t count = 20000;
+	static bool present[count] = {};
+
+	// Churn through keys so the table accumulates tombstones
+	uint32_t random = 12345;
+	for (uint32_t i = 0; i < count * 10; ++i)
+	{
+		random = random * 1664525u + 1013904223u;
+		uint32_t key = (random >> 8) % count;
+
+		if (present[key])
+		{
+			auto pair = map.Lookup(key);
+			REQUIRE(pair != nullptr);
+			CHECK(pair->second == key * 2);
+			map.Remove(pair);
+			present[key] = false;
+		}
+		else
+		{
+			CHECK(map.Lookup(key) == nullptr);
+			map.Insert(key)->second = key * 2;
+			present[key] = true;
+		}
+	}
+
+	size_t presentCount = 0;
+	for (uint32_t key = 0; key < count; ++key)
+	{
+		if (present[key])
+			presentCount += 1;
+
+		CHECK((map.Lookup(key) != nullptr) == present[key]);
+	}
+
+	CHECK(map.GetCount() == presentCount);
+}
+
+// Benchmarks are skipped by default, run with --no-skip --test-case=HashMap.Benchmark*
+TEST_CASE("HashMap.Benchmark" * doctest::skip())
+{
+	for (uint32_t count = 1000; count <= 10000000; count *= 10)
+	{
+		{
+			BenchmarkMap map(Allocator::GetDefault());
+			RunHashMapBenchmark("HashMap", map, count);
+		}
+
+		{
+			LinearProbingMap map(Allocator::GetDefault());
+			RunHashMapBenchmark("linear probing", map, count);
+		}
+
+		{
+			BenchmarkStdMap map;
+			RunHashMapBenchmark("unordered_map", map, count);
+		}
+	}
+}
+
 } // namespace kokko
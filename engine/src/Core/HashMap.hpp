@@ -1,11 +1,23 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KOKKO_HASHMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #include "Core/Core.hpp"
 #include "Core/Hash.hpp"
 #include "Core/Pair.hpp"
-#include "Core/TypeTraits.hpp"
 
 #include "Math/Math.hpp"
 
@@ -14,6 +26,95 @@
 namespace kokko
 {
 
+namespace HashMapDetail
+{
+
+// Control bytes describe the state of each slot. A full slot stores the low
+// 7 bits of the key's hash, so most mismatches are rejected without touching the slot.
+enum : int8_t
+{
+	CtrlEmpty = -128,
+	CtrlDeleted = -2
+};
+
+constexpr size_t GroupWidth = 16;
+
+inline uint32_t CountTrailingZeros(uint32_t mask)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+}
+
+inline uint32_t CountLeadingZeros16(uint32_t mask)
+{
+	uint32_t count = 0;
+	for (uint32_t bit = 1u << (GroupWidth - 1); bit != 0 && (mask & bit) == 0; bit >>= 1)
+		count += 1;
+	return count;
+}
+
+// Matches a group of 16 consecutive control bytes at once.
+// Bit N in the returned masks corresponds to control byte N in the group.
+struct Group
+{
+#ifdef KOKKO_HASHMAP_SSE2
+	__m128i ctrl;
+
+	explicit Group(const int8_t* pos) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+	uint32_t Match(int8_t hash) const
+	{
+		return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(hash), ctrl)));
+	}
+
+	uint32_t MatchEmpty() const
+	{
+		return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(CtrlEmpty), ctrl)));
+	}
+
+	// Empty and deleted are the only control values with the high bit set
+	uint32_t MatchEmptyOrDeleted() const
+	{
+		return static_cast<uint32_t>(_mm_movemask_epi8(ctrl));
+	}
+#else
+	int8_t ctrl[GroupWidth];
+
+	explicit Group(const int8_t* pos) { std::memcpy(ctrl, pos, GroupWidth); }
+
+	uint32_t Match(int8_t hash) const
+	{
+		uint32_t mask = 0;
+		for (uint32_t i = 0; i < GroupWidth; ++i)
+			mask |= static_cast<uint32_t>(ctrl[i] == hash) << i;
+		return mask;
+	}
+
+	uint32_t MatchEmpty() const
+	{
+		return Match(CtrlEmpty);
+	}
+
+	uint32_t MatchEmptyOrDeleted() const
+	{
+		uint32_t mask = 0;
+		for (uint32_t i = 0; i < GroupWidth; ++i)
+			mask |= static_cast<uint32_t>(ctrl[i] < 0) << i;
+		return mask;
+	}
+#endif
+};
+
+} // namespace HashMapDetail
+
+// Open addressing hash map that probes 16 slots at a time using a separate
+// array of control bytes. Removal leaves a tombstone instead of moving other
+// entries, so removing the current entry while iterating is safe.
 template <typename KeyType, typename ValueType>
 class HashMap
 {
@@ -24,12 +125,18 @@ public:
 	{
 	private:
 		KeyValuePair* current;
-		KeyValuePair* zero;
-		KeyValuePair* begin;
 		KeyValuePair* end;
+		const int8_t* ctrl;
+		KeyValuePair* slots;
 
 		friend class HashMap;
 
+		void SkipEmpty()
+		{
+			while (current != end && ctrl[current - slots] < 0)
+				++current;
+		}
+
 	public:
 		KeyValuePair& operator*() { return *current; }
 		KeyValuePair* operator->() { return current; }
@@ -39,23 +146,10 @@ public:
 
 		Iterator& operator++()
 		{
-			if (current == nullptr || current == end)
-			{
-				return *this;
-			}
-			else if (current == zero)
-			{
-				current = begin - 1;
-			}
-
-			while (true)
+			if (current != end)
 			{
 				++current;
-
-				if (current == end || !(current->first == KeyType{}))
-				{
-					break;
-				}
+				SkipEmpty();
 			}
 
 			return *this;
@@ -70,153 +164,246 @@ public:
 	};
 
 private:
+	static constexpr size_t GroupWidth = HashMapDetail::GroupWidth;
+
 	Allocator* allocator;
-	KeyValuePair* data;
+	void* buffer;
+	int8_t* ctrl; // capacity + GroupWidth bytes, the last group mirrors the first one
+	KeyValuePair* slots;
 	size_t population;
-	size_t allocated;
+	size_t capacity;
+	size_t growthLeft; // Empty slots that can be filled before reaching max load factor
 
-	bool zeroUsed;
-	KeyValuePair zeroPair;
+	static uint32_t HashKey(const KeyType& key) { return kokko::Hash32<KeyType>()(key, 0u); }
+	static size_t H1(uint32_t hash) { return hash >> 7; }
+	static int8_t H2(uint32_t hash) { return static_cast<int8_t>(hash & 0x7F); }
 
-	size_t GetIndex(size_t hash) const { return hash & (allocated - 1); }
-	size_t GetOffset(KeyValuePair* a, KeyValuePair* b) const
+	// Max load factor is 7/8
+	static size_t CapacityToGrowth(size_t cap) { return cap - cap / 8; }
+
+	static size_t GetBufferSize(size_t cap)
 	{
-		return b >= a ? b - a : allocated + b - a;
+		return cap + GroupWidth + cap * sizeof(KeyValuePair);
 	}
 
-	void ReserveInternal(size_t desiredCount)
+	bool IsFull(size_t index) const { return ctrl[index] >= 0; }
+
+	void SetCtrl(size_t index, int8_t value)
 	{
-		size_t newSize = desiredCount * sizeof(KeyValuePair);
-		KeyValuePair* newData = static_cast<KeyValuePair*>(allocator->Allocate(newSize, KOKKO_FUNC_SIG));
+		ctrl[index] = value;
 
-		if constexpr (kokko::IsZeroInitializable<KeyType>::Value)
-			std::memset(newData, 0, newSize);
-		else
-			for (size_t i = 0; i < desiredCount; ++i)
-				new (&newData[i].first) KeyType;
+		// Keep the mirrored bytes up-to-date so groups can be loaded past the end
+		if (index < GroupWidth)
+			ctrl[capacity + index] = value;
+	}
+
+	// Probe groups with triangular steps, which visits every group once when
+	// capacity is a power-of-two multiple of the group width. Stops when func returns true.
+	template <typename Func>
+	void Probe(uint32_t hash, Func&& func) const
+	{
+		size_t mask = capacity - 1;
+		size_t offset = H1(hash) & mask;
 
-		if (data != nullptr) // Old data exists
+		for (size_t step = GroupWidth;; step += GroupWidth)
 		{
-			KeyValuePair* existing = data;
-			KeyValuePair* end = existing + allocated;
+			if (func(HashMapDetail::Group(ctrl + offset), offset))
+				return;
 
-			// This needs to be set here because GetIndex() uses it
-			allocated = desiredCount;
+			offset = (offset + step) & mask;
+		}
+	}
+
+	// Returns SIZE_MAX if the key isn't found. If insertIndexOut is given, it
+	// receives the first slot where the key could be inserted.
+	size_t FindIndex(const KeyType& key, uint32_t hash, size_t* insertIndexOut = nullptr) const
+	{
+		int8_t h2 = H2(hash);
+		size_t mask = capacity - 1;
+		size_t result = SIZE_MAX;
 
-			for (; existing != end; ++existing)
+		Probe(hash, [&](const HashMapDetail::Group& group, size_t offset)
+		{
+			for (uint32_t match = group.Match(h2); match != 0; match &= match - 1)
 			{
-				if (!(existing->first == KeyType{})) // Pair has value
+				size_t index = (offset + HashMapDetail::CountTrailingZeros(match)) & mask;
+				if (slots[index].first == key)
 				{
-					for (size_t i = GetIndex(kokko::Hash32<KeyType>()(existing->first, 0u));; i = GetIndex(i + 1))
-					{
-						if (newData[i].first == KeyType{}) // Insert here
-						{
-							newData[i].first = std::move(existing->first);
-							new (&newData[i].second) ValueType(std::move(existing->second));
-
-							if constexpr (std::is_trivially_destructible<KeyType>::value == false)
-								existing->first.~KeyType();
-							if constexpr (std::is_trivially_destructible<ValueType>::value == false)
-								existing->second.~ValueType();
-
-							break;
-						}
-					}
+					result = index;
+					return true;
 				}
 			}
 
-			allocator->Deallocate(data);
-		}
-		else
-			allocated = desiredCount;
+			if (insertIndexOut != nullptr && *insertIndexOut == SIZE_MAX)
+			{
+				uint32_t available = group.MatchEmptyOrDeleted();
+				if (available != 0)
+					*insertIndexOut = (offset + HashMapDetail::CountTrailingZeros(available)) & mask;
+			}
+
+			// Key would have been placed in the first empty slot, so it can't be further
+			return group.MatchEmpty() != 0;
+		});
 
-		data = newData;
+		return result;
 	}
 
-public:
-	explicit HashMap(Allocator* allocator) :
-		allocator(allocator),
-		data(nullptr),
-		population(0),
-		allocated(0),
-		zeroUsed(false),
-		zeroPair{}
+	size_t FindIndex(const KeyType& key) const
 	{
+		if (capacity == 0)
+			return SIZE_MAX;
+
+		return FindIndex(key, HashKey(key));
 	}
 
-	HashMap(const HashMap& other) :
-		allocator(other.allocator),
-		data(nullptr),
-		population(other.population),
-		allocated(other.allocated),
-		zeroUsed(other.zeroUsed),
-		zeroPair(other.zeroPair)
-	{
-		if (other.data != nullptr && other.population > 0)
+	size_t FindInsertIndex(uint32_t hash) const
+	{
+		size_t mask = capacity - 1;
+		size_t result = SIZE_MAX;
+
+		Probe(hash, [&](const HashMapDetail::Group& group, size_t offset)
 		{
-			ReserveInternal(other.allocated);
-			std::memcpy(data, other.data, other.allocated * sizeof(KeyValuePair));
-		}
-	}
+			uint32_t available = group.MatchEmptyOrDeleted();
+			if (available != 0)
+				result = (offset + HashMapDetail::CountTrailingZeros(available)) & mask;
 
-	HashMap(HashMap&& other) noexcept :
-		allocator(other.allocator),
-		data(other.data),
-		population(other.population),
-		allocated(other.allocated),
-		zeroUsed(other.zeroUsed),
-		zeroPair(other.zeroPair)
-	{
-		other.data = nullptr;
-		other.population = 0;
-		other.allocated = 0;
-		other.zeroUsed = false;
-		other.zeroPair = KeyValuePair{};
+			return available != 0;
+		});
+
+		return result;
 	}
 
-	~HashMap()
+	void Rehash(size_t newCapacity)
 	{
-		if (data != nullptr)
+		void* oldBuffer = buffer;
+		int8_t* oldCtrl = ctrl;
+		KeyValuePair* oldSlots = slots;
+		size_t oldCapacity = capacity;
+
+		buffer = allocator->Allocate(GetBufferSize(newCapacity), KOKKO_FUNC_SIG);
+		ctrl = static_cast<int8_t*>(buffer);
+		slots = reinterpret_cast<KeyValuePair*>(ctrl + newCapacity + GroupWidth);
+		capacity = newCapacity;
+		growthLeft = CapacityToGrowth(newCapacity) - population;
+
+		std::memset(ctrl, static_cast<uint8_t>(HashMapDetail::CtrlEmpty), newCapacity + GroupWidth);
+
+		for (size_t i = 0; i < oldCapacity; ++i)
 		{
-			KeyValuePair* itr = data;
-			KeyValuePair* end = data + allocated;
-			for (; itr != end; ++itr)
+			if (oldCtrl[i] >= 0)
 			{
-				if (!(itr->first == KeyType{}))
-				{
-					itr->first.~KeyType();
-					itr->second.~ValueType();
-				}
-			}
+				KeyValuePair* existing = &oldSlots[i];
+				uint32_t hash = HashKey(existing->first);
+				size_t index = FindInsertIndex(hash);
 
-			if (zeroUsed)
-			{
-				zeroPair.first.~KeyType();
-				zeroPair.second.~ValueType();
+				SetCtrl(index, H2(hash));
+				new (&slots[index]) KeyValuePair(std::move(*existing));
+				existing->~KeyValuePair();
 			}
+		}
+
+		if (oldBuffer != nullptr)
+			allocator->Deallocate(oldBuffer);
+	}
 
-			allocator->Deallocate(data);
+	void DestroyAll()
+	{
+		if constexpr (std::is_trivially_destructible<KeyValuePair>::value == false)
+		{
+			for (size_t i = 0; i < capacity; ++i)
+				if (IsFull(i))
+					slots[i].~KeyValuePair();
 		}
 	}
 
-	HashMap& operator=(const HashMap& other)
+	void CopyFrom(const HashMap& other)
+	{
+		if (other.population > 0)
+		{
+			buffer = allocator->Allocate(GetBufferSize(other.capacity), KOKKO_FUNC_SIG);
+			ctrl = static_cast<int8_t*>(buffer);
+			slots = reinterpret_cast<KeyValuePair*>(ctrl + other.capacity + GroupWidth);
+			capacity = other.capacity;
+			growthLeft = other.growthLeft;
+			population = other.population;
+
+			std::memcpy(ctrl, other.ctrl, capacity + GroupWidth);
+
+			for (size_t i = 0; i < capacity; ++i)
+				if (IsFull(i))
+					new (&slots[i]) KeyValuePair(other.slots[i]);
+		}
+	}
+
+	void Release()
 	{
-		if (data != nullptr)
+		if (buffer != nullptr)
 		{
-			allocator->Deallocate(data);
-			data = nullptr;
+			DestroyAll();
+			allocator->Deallocate(buffer);
 		}
 
-		allocator = other.allocator;
+		buffer = nullptr;
+		ctrl = nullptr;
+		slots = nullptr;
+		population = 0;
+		capacity = 0;
+		growthLeft = 0;
+	}
+
+	void TakeFrom(HashMap& other)
+	{
+		buffer = other.buffer;
+		ctrl = other.ctrl;
+		slots = other.slots;
 		population = other.population;
-		allocated = other.allocated;
-		zeroUsed = other.zeroUsed;
-		zeroPair = other.zeroPair;
+		capacity = other.capacity;
+		growthLeft = other.growthLeft;
 
-		if (other.data != nullptr && other.population > 0)
+		other.buffer = nullptr;
+		other.ctrl = nullptr;
+		other.slots = nullptr;
+		other.population = 0;
+		other.capacity = 0;
+		other.growthLeft = 0;
+	}
+
+public:
+	explicit HashMap(Allocator* allocator) :
+		allocator(allocator),
+		buffer(nullptr),
+		ctrl(nullptr),
+		slots(nullptr),
+		population(0),
+		capacity(0),
+		growthLeft(0)
+	{
+	}
+
+	HashMap(const HashMap& other) :
+		HashMap(other.allocator)
+	{
+		CopyFrom(other);
+	}
+
+	HashMap(HashMap&& other) noexcept :
+		allocator(other.allocator)
+	{
+		TakeFrom(other);
+	}
+
+	~HashMap()
+	{
+		Release();
+	}
+
+	HashMap& operator=(const HashMap& other)
+	{
+		if (this != &other)
 		{
-			ReserveInternal(other.allocated);
-			std::memcpy(data, other.data, other.allocated * sizeof(KeyValuePair));
+			Release();
+			allocator = other.allocator;
+			CopyFrom(other);
 		}
 
 		return *this;
@@ -224,80 +411,36 @@ public:
 
 	HashMap& operator=(HashMap&& other) noexcept
 	{
-		if (data != nullptr)
+		if (this != &other)
 		{
-			allocator->Deallocate(data);
+			Release();
+			allocator = other.allocator;
+			TakeFrom(other);
 		}
 
-		allocator = other.allocator;
-		data = other.data;
-		population = other.population;
-		allocated = other.allocated;
-		zeroUsed = other.zeroUsed;
-		zeroPair = other.zeroPair;
-
-		other.data = nullptr;
-		other.population = 0;
-		other.allocated = 0;
-		other.zeroUsed = false;
-		other.zeroPair = KeyValuePair{};
-
 		return *this;
 	}
 
 	void Clear()
 	{
-		KeyValuePair* itr = data;
-		KeyValuePair* end = data + allocated;
-		for (; itr != end; ++itr)
+		if (buffer != nullptr)
 		{
-			if (!(itr->first == KeyType{}))
-			{
-				itr->second.~ValueType();
-				itr->first = KeyType{};
-			}
+			DestroyAll();
+			std::memset(ctrl, static_cast<uint8_t>(HashMapDetail::CtrlEmpty), capacity + GroupWidth);
 		}
 
 		population = 0;
-
-		if (zeroUsed)
-		{
-			zeroPair.second.~ValueType();
-			zeroUsed = false;
-		}
+		growthLeft = CapacityToGrowth(capacity);
 	}
 
 	Iterator begin()
 	{
 		Iterator itr;
-
-		if (data != nullptr)
-		{
-			// Start at one before this->data
-			itr.begin = data;
-			itr.end = itr.begin + allocated;
-
-			if (zeroUsed)
-			{
-				itr.current = &zeroPair;
-				itr.zero = &zeroPair;
-			}
-			else
-			{
-				itr.current = data - 1;
-				itr.zero = nullptr;
-
-				// Find first valid item with the real increment operator
-				++itr;
-			}
-		}
-		else
-		{
-			itr.current = nullptr;
-			itr.zero = nullptr;
-			itr.begin = nullptr;
-			itr.end = nullptr;
-		}
+		itr.current = slots;
+		itr.end = slots + capacity;
+		itr.ctrl = ctrl;
+		itr.slots = slots;
+		itr.SkipEmpty();
 
 		return itr;
 	}
@@ -305,110 +448,68 @@ public:
 	Iterator end()
 	{
 		Iterator itr;
-		itr.begin = data;
-		itr.end = itr.begin + allocated;
-		itr.current = itr.end;
-		itr.zero = zeroUsed ? &zeroPair : nullptr;
+		itr.current = slots + capacity;
+		itr.end = itr.current;
+		itr.ctrl = ctrl;
+		itr.slots = slots;
 
 		return itr;
 	}
 
+	size_t GetCount() const { return population; }
+
 	KeyValuePair* Lookup(const KeyType& key)
 	{
-		if (!(key == KeyType{}))
-		{
-			if (data != nullptr)
-			{
-				for (size_t i = GetIndex(kokko::Hash32<KeyType>()(key, 0u));; i = GetIndex(i + 1))
-				{
-					KeyValuePair* pair = data + i;
-
-					if (pair->first == key)
-						return pair;
-
-					if (pair->first == KeyType{})
-						return nullptr;
-				}
-			}
-		}
-		else if (zeroUsed)
-			return &zeroPair;
-
-		return nullptr;
+		size_t index = FindIndex(key);
+		return index != SIZE_MAX ? &slots[index] : nullptr;
 	}
 
 	const KeyValuePair* Lookup(const KeyType& key) const
 	{
-		if (!(key == KeyType{}))
-		{
-			if (data != nullptr)
-			{
-				for (size_t i = GetIndex(kokko::Hash32<KeyType>()(key, 0u));; i = GetIndex(i + 1))
-				{
-					KeyValuePair* pair = data + i;
-
-					if (pair->first == key)
-						return pair;
-
-					if (pair->first == KeyType{})
-						return nullptr;
-				}
-			}
-		}
-		else if (zeroUsed)
-			return &zeroPair;
-
-		return nullptr;
+		size_t index = FindIndex(key);
+		return index != SIZE_MAX ? &slots[index] : nullptr;
 	}
 
 	KeyValuePair* Insert(const KeyType& key)
 	{
-		if (data == nullptr)
-			ReserveInternal(16);
+		uint32_t hash = HashKey(key);
+		size_t index = SIZE_MAX;
 
-		if (!(key == KeyType{}))
+		if (capacity == 0)
 		{
-			for (;;)
-			{
-				for (size_t i = GetIndex(kokko::Hash32<KeyType>()(key, 0u));; i = GetIndex(i + 1))
-				{
-					KeyValuePair* pair = data + i;
-
-					if (pair->first == key) // Found
-						return pair;
-
-					if (pair->first == KeyType{}) // Insert here
-					{
-						if ((population + 1) * 4 >= allocated * 3)
-						{
-							ReserveInternal(allocated * 2);
-							break; // Back to outer loop, find first again
-						}
-
-						++population;
-
-						pair->first = key;
-						new (&pair->second) ValueType;
-
-						return pair;
-					}
-				}
-			}
+			Rehash(GroupWidth);
+			index = FindInsertIndex(hash);
 		}
 		else
 		{
-			if (zeroUsed == false)
-			{
-				zeroUsed = true;
-				++population;
+			size_t existing = FindIndex(key, hash, &index);
+			if (existing != SIZE_MAX)
+				return &slots[existing];
+		}
 
-				// Even though we didn't use a regular slot, let's keep the sizing rules consistent
-				if (population * 4 >= allocated * 3)
-					ReserveInternal(allocated * 2);
-			}
+		// Reusing a tombstone doesn't make probe sequences any longer
+		if (growthLeft == 0 && ctrl[index] == HashMapDetail::CtrlEmpty)
+		{
+			// If the table is mostly tombstones, clean them up without growing
+			if (population < CapacityToGrowth(capacity) / 2)
+				Rehash(capacity);
+			else
+				Rehash(capacity * 2);
 
-			return &zeroPair;
+			index = FindInsertIndex(hash);
 		}
+
+		if (ctrl[index] == HashMapDetail::CtrlEmpty)
+			growthLeft -= 1;
+
+		SetCtrl(index, H2(hash));
+		population += 1;
+
+		KeyValuePair* pair = &slots[index];
+		new (&pair->first) KeyType(key);
+		new (&pair->second) ValueType();
+
+		return pair;
 	}
 
 	void Remove(const Iterator& iterator)
@@ -418,58 +519,46 @@ public:
 
 	void Remove(KeyValuePair* pair)
 	{
-		if (pair != &zeroPair)
-		{
-			if (data != nullptr &&
-				pair >= data &&
-				pair < data + allocated &&
-				!(pair->first == KeyType{}))
-			{
-				// Remove this cell by shuffling neighboring cells
-				// so there are no gaps in anyone's probe chain
-				for (size_t i = GetIndex(pair - data + 1);; i = GetIndex(i + 1))
-				{
-					KeyValuePair* neighbor = data + i;
-
-					if (neighbor->first == KeyType{})
-					{
-						// There's nobody to swap with. Go ahead and clear this cell, then return
-						pair->first = KeyType{};
-						pair->second = ValueType{};
-						population--;
-						return;
-					}
-
-					KeyValuePair* ideal = data + GetIndex(kokko::Hash32<KeyType>()(neighbor->first, 0u));
-					if (GetOffset(ideal, pair) < GetOffset(ideal, neighbor))
-					{
-						// Swap with neighbor, then make neighbor the new cell to remove.
-						*pair = *neighbor;
-						pair = neighbor;
-					}
-				}
-			}
-		}
-		else if (zeroUsed) // Ignore if not in use
+		if (pair == nullptr || pair < slots || pair >= slots + capacity)
+			return;
+
+		size_t index = pair - slots;
+		if (IsFull(index) == false)
+			return;
+
+		pair->~KeyValuePair();
+		population -= 1;
+
+		// If there has never been a full group around this slot, no probe sequence
+		// could have continued past it, and it can be marked empty instead of deleted
+		size_t indexBefore = (index - GroupWidth) & (capacity - 1);
+		uint32_t emptyAfter = HashMapDetail::Group(ctrl + index).MatchEmpty();
+		uint32_t emptyBefore = HashMapDetail::Group(ctrl + indexBefore).MatchEmpty();
+
+		bool wasNeverFull = emptyBefore != 0 && emptyAfter != 0 &&
+			HashMapDetail::CountTrailingZeros(emptyAfter) + HashMapDetail::CountLeadingZeros16(emptyBefore) < GroupWidth;
+
+		if (wasNeverFull)
 		{
-			zeroUsed = false;
-			pair->second = ValueType{};
-			population--;
+			SetCtrl(index, HashMapDetail::CtrlEmpty);
+			growthLeft += 1;
 		}
+		else
+			SetCtrl(index, HashMapDetail::CtrlDeleted);
 	}
 
 	void Reserve(size_t desiredPopulation)
 	{
-		if (desiredPopulation < population)
+		if (desiredPopulation <= population)
 			return;
 
-		size_t desiredSize = (desiredPopulation * 4 + 2) / 3;
-
-		// Desired size is not a power-of-two
-		if ((desiredSize & (desiredSize - 1)) != 0)
-			desiredSize = Math::UpperPowerOfTwo(desiredSize);
+		// Round up so that desiredPopulation fits within the max load factor
+		size_t newCapacity = Math::UpperPowerOfTwo((desiredPopulation * 8 + 6) / 7);
+		if (newCapacity < GroupWidth)
+			newCapacity = GroupWidth;
 
-		this->ReserveInternal(desiredSize);
+		if (newCapacity > capacity)
+			Rehash(newCapacity);
 	}
 };
 
@@ -0,0 +1,121 @@
+#include "Core/SoaStorage.hpp"
+
+#include "doctest/doctest.h"
+
+#include "Math/Mat4x4.hpp"
+#include "Math/Vec3.hpp"
+
+namespace kokko
+{
+
+TEST_CASE("SoaStorage.ColumnsAreAligned")
+{
+	SoaStorage<uint8_t, Vec3f, Mat4x4f, uint16_t> storage(Allocator::GetDefault());
+	storage.Add(3);
+
+	CHECK(reinterpret_cast<uintptr_t>(storage.Get<0>()) % 64 == 0);
+	CHECK(reinterpret_cast<uintptr_t>(storage.Get<1>()) % 64 == 0);
+	CHECK(reinterpret_cast<uintptr_t>(storage.Get<2>()) % 64 == 0);
+	CHECK(reinterpret_cast<uintptr_t>(storage.Get<3>()) % 64 == 0);
+
+	// Columns must not overlap
+	CHECK(reinterpret_cast<uint8_t*>(storage.Get<1>()) >= reinterpret_cast<uint8_t*>(storage.Get<0>() + storage.GetCapacity()));
+	CHECK(reinterpret_cast<uint8_t*>(storage.Get<2>()) >= reinterpret_cast<uint8_t*>(storage.Get<1>() + storage.GetCapacity()));
+	CHECK(reinterpret_cast<uint8_t*>(storage.Get<3>()) >= reinterpret_cast<uint8_t*>(storage.Get<2>() + storage.GetCapacity()));
+}
+
+TEST_CASE("SoaStorage.GrowPreservesData")
+{
+	SoaStorage<uint32_t, float, uint8_t> storage(Allocator::GetDefault());
+
+	constexpr uint32_t count = 1000;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint32_t index = storage.Add();
+		CHECK(index == i);
+
+		storage.Get<0>()[index] = i;
+		storage.Get<1>()[index] = i * 0.5f;
+		storage.Get<2>()[index] = static_cast<uint8_t>(i);
+	}
+
+	CHECK(storage.GetCount() == count);
+	CHECK(storage.GetCapacity() >= count);
+
+	bool allMatch = true;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (storage.Get<0>()[i] != i ||
+			storage.Get<1>()[i] != i * 0.5f ||
+			storage.Get<2>()[i] != static_cast<uint8_t>(i))
+			allMatch = false;
+	}
+
+	CHECK(allMatch);
+}
+
+TEST_CASE("SoaStorage.AddAndRemove")
+{
+	SoaStorage<int, double> storage(Allocator::GetDefault());
+
+	uint32_t first = storage.Add(4);
+	CHECK(first == 0);
+	CHECK(storage.GetCount() == 4);
+
+	for (int i = 0; i < 4; ++i)
+	{
+		storage.Get<0>()[i] = i;
+		storage.Get<1>()[i] = i * 2.0;
+	}
+
+	// Last element moves into the removed slot
+	storage.RemoveSwap(1);
+	CHECK(storage.GetCount() == 3);
+	CHECK(storage.Get<0>()[1] == 3);
+	CHECK(storage.Get<1>()[1] == 6.0);
+
+	// Removing the last element doesn't move anything
+	storage.RemoveSwap(2);
+	CHECK(storage.GetCount() == 2);
+	CHECK(storage.Get<0>()[0] == 0);
+	CHECK(storage.Get<0>()[1] == 3);
+
+	storage.SetCount(1);
+	CHECK(storage.GetCount() == 1);
+
+	storage.Clear();
+	CHECK(storage.GetCount() == 0);
+}
+
+TEST_CASE("SoaStorage.RemoveSwapMultiple")
+{
+	SoaStorage<uint32_t, uint16_t> storage(Allocator::GetDefault());
+
+	constexpr uint32_t count = 8;
+	storage.Add(count);
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		storage.Get<0>()[i] = i;
+		storage.Get<1>()[i] = static_cast<uint16_t>(i * 10);
+	}
+
+	// Includes the last element and an element that would be moved
+	const uint32_t indices[] = { 1, 2, 6, 7 };
+	storage.RemoveSwap(indices);
+	CHECK(storage.GetCount() == 4);
+
+	const uint32_t expected[] = { 0, 4, 5, 3 };
+	for (uint32_t i = 0; i < KOKKO_ARRAY_ITEMS(expected); ++i)
+	{
+		CHECK(storage.Get<0>()[i] == expected[i]);
+		CHECK(storage.Get<1>()[i] == expected[i] * 10);
+	}
+
+	// Remove everything that's left
+	const uint32_t all[] = { 0, 1, 2, 3 };
+	storage.RemoveSwap(all);
+	CHECK(storage.GetCount() == 0);
+}
+
+} // namespace kokko
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+
+#include "Core/ArrayView.hpp"
+#include "Core/Core.hpp"
+
+#include "Math/Math.hpp"
+
+#include "Memory/Allocator.hpp"
+
+namespace kokko
+{
+
+// Structure-of-arrays storage for component data. Each field type is stored in
+// its own column, and all columns share a single allocation. Every column starts
+// on a cache line, so columns that aren't touched by a loop don't share cache
+// lines with columns that are. Fields that are always accessed together can be
+// grouped into a struct and stored as a single column.
+//
+// Capacity is always a power of two and at least one cache line of elements, so
+// every column size is a multiple of the cache line size. A column's offset in the
+// buffer is then the capacity multiplied by the sizes of the preceding fields, which
+// is computed at compile time.
+//
+// Columns are accessed by index, e.g. storage.Get<1>()[i]. Fields must be
+// trivially copyable, as they're moved with memcpy. New elements are not initialized.
+template <typename... Fields>
+class SoaStorage
+{
+public:
+	static constexpr size_t ColumnCount = sizeof...(Fields);
+	static constexpr size_t ColumnAlignment = 64;
+	static constexpr uint32_t MinCapacity = static_cast<uint32_t>(ColumnAlignment);
+
+	template <size_t Column>
+	using FieldType = typename std::tuple_element<Column, std::tuple<Fields...>>::type;
+
+	static_assert(ColumnCount > 0, "SoaStorage needs at least one field");
+	static_assert((std::is_trivially_copyable<Fields>::value && ...), "SoaStorage fields must be trivially copyable");
+	static_assert(((alignof(Fields) <= ColumnAlignment) && ...), "SoaStorage field alignment is too large");
+
+	explicit SoaStorage(Allocator* allocator, const char* debugTag = nullptr) :
+		allocator(allocator),
+		debugTag(debugTag),
+		buffer(nullptr),
+		count(0),
+		capacity(0)
+	{
+	}
+
+	SoaStorage(const SoaStorage&) = delete;
+	SoaStorage& operator=(const SoaStorage&) = delete;
+
+	~SoaStorage()
+	{
+		if (buffer != nullptr)
+			allocator->Deallocate(buffer);
+	}
+
+	uint32_t GetCount() const { return count; }
+	uint32_t GetCapacity() const { return capacity; }
+
+	template <size_t Column>
+	FieldType<Column>* Get()
+	{
+		return reinterpret_cast<FieldType<Column>*>(buffer + Layout.offsets[Column] * capacity);
+	}
+
+	template <size_t Column>
+	const FieldType<Column>* Get() const
+	{
+		return reinterpret_cast<const FieldType<Column>*>(buffer + Layout.offsets[Column] * capacity);
+	}
+
+	// Makes sure there's room for at least required elements. Grows to the next power of two.
+	void Reserve(uint32_t required)
+	{
+		if (required <= capacity)
+			return;
+
+		uint32_t newCapacity = static_cast<uint32_t>(Math::UpperPowerOfTwo(required));
+		if (newCapacity < MinCapacity)
+			newCapacity = MinCapacity;
+
+		uint8_t* newBuffer = static_cast<uint8_t*>(
+			allocator->AllocateAligned(Layout.rowSize * newCapacity, ColumnAlignment, debugTag));
+
+		if (count > 0)
+		{
+			for (size_t i = 0; i < ColumnCount; ++i)
+				std::memcpy(newBuffer + Layout.offsets[i] * newCapacity,
+					buffer + Layout.offsets[i] * capacity, ElementSizes[i] * count);
+		}
+
+		if (buffer != nullptr)
+			allocator->Deallocate(buffer);
+
+		buffer = newBuffer;
+		capacity = newCapacity;
+	}
+
+	// Adds uninitialized elements to the end, returns index of the first added element
+	uint32_t Add(uint32_t addCount = 1)
+	{
+		Reserve(count + addCount);
+
+		uint32_t first = count;
+		count += addCount;
+
+		return first;
+	}
+
+	// Removes an element by moving the last element into its place
+	void RemoveSwap(uint32_t index)
+	{
+		assert(index < count);
+
+		uint32_t last = count - 1;
+		if (index != last)
+		{
+			for (size_t i = 0; i < ColumnCount; ++i)
+			{
+				uint8_t* column = buffer + Layout.offsets[i] * capacity;
+				std::memcpy(column + index * ElementSizes[i], column + last * ElementSizes[i], ElementSizes[i]);
+			}
+		}
+
+		count = last;
+	}
+
+	// Removes multiple elements by moving elements from the end into their places.
+	// Indices must be unique and sorted in ascending order. Afterwards, removed indices
+	// that are still less than the count hold elements that were moved there.
+	void RemoveSwap(ArrayView<const uint32_t> sortedIndices)
+	{
+		uint32_t removeCount = static_cast<uint32_t>(sortedIndices.GetCount());
+		assert(removeCount <= count);
+
+		// Going from the highest index down, the last element is never one to remove
+		for (size_t i = 0; i < ColumnCount; ++i)
+		{
+			uint8_t* column = buffer + Layout.offsets[i] * capacity;
+			size_t elementSize = ElementSizes[i];
+
+			uint32_t last = count - 1;
+			for (uint32_t j = removeCount; j > 0; --j, --last)
+			{
+				uint32_t index = sortedIndices[j - 1];
+				assert(index <= last);
+				assert(j == 1 || sortedIndices[j - 2] < index);
+
+				if (index != last)
+					std::memcpy(column + index * elementSize, column + last * elementSize, elementSize);
+			}
+		}
+
+		count -= removeCount;
+	}
+
+	// Shrinks or grows the element count, new elements are not initialized
+	void SetCount(uint32_t newCount)
+	{
+		Reserve(newCount);
+		count = newCount;
+	}
+
+	void Clear() { count = 0; }
+
+private:
+	struct ColumnLayout
+	{
+		size_t offsets[ColumnCount];
+		size_t rowSize;
+	};
+
+	// Offsets are per element of capacity, multiply by capacity to get the byte offset
+	static constexpr ColumnLayout CalculateLayout()
+	{
+		ColumnLayout layout{};
+		size_t sizes[ColumnCount] = { sizeof(Fields)... };
+
+		for (size_t i = 0; i < ColumnCount; ++i)
+		{
+			layout.offsets[i] = layout.rowSize;
+			layout.rowSize += sizes[i];
+		}
+
+		return layout;
+	}
+
+	static constexpr size_t ElementSizes[ColumnCount] = { sizeof(Fields)... };
+	static constexpr ColumnLayout Layout = CalculateLayout();
+
+	Allocator* allocator;
+	const char* debugTag;
+	uint8_t* buffer;
+	uint32_t count;
+	uint32_t capacity;
+};
+
+} // namespace kokko
@@ -0,0 +1,63 @@
+#include "Core/Sort.hpp"
+
+#include <cstdint>
+
+#include "doctest/doctest.h"
+
+namespace kokko
+{
+
+namespace
+{
+struct SortItem
+{
+	uint64_t key;
+	int value;
+};
+
+uint64_t GetSortItemKey(const SortItem& item)
+{
+	return item.key;
+}
+}
+
+TEST_CASE("Sort.RadixSortAsc")
+{
+	constexpr size_t count = 1000;
+	SortItem items[count];
+	SortItem temporary[count];
+
+	uint64_t state = 12345;
+	for (size_t i = 0; i < count; ++i)
+	{
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		items[i] = SortItem{ state, static_cast<int>(i) };
+	}
+
+	RadixSortAsc(items, temporary, count, GetSortItemKey);
+
+	for (size_t i = 1; i < count; ++i)
+		CHECK(items[i - 1].key <= items[i].key);
+}
+
+TEST_CASE("Sort.RadixSortAscIsStable")
+{
+	SortItem items[] = {
+		SortItem{ 3ULL << 60, 0 },
+		SortItem{ 1, 1 },
+		SortItem{ 3ULL << 60, 2 },
+		SortItem{ 1, 3 },
+		SortItem{ 0, 4 }
+	};
+	SortItem temporary[5];
+
+	RadixSortAsc(items, temporary, 5, GetSortItemKey);
+
+	CHECK(items[0].value == 4);
+	CHECK(items[1].value == 1);
+	CHECK(items[2].value == 3);
+	CHECK(items[3].value == 0);
+	CHECK(items[4].value == 2);
+}
+
+} // namespace kokko
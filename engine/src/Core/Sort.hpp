@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
 
 namespace kokko
@@ -143,4 +144,63 @@ void ShellSortDesc(T* array, size_t count)
 	}
 }
 
+// Stable least significant digit radix sort on 64-bit keys.
+// temporary must have room for count items. The result is written to array.
+template <typename T>
+void RadixSortAsc(T* array, T* temporary, size_t count, uint64_t(*getKey)(const T&))
+{
+	constexpr unsigned int DigitBits = 8;
+	constexpr unsigned int DigitCount = sizeof(uint64_t) * 8 / DigitBits;
+	constexpr size_t BucketCount = 1 << DigitBits;
+	constexpr uint64_t DigitMask = BucketCount - 1;
+
+	if (count < 2)
+		return;
+
+	// Count the digits of all passes up front
+	size_t histograms[DigitCount][BucketCount] = {};
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint64_t key = getKey(array[i]);
+		for (unsigned int digit = 0; digit < DigitCount; ++digit)
+			histograms[digit][(key >> (digit * DigitBits)) & DigitMask] += 1;
+	}
+
+	T* source = array;
+	T* destination = temporary;
+
+	for (unsigned int digit = 0; digit < DigitCount; ++digit)
+	{
+		size_t* histogram = histograms[digit];
+		unsigned int shift = digit * DigitBits;
+
+		// Skip passes where every key has the same digit
+		if (histogram[(getKey(source[0]) >> shift) & DigitMask] == count)
+			continue;
+
+		size_t offset = 0;
+		for (size_t bucket = 0; bucket < BucketCount; ++bucket)
+		{
+			size_t bucketSize = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketSize;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			size_t bucket = (getKey(source[i]) >> shift) & DigitMask;
+			destination[histogram[bucket]] = source[i];
+			histogram[bucket] += 1;
+		}
+
+		T* swap = source;
+		source = destination;
+		destination = swap;
+	}
+
+	if (source != array)
+		for (size_t i = 0; i < count; ++i)
+			array[i] = source[i];
+}
+
 } // namespace kokko
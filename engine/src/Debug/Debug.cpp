@@ -91,7 +91,7 @@ bool Debug::Initialize(kokko::Window* window, kokko::ModelManager* modelManager,
 	if (textRenderer->Initialize(shaderManager, modelManager, textureManager) == false)
 		return false;
 
-	vectorRenderer->Initialize(modelManager, shaderManager);
+	vectorRenderer->Initialize(shaderManager);
 
 	return true;
 }
@@ -5,9 +5,11 @@
 #include "fmt/printf.h"
 
 #include "Core/Color.hpp"
+#include "Core/Core.hpp"
 #include "Resources/BitmapFont.hpp"
 
 #include "Memory/AllocatorManager.hpp"
+#include "Memory/FrameAllocator.hpp"
 
 #include "Debug/DebugTextRenderer.hpp"
 
@@ -113,6 +115,37 @@ void DebugMemoryStats::UpdateAndDraw()
 			textRenderer->AddText(kokko::ConstStringView(buffer), area);
 		}
 	}
+
+	// Frame arena usage is reset every frame, so show last frame and peak usage instead
+	const FrameAllocator* frameAllocator = allocatorManager->GetFrameAllocator();
+	const char* frameRowNames[] = { "Frame arena (last)", "Frame arena (peak)" };
+	std::size_t frameRowSizes[] = { frameAllocator->GetLastFrameUsage(), frameAllocator->GetHighWaterMark() };
+
+	for (unsigned int i = 0; i < KOKKO_ARRAY_ITEMS(frameRowNames); ++i)
+	{
+		float rowY = areaPos.y + (lineHeight * (scopeCount + i + 1));
+
+		{
+			Rectanglef area;
+			area.position.x = areaPos.x;
+			area.position.y = rowY;
+			area.size.x = static_cast<float>(glyphWidth * columnWidth0);
+			area.size.y = static_cast<float>(lineHeight);
+
+			textRenderer->AddText(kokko::ConstStringView(frameRowNames[i]), area);
+		}
+
+		{
+			Rectanglef area;
+			area.position.x = areaPos.x + glyphWidth * (columnWidth0 + columnWidth1);
+			area.position.y = rowY;
+			area.size.x = static_cast<float>(glyphWidth * columnWidth2);
+			area.size.y = static_cast<float>(lineHeight);
+
+			fmt::format_to_n(buffer, sizeof(buffer), FMT_STRING("{}"), frameRowSizes[i]);
+			textRenderer->AddText(kokko::ConstStringView(buffer), area);
+		}
+	}
 }
 
 } // namespace kokko
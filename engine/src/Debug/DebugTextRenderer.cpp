@@ -43,6 +43,7 @@ DebugTextRenderer::DebugTextRenderer(
 	stringData(allocator),
 	displayData(allocator),
 	scaleFactor(1.0f),
+	shaderId(kokko::ShaderId::Null),
 	meshId(kokko::ModelId{}),
 	bufferObjectId(0),
 	vertexData(allocator),
@@ -66,6 +67,10 @@ bool DebugTextRenderer::Initialize(kokko::ShaderManager* shaderManager,
 
 	auto scope = renderDevice->CreateDebugScope(0, kokko::ConstStringView("DebugText_InitResources"));
 
+	// The shader compiles while the font is loaded
+	const char* shaderPath = "engine/shaders/debug/debug_text.glsl";
+	shaderId = shaderManager->FindShaderByPath(kokko::ConstStringView(shaderPath));
+
 	const char* const debugFontFilename = "engine/fonts/gohufont-uni-14.bdf";
 	if (LoadBitmapFont(textureManager, debugFontFilename) == false)
 	{
@@ -162,8 +167,7 @@ void DebugTextRenderer::Render(kokko::render::CommandEncoder* encoder)
 
 		CreateAndUploadData();
 
-		const char* shaderPath = "engine/shaders/debug/debug_text.glsl";
-		kokko::ShaderId shaderId = shaderManager->FindShaderByPath(kokko::ConstStringView(shaderPath));
+		shaderId = shaderManager->WaitForShader(shaderId);
 
 		if (shaderId == kokko::ShaderId::Null)
 			return;
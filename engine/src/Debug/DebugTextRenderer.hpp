@@ -10,6 +10,7 @@
 #include "Rendering/RenderResourceId.hpp"
 
 #include "Resources/MeshId.hpp"
+#include "Resources/ShaderId.hpp"
 
 namespace kokko
 {
@@ -54,6 +55,7 @@ private:
 	Vec2f scaledFrameSize;
 	float scaleFactor;
 
+	ShaderId shaderId;
 	ModelId meshId;
 	Array<float> vertexData;
 	Array<unsigned short> indexData;
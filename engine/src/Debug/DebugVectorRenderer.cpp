@@ -1,5 +1,6 @@
 #include "Debug/DebugVectorRenderer.hpp"
 
+#include <cstddef>
 #include <cstring>
 #include <cmath>
 
@@ -11,6 +12,7 @@
 
 #include "Math/Math.hpp"
 #include "Math/Frustum.hpp"
+#include "Math/Vec4.hpp"
 
 #include "Platform/Window.hpp"
 
@@ -19,17 +21,52 @@
 #include "Rendering/RenderDevice.hpp"
 #include "Rendering/StaticUniformBuffer.hpp"
 #include "Rendering/CommandEncoder.hpp"
+#include "Rendering/VertexFormat.hpp"
 
-#include "Resources/ModelManager.hpp"
 #include "Resources/ShaderManager.hpp"
 
 namespace kokko
 {
 
+namespace
+{
+
+const Vec3f CubePoints[] = {
+	Vec3f(-0.5f, -0.5f, -0.5f),
+	Vec3f(0.5f, -0.5f, -0.5f),
+	Vec3f(-0.5f, -0.5f, 0.5f),
+	Vec3f(0.5f, -0.5f, 0.5f),
+	Vec3f(-0.5f, 0.5f, -0.5f),
+	Vec3f(0.5f, 0.5f, -0.5f),
+	Vec3f(-0.5f, 0.5f, 0.5f),
+	Vec3f(0.5f, 0.5f, 0.5f)
+};
+
+const uint16_t CubeLineIndices[] = {
+	0, 1, 1, 3, 3, 2, 2, 0,
+	0, 4, 1, 5, 2, 6, 3, 7,
+	4, 5, 5, 7, 7, 6, 6, 4
+};
+
+const Vec3f RectanglePoints[] = {
+	Vec3f(-0.5f, 0.5f, 0.0f),
+	Vec3f(0.5f, 0.5f, 0.0f),
+	Vec3f(0.5f, -0.5f, 0.0f),
+	Vec3f(-0.5f, -0.5f, 0.0f)
+};
+
+const uint16_t RectangleLineIndices[] = { 0, 1, 1, 2, 2, 3, 3, 0 };
+
+const uint16_t SingleLineIndices[] = { 0, 1 };
+
+constexpr uint32_t SphereRingPointCount = 24;
+constexpr uint32_t InitialVertexBufferCapacity = 4096;
+
+} // Anonymous namespace
+
 struct DebugVectorBlock
 {
 	alignas(16) Mat4x4f transform;
-	alignas(16) Vec4f color;
 };
 
 DebugVectorRenderer::DebugVectorRenderer(
@@ -38,34 +75,23 @@ DebugVectorRenderer::DebugVectorRenderer(
 	allocator(allocator),
 	renderDevice(renderDevice),
 	shaderManager(nullptr),
-	modelManager(nullptr),
-	meshesInitialized(false),
+	vertices{ Array<LineVertex>(allocator), Array<LineVertex>(allocator) },
 	shaderId(ShaderId{ 0 }),
-	bufferPrimitivesAllocated(0),
-	bufferAlignedSize(0)
+	uniformBlockStride(0),
+	vertexBufferCapacity(0)
 {
-	primitiveCount = 0;
-	primitiveAllocated = 2048;
-
-	size_t primitivesSize = sizeof(Primitive) * primitiveAllocated;
-	primitives = static_cast<Primitive*>(allocator->Allocate(primitivesSize, "DebugVectorRenderer.primitives"));
 }
 
 DebugVectorRenderer::~DebugVectorRenderer()
 {
 }
 
-void DebugVectorRenderer::Initialize(ModelManager* modelManager, ShaderManager* shaderManager)
+void DebugVectorRenderer::Initialize(ShaderManager* shaderManager)
 {
 	KOKKO_PROFILE_FUNCTION();
 
 	auto scope = renderDevice->CreateDebugScope(0, ConstStringView("DebugVec_InitResources"));
 
-	int alignment = 0;
-	renderDevice->GetIntegerValue(RenderDeviceParameter::UniformBufferOffsetAlignment, &alignment);
-	bufferAlignedSize = Math::RoundUpToMultiple(int(sizeof(DebugVectorBlock)), alignment);
-
-	this->modelManager = modelManager;
 	this->shaderManager = shaderManager;
 
 	// Initialize shaders
@@ -73,250 +99,136 @@ void DebugVectorRenderer::Initialize(ModelManager* modelManager, ShaderManager*
 	const char* shaderPath = "engine/shaders/debug/debug_vector.glsl";
 	shaderId = shaderManager->FindShaderByPath(ConstStringView(shaderPath));
 
-	// Initialize meshes
+	// Initialize uniform buffer, one block for each space
 
-	VertexAttribute vertexAttributes[] = { VertexAttribute::pos3 };
-	VertexFormat vertexFormatPos(vertexAttributes, sizeof(vertexAttributes) / sizeof(vertexAttributes[0]));
-	vertexFormatPos.CalcOffsetsAndSizeInterleaved();
+	int alignment = 0;
+	renderDevice->GetIntegerValue(RenderDeviceParameter::UniformBufferOffsetAlignment, &alignment);
+	uniformBlockStride = Math::RoundUpToMultiple(int(sizeof(DebugVectorBlock)), alignment);
 
-	{
-		float lineVertexData[] = {
-			0.0f, 0.0f, 0.0f,
-			0.0f, 0.0f, -1.0f
-		};
-
-		ModelCreateInfo modelInfo;
-		modelInfo.vertexFormat = vertexFormatPos;
-		modelInfo.primitiveMode = RenderPrimitiveMode::Lines;
-		modelInfo.vertexData = lineVertexData;
-		modelInfo.vertexDataSize = sizeof(lineVertexData);
-		modelInfo.vertexCount = 2;
-
-		ModelId& lineMeshId = staticMeshes[static_cast<unsigned int>(PrimitiveType::Line)];
-		lineMeshId = modelManager->CreateModel(modelInfo);
-	}
+	uint32_t uniformBufferSize = uniformBlockStride * static_cast<uint32_t>(Space::Count);
+	renderDevice->CreateBuffers(1, &uniformBufferId);
+	renderDevice->SetBufferStorage(uniformBufferId, uniformBufferSize, nullptr, BufferStorageFlags::Dynamic);
 
-	{
-		float cubeVertexData[] = {
-			-0.5f, -0.5f, -0.5f,
-			0.5f, -0.5f, -0.5f,
-			-0.5f, -0.5f, 0.5f,
-			0.5f, -0.5f, 0.5f,
-			-0.5f, 0.5f, -0.5f,
-			0.5f, 0.5f, -0.5f,
-			-0.5f, 0.5f, 0.5f,
-			0.5f, 0.5f, 0.5f
-		};
-
-		unsigned short cubeIndexData[] = {
-			0, 1, 1, 3, 3, 2, 2, 0,
-			0, 4, 1, 5, 2, 6, 3, 7,
-			4, 5, 5, 7, 7, 6, 6, 4
-		};
-
-		ModelCreateInfo modelInfo;
-		modelInfo.vertexFormat = vertexFormatPos;
-		modelInfo.primitiveMode = RenderPrimitiveMode::Lines;
-		modelInfo.vertexData = cubeVertexData;
-		modelInfo.vertexDataSize = sizeof(cubeVertexData);
-		modelInfo.vertexCount = sizeof(cubeVertexData) / (sizeof(cubeVertexData[0]) * 3);
-		modelInfo.indexData = cubeIndexData;
-		modelInfo.indexDataSize = sizeof(cubeIndexData);
-		modelInfo.indexCount = sizeof(cubeIndexData) / sizeof(cubeIndexData[0]);
-		modelInfo.indexType = RenderIndexType::UnsignedShort;
-
-		ModelId& cubeMeshId = staticMeshes[static_cast<unsigned int>(PrimitiveType::WireCube)];
-		cubeMeshId = modelManager->CreateModel(modelInfo);
-	}
+	// Initialize vertex array, vertex buffer is attached when it's created
 
-	{
-		static const int sphereVertices = 72;
+	renderDevice->CreateVertexArrays(1, &vertexArrayId);
 
-		float sphereVertexData[sphereVertices * 3];
+	renderDevice->EnableVertexAttribute(vertexArrayId, VertexFormat::AttributeIndexPos);
+	renderDevice->SetVertexAttribFormat(vertexArrayId, VertexFormat::AttributeIndexPos, 3,
+		RenderVertexElemType::Float, offsetof(LineVertex, position));
+	renderDevice->SetVertexAttribBinding(vertexArrayId, VertexFormat::AttributeIndexPos, 0);
 
-		for (int i = 0; i < 24; ++i)
-		{
-			float f = Math::Const::Tau / 24 * i;
-			sphereVertexData[i * 3 + 0] = std::sin(f);
-			sphereVertexData[i * 3 + 1] = std::cos(f);
-			sphereVertexData[i * 3 + 2] = 0.0f;
-		}
+	renderDevice->EnableVertexAttribute(vertexArrayId, VertexFormat::AttributeIndexCol0);
+	renderDevice->SetVertexAttribFormat(vertexArrayId, VertexFormat::AttributeIndexCol0, 4,
+		RenderVertexElemType::Float, offsetof(LineVertex, color));
+	renderDevice->SetVertexAttribBinding(vertexArrayId, VertexFormat::AttributeIndexCol0, 0);
 
-		for (int i = 0; i < 24; ++i)
-		{
-			float f = Math::Const::Tau / 24 * i;
-			sphereVertexData[24 * 3 + i * 3 + 0] = 0.0f;
-			sphereVertexData[24 * 3 + i * 3 + 1] = std::sin(f);
-			sphereVertexData[24 * 3 + i * 3 + 2] = std::cos(f);
-		}
+	// Initialize sphere as three rings around the coordinate axes
 
-		for (int i = 0; i < 24; ++i)
-		{
-			float f = Math::Const::Tau / 24 * i;
-			sphereVertexData[48 * 3 + i * 3 + 0] = std::cos(f);
-			sphereVertexData[48 * 3 + i * 3 + 1] = 0.0f;
-			sphereVertexData[48 * 3 + i * 3 + 2] = std::sin(f);
-		}
+	for (uint32_t i = 0; i < SphereRingPointCount; ++i)
+	{
+		float f = Math::Const::Tau / SphereRingPointCount * i;
+		float s = std::sin(f);
+		float c = std::cos(f);
 
-		unsigned short sphereIndexData[sphereVertices * 2] = {
-			0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
-			6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12,
-			12, 13, 13, 14, 14, 15, 15, 16, 16, 17, 17, 18,
-			18, 19, 19, 20, 20, 21, 21, 22, 22, 23, 23, 0,
-
-			24, 25, 25, 26, 26, 27, 27, 28, 28, 29, 29, 30,
-			30, 31, 31, 32, 32, 33, 33, 34, 34, 35, 35, 36,
-			36, 37, 37, 38, 38, 39, 39, 40, 40, 41, 41, 42,
-			42, 43, 43, 44, 44, 45, 45, 46, 46, 47, 47, 24,
-
-			48, 49, 49, 50, 50, 51, 51, 52, 52, 53, 53, 54,
-			54, 55, 55, 56, 56, 57, 57, 58, 58, 59, 59, 60,
-			60, 61, 61, 62, 62, 63, 63, 64, 64, 65, 65, 66,
-			66, 67, 67, 68, 68, 69, 69, 70, 70, 71, 71, 48
-		};
-
-		ModelCreateInfo modelInfo;
-		modelInfo.vertexFormat = vertexFormatPos;
-		modelInfo.primitiveMode = RenderPrimitiveMode::Lines;
-		modelInfo.vertexData = sphereVertexData;
-		modelInfo.vertexDataSize = sizeof(sphereVertexData);
-		modelInfo.vertexCount = sphereVertices;
-		modelInfo.indexData = sphereIndexData;
-		modelInfo.indexDataSize = sizeof(sphereIndexData);
-		modelInfo.indexCount = sizeof(sphereIndexData) / sizeof(sphereIndexData[0]);
-		modelInfo.indexType = RenderIndexType::UnsignedShort;
-
-		ModelId& sphereMeshId = staticMeshes[static_cast<unsigned int>(PrimitiveType::WireSphere)];
-		sphereMeshId = modelManager->CreateModel(modelInfo);
+		spherePoints[i] = Vec3f(s, c, 0.0f);
+		spherePoints[SphereRingPointCount + i] = Vec3f(0.0f, s, c);
+		spherePoints[SphereRingPointCount * 2 + i] = Vec3f(c, 0.0f, s);
 	}
 
+	for (uint32_t ring = 0; ring < 3; ++ring)
 	{
-		float rectangleVertexData[] = {
-			-0.5f, 0.5f, 0.0f,
-			0.5f, 0.5f, 0.0f,
-			0.5f, -0.5f, 0.0f,
-			-0.5f, -0.5f, 0.0f
-		};
-
-		unsigned short rectangleIndexData[] = { 0, 1, 1, 2, 2, 3, 3, 0 };
-
-		ModelCreateInfo modelInfo;
-		modelInfo.vertexFormat = vertexFormatPos;
-		modelInfo.primitiveMode = RenderPrimitiveMode::Lines;
-		modelInfo.vertexData = rectangleVertexData;
-		modelInfo.vertexDataSize = sizeof(rectangleVertexData);
-		modelInfo.vertexCount = sizeof(rectangleVertexData) / (sizeof(rectangleVertexData[0]) * 3);
-		modelInfo.indexData = rectangleIndexData;
-		modelInfo.indexDataSize = sizeof(rectangleIndexData);
-		modelInfo.indexCount = sizeof(rectangleIndexData) / sizeof(rectangleIndexData[0]);
-		modelInfo.indexType = RenderIndexType::UnsignedShort;
-
-		ModelId& rectangleMeshId = staticMeshes[static_cast<unsigned int>(PrimitiveType::Rectangle)];
-		rectangleMeshId = modelManager->CreateModel(modelInfo);
+		uint32_t first = ring * SphereRingPointCount;
+
+		for (uint32_t i = 0; i < SphereRingPointCount; ++i)
+		{
+			sphereLineIndices[(first + i) * 2 + 0] = static_cast<uint16_t>(first + i);
+			sphereLineIndices[(first + i) * 2 + 1] = static_cast<uint16_t>(first + (i + 1) % SphereRingPointCount);
+		}
 	}
 }
 
 void DebugVectorRenderer::Deinitialize()
 {
-	allocator->Deallocate(primitives);
-	primitives = nullptr;
+	for (auto& spaceVertices : vertices)
+		spaceVertices.Clear();
 
-	if (meshesInitialized)
+	if (vertexArrayId != 0)
 	{
-		for (unsigned int i = 0; i < 4; ++i)
-			modelManager->RemoveModel(staticMeshes[i]);
+		renderDevice->DestroyVertexArrays(1, &vertexArrayId);
+		vertexArrayId = render::VertexArrayId();
+	}
 
-		meshesInitialized = false;
+	if (vertexBufferId != 0)
+	{
+		renderDevice->DestroyBuffers(1, &vertexBufferId);
+		vertexBufferId = render::BufferId();
+		vertexBufferCapacity = 0;
 	}
 
 	if (uniformBufferId != 0)
 	{
 		renderDevice->DestroyBuffers(1, &uniformBufferId);
 		uniformBufferId = render::BufferId();
-		bufferPrimitivesAllocated = 0;
 	}
 }
 
-void DebugVectorRenderer::DrawLineScreen(const Vec2f& start, const Vec2f& end, const Color& color)
+void DebugVectorRenderer::AddLines(Space space, const Mat4x4f& transform, const Vec3f* points, uint32_t pointCount,
+	const uint16_t* indices, uint32_t indexCount, const Color& color)
 {
-	if (primitiveCount < primitiveAllocated)
-	{
-		Vec3f start3(start.x, start.y, 0.0f);
-		Vec3f end3(end.x, end.y, 0.0f);
-		float len = (end3 - start3).Magnitude();
+	Vec3f transformed[SpherePointCount];
+	assert(pointCount <= SpherePointCount);
+
+	for (uint32_t i = 0; i < pointCount; ++i)
+		transformed[i] = (transform * Vec4f(points[i], 1.0f)).xyz();
 
-		Primitive* prim = primitives + primitiveCount;
-		prim->screenSpace = true;
-		prim->type = PrimitiveType::Line;
-		prim->transform = Mat4x4f::LookAt(start3, end3, Vec3f(0.0f, 0.0f, 1.0f)) * Mat4x4f::Scale(len);
-		prim->color = color;
+	Array<LineVertex>& spaceVertices = vertices[static_cast<size_t>(space)];
+	size_t first = spaceVertices.GetCount();
+	spaceVertices.Resize(first + indexCount);
 
-		++primitiveCount;
+	LineVertex* dest = spaceVertices.GetData() + first;
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		dest[i].position = transformed[indices[i]];
+		dest[i].color = color;
 	}
 }
 
-void DebugVectorRenderer::DrawLine(const Vec3f& start, const Vec3f& end, const Color& color)
+void DebugVectorRenderer::DrawLineScreen(const Vec2f& start, const Vec2f& end, const Color& color)
 {
-	if (primitiveCount < primitiveAllocated)
-	{
-		Vec3f dir = end - start;
-		float len = dir.Magnitude();
-		Vec3f up = std::abs(dir.y / len) < 0.9f ? Vec3f(0.0f, 1.0f, 0.0f) : Vec3f(1.0f, 0.0f, 0.0f);
-
-		Primitive* prim = primitives + primitiveCount;
-		prim->screenSpace = false;
-		prim->type = PrimitiveType::Line;
-		prim->transform = Mat4x4f::LookAt(start, end, up) * Mat4x4f::Scale(len);
-		prim->color = color;
+	Vec3f points[] = { Vec3f(start.x, start.y, 0.0f), Vec3f(end.x, end.y, 0.0f) };
+	AddLines(Space::Screen, Mat4x4f(), points, 2, SingleLineIndices, 2, color);
+}
 
-		++primitiveCount;
-	}
+void DebugVectorRenderer::DrawLine(const Vec3f& start, const Vec3f& end, const Color& color)
+{
+	Vec3f points[] = { start, end };
+	AddLines(Space::World, Mat4x4f(), points, 2, SingleLineIndices, 2, color);
 }
 
 void DebugVectorRenderer::DrawWireCube(const Mat4x4f& transform, const Color& color)
 {
-	if (primitiveCount < primitiveAllocated)
-	{
-		Primitive* prim = primitives + primitiveCount;
-		prim->screenSpace = false;
-		prim->type = PrimitiveType::WireCube;
-		prim->transform = transform;
-		prim->color = color;
-
-		++primitiveCount;
-	}
+	AddLines(Space::World, transform, CubePoints, KOKKO_ARRAY_ITEMS(CubePoints),
+		CubeLineIndices, KOKKO_ARRAY_ITEMS(CubeLineIndices), color);
 }
 
 void DebugVectorRenderer::DrawWireSphere(const Vec3f& position, float radius, const Color& color)
 {
-	if (primitiveCount < primitiveAllocated)
-	{
-		Primitive* prim = primitives + primitiveCount;
-		prim->screenSpace = false;
-		prim->type = PrimitiveType::WireSphere;
-		prim->transform = Mat4x4f::Translate(position) * Mat4x4f::Scale(radius);
-		prim->color = color;
+	Mat4x4f transform = Mat4x4f::Translate(position) * Mat4x4f::Scale(radius);
 
-		++primitiveCount;
-	}
+	AddLines(Space::World, transform, spherePoints, SpherePointCount,
+		sphereLineIndices, SphereLineIndexCount, color);
 }
 
 void DebugVectorRenderer::DrawRectangleScreen(const Rectanglef& rectangle, const Color& color)
 {
-	if (primitiveCount < primitiveAllocated)
-	{
-		Vec2f center = rectangle.position + rectangle.size * 0.5f;
-		Vec3f center3(center.x, center.y, 0.0f);
-		Vec3f scale(rectangle.size.x, rectangle.size.y, 1.0f);
-
-		Primitive* prim = primitives + primitiveCount;
-		prim->screenSpace = true;
-		prim->type = PrimitiveType::Rectangle;
-		prim->transform = Mat4x4f::Translate(center3) * Mat4x4f::Scale(scale);
-		prim->color = color;
+	Vec2f center = rectangle.position + rectangle.size * 0.5f;
+	Vec3f center3(center.x, center.y, 0.0f);
+	Vec3f scale(rectangle.size.x, rectangle.size.y, 1.0f);
+	Mat4x4f transform = Mat4x4f::Translate(center3) * Mat4x4f::Scale(scale);
 
-		++primitiveCount;
-	}
+	AddLines(Space::Screen, transform, RectanglePoints, KOKKO_ARRAY_ITEMS(RectanglePoints),
+		RectangleLineIndices, KOKKO_ARRAY_ITEMS(RectangleLineIndices), color);
 }
 
 void DebugVectorRenderer::DrawWireFrustum(const Mat4x4f& transform, const ProjectionParameters& projection, const Color& color)
@@ -324,27 +236,28 @@ void DebugVectorRenderer::DrawWireFrustum(const Mat4x4f& transform, const Projec
 	FrustumPoints frustum;
 	frustum.Update(projection, transform);
 
-	this->DrawLine(frustum.points[0], frustum.points[1], color);
-	this->DrawLine(frustum.points[0], frustum.points[2], color);
-	this->DrawLine(frustum.points[1], frustum.points[3], color);
-	this->DrawLine(frustum.points[2], frustum.points[3], color);
-
-	this->DrawLine(frustum.points[0], frustum.points[4], color);
-	this->DrawLine(frustum.points[1], frustum.points[5], color);
-	this->DrawLine(frustum.points[2], frustum.points[6], color);
-	this->DrawLine(frustum.points[3], frustum.points[7], color);
+	static const uint16_t frustumLineIndices[] = {
+		0, 1, 0, 2, 1, 3, 2, 3,
+		0, 4, 1, 5, 2, 6, 3, 7,
+		4, 5, 4, 6, 5, 7, 6, 7
+	};
 
-	this->DrawLine(frustum.points[4], frustum.points[5], color);
-	this->DrawLine(frustum.points[4], frustum.points[6], color);
-	this->DrawLine(frustum.points[5], frustum.points[7], color);
-	this->DrawLine(frustum.points[6], frustum.points[7], color);
+	AddLines(Space::World, Mat4x4f(), frustum.points, KOKKO_ARRAY_ITEMS(frustum.points),
+		frustumLineIndices, KOKKO_ARRAY_ITEMS(frustumLineIndices), color);
 }
 
 void DebugVectorRenderer::Render(kokko::render::CommandEncoder* encoder, World* world, const ViewRectangle& viewport, const Optional<CameraParameters>& editorCamera)
 {
 	KOKKO_PROFILE_FUNCTION();
 
-	if (primitiveCount > 0)
+	Array<LineVertex>& worldVertices = vertices[static_cast<size_t>(Space::World)];
+	Array<LineVertex>& screenVertices = vertices[static_cast<size_t>(Space::Screen)];
+
+	uint32_t worldVertexCount = static_cast<uint32_t>(worldVertices.GetCount());
+	uint32_t screenVertexCount = static_cast<uint32_t>(screenVertices.GetCount());
+	uint32_t totalVertexCount = worldVertexCount + screenVertexCount;
+
+	if (totalVertexCount > 0)
 	{
 		Mat4x4f viewProj;
 		Mat4x4f screenProj = Mat4x4f::ScreenSpaceProjection(viewport.size);
@@ -383,43 +296,44 @@ void DebugVectorRenderer::Render(kokko::render::CommandEncoder* encoder, World*
 			viewProj = proj * view;
 		}
 
-		DebugVectorBlock objectUniforms;
-
 		{
 			auto scope = renderDevice->CreateDebugScope(0, kokko::ConstStringView("DebugVec_Upload"));
 
-			if (bufferPrimitivesAllocated != 0 && primitiveCount > bufferPrimitivesAllocated)
+			if (totalVertexCount > vertexBufferCapacity)
 			{
-				renderDevice->DestroyBuffers(1, &uniformBufferId);
-				uniformBufferId = kokko::render::BufferId();
-				bufferPrimitivesAllocated = 0;
-			}
+				if (vertexBufferId != 0)
+					renderDevice->DestroyBuffers(1, &vertexBufferId);
 
-			if (uniformBufferId == 0)
-			{
-				bufferPrimitivesAllocated = primitiveCount;
-				uint32_t size = bufferAlignedSize * bufferPrimitivesAllocated;
+				vertexBufferCapacity = std::max(vertexBufferCapacity * 2, InitialVertexBufferCapacity);
+				while (vertexBufferCapacity < totalVertexCount)
+					vertexBufferCapacity *= 2;
+
+				uint32_t size = vertexBufferCapacity * sizeof(LineVertex);
 
-				renderDevice->CreateBuffers(1, &uniformBufferId);
-				renderDevice->SetBufferStorage(uniformBufferId, size, nullptr, BufferStorageFlags::Dynamic);
+				renderDevice->CreateBuffers(1, &vertexBufferId);
+				renderDevice->SetBufferStorage(vertexBufferId, size, nullptr, BufferStorageFlags::Dynamic);
+				renderDevice->SetVertexArrayVertexBuffer(vertexArrayId, 0, vertexBufferId, 0, sizeof(LineVertex));
 			}
 
-			for (unsigned int i = 0; i < primitiveCount; ++i)
-			{
-				const Primitive& primitive = primitives[i];
+			// World space vertices are followed by screen space vertices
 
-				// Use view or screen based transform depending on whether this is a screen-space primitive
-				Mat4x4f mvp = (primitive.screenSpace ? screenProj : viewProj) * primitive.transform;
+			if (worldVertexCount > 0)
+				renderDevice->SetBufferSubData(vertexBufferId, 0,
+					worldVertexCount * sizeof(LineVertex), worldVertices.GetData());
 
-				// Update uniform buffer
+			if (screenVertexCount > 0)
+				renderDevice->SetBufferSubData(vertexBufferId, worldVertexCount * sizeof(LineVertex),
+					screenVertexCount * sizeof(LineVertex), screenVertices.GetData());
 
-				objectUniforms.transform = mvp;
-				Vec4f colorVec4(primitive.color.r, primitive.color.g, primitive.color.b, primitive.color.a);
-				objectUniforms.color = colorVec4;
+			DebugVectorBlock uniforms;
 
-				uint32_t offset = bufferAlignedSize * i;
-				renderDevice->SetBufferSubData(uniformBufferId, offset, sizeof(DebugVectorBlock), &objectUniforms);
-			}
+			uniforms.transform = viewProj;
+			uint32_t worldOffset = uniformBlockStride * static_cast<uint32_t>(Space::World);
+			renderDevice->SetBufferSubData(uniformBufferId, worldOffset, sizeof(DebugVectorBlock), &uniforms);
+
+			uniforms.transform = screenProj;
+			uint32_t screenOffset = uniformBlockStride * static_cast<uint32_t>(Space::Screen);
+			renderDevice->SetBufferSubData(uniformBufferId, screenOffset, sizeof(DebugVectorBlock), &uniforms);
 		}
 
 		{
@@ -435,33 +349,28 @@ void DebugVectorRenderer::Render(kokko::render::CommandEncoder* encoder, World*
 			encoder->SetViewport(viewport.position.x, viewport.position.y, viewport.size.x, viewport.size.y);
 
 			encoder->UseShaderProgram(shader.driverId);
+			encoder->BindVertexArray(vertexArrayId);
 
-			// FIXME: A single buffer can no longer be shared between draw calls
+			uint32_t firstVertex = 0;
 
-			for (unsigned int i = 0; i < primitiveCount; ++i)
+			for (uint32_t space = 0; space < static_cast<uint32_t>(Space::Count); ++space)
 			{
-				const Primitive& primitive = primitives[i];
-
-				uint32_t offset = bufferAlignedSize * i;
-				encoder->BindBufferRange(RenderBufferTarget::UniformBuffer, UniformBlockBinding::Object,
-					uniformBufferId, offset, sizeof(DebugVectorBlock));
+				uint32_t count = static_cast<uint32_t>(vertices[space].GetCount());
 
-				// Draw
+				if (count > 0)
+				{
+					encoder->BindBufferRange(RenderBufferTarget::UniformBuffer, UniformBlockBinding::Object,
+						uniformBufferId, uniformBlockStride * space, sizeof(DebugVectorBlock));
 
-				ModelId meshId = staticMeshes[static_cast<unsigned int>(primitive.type)];
-				auto& mesh = modelManager->GetModelMeshes(meshId)[0];
-				auto& part = modelManager->GetModelMeshParts(meshId)[0];
-				encoder->BindVertexArray(part.vertexArrayId);
+					encoder->Draw(RenderPrimitiveMode::Lines, firstVertex, count);
+				}
 
-				if (mesh.indexType != RenderIndexType::None)
-					encoder->DrawIndexed(mesh.primitiveMode, mesh.indexType, part.count, part.indexOffset, 0);
-				else
-					encoder->Draw(mesh.primitiveMode, 0, part.count);
+				firstVertex += count;
 			}
 		}
 
-		// Clear primitive count
-		primitiveCount = 0;
+		for (auto& spaceVertices : vertices)
+			spaceVertices.Clear();
 	}
 }
 
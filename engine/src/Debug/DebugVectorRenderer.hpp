@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 
+#include "Core/Array.hpp"
 #include "Core/Color.hpp"
 #include "Core/Optional.hpp"
 
@@ -13,7 +15,6 @@
 
 #include "Rendering/RenderResourceId.hpp"
 
-#include "Resources/MeshId.hpp"
 #include "Resources/ShaderId.hpp"
 
 namespace kokko
@@ -23,7 +24,6 @@ struct Entity;
 struct CameraParameters;
 
 class Allocator;
-class ModelManager;
 class ShaderManager;
 class Window;
 class World;
@@ -34,49 +34,56 @@ class CommandEncoder;
 class Device;
 }
 
+/*
+* Primitives are expanded into line vertices as they are added. All vertices of a frame
+* are uploaded into one streaming vertex buffer and drawn with one call per space.
+*/
 class DebugVectorRenderer
 {
 private:
-	enum class PrimitiveType
+	enum class Space
 	{
-		// Static
-		Line,
-		WireCube,
-		WireSphere,
-		Rectangle
+		World,
+		Screen,
+
+		Count
 	};
 
-	struct Primitive
+	struct LineVertex
 	{
-		Mat4x4f transform;
+		Vec3f position;
 		Color color;
-		PrimitiveType type;
-		bool screenSpace;
 	};
 
+	static const uint32_t SpherePointCount = 72;
+	static const uint32_t SphereLineIndexCount = 144;
+
+	void AddLines(Space space, const Mat4x4f& transform, const Vec3f* points, uint32_t pointCount,
+		const uint16_t* indices, uint32_t indexCount, const Color& color);
+
 	Allocator* allocator;
 	render::Device* renderDevice;
-	ModelManager* modelManager;
 	ShaderManager* shaderManager;
 
-	Primitive* primitives;
-	unsigned int primitiveCount;
-	unsigned int primitiveAllocated;
+	Array<LineVertex> vertices[static_cast<size_t>(Space::Count)];
 
-	bool meshesInitialized;
-	ModelId staticMeshes[4];
+	Vec3f spherePoints[SpherePointCount];
+	uint16_t sphereLineIndices[SphereLineIndexCount];
 
 	ShaderId shaderId;
 
 	render::BufferId uniformBufferId;
-	uint32_t bufferPrimitivesAllocated;
-	uint32_t bufferAlignedSize;
+	uint32_t uniformBlockStride;
+
+	render::VertexArrayId vertexArrayId;
+	render::BufferId vertexBufferId;
+	uint32_t vertexBufferCapacity;
 
 public:
 	DebugVectorRenderer(Allocator* allocator, render::Device* renderDevice);
 	~DebugVectorRenderer();
 
-	void Initialize(ModelManager* modelManager, ShaderManager* shaderManager);
+	void Initialize(ShaderManager* shaderManager);
 	void Deinitialize();
 
 	void DrawLineScreen(const Vec2f& start, const Vec2f& end, const Color& color);
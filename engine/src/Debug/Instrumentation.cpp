@@ -64,6 +64,29 @@ void Instrumentation::WriteProfile(const char* name, double start, double end, s
 	}
 }
 
+void Instrumentation::WriteCounter(const char* name, double time, double value)
+{
+	if (fileHandle != nullptr)
+	{
+		FILE* file = static_cast<FILE*>(fileHandle);
+
+		char comma = profileCount > 0 ? ',' : ' ';
+
+		profileCount += 1;
+
+		fmt::print(
+			file,
+			FMT_STRING("{:c}{{"
+				"\"args\":{{\"value\":{:f}}},"
+				"\"name\":\"{}\","
+				"\"ph\":\"C\","
+				"\"pid\":0,"
+				"\"ts\":{:f}"
+				"}}"),
+			comma, value, name, time);
+	}
+}
+
 void Instrumentation::EndSession()
 {
 	if (fileHandle != nullptr)
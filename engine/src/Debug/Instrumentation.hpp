@@ -22,6 +22,7 @@ public:
 
 	bool BeginSession(const char* filepath);
 	void WriteProfile(const char* name, double start, double end, size_t threadId);
+	void WriteCounter(const char* name, double time, double value);
 	void EndSession();
 
 	static Instrumentation& Get()
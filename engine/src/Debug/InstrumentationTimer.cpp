@@ -37,4 +37,14 @@ void InstrumentationTimer::Stop()
 	stopped = true;
 }
 
+void InstrumentationTimer::WriteCounter(const char* name, double value)
+{
+	using namespace std::chrono;
+
+	time_point<high_resolution_clock> timepoint = high_resolution_clock::now();
+	long long nano = time_point_cast<nanoseconds>(timepoint).time_since_epoch().count();
+
+	Instrumentation::Get().WriteCounter(name, nano / 1000.0, value);
+}
+
 } // namespace kokko
@@ -17,6 +17,9 @@ public:
 	~InstrumentationTimer();
 
 	void Stop();
+
+	// Records the value of a counter at the current time
+	static void WriteCounter(const char* name, double value);
 };
 
 } // namespace kokko
@@ -1,6 +1,8 @@
 #include "Engine/Engine.hpp"
 
+#include <algorithm>
 #include <cstdio>
+#include <thread>
 #include <time.h>
 
 #include "Core/Core.hpp"
@@ -12,12 +14,15 @@
 #include "Debug/Instrumentation.hpp"
 
 #include "Engine/EntityManager.hpp"
+#include "Engine/JobSystem.hpp"
 #include "Engine/World.hpp"
 
 #include "Graphics/Scene.hpp"
 
 #include "Math/Random.hpp"
 
+#include "Memory/AllocatorManager.hpp"
+#include "Memory/FrameAllocator.hpp"
 #include "Memory/RootAllocator.hpp"
 
 #include "Platform/Window.hpp"
@@ -59,6 +64,7 @@ Engine::Engine(
 
 	Allocator* alloc = RootAllocator::GetDefaultAllocator();
 	systemAllocator = allocatorManager->CreateAllocatorScope("System", alloc);
+	frameAllocator = allocatorManager->GetFrameAllocator();
 
 	renderDevice = kokko::render::Device::Create(systemAllocator);
 	commandBuffer = kokko::MakeUnique<kokko::render::CommandBuffer>(systemAllocator, systemAllocator);
@@ -66,6 +72,13 @@ Engine::Engine(
 		systemAllocator, systemAllocator, commandBuffer.Get());
 	commandExecutor = kokko::render::CommandExecutor::Create(systemAllocator);
 
+	// The main thread also executes jobs while it waits for them
+	size_t hardwareThreads = std::thread::hardware_concurrency();
+	size_t workerCount = std::max<size_t>(hardwareThreads, 2) - 1;
+
+	jobSystem.CreateScope(allocatorManager, "JobSystem", alloc);
+	jobSystem.New(jobSystem.allocator, workerCount);
+
 	windowManager.CreateScope(allocatorManager, "Window", alloc);
 	windowManager.New(windowManager.allocator);
 
@@ -76,13 +89,13 @@ Engine::Engine(
 	debug.CreateScope(allocatorManager, "Debug", alloc);
 	debug.New(debug.allocator, allocatorManager, renderDevice, filesystem);
 
-	debugNameAllocator = allocatorManager->CreateAllocatorScope("EntityDebugNames", alloc);
+	debugNameAllocator = allocatorManager->CreateAllocatorScope("EntityDebugNames", alloc, false, true);
 
 	modelManager.CreateScope(allocatorManager, "ModelManager", alloc);
 	modelManager.New(modelManager.allocator, assetLoader, renderDevice);
 
 	textureManager.CreateScope(allocatorManager, "TextureManager", alloc);
-	textureManager.New(textureManager.allocator, assetLoader, renderDevice);
+	textureManager.New(textureManager.allocator, frameAllocator, assetLoader, renderDevice);
 
 	shaderManager.CreateScope(allocatorManager, "ShaderManager", alloc);
 	shaderManager.New(shaderManager.allocator, filesystem, assetLoader, renderDevice);
@@ -95,7 +108,7 @@ Engine::Engine(
 
 	world.CreateScope(allocatorManager, "World", alloc);
 	world.New(allocatorManager, world.allocator, debugNameAllocator, renderDevice,
-		commandEncoder.Get(), assetLoader, resManagers, &(settings.renderDebug));
+		commandEncoder.Get(), jobSystem.instance, filesystem, assetLoader, resManagers, &(settings.renderDebug));
 }
 
 Engine::~Engine()
@@ -111,6 +124,9 @@ Engine::~Engine()
 	debug.Delete();
 	windowManager.Delete();
 
+	jobSystem.instance->Deinitialize();
+	jobSystem.Delete();
+
 	systemAllocator->MakeDelete(commandExecutor);
 	systemAllocator->MakeDelete(renderDevice);
 }
@@ -124,11 +140,14 @@ bool Engine::Initialize(const kokko::WindowSettings& windowSettings)
 
 	renderDevice->InitializeDefaults();
 
+	jobSystem.instance->Initialize();
+
 	if (debug.instance->Initialize(windowManager.instance->GetWindow(), modelManager.instance,
 		shaderManager.instance, textureManager.instance) == false)
 		return false;
 
 	textureManager.instance->Initialize();
+	modelManager.instance->SetLoadOptions(settings.modelLoadOptions);
 
 	world.instance->Initialize();
 
@@ -137,6 +156,8 @@ bool Engine::Initialize(const kokko::WindowSettings& windowSettings)
 
 void Engine::StartFrame()
 {
+	modelManager.instance->SetLoadOptions(settings.modelLoadOptions);
+
 	if (debug.instance->ShouldBeginProfileSession())
 		Instrumentation::Get().BeginSession("runtime_trace.json");
 
@@ -180,6 +201,9 @@ void Engine::EndFrame()
 	window->UpdateInput();
 
 	window->SetSwapInterval(settings.verticalSync ? 1 : 0);
+
+	jobSystem.instance->EndFrame();
+	frameAllocator->EndFrame();
 }
 
 void Engine::SetAppPointer(void* app)
@@ -14,6 +14,8 @@ class AllocatorManager;
 class AssetLoader;
 class Debug;
 class Filesystem;
+class FrameAllocator;
+class JobSystem;
 class MaterialManager;
 class MeshManager;
 class ModelManager;
@@ -29,7 +31,7 @@ struct WindowSettings;
 
 namespace render
 {
-struct CommandBuffer;
+class CommandBuffer;
 class CommandEncoder;
 class CommandExecutor;
 class Device;
@@ -41,6 +43,7 @@ class Engine
 private:
 	Allocator* systemAllocator;
 	Allocator* debugNameAllocator;
+	FrameAllocator* frameAllocator;
 
 	EngineSettings settings;
 
@@ -51,6 +54,7 @@ private:
 	UniquePtr<render::CommandEncoder> commandEncoder;
 	render::CommandExecutor* commandExecutor;
 
+	InstanceAllocatorPair<JobSystem> jobSystem;
 	InstanceAllocatorPair<WindowManager> windowManager;
 	UniquePtr<Time> engineTime;
 	InstanceAllocatorPair<Debug> debug;
@@ -80,6 +84,7 @@ public:
 	WindowManager* GetWindowManager() { return windowManager.instance; }
 	render::Device* GetRenderDevice() { return renderDevice; }
 	render::CommandEncoder* GetCommandEncoder() { return commandEncoder.Get(); }
+	JobSystem* GetJobSystem() { return jobSystem.instance; }
 	Debug* GetDebug() { return debug.instance; }
 	Filesystem* GetFilesystem() { return filesystem; }
 	ModelManager* GetModelManager() { return modelManager.instance; }
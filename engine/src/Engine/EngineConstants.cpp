@@ -4,6 +4,8 @@ namespace kokko
 {
 const char* const EngineConstants::MetadataExtension = ".meta";
 const char* const EngineConstants::EngineResourcePath = "engine/res";
+const char* const EngineConstants::ShaderCachePath = "cache/shaders";
+const char* const EngineConstants::EnvironmentCachePath = "cache/environments";
 const char* const EngineConstants::VirtualMountEngine = "engine";
 const char* const EngineConstants::VirtualMountAssets = "assets";
 }
@@ -11,6 +11,12 @@ public:
 	static const char* const MetadataExtension;
 	static const char* const EngineResourcePath;
 
+	// Shader program binary cache, relative to the working directory
+	static const char* const ShaderCachePath;
+
+	// Baked environment map cache, relative to the working directory
+	static const char* const EnvironmentCachePath;
+
 	// Virtual filesystem
 
 	static const char* const VirtualMountEngine;
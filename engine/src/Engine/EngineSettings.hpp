@@ -2,6 +2,8 @@
 
 #include "Rendering/RenderDebugSettings.hpp"
 
+#include "Resources/ModelLoader.hpp"
+
 namespace kokko
 {
 
@@ -11,6 +13,9 @@ struct EngineSettings
 	bool enableDebugTools = true;
 	
 	RenderDebugSettings renderDebug;
+
+	// Applied at the start of each frame, so changes only affect models loaded after that
+	ModelLoadOptions modelLoadOptions;
 };
 
 }
@@ -16,9 +16,9 @@ struct InstanceAllocatorPair
 	{
 	}
 
-	void CreateScope(AllocatorManager* manager, const char* name, Allocator* alloc, bool tracing = false)
+	void CreateScope(AllocatorManager* manager, const char* name, Allocator* alloc, bool tracing = false, bool pooled = false)
 	{
-		allocator = manager->CreateAllocatorScope(name, alloc, tracing);
+		allocator = manager->CreateAllocatorScope(name, alloc, tracing, pooled);
 	}
 
 	template <typename... Args>
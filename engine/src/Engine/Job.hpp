@@ -9,15 +9,34 @@
 namespace kokko
 {
 
+struct JobChunk;
+
 struct Job
 {
+	static const size_t MaxContinuationCount = 4;
+
 	JobFunction function;
 	Job* parent;
 	std::atomic_size_t unfinishedJobs;
 
+	// Job is pushed to a queue when this reaches zero.
+	// Starts at one, which is released when the job is enqueued.
+	std::atomic_int32_t pendingDependencies;
+
+	// Jobs that depend on this job, released when this job and its children have finished.
+	// When more are needed, the last one is an empty relay job that holds the rest.
+	std::atomic_int32_t continuationCount;
+	Job* continuations[MaxContinuationCount];
+
+	// Allocation chunk, which can be reused once all of its jobs have finished
+	JobChunk* chunk;
+
 	static const size_t CL = KK_CACHE_LINE;
-	static const size_t MemberBytes = sizeof(JobFunction) + sizeof(Job*) + sizeof(std::atomic_size_t);
-	uint8_t data[(MemberBytes + CL - 1) / CL * CL - MemberBytes];
+	static const size_t MemberBytes = sizeof(JobFunction) + sizeof(Job*) + sizeof(std::atomic_size_t) +
+		sizeof(std::atomic_int32_t) * 2 + sizeof(Job*) * MaxContinuationCount + sizeof(JobChunk*);
+
+	// Fill out the second cache line
+	uint8_t data[2 * CL - MemberBytes];
 
 	void* GetDataAsPtr()
 	{
@@ -39,4 +58,6 @@ struct Job
 	}
 };
 
+static_assert(sizeof(Job) == 2 * KK_CACHE_LINE, "Job should take exactly two cache lines");
+
 } // namespace kokko
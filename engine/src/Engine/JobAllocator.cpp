@@ -1,47 +1,163 @@
 #include "Engine/JobAllocator.hpp"
 
 #include <cassert>
+#include <cstring>
+
+#include "doctest/doctest.h"
 
 #include "Core/Core.hpp"
 
 #include "Engine/Job.hpp"
-#include "Engine/JobSystem.hpp"
 
 #include "Memory/Allocator.hpp"
 
 namespace kokko
 {
 
-JobAllocator::JobAllocator(Allocator* allocator) :
+JobAllocator::JobAllocator(Allocator* allocator, const std::atomic_uint64_t* frameIndex) :
 	allocator(allocator),
-	jobs(nullptr),
-	jobIndex(0)
+	frameIndex(frameIndex),
+	currentChunk(nullptr),
+	chunks(allocator)
 {
-	const size_t maxJobs = JobSystem::MaxJobsPerThreadPerFrame;
-	void* buf = allocator->AllocateAligned(sizeof(Job) * maxJobs, KK_CACHE_LINE);
-	jobs = static_cast<Job*>(buf);
-
 	std::memset(padding, 0, sizeof(padding));
+
+	currentChunk = CreateChunk();
 }
 
 JobAllocator::~JobAllocator()
 {
-	allocator->Deallocate(jobs);
+	for (JobChunk* chunk : chunks)
+	{
+		assert(chunk->unfinishedCount.load() == 0);
+
+		allocator->Deallocate(chunk->jobs);
+		allocator->MakeDelete(chunk);
+	}
 }
 
 Job* JobAllocator::AllocateJob()
 {
-	size_t index = jobIndex.fetch_add(1);
+	if (currentChunk->allocatedCount == JobChunk::JobCount)
+		currentChunk = AcquireChunk();
+
+	Job* job = &currentChunk->jobs[currentChunk->allocatedCount];
+	currentChunk->allocatedCount += 1;
+	currentChunk->unfinishedCount.fetch_add(1, std::memory_order_relaxed);
+
+	job->chunk = currentChunk;
+
+	return job;
+}
+
+void JobAllocator::ReleaseJob(JobChunk* chunk)
+{
+	size_t previousCount = chunk->unfinishedCount.fetch_sub(1, std::memory_order_release);
+
+	// Detect finishing a job more times than it was allocated
+	assert(previousCount > 0);
+	(void)previousCount;
+}
+
+JobChunk* JobAllocator::AcquireChunk()
+{
+	uint64_t frame = frameIndex->load(std::memory_order_relaxed);
+
+	// The current chunk is full, so it's checked like the rest
+	for (JobChunk* chunk : chunks)
+	{
+		if (chunk->unfinishedCount.load(std::memory_order_acquire) != 0)
+		{
+			chunk->emptyFrame = NotEmpty;
+		}
+		else if (chunk->emptyFrame == NotEmpty)
+		{
+			// Jobs might still be waited on until the end of this frame
+			chunk->emptyFrame = frame;
+		}
+		else if (chunk->emptyFrame < frame)
+		{
+			chunk->allocatedCount = 0;
+			chunk->emptyFrame = NotEmpty;
+			return chunk;
+		}
+	}
+
+	return CreateChunk();
+}
+
+JobChunk* JobAllocator::CreateChunk()
+{
+	JobChunk* chunk = allocator->MakeNew<JobChunk>();
 
-	assert(index < JobSystem::MaxJobsPerThreadPerFrame);
+	void* buf = allocator->AllocateAligned(sizeof(Job) * JobChunk::JobCount, KK_CACHE_LINE, "JobChunk.jobs");
+	chunk->jobs = static_cast<Job*>(buf);
+	chunk->allocatedCount = 0;
+	chunk->unfinishedCount.store(0, std::memory_order_relaxed);
+	chunk->emptyFrame = NotEmpty;
 
-	return &jobs[index];
+	chunks.PushBack(chunk);
+
+	return chunk;
 }
 
-void JobAllocator::Reset()
+TEST_CASE("JobAllocator.ReusesChunksAfterFrameEnds")
 {
-	assert(jobIndex < JobSystem::MaxJobsPerThreadPerFrame);
-	jobIndex.store(0);
+	Allocator* allocator = Allocator::GetDefault();
+	std::atomic_uint64_t frameIndex(0);
+
+	JobAllocator jobAllocator(allocator, &frameIndex);
+
+	Job* firstJob = jobAllocator.AllocateJob();
+	JobChunk* firstChunk = firstJob->chunk;
+	JobAllocator::ReleaseJob(firstChunk);
+
+	for (size_t i = 1; i < JobChunk::JobCount; ++i)
+		JobAllocator::ReleaseJob(jobAllocator.AllocateJob()->chunk);
+
+	// First chunk is full and its jobs have finished, but the frame hasn't ended
+	Job* secondJob = jobAllocator.AllocateJob();
+	CHECK(secondJob->chunk != firstChunk);
+	JobAllocator::ReleaseJob(secondJob->chunk);
+
+	for (size_t i = 1; i < JobChunk::JobCount; ++i)
+		JobAllocator::ReleaseJob(jobAllocator.AllocateJob()->chunk);
+
+	frameIndex.store(1);
+
+	Job* reusedJob = jobAllocator.AllocateJob();
+	CHECK(reusedJob == firstJob);
+	JobAllocator::ReleaseJob(reusedJob->chunk);
+}
+
+TEST_CASE("JobAllocator.KeepsChunksWithUnfinishedJobs")
+{
+	Allocator* allocator = Allocator::GetDefault();
+	std::atomic_uint64_t frameIndex(0);
+
+	JobAllocator jobAllocator(allocator, &frameIndex);
+
+	// A long running job keeps the first chunk alive over frame boundaries
+	Job* longJob = jobAllocator.AllocateJob();
+	JobChunk* firstChunk = longJob->chunk;
+
+	for (size_t i = 1; i < JobChunk::JobCount; ++i)
+		JobAllocator::ReleaseJob(jobAllocator.AllocateJob()->chunk);
+
+	bool firstChunkReused = false;
+
+	for (size_t i = 0; i < JobChunk::JobCount * 3; ++i)
+	{
+		Job* job = jobAllocator.AllocateJob();
+		firstChunkReused = firstChunkReused || job->chunk == firstChunk;
+		JobAllocator::ReleaseJob(job->chunk);
+
+		frameIndex.fetch_add(1);
+	}
+
+	CHECK(firstChunkReused == false);
+
+	JobAllocator::ReleaseJob(longJob->chunk);
 }
 
 } // namespace kokko
@@ -1,11 +1,11 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 
+#include "Core/Array.hpp"
 #include "Core/Core.hpp"
 
-#include "Engine/JobSystem.hpp"
-
 namespace kokko
 {
 
@@ -13,23 +13,52 @@ class Allocator;
 
 struct Job;
 
+struct JobChunk
+{
+	static const size_t JobCount = 1 << 10;
+
+	Job* jobs;
+	size_t allocatedCount;
+
+	// Jobs that have been allocated from the chunk but haven't finished yet
+	std::atomic_size_t unfinishedCount;
+
+	// Frame when the chunk was first seen with all jobs finished
+	uint64_t emptyFrame;
+};
+
+/*
+* Allocates jobs for a single thread from chunks that are added as needed.
+* When the current chunk is full, the allocator switches to a chunk whose jobs have
+* all finished before an earlier frame ended, so a job and its handle stay valid
+* until the end of the frame it finishes in, even if it was started frames earlier.
+*/
 class JobAllocator
 {
 public:
-	JobAllocator(Allocator* allocator);
+	JobAllocator(Allocator* allocator, const std::atomic_uint64_t* frameIndex);
 	~JobAllocator();
 
+	// Must only be called from the thread that owns the allocator
 	Job* AllocateJob();
 
-	void Reset();
+	// Called when a job and its children have finished, from any thread
+	static void ReleaseJob(JobChunk* chunk);
 
 private:
+	JobChunk* AcquireChunk();
+	JobChunk* CreateChunk();
+
+	static const uint64_t NotEmpty = UINT64_MAX;
+
 	Allocator* allocator;
-	Job* jobs;
-	std::atomic_size_t jobIndex;
+	const std::atomic_uint64_t* frameIndex;
+	JobChunk* currentChunk;
+	Array<JobChunk*> chunks;
 
 	static const size_t CL = KK_CACHE_LINE;
-	static const size_t MemberBytes = sizeof(Allocator*) + sizeof(Job*) + sizeof(std::atomic_size_t);
+	static const size_t MemberBytes = sizeof(Allocator*) + sizeof(std::atomic_uint64_t*) +
+		sizeof(JobChunk*) + sizeof(Array<JobChunk*>);
 	uint8_t padding[(MemberBytes + CL - 1) / CL * CL - MemberBytes];
 };
 
@@ -0,0 +1,191 @@
+#include "Engine/JobGraph.hpp"
+
+#include <atomic>
+#include <cassert>
+
+#include "doctest/doctest.h"
+
+#include "Core/Core.hpp"
+
+#include "Engine/Job.hpp"
+#include "Engine/JobSystem.hpp"
+
+#include "Memory/Allocator.hpp"
+
+namespace kokko
+{
+
+JobGraph::JobGraph(Allocator* allocator) :
+	nodes(allocator),
+	edges(allocator),
+	jobs(allocator)
+{
+}
+
+JobGraph::NodeId JobGraph::AddNode(JobFunction function, void* userData)
+{
+	NodeId id = static_cast<NodeId>(nodes.GetCount());
+	nodes.PushBack(Node{ function, userData });
+	return id;
+}
+
+void JobGraph::AddDependency(NodeId node, NodeId dependency)
+{
+	assert(node < nodes.GetCount());
+	assert(dependency < node);
+
+	edges.PushBack(Edge{ node, dependency });
+}
+
+void JobGraph::Clear()
+{
+	nodes.Clear();
+	edges.Clear();
+	jobs.Clear();
+}
+
+Job* JobGraph::Run(JobSystem* jobSystem)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	// Nodes are children of the root, so waiting for the root waits for the whole graph
+	Job* root = jobSystem->CreateJob(RootJob);
+
+	jobs.Resize(nodes.GetCount());
+
+	for (size_t i = 0, count = nodes.GetCount(); i < count; ++i)
+		jobs[i] = jobSystem->CreateJobAsChildWithPtr(root, nodes[i].function, nodes[i].userData);
+
+	for (const Edge& edge : edges)
+		jobSystem->AddDependency(jobs[edge.node], jobs[edge.dependency]);
+
+	// Nodes with dependencies are only pushed to a queue once their dependencies finish
+	for (Job* job : jobs)
+		jobSystem->Enqueue(job);
+
+	jobSystem->Enqueue(root);
+
+	return root;
+}
+
+void JobGraph::RootJob(Job*, JobSystem*)
+{
+}
+
+namespace
+{
+
+struct TestGraphNode
+{
+	std::atomic_int* counter;
+	int order;
+	const TestGraphNode* dependencies[2];
+};
+
+void TestGraphNodeJob(Job* job, JobSystem*)
+{
+	TestGraphNode* node = static_cast<TestGraphNode*>(job->GetDataAsPtr());
+
+	// All dependencies must have run before this node
+	for (const TestGraphNode* dependency : node->dependencies)
+		if (dependency != nullptr)
+			CHECK(dependency->order >= 0);
+
+	node->order = node->counter->fetch_add(1);
+}
+
+} // namespace
+
+TEST_CASE("JobGraph.RunsNodesAfterDependencies")
+{
+	Allocator* allocator = Allocator::GetDefault();
+
+	JobSystem jobSystem(allocator, 3);
+	jobSystem.Initialize();
+
+	std::atomic_int counter(0);
+
+	// Diamond shaped graph with one more independent node:
+	// 0 -> 1, 0 -> 2, 1 -> 3, 2 -> 3
+	TestGraphNode testNodes[5];
+	for (TestGraphNode& node : testNodes)
+		node = TestGraphNode{ &counter, -1, { nullptr, nullptr } };
+
+	testNodes[1].dependencies[0] = &testNodes[0];
+	testNodes[2].dependencies[0] = &testNodes[0];
+	testNodes[3].dependencies[0] = &testNodes[1];
+	testNodes[3].dependencies[1] = &testNodes[2];
+
+	JobGraph graph(allocator);
+
+	JobGraph::NodeId ids[5];
+	for (int i = 0; i < 5; ++i)
+		ids[i] = graph.AddNode(TestGraphNodeJob, &testNodes[i]);
+
+	graph.AddDependency(ids[1], ids[0]);
+	graph.AddDependency(ids[2], ids[0]);
+	graph.AddDependency(ids[3], ids[1]);
+	graph.AddDependency(ids[3], ids[2]);
+
+	// Run the same graph over several frames
+	for (int frame = 0; frame < 3; ++frame)
+	{
+		counter.store(0);
+		for (TestGraphNode& node : testNodes)
+			node.order = -1;
+
+		Job* job = graph.Run(&jobSystem);
+		jobSystem.Wait(job);
+
+		CHECK(counter.load() == 5);
+		CHECK(testNodes[0].order < testNodes[1].order);
+		CHECK(testNodes[0].order < testNodes[2].order);
+		CHECK(testNodes[1].order < testNodes[3].order);
+		CHECK(testNodes[2].order < testNodes[3].order);
+		CHECK(testNodes[4].order >= 0);
+
+		jobSystem.EndFrame();
+	}
+
+	jobSystem.Deinitialize();
+}
+
+TEST_CASE("JobGraph.ManyDependents")
+{
+	Allocator* allocator = Allocator::GetDefault();
+
+	JobSystem jobSystem(allocator, 3);
+	jobSystem.Initialize();
+
+	std::atomic_int counter(0);
+
+	// More dependents than fit in the continuations of a single job
+	constexpr int NodeCount = 4 * Job::MaxContinuationCount + 2;
+	TestGraphNode testNodes[NodeCount];
+	for (TestGraphNode& node : testNodes)
+		node = TestGraphNode{ &counter, -1, { nullptr, nullptr } };
+
+	JobGraph graph(allocator);
+
+	JobGraph::NodeId ids[NodeCount];
+	for (int i = 0; i < NodeCount; ++i)
+		ids[i] = graph.AddNode(TestGraphNodeJob, &testNodes[i]);
+
+	for (int i = 1; i < NodeCount; ++i)
+	{
+		testNodes[i].dependencies[0] = &testNodes[0];
+		graph.AddDependency(ids[i], ids[0]);
+	}
+
+	Job* job = graph.Run(&jobSystem);
+	jobSystem.Wait(job);
+
+	CHECK(counter.load() == NodeCount);
+	for (int i = 1; i < NodeCount; ++i)
+		CHECK(testNodes[0].order < testNodes[i].order);
+
+	jobSystem.EndFrame();
+	jobSystem.Deinitialize();
+}
+
+} // namespace kokko
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Core/Array.hpp"
+
+#include "Engine/JobFunction.hpp"
+
+namespace kokko
+{
+
+class Allocator;
+class JobSystem;
+
+struct Job;
+
+/*
+* Describes a set of jobs and the dependencies between them once, so the same graph
+* can be run every frame. Nodes whose dependencies have finished run in parallel,
+* so independent stages overlap instead of being serialized with JobSystem::Wait.
+* Nodes must be added in dependency order, which also rules out cycles.
+*/
+class JobGraph
+{
+public:
+	using NodeId = uint32_t;
+
+	explicit JobGraph(Allocator* allocator);
+
+	// The node function gets userData through Job::GetDataAsPtr
+	NodeId AddNode(JobFunction function, void* userData);
+
+	// Node will start after dependency has finished. Dependency must be added before node.
+	// A node can have any number of dependents.
+	void AddDependency(NodeId node, NodeId dependency);
+
+	void Clear();
+
+	uint32_t GetNodeCount() const { return static_cast<uint32_t>(nodes.GetCount()); }
+
+	// Enqueues every node of the graph. The returned job finishes when all nodes have finished.
+	Job* Run(JobSystem* jobSystem);
+
+private:
+	struct Node
+	{
+		JobFunction function;
+		void* userData;
+	};
+
+	struct Edge
+	{
+		NodeId node;
+		NodeId dependency;
+	};
+
+	static void RootJob(Job* job, JobSystem* jobSystem);
+
+	Array<Node> nodes;
+	Array<Edge> edges;
+	Array<Job*> jobs;
+};
+
+} // namespace kokko
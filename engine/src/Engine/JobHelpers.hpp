@@ -1,7 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+#include "Core/Core.hpp"
+
 #include "Engine/JobSystem.hpp"
 
+#include "Memory/Allocator.hpp"
+
 namespace kokko
 {
 
@@ -23,7 +31,187 @@ public:
 		return jobSystem->CreateJobWithData(ParallelForJob<JobData>, jobData);
 	}
 
+	/*
+	* Calls function(begin, end) on subranges of [begin, end) and waits until all have finished.
+	* Ranges are split lazily: a job only gives away half of its remaining range when its
+	* thread has no other queued work for idle workers to steal, otherwise it keeps processing
+	* grainSize items at a time. The function can be a capturing lambda, since it's only
+	* referenced until this call returns.
+	*/
+	template <typename Function>
+	static void ParallelFor(JobSystem* jobSystem, size_t begin, size_t end, size_t grainSize, const Function& function)
+	{
+		if (begin >= end)
+			return;
+
+		const RangeContext<Function> context{ &function, grainSize > 0 ? grainSize : 1 };
+		const RangeData rangeData{ &context, begin, end };
+
+		Job* job = jobSystem->CreateJobWithData(RangeJob<Function>, rangeData);
+		jobSystem->Enqueue(job);
+		jobSystem->Wait(job);
+	}
+
+	/*
+	* Reduces [begin, end) in parallel. function(begin, end) returns the value of a subrange,
+	* and values are combined with combine(a, b), which must be associative and commutative,
+	* because each thread accumulates the subranges it happens to process.
+	*/
+	template <typename T, typename Function, typename Combine>
+	static T ParallelReduce(JobSystem* jobSystem, size_t begin, size_t end, size_t grainSize,
+		const T& identity, const Function& function, const Combine& combine)
+	{
+		const size_t threadCount = jobSystem->GetThreadCount();
+		Allocator* allocator = jobSystem->GetAllocator();
+
+		void* buf = allocator->AllocateAligned(sizeof(ReduceSlot<T>) * threadCount, KK_CACHE_LINE);
+		ReduceSlot<T>* slots = static_cast<ReduceSlot<T>*>(buf);
+
+		for (size_t i = 0; i < threadCount; ++i)
+			new (&slots[i]) ReduceSlot<T>{ identity };
+
+		ParallelFor(jobSystem, begin, end, grainSize, [&](size_t rangeBegin, size_t rangeEnd)
+		{
+			T& value = slots[JobSystem::currentThreadIndex].value;
+			value = combine(value, function(rangeBegin, rangeEnd));
+		});
+
+		T result = identity;
+
+		for (size_t i = 0; i < threadCount; ++i)
+		{
+			result = combine(result, slots[i].value);
+			slots[i].~ReduceSlot<T>();
+		}
+
+		allocator->Deallocate(buf);
+
+		return result;
+	}
+
+	/*
+	* Writes the inclusive prefix combination of input to output, so that
+	* output[i] = combine(input[0], ..., input[i]). combine must be associative.
+	* Input is split into blocks of at least grainSize items. Block totals are computed
+	* in parallel, scanned on the calling thread and then used as offsets for the blocks.
+	*/
+	template <typename T, typename Combine>
+	static void ParallelScan(JobSystem* jobSystem, const T* input, T* output, size_t count, size_t grainSize,
+		const T& identity, const Combine& combine)
+	{
+		if (count == 0)
+			return;
+
+		// A few blocks per thread balances load without making the serial part expensive
+		const size_t maxBlockCount = jobSystem->GetThreadCount() * 4;
+		const size_t minBlockSize = grainSize > 0 ? grainSize : 1;
+		const size_t blockSize = std::max(minBlockSize, (count + maxBlockCount - 1) / maxBlockCount);
+		const size_t blockCount = (count + blockSize - 1) / blockSize;
+
+		Allocator* allocator = jobSystem->GetAllocator();
+		T* blockOffsets = static_cast<T*>(allocator->Allocate(sizeof(T) * blockCount));
+
+		for (size_t i = 0; i < blockCount; ++i)
+			new (&blockOffsets[i]) T(identity);
+
+		ParallelFor(jobSystem, 0, blockCount, 1, [&](size_t blockBegin, size_t blockEnd)
+		{
+			for (size_t block = blockBegin; block < blockEnd; ++block)
+			{
+				size_t itemEnd = std::min((block + 1) * blockSize, count);
+
+				T total = identity;
+				for (size_t i = block * blockSize; i < itemEnd; ++i)
+					total = combine(total, input[i]);
+
+				blockOffsets[block] = total;
+			}
+		});
+
+		// Exclusive scan of the block totals
+		T runningTotal = identity;
+		for (size_t i = 0; i < blockCount; ++i)
+		{
+			T blockTotal = blockOffsets[i];
+			blockOffsets[i] = runningTotal;
+			runningTotal = combine(runningTotal, blockTotal);
+		}
+
+		ParallelFor(jobSystem, 0, blockCount, 1, [&](size_t blockBegin, size_t blockEnd)
+		{
+			for (size_t block = blockBegin; block < blockEnd; ++block)
+			{
+				size_t itemEnd = std::min((block + 1) * blockSize, count);
+
+				T total = blockOffsets[block];
+				for (size_t i = block * blockSize; i < itemEnd; ++i)
+				{
+					total = combine(total, input[i]);
+					output[i] = total;
+				}
+			}
+		});
+
+		for (size_t i = 0; i < blockCount; ++i)
+			blockOffsets[i].~T();
+
+		allocator->Deallocate(blockOffsets);
+	}
+
 private:
+	template <typename Function>
+	struct RangeContext
+	{
+		const Function* function;
+		size_t grainSize;
+	};
+
+	struct RangeData
+	{
+		const void* context;
+		size_t begin;
+		size_t end;
+	};
+
+	template <typename T>
+	struct alignas(KK_CACHE_LINE) ReduceSlot
+	{
+		T value;
+	};
+
+	template <typename Function>
+	static void RangeJob(Job* job, JobSystem* jobSystem)
+	{
+		const RangeData* data = job->GetPtrToData<RangeData>();
+		const RangeContext<Function>* context = static_cast<const RangeContext<Function>*>(data->context);
+		const size_t grainSize = context->grainSize;
+
+		size_t begin = data->begin;
+		size_t end = data->end;
+
+		while (end - begin > grainSize)
+		{
+			if (jobSystem->IsCurrentThreadQueueEmpty())
+			{
+				// Nothing to steal from this thread, give away the upper half of the range
+				size_t middle = begin + (end - begin) / 2;
+
+				const RangeData rightData{ context, middle, end };
+				Job* right = jobSystem->CreateJobAsChildWithData(job, RangeJob<Function>, rightData);
+				jobSystem->Enqueue(right);
+
+				end = middle;
+			}
+			else
+			{
+				(*context->function)(begin, begin + grainSize);
+				begin += grainSize;
+			}
+		}
+
+		(*context->function)(begin, end);
+	}
+
 	template <typename InstanceData, typename ConstantData>
 	struct ParallerForJobData
 	{
@@ -1,6 +1,9 @@
 #include "Engine/JobQueue.hpp"
 
 #include <cassert>
+#include <cstdint>
+
+#include "doctest/doctest.h"
 
 #include "Core/Core.hpp"
 
@@ -17,23 +20,39 @@ namespace kokko
 
 JobQueue::JobQueue(Allocator* allocator) :
 	allocator(allocator),
-	jobs(nullptr),
+	buffer(nullptr),
 	top(0),
 	bottom(0)
 {
 	std::memset(padding, 0, sizeof(padding));
-	jobs = static_cast<Job**>(allocator->Allocate(MaxJobCount * sizeof(Job), "JobQueue.jobs"));
+	buffer.store(CreateBuffer(InitialCapacity), std::memory_order_relaxed);
 }
 
 JobQueue::~JobQueue()
 {
-	allocator->Deallocate(jobs);
+	Buffer* buf = buffer.load(std::memory_order_relaxed);
+
+	while (buf != nullptr)
+	{
+		Buffer* previous = buf->previous;
+		allocator->Deallocate(buf);
+		buf = previous;
+	}
 }
 
 void JobQueue::Push(Job* job)
 {
 	int64_t b = bottom.load(std::memory_order_relaxed);
-	jobs[b & JobIndexMask] = job;
+	int64_t t = top.load(std::memory_order_acquire);
+	Buffer* buf = buffer.load(std::memory_order_relaxed);
+
+	if (b - t >= buf->capacity)
+		buf = Grow(buf, t, b);
+
+	// Slots between top and bottom must never be overwritten
+	assert(b - t < buf->capacity);
+
+	buf->jobs[b & (buf->capacity - 1)] = job;
 
 	// Atomic store ensures the job is written before b+1 is published to other threads
 	// Release semantics prevent memory reordering of operations preceding this
@@ -50,7 +69,9 @@ Job* JobQueue::Pop()
 	if (t <= b)
 	{
 		// Queue is not empty since t<=b
-		Job* job = jobs[b & JobIndexMask];
+		// Only the owning thread replaces the buffer, so relaxed ordering is enough
+		Buffer* buf = buffer.load(std::memory_order_relaxed);
+		Job* job = buf->jobs[b & (buf->capacity - 1)];
 		if (t != b)
 		{
 			// There's still more than one item left in the queue
@@ -91,7 +112,10 @@ Job* JobQueue::Steal()
 
 	if (t < b) // Queue is not empty
 	{
-		Job* job = jobs[t & JobIndexMask];
+		// Acquire ordering ensures the contents of a newly grown buffer are visible.
+		// If the buffer has been replaced, the old one still holds the job at t.
+		Buffer* buf = buffer.load(std::memory_order_acquire);
+		Job* job = buf->jobs[t & (buf->capacity - 1)];
 
 		// Compare-exchange operation with release ordering guarantees that
 		// the jobs array read happens before it
@@ -116,4 +140,65 @@ bool JobQueue::HasWork() const
 	return top.load() != bottom.load();
 }
 
+JobQueue::Buffer* JobQueue::CreateBuffer(int64_t capacity)
+{
+	// Capacity must be a power of two so indices can be masked
+	assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+
+	// Buffer header and the job array are allocated together
+	size_t size = sizeof(Buffer) + sizeof(Job*) * capacity;
+	void* mem = allocator->Allocate(size, "JobQueue.Buffer");
+
+	Buffer* buf = static_cast<Buffer*>(mem);
+	buf->jobs = reinterpret_cast<Job**>(buf + 1);
+	buf->capacity = capacity;
+	buf->previous = nullptr;
+
+	return buf;
+}
+
+JobQueue::Buffer* JobQueue::Grow(Buffer* oldBuffer, int64_t t, int64_t b)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	Buffer* newBuffer = CreateBuffer(oldBuffer->capacity * 2);
+	newBuffer->previous = oldBuffer;
+
+	for (int64_t i = t; i < b; ++i)
+		newBuffer->jobs[i & (newBuffer->capacity - 1)] = oldBuffer->jobs[i & (oldBuffer->capacity - 1)];
+
+	// Release ordering publishes the copied jobs to stealing threads
+	buffer.store(newBuffer, std::memory_order_release);
+
+	return newBuffer;
+}
+
+TEST_CASE("JobQueue.GrowsWhenFull")
+{
+	JobQueue queue(Allocator::GetDefault());
+
+	// Jobs are never dereferenced, so fake addresses are enough
+	auto job = [](size_t index) { return reinterpret_cast<Job*>((index + 1) * KK_CACHE_LINE); };
+
+	constexpr size_t JobCount = 5000;
+
+	for (size_t i = 0; i < JobCount; ++i)
+		queue.Push(job(i));
+
+	// Steal takes from the top, which moves the live range within the buffer before it grows again
+	CHECK(queue.Steal() == job(0));
+
+	for (size_t i = 0; i < JobCount; ++i)
+		queue.Push(job(JobCount + i));
+
+	bool orderMatches = true;
+	for (size_t i = JobCount * 2; i > 1; --i)
+		if (queue.Pop() != job(i - 1))
+			orderMatches = false;
+
+	CHECK(orderMatches);
+	CHECK(queue.Pop() == nullptr);
+	CHECK(queue.HasWork() == false);
+}
+
 } // namespace kokko
@@ -18,23 +18,38 @@ public:
 	JobQueue(Allocator* allocator);
 	~JobQueue();
 
+	// Must only be called from the thread that owns the queue, grows the queue if it's full
 	void Push(Job* job);
+
+	// Must only be called from the thread that owns the queue
 	Job* Pop();
+
 	Job* Steal();
 
 	bool HasWork() const;
 
 private:
-	static const size_t MaxJobCount = 1 << 12;
-	static const size_t JobIndexMask = MaxJobCount - 1;
+	static const int64_t InitialCapacity = 1 << 10;
+
+	// Circular buffer of jobs. Buffers are kept until the queue is destroyed,
+	// because other threads might still be stealing from a buffer that has been replaced.
+	struct Buffer
+	{
+		Job** jobs;
+		int64_t capacity;
+		Buffer* previous;
+	};
+
+	Buffer* CreateBuffer(int64_t capacity);
+	Buffer* Grow(Buffer* buffer, int64_t top, int64_t bottom);
 
 	Allocator* allocator;
-	Job** jobs;
+	std::atomic<Buffer*> buffer;
 	std::atomic_int64_t top;
 	std::atomic_int64_t bottom;
 
 	static const size_t CL = KK_CACHE_LINE;
-	static const size_t MemberBytes = sizeof(Allocator*) + sizeof(Job**) + sizeof(long) * 2;
+	static const size_t MemberBytes = sizeof(Allocator*) + sizeof(std::atomic<Buffer*>) + sizeof(int64_t) * 2;
 	uint8_t padding[(MemberBytes + CL - 1) / CL * CL - MemberBytes];
 };
 
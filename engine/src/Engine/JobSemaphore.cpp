@@ -0,0 +1,144 @@
+#include "Engine/JobSemaphore.hpp"
+
+#include <thread>
+
+#if defined(__linux__)
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+#include "doctest/doctest.h"
+
+namespace kokko
+{
+
+namespace
+{
+
+#if defined(__linux__)
+
+static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t), "Futex word must be a plain 32-bit integer");
+
+void FutexWait(std::atomic<int32_t>* address, int32_t expectedValue)
+{
+	// Returns immediately if the value has already changed
+	syscall(SYS_futex, reinterpret_cast<int32_t*>(address), FUTEX_WAIT_PRIVATE, expectedValue, nullptr, nullptr, 0);
+}
+
+void FutexWake(std::atomic<int32_t>* address, int32_t count)
+{
+	syscall(SYS_futex, reinterpret_cast<int32_t*>(address), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+#elif defined(_WIN32)
+
+void FutexWait(std::atomic<int32_t>* address, int32_t expectedValue)
+{
+	WaitOnAddress(address, &expectedValue, sizeof(int32_t), INFINITE);
+}
+
+void FutexWake(std::atomic<int32_t>* address, int32_t count)
+{
+	if (count == 1)
+		WakeByAddressSingle(address);
+	else
+		WakeByAddressAll(address);
+}
+
+#endif
+
+} // namespace
+
+JobSemaphore::JobSemaphore() :
+	tokenCount(0)
+{
+}
+
+void JobSemaphore::Signal(int32_t count)
+{
+	if (count <= 0)
+		return;
+
+#if defined(__linux__) || defined(_WIN32)
+	tokenCount.fetch_add(count, std::memory_order_release);
+	FutexWake(&tokenCount, count);
+#else
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tokenCount.fetch_add(count, std::memory_order_release);
+	}
+
+	if (count == 1)
+		condition.notify_one();
+	else
+		condition.notify_all();
+#endif
+}
+
+void JobSemaphore::Wait()
+{
+#if defined(__linux__) || defined(_WIN32)
+	while (TryTake() == false)
+		FutexWait(&tokenCount, 0);
+#else
+	if (TryTake())
+		return;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	condition.wait(lock, [this] { return TryTake(); });
+#endif
+}
+
+bool JobSemaphore::TryTake()
+{
+	int32_t count = tokenCount.load(std::memory_order_relaxed);
+
+	while (count > 0)
+	{
+		if (tokenCount.compare_exchange_weak(count, count - 1, std::memory_order_acquire))
+			return true;
+	}
+
+	return false;
+}
+
+TEST_CASE("JobSemaphore.SignalBeforeWait")
+{
+	JobSemaphore semaphore;
+
+	semaphore.Signal(2);
+	semaphore.Wait();
+	semaphore.Wait();
+}
+
+TEST_CASE("JobSemaphore.WakesWaitingThreads")
+{
+	constexpr int ThreadCount = 4;
+
+	JobSemaphore semaphore;
+	std::atomic<int> wokenCount(0);
+	std::thread threads[ThreadCount];
+
+	for (auto& thread : threads)
+	{
+		thread = std::thread([&semaphore, &wokenCount]
+		{
+			semaphore.Wait();
+			wokenCount.fetch_add(1);
+		});
+	}
+
+	semaphore.Signal(ThreadCount);
+
+	for (auto& thread : threads)
+		thread.join();
+
+	CHECK(wokenCount.load() == ThreadCount);
+}
+
+} // namespace kokko
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#if !defined(__linux__) && !defined(_WIN32)
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace kokko
+{
+
+/*
+* Counting semaphore used to park idle job workers. Tokens are counted in a single
+* atomic, so Wait returns without a system call when a token is already available.
+* On Linux the thread sleeps on a futex and on Windows with WaitOnAddress. Other
+* platforms fall back to a mutex and a condition variable.
+*/
+class JobSemaphore
+{
+public:
+	JobSemaphore();
+
+	// Releases count tokens, waking at most as many waiting threads
+	void Signal(int32_t count);
+
+	// Blocks until a token can be taken
+	void Wait();
+
+private:
+	bool TryTake();
+
+	std::atomic<int32_t> tokenCount;
+
+#if !defined(__linux__) && !defined(_WIN32)
+	std::mutex mutex;
+	std::condition_variable condition;
+#endif
+};
+
+} // namespace kokko
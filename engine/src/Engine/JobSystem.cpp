@@ -1,8 +1,12 @@
 #include "Engine/JobSystem.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <cstdio>
 #include <new>
+#include <thread>
 
 #include "doctest/doctest.h"
 
@@ -28,7 +32,9 @@ JobSystem::JobSystem(Allocator* allocator, size_t numWorkers) :
 	jobAllocators(nullptr),
 	jobQueues(nullptr),
 	workerCount(numWorkers),
-	workers(nullptr)
+	workers(nullptr),
+	frameIndex(0),
+	parkedWorkerCount(0)
 {
 	assert(workerCount > 0);
 }
@@ -50,7 +56,7 @@ void JobSystem::Initialize()
 		jobAllocators = static_cast<JobAllocator*>(buf);
 
 		for (int i = 0; i < threadCount; ++i)
-			new (&jobAllocators[i]) JobAllocator(allocator);
+			new (&jobAllocators[i]) JobAllocator(allocator, &frameIndex);
 	}
 
 	if (jobQueues == nullptr)
@@ -86,11 +92,7 @@ void JobSystem::Deinitialize()
 		for (int i = 0; i < workerCount; ++i)
 			workers[i].RequestExit();
 
-		{
-			// Lock must be acquired before notifying the condition 
-			std::lock_guard<std::mutex> lock(conditionMutex);
-			workerNotifyCondition.notify_all();
-		}
+		WakeWorkers(static_cast<uint32_t>(workerCount));
 
 		for (int i = 0; i < workerCount; ++i)
 			workers[i].WaitToExit();
@@ -136,6 +138,8 @@ Job* JobSystem::CreateJobWithBuffer(JobFunction function, const void* data, size
 	job->function = function;
 	job->parent = nullptr;
 	job->unfinishedJobs = 1;
+	job->pendingDependencies = 1;
+	job->continuationCount = 0;
 
 	if (size > 0)
 	{
@@ -163,6 +167,8 @@ Job* JobSystem::CreateJobAsChildWithBuffer(Job* parent, JobFunction function, co
 	job->function = function;
 	job->parent = parent;
 	job->unfinishedJobs = 1;
+	job->pendingDependencies = 1;
+	job->continuationCount = 0;
 
 	if (size > 0)
 	{
@@ -172,13 +178,20 @@ Job* JobSystem::CreateJobAsChildWithBuffer(Job* parent, JobFunction function, co
 	return job;
 }
 
-void JobSystem::Enqueue(Job* job)
+void JobSystem::AddDependency(Job* job, Job* dependency)
 {
-	JobQueue* queue = GetCurrentThreadJobQueue();
+	assert(job != dependency);
+	assert(job->pendingDependencies.load() > 0);
+	assert(HasJobCompleted(dependency) == false);
 
-	queue->Push(job);
+	job->pendingDependencies.fetch_add(1);
 
-	workerNotifyCondition.notify_all();
+	AddContinuation(dependency, job);
+}
+
+void JobSystem::Enqueue(Job* job)
+{
+	ReleaseDependency(job);
 }
 
 void JobSystem::Wait(const Job* job)
@@ -191,20 +204,53 @@ void JobSystem::Wait(const Job* job)
 
 		if (nextJob != nullptr)
 			Execute(nextJob);
+		else
+			JobWorker::CpuRelax();
 	}
 }
 
 void JobSystem::EndFrame()
 {
-	size_t threadCount = workerCount + 1;
-	for (size_t i = 0; i < threadCount; ++i)
-		jobAllocators[i].Reset();
+	// Job allocators reuse chunks whose jobs have all finished before this
+	frameIndex.fetch_add(1, std::memory_order_relaxed);
 }
 
 // ===============
 // PRIVATE METHODS
 // ===============
 
+void JobSystem::AddContinuation(Job* job, Job* continuation)
+{
+	constexpr int32_t maxCount = static_cast<int32_t>(Job::MaxContinuationCount);
+
+	int32_t count = job->continuationCount.load();
+	if (count < maxCount)
+	{
+		job->continuations[count] = continuation;
+		job->continuationCount.store(count + 1);
+		return;
+	}
+
+	// The list is full, so the last continuation is moved to a relay job that takes its place.
+	// The relay is released with the other continuations and then releases its own.
+	Job* last = job->continuations[maxCount - 1];
+	if (last->function != RelayJob)
+	{
+		Job* relay = CreateJob(RelayJob);
+		relay->continuations[0] = last;
+		relay->continuationCount.store(1);
+
+		job->continuations[maxCount - 1] = relay;
+		last = relay;
+	}
+
+	AddContinuation(last, continuation);
+}
+
+void JobSystem::RelayJob(Job*, JobSystem*)
+{
+}
+
 bool JobSystem::HasJobCompleted(const Job* job)
 {
 	return job->unfinishedJobs.load() == 0;
@@ -218,12 +264,45 @@ void JobSystem::Execute(Job* job)
 
 void JobSystem::Finish(Job* job)
 {
+	// Continuations can't be added after the job has been enqueued,
+	// so they can be read before anyone waiting for the job is released
+	Job* continuations[Job::MaxContinuationCount];
+	int32_t continuationCount = job->continuationCount.load();
+
+	for (int32_t i = 0; i < continuationCount; ++i)
+		continuations[i] = job->continuations[i];
+
+	Job* parent = job->parent;
+	JobChunk* chunk = job->chunk;
+
 	size_t unfinishedJobs = job->unfinishedJobs.fetch_sub(1);
 
 	// fetch_sub returns the previous value, so 1 means the value now is 0
-	if (unfinishedJobs == 1 && job->parent != nullptr)
+	if (unfinishedJobs == 1)
+	{
+		for (int32_t i = 0; i < continuationCount; ++i)
+			ReleaseDependency(continuations[i]);
+
+		if (parent != nullptr)
+			Finish(parent);
+
+		JobAllocator::ReleaseJob(chunk);
+	}
+}
+
+void JobSystem::ReleaseDependency(Job* job)
+{
+	int32_t pendingDependencies = job->pendingDependencies.fetch_sub(1);
+
+	// fetch_sub returns the previous value, so 1 means the value now is 0
+	if (pendingDependencies == 1)
 	{
-		Finish(job->parent);
+		JobQueue* queue = GetCurrentThreadJobQueue();
+
+		queue->Push(job);
+
+		// Only one worker is needed to run the job, it will wake more if it creates new jobs
+		WakeWorkers(1);
 	}
 }
 
@@ -250,9 +329,6 @@ Job* JobSystem::GetJobToExecute()
 		// Skip current thread queue
 		if (threadIndex != currentThreadIndex)
 		{
-			// Give hint to allow other threads to work
-			std::this_thread::yield();
-
 			Job* stolenJob = jobQueues[threadIndex].Steal();
 
 			if (stolenJob != nullptr)
@@ -282,11 +358,57 @@ bool JobSystem::IsWorkAvailable()
 	return false;
 }
 
+void JobSystem::WakeWorkers(uint32_t count)
+{
+	// Pairs with the fence in ParkWorker: either the parking worker sees the pushed job
+	// or this thread sees the parked worker count that includes that worker
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	uint32_t parkedCount = parkedWorkerCount.load(std::memory_order_relaxed);
+
+	while (parkedCount > 0)
+	{
+		uint32_t wakeCount = std::min(parkedCount, count);
+
+		if (parkedWorkerCount.compare_exchange_weak(parkedCount, parkedCount - wakeCount, std::memory_order_relaxed))
+		{
+			workerSemaphore.Signal(static_cast<int32_t>(wakeCount));
+			break;
+		}
+	}
+}
+
+void JobSystem::ParkWorker(const std::atomic_bool& exitRequested)
+{
+	parkedWorkerCount.fetch_add(1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (exitRequested.load() || IsWorkAvailable())
+	{
+		// Cancel parking. If a waker has already taken this worker out of the count,
+		// a token has been or will be signaled for it and it needs to be consumed.
+		uint32_t parkedCount = parkedWorkerCount.load(std::memory_order_relaxed);
+
+		while (parkedCount > 0)
+		{
+			if (parkedWorkerCount.compare_exchange_weak(parkedCount, parkedCount - 1, std::memory_order_relaxed))
+				return;
+		}
+	}
+
+	workerSemaphore.Wait();
+}
+
 Job* JobSystem::AllocateJob()
 {
 	return jobAllocators[currentThreadIndex].AllocateJob();
 }
 
+bool JobSystem::IsCurrentThreadQueueEmpty()
+{
+	return GetCurrentThreadJobQueue()->HasWork() == false;
+}
+
 JobQueue* JobSystem::GetCurrentThreadJobQueue()
 {
 	return &jobQueues[currentThreadIndex];
@@ -422,4 +544,180 @@ TEST_CASE("JobSystem")
 	allocator->Deallocate(resultsBuffer);
 }
 
+TEST_CASE("JobHelpers.ParallelFor")
+{
+	constexpr size_t Count = 100'000;
+
+	Allocator* allocator = Allocator::GetDefault();
+
+	JobSystem jobSystem(allocator, 3);
+	jobSystem.Initialize();
+
+	std::atomic_uint8_t* visitCounts = static_cast<std::atomic_uint8_t*>(allocator->Allocate(sizeof(std::atomic_uint8_t) * Count));
+	for (size_t i = 0; i < Count; ++i)
+		new (&visitCounts[i]) std::atomic_uint8_t(0);
+
+	JobHelpers::ParallelFor(&jobSystem, 0, Count, 64, [visitCounts](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+			visitCounts[i].fetch_add(1);
+	});
+
+	bool allVisitedOnce = true;
+	for (size_t i = 0; i < Count; ++i)
+		if (visitCounts[i].load() != 1)
+			allVisitedOnce = false;
+
+	CHECK(allVisitedOnce);
+
+	allocator->Deallocate(visitCounts);
+
+	jobSystem.EndFrame();
+	jobSystem.Deinitialize();
+}
+
+TEST_CASE("JobHelpers.ParallelReduceAndScan")
+{
+	constexpr size_t Count = 50'000;
+
+	Allocator* allocator = Allocator::GetDefault();
+
+	JobSystem jobSystem(allocator, 3);
+	jobSystem.Initialize();
+
+	uint64_t* values = static_cast<uint64_t*>(allocator->Allocate(sizeof(uint64_t) * Count));
+	uint64_t* prefixSums = static_cast<uint64_t*>(allocator->Allocate(sizeof(uint64_t) * Count));
+
+	for (size_t i = 0; i < Count; ++i)
+		values[i] = i % 7;
+
+	auto sum = [](uint64_t a, uint64_t b) { return a + b; };
+
+	uint64_t total = JobHelpers::ParallelReduce(&jobSystem, 0, Count, 128, uint64_t(0),
+		[values](size_t begin, size_t end)
+		{
+			uint64_t rangeTotal = 0;
+			for (size_t i = begin; i < end; ++i)
+				rangeTotal += values[i];
+			return rangeTotal;
+		}, sum);
+
+	uint64_t expectedTotal = 0;
+	for (size_t i = 0; i < Count; ++i)
+		expectedTotal += values[i];
+
+	CHECK(total == expectedTotal);
+
+	JobHelpers::ParallelScan(&jobSystem, values, prefixSums, Count, 128, uint64_t(0), sum);
+
+	bool prefixSumsMatch = true;
+	uint64_t runningTotal = 0;
+	for (size_t i = 0; i < Count; ++i)
+	{
+		runningTotal += values[i];
+		if (prefixSums[i] != runningTotal)
+			prefixSumsMatch = false;
+	}
+
+	CHECK(prefixSumsMatch);
+
+	allocator->Deallocate(prefixSums);
+	allocator->Deallocate(values);
+
+	jobSystem.EndFrame();
+	jobSystem.Deinitialize();
+}
+
+namespace
+{
+
+struct WakeLatencyData
+{
+	std::atomic_bool started;
+	std::chrono::steady_clock::time_point startTime;
+};
+
+void EmptyBenchmarkJob(size_t*, uint32_t*, size_t)
+{
+}
+
+void WakeLatencyJob(Job* job, JobSystem*)
+{
+	WakeLatencyData* data = static_cast<WakeLatencyData*>(job->GetDataAsPtr());
+	data->startTime = std::chrono::steady_clock::now();
+	data->started.store(true);
+}
+
+} // namespace
+
+TEST_CASE("JobSystem.Benchmark" * doctest::skip())
+{
+	using Clock = std::chrono::steady_clock;
+
+	// ParallelFor with these values creates 2047 jobs per round
+	constexpr size_t ParallelForCount = 1 << 14;
+	constexpr size_t ParallelForSplitCount = 16;
+	constexpr size_t ParallelForJobCount = 2 * (ParallelForCount / ParallelForSplitCount) - 1;
+	constexpr int ThroughputRoundCount = 200;
+	constexpr int WakeRoundCount = 50;
+
+	Allocator* allocator = Allocator::GetDefault();
+	uint32_t instanceData[ParallelForCount];
+	size_t constantData = 0;
+
+	for (size_t threadCount = 1; threadCount <= 64; threadCount *= 2)
+	{
+		JobSystem jobSystem(allocator, threadCount);
+		jobSystem.Initialize();
+
+		// Job throughput
+
+		Clock::time_point throughputStart = Clock::now();
+
+		for (int round = 0; round < ThroughputRoundCount; ++round)
+		{
+			Job* job = JobHelpers::CreateParallelFor(&jobSystem, &constantData, instanceData,
+				ParallelForCount, EmptyBenchmarkJob, ParallelForSplitCount);
+			jobSystem.Enqueue(job);
+			jobSystem.Wait(job);
+			jobSystem.EndFrame();
+		}
+
+		Clock::duration throughputTime = Clock::now() - throughputStart;
+		double jobCount = static_cast<double>(ParallelForJobCount) * ThroughputRoundCount;
+		double nanosPerJob = std::chrono::duration<double, std::nano>(throughputTime).count() / jobCount;
+
+		// Wake latency from enqueue to job start, measured when the workers are parked.
+		// The main thread doesn't call Wait until the job has started, so a worker has to run it.
+
+		double totalWakeMicros = 0.0;
+
+		for (int round = 0; round < WakeRoundCount; ++round)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+			WakeLatencyData data;
+			data.started.store(false);
+
+			Job* job = jobSystem.CreateJobWithPtr(WakeLatencyJob, &data);
+
+			Clock::time_point enqueueTime = Clock::now();
+			jobSystem.Enqueue(job);
+
+			while (data.started.load() == false)
+				JobWorker::CpuRelax();
+
+			jobSystem.Wait(job);
+			jobSystem.EndFrame();
+
+			totalWakeMicros += std::chrono::duration<double, std::micro>(data.startTime - enqueueTime).count();
+		}
+
+		jobSystem.Deinitialize();
+
+		std::printf("JobSystem %2zu workers: %7.1f ns per job, wake latency %7.1f us\n",
+			threadCount, nanosPerJob, totalWakeMicros / WakeRoundCount);
+	}
+}
+
 } // namespace kokko
@@ -1,11 +1,11 @@
 #pragma once
 
 #include <atomic>
-#include <condition_variable>
-#include <mutex>
+#include <cstdint>
 
 #include "Engine/Job.hpp"
 #include "Engine/JobFunction.hpp"
+#include "Engine/JobSemaphore.hpp"
 
 namespace kokko
 {
@@ -46,13 +46,26 @@ public:
 		return CreateJobAsChildWithBuffer(parent, function, &data, sizeof(data));
 	}
 
+	// Job will not start before dependency and its children have finished.
+	// Must be called before either of the jobs is enqueued, and not concurrently for the same dependency.
+	void AddDependency(Job* job, Job* dependency);
+
+	// Job is pushed to a queue once all its dependencies have finished
 	void Enqueue(Job* job);
 
 	void Wait(const Job* job);
 
+	// Job handles are valid until the end of the frame the job finishes in
 	void EndFrame();
 
-	static const size_t MaxJobsPerThreadPerFrame = 1 << 12;
+	// Worker threads and the main thread
+	size_t GetThreadCount() const { return workerCount + 1; }
+
+	Allocator* GetAllocator() const { return allocator; }
+
+	// True if no jobs are waiting in the current thread's queue, so idle threads have nothing to steal from it
+	bool IsCurrentThreadQueueEmpty();
+
 	static const size_t ThreadIndexMainThread = 0;
 
 	static thread_local size_t currentThreadIndex;
@@ -63,10 +76,22 @@ private:
 	void Execute(Job* job);
 	void Finish(Job* job);
 
+	// Pushes the job to the current thread's queue when its last dependency is released
+	void ReleaseDependency(Job* job);
+
+	void AddContinuation(Job* job, Job* continuation);
+	static void RelayJob(Job*, JobSystem*);
+
 	Job* GetJobToExecute();
 
 	bool IsWorkAvailable();
 
+	// Wakes at most count parked workers, without system calls if none are parked
+	void WakeWorkers(uint32_t count);
+
+	// Parks the calling worker until it's woken, unless work is available or exit was requested
+	void ParkWorker(const std::atomic_bool& exitRequested);
+
 	Job* AllocateJob();
 
 	JobQueue* GetCurrentThreadJobQueue();
@@ -80,8 +105,10 @@ private:
 	size_t workerCount;
 	JobWorker* workers;
 
-	std::mutex conditionMutex;
-	std::condition_variable workerNotifyCondition;
+	std::atomic_uint64_t frameIndex;
+
+	JobSemaphore workerSemaphore;
+	std::atomic_uint32_t parkedWorkerCount;
 
 	friend class JobWorker;
 };
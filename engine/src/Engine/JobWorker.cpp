@@ -2,6 +2,14 @@
 
 #include <cassert>
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#endif
+
+#include "Core/Core.hpp"
+
 #include "Engine/Job.hpp"
 #include "Engine/JobSystem.hpp"
 
@@ -33,50 +41,53 @@ void JobWorker::WaitToExit()
 		thread.join();
 }
 
+void JobWorker::CpuRelax()
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	_mm_pause();
+#elif defined(_M_ARM64)
+	__yield();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
 void JobWorker::ThreadMain()
 {
 	JobSystem::currentThreadIndex = threadIndex;
 
-	bool exit = false;
+	size_t idleCount = 0;
 
-	while (exit == false)
+	while (exitRequested.load() == false)
 	{
-		static const size_t MaxGetJobTryCount = 4;
-		size_t getJobTryCount = 0;
+		Job* job = jobSystem->GetJobToExecute();
 
-		Job* job;
+		if (job != nullptr)
+		{
+			idleCount = 0;
+			jobSystem->Execute(job);
+			continue;
+		}
 
-		do
+		// GetJobToExecute can return nullptr even when there are jobs remaining,
+		// and new jobs often arrive soon, so only park after staying idle for a while.
+
+		idleCount += 1;
+
+		if (idleCount <= IdleSpinCount)
+		{
+			CpuRelax();
+		}
+		else if (idleCount <= IdleSpinCount + IdleYieldCount)
 		{
-			job = jobSystem->GetJobToExecute();
-
-			if (job != nullptr)
-			{
-				getJobTryCount = 0;
-				jobSystem->Execute(job);
-			}
-			else
-			{
-				getJobTryCount += 1;
-			}
-		} while (getJobTryCount < MaxGetJobTryCount);
-		// GetJobToExecute can return nullptr even when there are jobs remaining.
-		// We only start waiting on the condition variable if we failed to get a job
-		// MaxGetJobTryCount times in a row.
-
-		exit = exitRequested.load();
-		if (exit == true)
-			break;
-
-		std::unique_lock<std::mutex> lock(jobSystem->conditionMutex);
+			std::this_thread::yield();
+		}
+		else
 		{
-			KOKKO_PROFILE_SCOPE("CondWait");
-			jobSystem->workerNotifyCondition.wait(lock, [&] {
-				return exitRequested.load() || jobSystem->IsWorkAvailable();
-			});
+			KOKKO_PROFILE_SCOPE("Park");
+			jobSystem->ParkWorker(exitRequested);
+			idleCount = 0;
 		}
-
-		exit = exitRequested.load();
 	}
 
 	// We need to make sure no one is accidentally modifying the thread index
@@ -19,7 +19,14 @@ public:
 	void RequestExit();
 	void WaitToExit();
 
+	// Hints the processor that the calling thread is spin-waiting
+	static void CpuRelax();
+
 private:
+	// Idle workers first spin, then yield their time slice and finally park
+	static const size_t IdleSpinCount = 64;
+	static const size_t IdleYieldCount = 16;
+
 	std::thread thread;
 	size_t threadIndex;
 	JobSystem* jobSystem;
@@ -14,6 +14,9 @@
 
 #include "Math/Rectangle.hpp"
 
+#include "Memory/AllocatorManager.hpp"
+#include "Memory/FrameAllocator.hpp"
+
 #include "Rendering/CameraParameters.hpp"
 #include "Rendering/CameraSystem.hpp"
 #include "Rendering/LightManager.hpp"
@@ -34,6 +37,8 @@ World::World(AllocatorManager* allocManager,
 	Allocator* debugNameAllocator,
 	render::Device* renderDevice,
 	render::CommandEncoder* commandEncoder,
+	JobSystem* jobSystem,
+	Filesystem* filesystem,
 	AssetLoader* assetLoader,
 	const ResourceManagers& resourceManagers,
 	const RenderDebugSettings* renderDebug) :
@@ -42,11 +47,11 @@ World::World(AllocatorManager* allocManager,
 	levelSerializer(allocator, renderDevice),
 	resourceManagers(resourceManagers)
 {
-	entityManager.CreateScope(allocManager, "EntityManager", allocator);
+	entityManager.CreateScope(allocManager, "EntityManager", allocator, false, true);
 	entityManager.New(entityManager.allocator, debugNameAllocator);
 
 	lightManager.CreateScope(allocManager, "LightManager", allocator);
-	lightManager.New(lightManager.allocator);
+	lightManager.New(lightManager.allocator, allocManager->GetFrameAllocator());
 
 	cameraSystem.CreateScope(allocManager, "CameraSystem", allocator);
 	cameraSystem.New(cameraSystem.allocator);
@@ -55,15 +60,15 @@ World::World(AllocatorManager* allocManager,
 	scene.New(scene.allocator);
 
 	environmentSystem.CreateScope(allocManager, "EnvironmentSystem", allocator);
-	environmentSystem.New(environmentSystem.allocator, assetLoader, renderDevice,
+	environmentSystem.New(environmentSystem.allocator, assetLoader, filesystem, renderDevice,
 		resourceManagers.shaderManager, resourceManagers.modelManager, resourceManagers.textureManager);
 
 	meshComponentSystem.CreateScope(allocManager, "MeshComponentSystem", allocator);
 	meshComponentSystem.New(meshComponentSystem.allocator, resourceManagers.modelManager);
 
 	renderer.CreateScope(allocManager, "Renderer", allocator);
-	renderer.New(renderer.allocator, renderDevice, commandEncoder, meshComponentSystem.instance, scene.instance,
-		cameraSystem.instance, lightManager.instance, environmentSystem.instance, resourceManagers, renderDebug);
+	renderer.New(renderer.allocator, renderDevice, commandEncoder, jobSystem, meshComponentSystem.instance,
+		scene.instance, cameraSystem.instance, lightManager.instance, environmentSystem.instance, resourceManagers, renderDebug);
 
 	scriptSystem.CreateScope(allocManager, "ScriptSystem", allocator);
 	scriptSystem.New(scriptSystem.allocator);
@@ -21,6 +21,7 @@ class EntityManager;
 class EnvironmentSystem;
 class Filesystem;
 class InputManager;
+class JobSystem;
 class LightManager;
 class MeshComponentSystem;
 class ParticleSystem;
@@ -48,6 +49,8 @@ public:
 		Allocator* debugNameAllocator,
 		render::Device* renderDevice,
 		render::CommandEncoder* commandEncoder,
+		JobSystem* jobSystem,
+		Filesystem* filesystem,
 		AssetLoader* assetLoader,
 		const ResourceManagers& resourceManagers,
 		const RenderDebugSettings* renderDebug);
@@ -0,0 +1,91 @@
+#include "Graphics/EnvironmentCache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#include "Core/Core.hpp"
+
+#include "Engine/EngineConstants.hpp"
+
+#include "System/Filesystem.hpp"
+
+namespace kokko
+{
+
+EnvironmentCache::EnvironmentCache(Allocator* allocator, Filesystem* filesystem) :
+	allocator(allocator),
+	filesystem(filesystem),
+	directoryCreated(false),
+	fileBuffer(allocator)
+{
+}
+
+bool EnvironmentCache::Load(uint64_t key, ArrayView<const uint8_t>& dataOut)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	char path[256];
+	GetCacheFilePath(key, path, sizeof(path));
+
+	fileBuffer.Clear();
+	if (filesystem->ReadBinary(path, fileBuffer) == false)
+		return false;
+
+	FileHeader header;
+	if (fileBuffer.GetCount() < sizeof(FileHeader))
+		return false;
+
+	std::memcpy(&header, fileBuffer.GetData(), sizeof(FileHeader));
+
+	if (header.magic != FileHeader::Magic ||
+		header.version != FileHeader::CurrentVersion ||
+		header.key != key ||
+		fileBuffer.GetCount() != sizeof(FileHeader) + header.dataSize)
+	{
+		KK_LOG_WARN("Environment cache file {} is invalid", path);
+		return false;
+	}
+
+	dataOut = ArrayView<const uint8_t>(fileBuffer.GetData() + sizeof(FileHeader), header.dataSize);
+
+	return true;
+}
+
+void EnvironmentCache::Store(uint64_t key, ArrayView<const uint8_t> data)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	fileBuffer.Resize(sizeof(FileHeader) + data.GetCount());
+
+	FileHeader header;
+	header.magic = FileHeader::Magic;
+	header.version = FileHeader::CurrentVersion;
+	header.key = key;
+	header.dataSize = data.GetCount();
+
+	std::memcpy(fileBuffer.GetData(), &header, sizeof(FileHeader));
+	std::memcpy(fileBuffer.GetData() + sizeof(FileHeader), data.GetData(), data.GetCount());
+
+	if (directoryCreated == false)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(EngineConstants::EnvironmentCachePath, error);
+		directoryCreated = true;
+	}
+
+	char path[256];
+	GetCacheFilePath(key, path, sizeof(path));
+
+	if (filesystem->Write(path, fileBuffer.GetView(), false) == false)
+		KK_LOG_WARN("Couldn't write environment cache file {}", path);
+}
+
+void EnvironmentCache::GetCacheFilePath(uint64_t key, char* pathOut, size_t pathSize)
+{
+	std::snprintf(pathOut, pathSize, "%s/%016llx.bin", EngineConstants::EnvironmentCachePath,
+		static_cast<unsigned long long>(key));
+}
+
+} // namespace kokko
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Core/Array.hpp"
+#include "Core/ArrayView.hpp"
+
+namespace kokko
+{
+
+class Allocator;
+class Filesystem;
+
+// Stores baked environment map data on disk, so that the cubemaps don't have to be
+// rendered again the next time the same source texture is loaded.
+class EnvironmentCache
+{
+public:
+	EnvironmentCache(Allocator* allocator, Filesystem* filesystem);
+
+	// Returns a view to the cached data, valid until the next call to Load or Store
+	bool Load(uint64_t key, ArrayView<const uint8_t>& dataOut);
+
+	void Store(uint64_t key, ArrayView<const uint8_t> data);
+
+private:
+	struct FileHeader
+	{
+		static const uint32_t Magic = 0x564E454B; // "KENV"
+		static const uint32_t CurrentVersion = 1;
+
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint64_t dataSize;
+	};
+
+	void GetCacheFilePath(uint64_t key, char* pathOut, size_t pathSize);
+
+	Allocator* allocator;
+	Filesystem* filesystem;
+
+	bool directoryCreated;
+
+	Array<uint8_t> fileBuffer;
+};
+
+} // namespace kokko
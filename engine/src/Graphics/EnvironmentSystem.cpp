@@ -7,6 +7,10 @@
 
 #include "Core/Array.hpp"
 #include "Core/Core.hpp"
+#include "Core/Hash.hpp"
+#include "Core/String.hpp"
+
+#include "Graphics/EnvironmentCache.hpp"
 
 #include "Math/Mat4x4.hpp"
 #include "Math/Math.hpp"
@@ -25,6 +29,7 @@
 #include "Resources/ShaderManager.hpp"
 #include "Resources/TextureManager.hpp"
 
+#include "System/Filesystem.hpp"
 
 namespace kokko
 {
@@ -32,6 +37,18 @@ namespace kokko
 namespace
 {
 
+// Baked textures are cached as RGB half floats
+constexpr size_t BakedPixelSize = 3 * sizeof(uint16_t);
+
+const char* const EquirectShaderPath = "engine/shaders/preprocess/equirect_to_cube.glsl";
+const char* const CalcDiffuseShaderPath = "engine/shaders/preprocess/calc_diffuse_irradiance.glsl";
+const char* const CalcSpecularShaderPath = "engine/shaders/preprocess/calc_specular_irradiance.glsl";
+
+size_t GetCubemapFaceByteSize(int size)
+{
+	return static_cast<size_t>(size) * static_cast<size_t>(size) * BakedPixelSize;
+}
+
 RenderTextureTarget GetCubeTextureTarget(unsigned int index)
 {
 	// TODO: Refactor into a reusable function
@@ -90,12 +107,15 @@ struct CalcSpecularUniforms
 EnvironmentSystem::EnvironmentSystem(
 	Allocator* allocator,
 	AssetLoader* assetLoader,
+	Filesystem* filesystem,
 	render::Device* renderDevice,
 	ShaderManager* shaderManager,
 	ModelManager* modelManager,
 	TextureManager* textureManager) :
 	allocator(allocator),
 	assetLoader(assetLoader),
+	filesystem(filesystem),
+	cache(nullptr),
 	renderDevice(renderDevice),
 	shaderManager(shaderManager),
 	modelManager(modelManager),
@@ -110,8 +130,11 @@ EnvironmentSystem::EnvironmentSystem(
 	specularUniformBufferId(0),
 	samplerId(0),
 	cubeMeshId(ModelId::Null),
+	bakeHash(0),
 	resourcesUploaded(false)
 {
+	cache = allocator->MakeNew<EnvironmentCache>(allocator, filesystem);
+
 	components.Reserve(4);
 	components.PushBack(); // Reserve index 0 as EnvironmentId::Null
 }
@@ -119,6 +142,8 @@ EnvironmentSystem::EnvironmentSystem(
 EnvironmentSystem::~EnvironmentSystem()
 {
 	Deinitialize();
+
+	allocator->MakeDelete(cache);
 }
 
 void EnvironmentSystem::Initialize()
@@ -174,12 +199,21 @@ void EnvironmentSystem::Upload(render::CommandEncoder* encoder)
 		texturesToRemove.Clear();
 	}
 
+	// Rendering commands of last frame have been executed, so baked textures can be read back
+	for (size_t i = 1, end = components.GetCount(); i < end; ++i)
+	{
+		if (components[i].needsCacheStore)
+			StoreToCache(components[i]);
+	}
+
 	if (resourcesUploaded == false)
 	{
 		resourcesUploaded = true;
 
 		auto scope = renderDevice->CreateDebugScope(0, ConstStringView("EnvironSys_InitResources"));
 
+		bakeHash = CalculateBakeHash();
+
 		// Create cube mesh
 		cubeMeshId = MeshPresets::CreateCube(modelManager);
 
@@ -334,17 +368,19 @@ void EnvironmentSystem::Upload(render::CommandEncoder* encoder)
 		auto& env = components[i];
 		if (env.needsUpload && env.sourceTextureUid.HasValue())
 		{
-			static const int EnvironmentTextureSize = 1024;
-			static const int SpecularTextureSize = 256;
-			static const int DiffuseTextureSize = 32;
-
 			RenderTextureSizedFormat sizedFormat = RenderTextureSizedFormat::RGB16F;
 
 			// Load equirectangular image and create texture
 
 			stbi_set_flip_vertically_on_load(true);
 			int equirectWidth, equirectHeight, nrComponents;
-			float* equirectData;
+			float* equirectData = nullptr;
+			uint64_t cacheKey = 0;
+			bool loadedFromCache = false;
+
+			ShaderId equirectShaderId = ShaderId::Null;
+			ShaderId calcDiffuseShaderId = ShaderId::Null;
+			ShaderId calcSpecularShaderId = ShaderId::Null;
 
 			{
 				Array<uint8_t> buffer(allocator);
@@ -355,15 +391,31 @@ void EnvironmentSystem::Upload(render::CommandEncoder* encoder)
 					continue;
 				}
 
+				uint8_t* bytesPtr = buffer.GetData() + loadResult.assetStart;
+				cacheKey = HashValue64(bytesPtr, loadResult.assetSize, bakeHash);
+
+				ArrayView<const uint8_t> cachedData;
+				if (cache->Load(cacheKey, cachedData))
+					loadedFromCache = LoadFromCache(env, cachedData);
+
+				if (loadedFromCache == false)
 				{
+					// Start all shader compiles before decoding, so they run while the image is loaded
+					equirectShaderId = shaderManager->FindShaderByPath(ConstStringView(EquirectShaderPath));
+					calcDiffuseShaderId = shaderManager->FindShaderByPath(ConstStringView(CalcDiffuseShaderPath));
+					calcSpecularShaderId = shaderManager->FindShaderByPath(ConstStringView(CalcSpecularShaderPath));
+
 					KOKKO_PROFILE_SCOPE("stbi_loadf_from_memory()");
 
-					uint8_t* bytesPtr = buffer.GetData() + loadResult.assetStart;
 					int length = static_cast<int>(loadResult.assetSize);
 					equirectData = stbi_loadf_from_memory(bytesPtr, length, &equirectWidth, &equirectHeight, &nrComponents, 0);
 				}
 			}
 
+			// Uploading cached textures is still a lot of data, keep to one map per frame
+			if (loadedFromCache)
+				break;
+
 			if (equirectData == nullptr)
 			{
 				KK_LOG_ERROR("Couldn't load source texture for environment map");
@@ -398,7 +450,6 @@ void EnvironmentSystem::Upload(render::CommandEncoder* encoder)
 
 			// Load shader
 
-			ShaderId equirectShaderId = shaderManager->FindShaderByPath(ConstStringView("engine/shaders/preprocess/equirect_to_cube.glsl"));
 			const ShaderData& equirectShader = shaderManager->GetShaderData(equirectShaderId);
 
 			encoder->BindVertexArray(part.vertexArrayId);
@@ -443,7 +494,6 @@ void EnvironmentSystem::Upload(render::CommandEncoder* encoder)
 
 			// Load shader
 
-			ShaderId calcDiffuseShaderId = shaderManager->FindShaderByPath(ConstStringView("engine/shaders/preprocess/calc_diffuse_irradiance.glsl"));
 			const ShaderData& calcDiffuseShader = shaderManager->GetShaderData(calcDiffuseShaderId);
 
 			encoder->UseShaderProgram(calcDiffuseShader.driverId);
@@ -483,7 +533,6 @@ void EnvironmentSystem::Upload(render::CommandEncoder* encoder)
 
 			const TextureData& specMapTexture = textureManager->GetTextureData(specMapTextureId);
 
-			ShaderId calcSpecularShaderId = shaderManager->FindShaderByPath(ConstStringView("engine/shaders/preprocess/calc_specular_irradiance.glsl"));
 			const ShaderData& calcSpecularShader = shaderManager->GetShaderData(calcSpecularShaderId);
 
 			encoder->UseShaderProgram(calcSpecularShader.driverId);
@@ -529,6 +578,8 @@ void EnvironmentSystem::Upload(render::CommandEncoder* encoder)
 			env.textures.diffuseIrradianceTexture = diffuseMapTextureId;
 			env.textures.specularIrradianceTexture = specMapTextureId;
 			env.needsUpload = false;
+			env.needsCacheStore = true;
+			env.cacheKey = cacheKey;
 
 			// Only render one environment map per frame
 			break;
@@ -553,6 +604,8 @@ EnvironmentId EnvironmentSystem::AddComponent(Entity entity)
 	components[id.i].entity = entity;
 	components[id.i].intensity = 1.0f;
 	components[id.i].needsUpload = false;
+	components[id.i].needsCacheStore = false;
+	components[id.i].cacheKey = 0;
 
 	return id;
 }
@@ -587,6 +640,8 @@ void EnvironmentSystem::RemoveComponent(EnvironmentId id)
 		components[id.i].entity = components[swapIdx].entity;
 		components[id.i].sourceTextureUid = components[swapIdx].sourceTextureUid;
 		components[id.i].textures = components[swapIdx].textures;
+		components[id.i].needsCacheStore = components[swapIdx].needsCacheStore;
+		components[id.i].cacheKey = components[swapIdx].cacheKey;
 	}
 
 	components.PopBack();
@@ -620,6 +675,7 @@ void EnvironmentSystem::SetEnvironmentTexture(EnvironmentId id, const kokko::Uid
 
 	component.sourceTextureUid = textureUid;
 	component.needsUpload = true;
+	component.needsCacheStore = false;
 }
 
 void EnvironmentSystem::SetIntensity(EnvironmentId id, float intensity)
@@ -668,4 +724,114 @@ void EnvironmentSystem::LoadEmptyEnvironmentMap()
 	KOKKO_PROFILE_FUNCTION();
 }
 
+uint64_t EnvironmentSystem::CalculateBakeHash()
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	const int textureSizes[] = {
+		EnvironmentTextureSize, DiffuseTextureSize, SpecularTextureSize, SpecularMipmapLevelCount
+	};
+
+	uint64_t hash = HashValue64(textureSizes, sizeof(textureSizes), 0);
+
+	const char* const shaderPaths[] = { EquirectShaderPath, CalcDiffuseShaderPath, CalcSpecularShaderPath };
+
+	String shaderSource(allocator);
+	for (const char* path : shaderPaths)
+	{
+		shaderSource.Clear();
+		if (filesystem->ReadText(path, shaderSource))
+			hash = HashValue64(shaderSource.GetData(), shaderSource.GetLength(), hash);
+	}
+
+	return hash;
+}
+
+bool EnvironmentSystem::LoadFromCache(EnvironmentComponent& env, ArrayView<const uint8_t> data)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	size_t expectedSize = (GetCubemapFaceByteSize(EnvironmentTextureSize) +
+		GetCubemapFaceByteSize(DiffuseTextureSize)) * CubemapSideCount;
+
+	for (uint32_t mip = 0; mip < SpecularMipmapLevelCount; ++mip)
+		expectedSize += GetCubemapFaceByteSize(SpecularTextureSize >> mip) * CubemapSideCount;
+
+	if (data.GetCount() != expectedSize)
+	{
+		KK_LOG_WARN("Cached environment map has unexpected size, baking it again");
+		return false;
+	}
+
+	auto devScope = renderDevice->CreateDebugScope(0, ConstStringView("EnvironSys_LoadCachedMap"));
+
+	RenderTextureSizedFormat sizedFormat = RenderTextureSizedFormat::RGB16F;
+	const uint8_t* readPtr = data.GetData();
+
+	auto createTexture = [&](int size, int levels) -> TextureId
+	{
+		TextureId textureId = textureManager->CreateTexture();
+		textureManager->AllocateTextureStorage(textureId, RenderTextureTarget::TextureCubeMap,
+			sizedFormat, levels, Vec2i(size, size));
+		const TextureData& texture = textureManager->GetTextureData(textureId);
+
+		for (int mip = 0; mip < levels; ++mip)
+		{
+			int mipSize = size >> mip;
+
+			for (unsigned int i = 0; i < CubemapSideCount; ++i)
+			{
+				renderDevice->SetTextureSubImage3D(texture.textureObjectId, mip, 0, 0, i, mipSize, mipSize, 1,
+					RenderTextureBaseFormat::RGB, RenderTextureDataType::HalfFloat, readPtr);
+
+				readPtr += GetCubemapFaceByteSize(mipSize);
+			}
+		}
+
+		return textureId;
+	};
+
+	env.textures.environmentTexture = createTexture(EnvironmentTextureSize, 1);
+	env.textures.diffuseIrradianceTexture = createTexture(DiffuseTextureSize, 1);
+	env.textures.specularIrradianceTexture = createTexture(SpecularTextureSize, SpecularMipmapLevelCount);
+	env.needsUpload = false;
+
+	return true;
+}
+
+void EnvironmentSystem::StoreToCache(EnvironmentComponent& env)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	env.needsCacheStore = false;
+
+	if (env.textures.environmentTexture == TextureId::Null ||
+		env.textures.diffuseIrradianceTexture == TextureId::Null ||
+		env.textures.specularIrradianceTexture == TextureId::Null)
+		return;
+
+	Array<uint8_t> data(allocator);
+
+	auto readTexture = [&](TextureId textureId, int size, int levels)
+	{
+		const TextureData& texture = textureManager->GetTextureData(textureId);
+
+		for (int mip = 0; mip < levels; ++mip)
+		{
+			size_t levelSize = GetCubemapFaceByteSize(size >> mip) * CubemapSideCount;
+			size_t offset = data.GetCount();
+			data.Resize(offset + levelSize);
+
+			renderDevice->GetTextureImage(texture.textureObjectId, mip, RenderTextureBaseFormat::RGB,
+				RenderTextureDataType::HalfFloat, static_cast<int>(levelSize), data.GetData() + offset);
+		}
+	};
+
+	readTexture(env.textures.environmentTexture, EnvironmentTextureSize, 1);
+	readTexture(env.textures.diffuseIrradianceTexture, DiffuseTextureSize, 1);
+	readTexture(env.textures.specularIrradianceTexture, SpecularTextureSize, SpecularMipmapLevelCount);
+
+	cache->Store(env.cacheKey, data.GetView());
+}
+
 } // namespace kokko
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Core/Array.hpp"
+#include "Core/ArrayView.hpp"
 #include "Core/HashMap.hpp"
 #include "Core/Optional.hpp"
 #include "Core/String.hpp"
@@ -18,6 +19,7 @@ namespace kokko
 
 class Allocator;
 class AssetLoader;
+class EnvironmentCache;
 class Filesystem;
 class ModelManager;
 class ShaderManager;
@@ -63,13 +65,23 @@ private:
 		EnvironmentTextures textures;
 		float intensity;
 		bool needsUpload;
+
+		// Baked textures are read back on the next frame, after the bake has been rendered
+		bool needsCacheStore;
+		uint64_t cacheKey;
 	};
 
 	static const uint32_t CubemapSideCount = 6;
 	static const uint32_t SpecularMipmapLevelCount = 6;
 
+	static const int EnvironmentTextureSize = 1024;
+	static const int SpecularTextureSize = 256;
+	static const int DiffuseTextureSize = 32;
+
 	Allocator* allocator;
 	AssetLoader* assetLoader;
+	Filesystem* filesystem;
+	EnvironmentCache* cache;
 	kokko::render::Device* renderDevice;
 	ShaderManager* shaderManager;
 	ModelManager* modelManager;
@@ -91,14 +103,22 @@ private:
 	render::SamplerId samplerId;
 	ModelId cubeMeshId;
 
+	// Hash of the bake shaders and texture sizes, used as the seed of cache keys
+	uint64_t bakeHash;
+
 	bool resourcesUploaded;
 
 	void LoadEmptyEnvironmentMap();
 
+	uint64_t CalculateBakeHash();
+	bool LoadFromCache(EnvironmentComponent& env, ArrayView<const uint8_t> data);
+	void StoreToCache(EnvironmentComponent& env);
+
 public:
 	EnvironmentSystem(
 		Allocator* allocator,
 		AssetLoader* assetLoader,
+		Filesystem* filesystem,
 		kokko::render::Device* renderDevice,
 		ShaderManager* shaderManager,
 		ModelManager* modelManager,
@@ -25,21 +25,21 @@ static const int KernelExtent = 2;
 
 struct ExtractUniforms
 {
-	alignas(8) Vec2f textureScale;
+	alignas(8) Vec2f sourceSize;
 	alignas(4) float threshold;
 	alignas(4) float softThreshold;
 };
 
 struct DownsampleUniforms
 {
-	alignas(16) Vec2f textureScale;
+	alignas(16) Vec2f sourceSize;
 };
 
 struct UpsampleUniforms
 {
 	UniformBlockArray<float, MaxKernelSize> kernel;
 
-	alignas(8) Vec2f textureScale;
+	alignas(8) Vec2f sourceSize;
 	alignas(4) int kernelExtent;
 };
 
@@ -47,7 +47,7 @@ struct ApplyUniforms
 {
 	UniformBlockArray<float, MaxKernelSize> kernel;
 
-	alignas(8) Vec2f textureScale;
+	alignas(8) Vec2f sourceSize;
 	alignas(4) int kernelExtent;
 	alignas(4) float intensity;
 };
@@ -168,7 +168,7 @@ void GraphicsFeatureBloom::Upload(const UploadParameters& parameters)
 	currentDestination = &renderTargets[0];
 
 	auto extractBlock = reinterpret_cast<ExtractUniforms*>(&uniformStagingBuffer[uniformBlockStride * renderPasses.GetCount()]);
-	extractBlock->textureScale = Vec2f(1.0f / framebufferSize.x, 1.0f / framebufferSize.y);
+	extractBlock->sourceSize = framebufferSize.As<float>();
 	extractBlock->threshold = bloomThreshold;
 	extractBlock->softThreshold = bloomSoftThreshold;
 
@@ -200,7 +200,7 @@ void GraphicsFeatureBloom::Upload(const UploadParameters& parameters)
 
 		DownsampleUniforms* block = 
 			reinterpret_cast<DownsampleUniforms*>(&uniformStagingBuffer[uniformBlockStride * renderPasses.GetCount()]);
-		block->textureScale = Vec2f(1.0f / currentSource->size.x, 1.0f / currentSource->size.y);
+		block->sourceSize = currentSource->size.As<float>();
 
 		pass.textureIds[0] = currentSource->colorTexture;
 		pass.samplerIds[0] = downsamplePassSampler;
@@ -228,7 +228,7 @@ void GraphicsFeatureBloom::Upload(const UploadParameters& parameters)
 		for (size_t i = 0; i < MaxKernelSize; ++i)
 			block->kernel[i] = blurKernel[i];
 
-		block->textureScale = Vec2f(1.0f / currentSource->size.x, 1.0f / currentSource->size.y);
+		block->sourceSize = currentSource->size.As<float>();
 		block->kernelExtent = KernelExtent;
 
 		currentDestination = &renderTargets[rtIdx];
@@ -254,7 +254,7 @@ void GraphicsFeatureBloom::Upload(const UploadParameters& parameters)
 	for (size_t i = 0; i < MaxKernelSize; ++i)
 		applyBlock->kernel[i] = blurKernel[i];
 
-	applyBlock->textureScale = Vec2f(1.0f / currentSource->size.x, 1.0f / currentSource->size.y);
+	applyBlock->sourceSize = currentSource->size.As<float>();
 	applyBlock->kernelExtent = KernelExtent;
 	applyBlock->intensity = bloomIntensity;
 
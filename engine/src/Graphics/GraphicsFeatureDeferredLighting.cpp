@@ -65,6 +65,7 @@ struct LightingUniformBlock
 GraphicsFeatureDeferredLighting::GraphicsFeatureDeferredLighting(Allocator* allocator) :
 	lightResultArray(allocator),
 	shaderId(ShaderId::Null),
+	calcBrdfShaderId(ShaderId::Null),
 	meshId(ModelId::Null),
 	renderOrder(0),
 	uniformBufferId(0),
@@ -92,6 +93,9 @@ void GraphicsFeatureDeferredLighting::Initialize(const InitializeParameters& par
 	ConstStringView shaderPath("engine/shaders/deferred_lighting/lighting.glsl");
 	shaderId = parameters.shaderManager->FindShaderByPath(shaderPath);
 
+	ConstStringView calcBrdfShaderPath("engine/shaders/preprocess/calc_brdf_lut.glsl");
+	calcBrdfShaderId = parameters.shaderManager->FindShaderByPath(calcBrdfShaderPath);
+
 	// Create screen filling quad
 	meshId = MeshPresets::CreatePlane(parameters.modelManager);
 }
@@ -370,8 +374,6 @@ void GraphicsFeatureDeferredLighting::Render(const RenderParameters& parameters)
 		encoder->BindFramebuffer(brdfLutFramebufferId);
 		encoder->SetViewport(0, 0, BrdfLutSize, BrdfLutSize);
 
-		ConstStringView path("engine/shaders/preprocess/calc_brdf_lut.glsl");
-		ShaderId calcBrdfShaderId = parameters.shaderManager->FindShaderByPath(path);
 		const ShaderData& calcBrdfShader = parameters.shaderManager->GetShaderData(calcBrdfShaderId);
 		encoder->UseShaderProgram(calcBrdfShader.driverId);
 
@@ -34,6 +34,7 @@ private:
 	Array<LightId> lightResultArray;
 
 	ShaderId shaderId;
+	ShaderId calcBrdfShaderId;
 
 	ModelId meshId;
 
@@ -9,6 +9,7 @@
 
 #include "Rendering/PostProcessRenderer.hpp"
 #include "Rendering/PostProcessRenderPass.hpp"
+#include "Rendering/RenderDebugSettings.hpp"
 #include "Rendering/RenderDevice.hpp"
 #include "Rendering/RenderTypes.hpp"
 #include "Rendering/RenderGraphResources.hpp"
@@ -29,6 +30,10 @@ static constexpr size_t KernelSize = 16;
 static constexpr unsigned int NoiseTextureSize = 4;
 static constexpr unsigned int UniformBlockBinding = 0;
 
+// With temporal accumulation, the kernel is split over this many frames
+static constexpr unsigned int TemporalKernelSplit = 2;
+static constexpr float TemporalHistoryWeight = 0.8f;
+
 struct OcclusionUniformBlock
 {
 	UniformBlockArray<Vec3f, MaxKernelSize> kernel;
@@ -37,26 +42,59 @@ struct OcclusionUniformBlock
 	alignas(8) Vec2f noiseScale;
 	alignas(4) float sampleRadius;
 	alignas(4) int kernelSize;
+	alignas(4) int kernelOffset;
 };
 
 struct BlurUniformBlock
 {
-	alignas(16) Vec2f textureScale;
+	alignas(16) Vec2f occlusionSize;
+};
+
+struct TemporalUniformBlock
+{
+	alignas(16) Mat4x4f projection;
+	alignas(16) Mat4x4f reprojection;
+	alignas(8) Vec2f halfNearPlane;
+	alignas(4) float historyWeight;
+	alignas(4) int historyValid;
+	alignas(8) Vec2f occlusionSize;
+};
+
+struct UpsampleUniformBlock
+{
+	alignas(16) Mat4x4f projection;
+	alignas(8) Vec2f occlusionSize;
 };
 
+int GetResolutionDivisor(SsaoResolution resolution)
+{
+	switch (resolution)
+	{
+	case SsaoResolution::Half: return 2;
+	case SsaoResolution::Quarter: return 4;
+	default: return 1;
+	}
+}
+
 } // Anonymous namespace
 
 GraphicsFeatureSsao::GraphicsFeatureSsao(Allocator* allocator) :
 	allocator(allocator),
 	kernel(allocator),
 	renderOrder(0),
-	noiseTextureId(0)
+	noiseTextureId(0),
+	fullResolution(true),
+	temporalAccumulation(false),
+	occlusionTarget{},
+	historyWriteIndex(0),
+	historyValid(false),
+	frameIndex(0)
 {
-	uniformBufferIds[0] = render::BufferId();
-	uniformBufferIds[1] = render::BufferId();
-
-	shaderIds[0] = ShaderId::Null;
-	shaderIds[1] = ShaderId::Null;
+	for (size_t i = 0; i < PassCount; ++i)
+	{
+		uniformBufferIds[i] = render::BufferId();
+		shaderIds[i] = ShaderId::Null;
+	}
 }
 
 void GraphicsFeatureSsao::SetOrder(unsigned int order)
@@ -70,6 +108,9 @@ void GraphicsFeatureSsao::Initialize(const InitializeParameters& parameters)
 
 	kokko::render::Device* device = parameters.renderDevice;
 
+	historyFramebuffers[0].SetRenderDevice(device);
+	historyFramebuffers[1].SetRenderDevice(device);
+
 	kernel.Resize(KernelSize);
 	for (int i = 0; i < KernelSize;)
 	{
@@ -114,12 +155,16 @@ void GraphicsFeatureSsao::Initialize(const InitializeParameters& parameters)
 
 	kokko::ConstStringView shaderPaths[PassCount] = {
 		kokko::ConstStringView("engine/shaders/post_process/ssao_occlusion.glsl"),
-		kokko::ConstStringView("engine/shaders/post_process/ssao_blur.glsl")
+		kokko::ConstStringView("engine/shaders/post_process/ssao_blur.glsl"),
+		kokko::ConstStringView("engine/shaders/post_process/ssao_temporal.glsl"),
+		kokko::ConstStringView("engine/shaders/post_process/ssao_upsample.glsl")
 	};
 
 	size_t uniformSizes[PassCount] = {
 		sizeof(OcclusionUniformBlock),
-		sizeof(BlurUniformBlock)
+		sizeof(BlurUniformBlock),
+		sizeof(TemporalUniformBlock),
+		sizeof(UpsampleUniformBlock)
 	};
 
 	device->CreateBuffers(static_cast<unsigned int>(PassCount), uniformBufferIds);
@@ -135,6 +180,7 @@ void GraphicsFeatureSsao::Initialize(const InitializeParameters& parameters)
 }
 void GraphicsFeatureSsao::Deinitialize(const InitializeParameters& parameters)
 {
+	DestroyHistory();
 }
 void GraphicsFeatureSsao::Upload(const UploadParameters& parameters)
 {
@@ -143,28 +189,89 @@ void GraphicsFeatureSsao::Upload(const UploadParameters& parameters)
 	kokko::render::Device* device = parameters.renderDevice;
 	Vec2i framebufferSize = parameters.viewports[parameters.fullscreenViewportIndex].viewportRectangle.size;
 
+	SsaoResolution resolution = parameters.renderDebug.GetSsaoResolution();
+	int divisor = GetResolutionDivisor(resolution);
+
+	occlusionSize.x = (framebufferSize.x + divisor - 1) / divisor;
+	occlusionSize.y = (framebufferSize.y + divisor - 1) / divisor;
+	fullResolution = divisor == 1;
+	temporalAccumulation = parameters.renderDebug.IsFeatureEnabled(RenderDebugFeatureFlag::SsaoTemporalAccumulation);
+
+	// Acquired here, because the pooled texture can be larger than the occlusion size
+	RenderTargetContainer* renderTargetContainer = parameters.postProcessRenderer->GetRenderTargetContainer();
+	occlusionTarget = renderTargetContainer->AcquireRenderTarget(occlusionSize, RenderTextureSizedFormat::R8);
+
 	float noiseSizef = static_cast<float>(NoiseTextureSize);
 
 	const ProjectionParameters& projection = parameters.cameraParameters.projection;
 	bool reverseDepth = true;
 	Mat4x4f projectionMat = parameters.cameraParameters.projection.GetProjectionMatrix(reverseDepth);
+	Mat4x4f viewProjection = projectionMat * parameters.cameraParameters.transform.inverse;
+
+	Vec2f halfNearPlane;
+	halfNearPlane.y = std::tan(projection.perspectiveFieldOfView * 0.5f);
+	halfNearPlane.x = halfNearPlane.y * projection.aspect;
 
 	OcclusionUniformBlock occlusionUniforms;
 	occlusionUniforms.projection = projectionMat;
-	occlusionUniforms.halfNearPlane.y = std::tan(projection.perspectiveFieldOfView * 0.5f);
-	occlusionUniforms.halfNearPlane.x = occlusionUniforms.halfNearPlane.y * projection.aspect;
-	occlusionUniforms.noiseScale = Vec2f(framebufferSize.x / noiseSizef, framebufferSize.y / noiseSizef);
+	occlusionUniforms.halfNearPlane = halfNearPlane;
+	occlusionUniforms.noiseScale = Vec2f(occlusionSize.x / noiseSizef, occlusionSize.y / noiseSizef);
 	occlusionUniforms.sampleRadius = 0.5f;
 	occlusionUniforms.kernelSize = KernelSize;
+	occlusionUniforms.kernelOffset = 0;
 
 	for (size_t i = 0; i < KernelSize; ++i)
 		occlusionUniforms.kernel[i] = kernel[i];
 
-	BlurUniformBlock blurUniforms;
-	blurUniforms.textureScale = Vec2f(1.0f / framebufferSize.x, 1.0f / framebufferSize.y);
+	if (temporalAccumulation)
+	{
+		if (historyFramebuffers[0].IsInitialized() == false || historyFramebuffers[0].GetSize() != occlusionSize)
+			CreateHistory(occlusionSize);
+
+		historyWriteIndex = 1 - historyWriteIndex;
+
+		// Take a different subset of the kernel on each frame
+		unsigned int subsetSize = KernelSize / TemporalKernelSplit;
+		occlusionUniforms.kernelSize = subsetSize;
+		occlusionUniforms.kernelOffset = (frameIndex % TemporalKernelSplit) * subsetSize;
+
+		TemporalUniformBlock temporalUniforms;
+		temporalUniforms.projection = projectionMat;
+		temporalUniforms.reprojection = previousViewProjection * parameters.cameraParameters.transform.forward;
+		temporalUniforms.halfNearPlane = halfNearPlane;
+		temporalUniforms.historyWeight = TemporalHistoryWeight;
+		temporalUniforms.historyValid = historyValid ? 1 : 0;
+		temporalUniforms.occlusionSize = occlusionSize.As<float>();
+
+		device->SetBufferSubData(uniformBufferIds[PassIdx_Temporal], 0, sizeof(TemporalUniformBlock), &temporalUniforms);
+
+		historyValid = true;
+	}
+	else if (historyFramebuffers[0].IsInitialized())
+	{
+		DestroyHistory();
+	}
+
+	previousViewProjection = viewProjection;
+	frameIndex += 1;
 
 	device->SetBufferSubData(uniformBufferIds[PassIdx_Occlusion], 0, sizeof(OcclusionUniformBlock), &occlusionUniforms);
-	device->SetBufferSubData(uniformBufferIds[PassIdx_Blur], 0, sizeof(BlurUniformBlock), &blurUniforms);
+
+	if (fullResolution && temporalAccumulation == false)
+	{
+		BlurUniformBlock blurUniforms;
+		blurUniforms.occlusionSize = occlusionSize.As<float>();
+
+		device->SetBufferSubData(uniformBufferIds[PassIdx_Blur], 0, sizeof(BlurUniformBlock), &blurUniforms);
+	}
+	else
+	{
+		UpsampleUniformBlock upsampleUniforms;
+		upsampleUniforms.projection = projectionMat;
+		upsampleUniforms.occlusionSize = occlusionSize.As<float>();
+
+		device->SetBufferSubData(uniformBufferIds[PassIdx_Upsample], 0, sizeof(UpsampleUniformBlock), &upsampleUniforms);
+	}
 }
 
 void GraphicsFeatureSsao::Submit(const SubmitParameters& parameters)
@@ -177,25 +284,25 @@ void GraphicsFeatureSsao::Render(const RenderParameters& parameters)
 {
 	Vec2i framebufferSize = parameters.viewports[parameters.fullscreenViewportIndex].viewportRectangle.size;
 
-	// Get render targets
-
 	PostProcessRenderer* postProcessRenderer = parameters.postProcessRenderer;
 	RenderTargetContainer* renderTargetContainer = postProcessRenderer->GetRenderTargetContainer();
 
-	RenderTextureSizedFormat format = RenderTextureSizedFormat::R8;
-	RenderTarget occlusionTarget = renderTargetContainer->AcquireRenderTarget(framebufferSize, format);
+	render::TextureId depthTextureId = parameters.renderGraphResources->GetGeometryBuffer().GetDepthTextureId();
+	render::FramebufferId outputFramebufferId =
+		parameters.renderGraphResources->GetAmbientOcclusionBuffer().GetFramebufferId();
 
 	PostProcessRenderPass renderPasses[PassCount];
+	unsigned int passCount = 0;
 
 	// SSAO occlusion pass
 
-	PostProcessRenderPass& occlusionPass = renderPasses[PassIdx_Occlusion];
+	PostProcessRenderPass& occlusionPass = renderPasses[passCount++];
 
 	occlusionPass.textureNameHashes[0] = "g_normal"_hash;
 	occlusionPass.textureNameHashes[1] = "g_depth"_hash;
 	occlusionPass.textureNameHashes[2] = "noise_texture"_hash;
 	occlusionPass.textureIds[0] = parameters.renderGraphResources->GetGeometryBufferNormalTexture();
-	occlusionPass.textureIds[1] = parameters.renderGraphResources->GetGeometryBuffer().GetDepthTextureId();
+	occlusionPass.textureIds[1] = depthTextureId;
 	occlusionPass.textureIds[2] = noiseTextureId;
 	occlusionPass.samplerIds[0] = render::SamplerId();
 	occlusionPass.samplerIds[1] = render::SamplerId();
@@ -208,32 +315,122 @@ void GraphicsFeatureSsao::Render(const RenderParameters& parameters)
 	occlusionPass.uniformBufferRangeSize = sizeof(OcclusionUniformBlock);
 
 	occlusionPass.framebufferId = occlusionTarget.framebuffer;
-	occlusionPass.viewportSize = framebufferSize;
+	occlusionPass.viewportSize = occlusionSize;
 	occlusionPass.shaderId = shaderIds[PassIdx_Occlusion];
 	occlusionPass.enableBlending = false;
 
-	// SSAO blur pass
+	render::TextureId occlusionTextureId = occlusionTarget.colorTexture;
+
+	// SSAO temporal accumulation pass
 
-	PostProcessRenderPass& blurPass = renderPasses[PassIdx_Blur];
+	if (temporalAccumulation)
+	{
+		const render::Framebuffer& historyRead = historyFramebuffers[1 - historyWriteIndex];
+		const render::Framebuffer& historyWrite = historyFramebuffers[historyWriteIndex];
+
+		PostProcessRenderPass& temporalPass = renderPasses[passCount++];
+
+		temporalPass.textureNameHashes[0] = "occlusion_map"_hash;
+		temporalPass.textureNameHashes[1] = "history_map"_hash;
+		temporalPass.textureNameHashes[2] = "g_depth"_hash;
+		temporalPass.textureIds[0] = occlusionTarget.colorTexture;
+		temporalPass.textureIds[1] = historyRead.GetColorTextureId(0);
+		temporalPass.textureIds[2] = depthTextureId;
+		temporalPass.samplerIds[0] = render::SamplerId();
+		temporalPass.samplerIds[1] = render::SamplerId();
+		temporalPass.samplerIds[2] = render::SamplerId();
+		temporalPass.textureCount = 3;
+
+		temporalPass.uniformBufferId = uniformBufferIds[PassIdx_Temporal];
+		temporalPass.uniformBindingPoint = UniformBlockBinding::Object;
+		temporalPass.uniformBufferRangeStart = 0;
+		temporalPass.uniformBufferRangeSize = sizeof(TemporalUniformBlock);
+
+		temporalPass.framebufferId = historyWrite.GetFramebufferId();
+		temporalPass.viewportSize = occlusionSize;
+		temporalPass.shaderId = shaderIds[PassIdx_Temporal];
+		temporalPass.enableBlending = false;
+
+		occlusionTextureId = historyWrite.GetColorTextureId(0);
+	}
 
-	blurPass.textureNameHashes[0] = "occlusion_map"_hash;
-	blurPass.textureIds[0] = occlusionTarget.colorTexture;
-	blurPass.samplerIds[0] = render::SamplerId();
-	blurPass.textureCount = 1;
+	if (fullResolution && temporalAccumulation == false)
+	{
+		// SSAO blur pass
 
-	blurPass.uniformBufferId = uniformBufferIds[PassIdx_Blur];
-	blurPass.uniformBindingPoint = UniformBlockBinding::Object;
-	blurPass.uniformBufferRangeStart = 0;
-	blurPass.uniformBufferRangeSize = sizeof(OcclusionUniformBlock);
+		PostProcessRenderPass& blurPass = renderPasses[passCount++];
 
-	blurPass.framebufferId = parameters.renderGraphResources->GetAmbientOcclusionBuffer().GetFramebufferId();
-	blurPass.viewportSize = framebufferSize;
-	blurPass.shaderId = shaderIds[PassIdx_Blur];
-	blurPass.enableBlending = false;
+		blurPass.textureNameHashes[0] = "occlusion_map"_hash;
+		blurPass.textureIds[0] = occlusionTextureId;
+		blurPass.samplerIds[0] = render::SamplerId();
+		blurPass.textureCount = 1;
 
-	postProcessRenderer->RenderPasses(PassCount, renderPasses);
+		blurPass.uniformBufferId = uniformBufferIds[PassIdx_Blur];
+		blurPass.uniformBindingPoint = UniformBlockBinding::Object;
+		blurPass.uniformBufferRangeStart = 0;
+		blurPass.uniformBufferRangeSize = sizeof(BlurUniformBlock);
+
+		blurPass.framebufferId = outputFramebufferId;
+		blurPass.viewportSize = framebufferSize;
+		blurPass.shaderId = shaderIds[PassIdx_Blur];
+		blurPass.enableBlending = false;
+	}
+	else
+	{
+		// SSAO depth-aware blur and upsample pass
+
+		PostProcessRenderPass& upsamplePass = renderPasses[passCount++];
+
+		upsamplePass.textureNameHashes[0] = "occlusion_map"_hash;
+		upsamplePass.textureNameHashes[1] = "g_depth"_hash;
+		upsamplePass.textureIds[0] = occlusionTextureId;
+		upsamplePass.textureIds[1] = depthTextureId;
+		upsamplePass.samplerIds[0] = render::SamplerId();
+		upsamplePass.samplerIds[1] = render::SamplerId();
+		upsamplePass.textureCount = 2;
+
+		upsamplePass.uniformBufferId = uniformBufferIds[PassIdx_Upsample];
+		upsamplePass.uniformBindingPoint = UniformBlockBinding::Object;
+		upsamplePass.uniformBufferRangeStart = 0;
+		upsamplePass.uniformBufferRangeSize = sizeof(UpsampleUniformBlock);
+
+		upsamplePass.framebufferId = outputFramebufferId;
+		upsamplePass.viewportSize = framebufferSize;
+		upsamplePass.shaderId = shaderIds[PassIdx_Upsample];
+		upsamplePass.enableBlending = false;
+	}
+
+	postProcessRenderer->RenderPasses(passCount, renderPasses);
 
 	renderTargetContainer->ReleaseRenderTarget(occlusionTarget.id);
+	occlusionTarget = RenderTarget{};
+}
+
+void GraphicsFeatureSsao::CreateHistory(const Vec2i& size)
+{
+	DestroyHistory();
+
+	RenderTextureSizedFormat format = RenderTextureSizedFormat::RG16F;
+
+	for (size_t i = 0; i < KOKKO_ARRAY_ITEMS(historyFramebuffers); ++i)
+	{
+		historyFramebuffers[i].Create(size.x, size.y, Optional<RenderTextureSizedFormat>(), ArrayView(&format, 1));
+		historyFramebuffers[i].SetDebugLabel(ConstStringView("SSAO history framebuffer"));
+	}
+
+	historyWriteIndex = 0;
+	historyValid = false;
+
+	// Restart the kernel subset sequence, so that accumulation is repeatable from a fresh history
+	frameIndex = 0;
+}
+
+void GraphicsFeatureSsao::DestroyHistory()
+{
+	for (size_t i = 0; i < KOKKO_ARRAY_ITEMS(historyFramebuffers); ++i)
+		historyFramebuffers[i].Destroy();
+
+	historyValid = false;
 }
 
 }
@@ -2,11 +2,15 @@
 
 #include "Core/Array.hpp"
 
+#include "Math/Mat4x4.hpp"
+#include "Math/Vec2.hpp"
 #include "Math/Vec3.hpp"
 
 #include "Graphics/GraphicsFeature.hpp"
 
+#include "Rendering/Framebuffer.hpp"
 #include "Rendering/RenderResourceId.hpp"
+#include "Rendering/RenderTargetContainer.hpp"
 
 #include "Resources/ShaderId.hpp"
 
@@ -15,6 +19,12 @@ namespace kokko
 
 class Allocator;
 
+/*
+* Screen space ambient occlusion. Occlusion can be calculated at half or quarter
+* resolution, in which case a depth-aware blur upsamples it to the full resolution.
+* Temporal accumulation takes half of the kernel samples each frame and blends the
+* result with the previous frame's occlusion, reprojected with the previous camera.
+*/
 class GraphicsFeatureSsao : public GraphicsFeature
 {
 public:
@@ -30,18 +40,34 @@ public:
 	virtual void Render(const RenderParameters& parameters) override;
 
 private:
+	void CreateHistory(const Vec2i& size);
+	void DestroyHistory();
+
 	Allocator* allocator;
 	Array<Vec3f> kernel;
 
 	unsigned int renderOrder;
 
-	static const size_t PassCount = 2;
-	enum { PassIdx_Occlusion = 0, PassIdx_Blur = 1 };
+	static const size_t PassCount = 4;
+	enum { PassIdx_Occlusion = 0, PassIdx_Blur = 1, PassIdx_Temporal = 2, PassIdx_Upsample = 3 };
 
 	kokko::render::BufferId uniformBufferIds[PassCount];
 	ShaderId shaderIds[PassCount];
 
 	kokko::render::TextureId noiseTextureId;
+
+	// Set in Upload for the current frame
+	Vec2i occlusionSize;
+	bool fullResolution;
+	bool temporalAccumulation;
+	RenderTarget occlusionTarget;
+
+	// Temporal accumulation state
+	render::Framebuffer historyFramebuffers[2];
+	unsigned int historyWriteIndex;
+	bool historyValid;
+	Mat4x4f previousViewProjection;
+	unsigned int frameIndex;
 };
 
 }
@@ -63,9 +63,10 @@ ParticleSystem::ParticleSystem(
 	finishUpdateShaderId(ShaderId{ 0 }),
 	renderShaderId(ShaderId{ 0 }),
 	noiseTextureId(0),
+	data(allocator, "ParticleSystem.data"),
 	entityMap(allocator)
 {
-	data = InstanceData{};
+	data.Add(); // Reserve index 0 as ParticleEmitterId::Null value
 }
 
 ParticleSystem::~ParticleSystem()
@@ -137,10 +138,10 @@ void ParticleSystem::Upload(const UploadParameters& parameters)
 	double currentTime = Time::GetRunningTime();
 	float deltaTime = Time::GetDeltaTime();
 
-	for (unsigned int i = 1; i < data.count; ++i)
+	for (unsigned int i = 1; i < data.GetCount(); ++i)
 	{
-		EmitterData& emitter = data.emitter[i];
-		const Mat4x4f& transform = data.transform[i];
+		EmitterData& emitter = data.Get<Column::Emitter>()[i];
+		const Mat4x4f& transform = data.Get<Column::Transform>()[i];
 
 		if (emitter.bufferIds[0] == 0)
 			InitializeEmitter(renderDevice, ParticleEmitterId{ i });
@@ -180,11 +181,11 @@ void ParticleSystem::Upload(const UploadParameters& parameters)
 
 void ParticleSystem::Submit(const SubmitParameters& parameters)
 {
-	assert(data.count <= UINT16_MAX);
+	assert(data.GetCount() <= UINT16_MAX);
 
-	for (unsigned int i = 1; i < data.count; ++i)
+	for (unsigned int i = 1; i < data.GetCount(); ++i)
 	{
-		EmitterData& emitter = data.emitter[i];
+		EmitterData& emitter = data.Get<Column::Emitter>()[i];
 		float depth = 0.0f; // TODO: Calculate
 		parameters.commandList->AddToViewport(
 			parameters.fullscreenViewportIndex, RenderPassType::Transparent, depth, static_cast<uint16_t>(i));
@@ -196,7 +197,7 @@ void ParticleSystem::Render(const RenderParameters& parameters)
 	KOKKO_PROFILE_FUNCTION();
 
 	render::CommandEncoder* encoder = parameters.encoder;
-	EmitterData& emitter = data.emitter[parameters.featureObjectId];
+	EmitterData& emitter = data.Get<Column::Emitter>()[parameters.featureObjectId];
 
 	MemoryBarrierFlags shaderStorageBarrier{};
 	shaderStorageBarrier.shaderStorage = true;
@@ -289,7 +290,7 @@ void ParticleSystem::NotifyUpdatedTransforms(size_t count, const Entity* entitie
 		Entity entity = entities[i];
 		ParticleEmitterId id = Lookup(entity);
 		if (id != ParticleEmitterId::Null)
-			data.transform[id.i] = transforms[i];
+			data.Get<Column::Transform>()[id.i] = transforms[i];
 	}
 }
 
@@ -308,127 +309,84 @@ ParticleEmitterId ParticleSystem::AddEmitter(Entity entity)
 
 void ParticleSystem::AddEmitters(unsigned int count, const Entity* entities, ParticleEmitterId* emitterIdsOut)
 {
-	if (data.count + count > data.allocated)
-		this->ReallocateEmitters(data.count + count);
+	unsigned int first = data.Add(count);
+
+	// Reserve same amount in entity map
+	entityMap.Reserve(data.GetCapacity());
 
 	for (unsigned int i = 0; i < count; ++i)
 	{
-		unsigned int id = data.count + i;
+		unsigned int id = first + i;
 
 		Entity e = entities[i];
 
 		auto mapPair = entityMap.Insert(e.id);
 		mapPair->second.i = id;
 
-		data.entity[id] = e;
-		data.transform[id] = Mat4x4f();
-		data.emitter[id] = EmitterData{};
+		data.Get<Column::Entity>()[id] = e;
+		data.Get<Column::Transform>()[id] = Mat4x4f();
+		data.Get<Column::Emitter>()[id] = EmitterData{};
 
 		emitterIdsOut[i].i = id;
 	}
-
-	data.count += count;
 }
 
 void ParticleSystem::RemoveEmitter(ParticleEmitterId id)
 {
 	assert(id != ParticleEmitterId::Null);
-	assert(id.i < data.count);
+	assert(id.i < data.GetCount());
 
 	// Remove from entity map
-	Entity entity = data.entity[id.i];
+	Entity entity = data.Get<Column::Entity>()[id.i];
 	auto* pair = entityMap.Lookup(entity.id);
 	if (pair != nullptr)
 		entityMap.Remove(pair);
 
 	DeinitializeEmitter(renderDevice, id);
 
-	if (data.count > 2 && id.i + 1 < data.count) // We need to swap another object
+	if (id.i + 1 < data.GetCount()) // We need to swap another object
 	{
-		unsigned int swapIdx = data.count - 1;
+		unsigned int swapIdx = data.GetCount() - 1;
 
 		// Update the swapped objects id in the entity map
-		auto* swapKv = entityMap.Lookup(data.entity[swapIdx].id);
+		auto* swapKv = entityMap.Lookup(data.Get<Column::Entity>()[swapIdx].id);
 		if (swapKv != nullptr)
 			swapKv->second = id;
-
-		data.entity[id.i] = data.entity[swapIdx];
-		data.transform[id.i] = data.transform[swapIdx];
-		data.emitter[id.i] = data.emitter[swapIdx];
 	}
 
-	--data.count;
+	data.RemoveSwap(id.i);
 }
 
 void ParticleSystem::RemoveAll()
 {
-	for (unsigned int i = 1; i < data.count; ++i)
+	for (unsigned int i = 1; i < data.GetCount(); ++i)
 	{
 		DeinitializeEmitter(renderDevice, ParticleEmitterId{ i });
 	}
 
 	entityMap.Clear();
-	data.count = 1;
+	data.SetCount(1);
 }
 
 float ParticleSystem::GetEmitRate(ParticleEmitterId id) const
 {
 	assert(id != ParticleEmitterId::Null);
-	assert(id.i < data.count);
-	return data.emitter[id.i].emitRate;
+	assert(id.i < data.GetCount());
+	return data.Get<Column::Emitter>()[id.i].emitRate;
 }
 
 void ParticleSystem::SetEmitRate(ParticleEmitterId id, float rate)
 {
 	assert(id != ParticleEmitterId::Null);
-	assert(id.i < data.count);
-	data.emitter[id.i].emitRate = rate;
-}
-
-void ParticleSystem::ReallocateEmitters(unsigned int requiredCount)
-{
-	if (requiredCount <= data.allocated)
-		return;
-
-	static const unsigned int MinAllocation = 16;
-	if (requiredCount < MinAllocation)
-		requiredCount = MinAllocation;
-
-	requiredCount = static_cast<unsigned int>(Math::UpperPowerOfTwo(requiredCount));
-
-	// Reserve same amount in entity map
-	entityMap.Reserve(requiredCount);
-
-	InstanceData newData;
-	unsigned int bytes = requiredCount * (sizeof(Entity) + sizeof(Mat4x4f) + sizeof(EmitterData));
-
-	newData.buffer = this->allocator->Allocate(bytes, "ParticleSystem InstanceData cmdBuffer");
-	newData.count = data.count;
-	newData.allocated = requiredCount;
-
-	newData.entity = static_cast<Entity*>(newData.buffer);
-	newData.transform = reinterpret_cast<Mat4x4f*>(newData.entity + requiredCount);
-	newData.emitter = reinterpret_cast<EmitterData*>(newData.transform + requiredCount);
-
-	if (data.buffer != nullptr)
-	{
-		std::memcpy(newData.entity, data.entity, data.count * sizeof(Entity));
-		std::memcpy(newData.transform, data.transform, data.count * sizeof(Mat4x4f));
-		std::memcpy(newData.emitter, data.emitter, data.count * sizeof(EmitterData));
-
-		this->allocator->Deallocate(data.buffer);
-	}
-	else
-		newData.count = 1;
-
-	data = newData;
+	assert(id.i < data.GetCount());
+	data.Get<Column::Emitter>()[id.i].emitRate = rate;
 }
 
 void ParticleSystem::InitializeEmitter(kokko::render::Device* renderDevice, ParticleEmitterId id)
 {
 	// Create the GPU buffers we need for updating and rendering our particles
 
-	EmitterData& emitter = data.emitter[id.i];
+	EmitterData& emitter = data.Get<Column::Emitter>()[id.i];
 	kokko::render::BufferId* bufferIds = emitter.bufferIds;
 
 	renderDevice->CreateBuffers(Buffer_COUNT, emitter.bufferIds);
@@ -512,7 +470,7 @@ void ParticleSystem::InitializeEmitter(kokko::render::Device* renderDevice, Part
 
 void ParticleSystem::DeinitializeEmitter(kokko::render::Device* renderDevice, ParticleEmitterId id)
 {
-	EmitterData& emitter = data.emitter[id.i];
+	EmitterData& emitter = data.Get<Column::Emitter>()[id.i];
 
 	if (emitter.bufferIds[0] != 0)
 	{
@@ -4,10 +4,15 @@
 #include <cstdint>
 
 #include "Core/HashMap.hpp"
+#include "Core/SoaStorage.hpp"
+
+#include "Engine/Entity.hpp"
 
 #include "Graphics/GraphicsFeature.hpp"
 #include "Graphics/TransformUpdateReceiver.hpp"
 
+#include "Math/Mat4x4.hpp"
+
 #include "Resources/MeshId.hpp"
 #include "Resources/ShaderId.hpp"
 
@@ -20,8 +25,6 @@ class ShaderManager;
 class ModelManager;
 class Renderer;
 
-struct Entity;
-
 struct ParticleEmitterId
 {
 	unsigned int i;
@@ -122,21 +125,15 @@ private:
 		}
 	};
 
-	struct InstanceData
+	struct Column
 	{
-		unsigned int count;
-		unsigned int allocated;
-		void* buffer;
+		enum : size_t { Entity, Transform, Emitter };
+	};
 
-		Entity* entity;
-		Mat4x4f* transform;
-		EmitterData* emitter;
-	}
-	data;
+	SoaStorage<Entity, Mat4x4f, EmitterData> data;
 
 	HashMap<unsigned int, ParticleEmitterId> entityMap;
 
-	void ReallocateEmitters(unsigned int requiredCount);
 
 	void InitializeEmitter(kokko::render::Device* renderDevice, ParticleEmitterId id);
 	void DeinitializeEmitter(kokko::render::Device* renderDevice, ParticleEmitterId id);
@@ -2,6 +2,7 @@
 
 #include "Core/HashMap.hpp"
 #include "Core/Array.hpp"
+#include "Core/SoaStorage.hpp"
 #include "Core/SortedArray.hpp"
 #include "Core/StringView.hpp"
 
@@ -48,29 +49,28 @@ class Scene
 private:
 	Allocator* allocator;
 
-	struct InstanceData
+	struct Column
 	{
-		unsigned int count;
-		unsigned int allocated;
-		void* buffer;
-
-		Entity* entity;
-		Mat4x4f* local;
-		Mat4x4f* world;
-		SceneObjectId* parent;
-		SceneObjectId* firstChild;
-		SceneObjectId* nextSibling;
-		SceneObjectId* prevSibling;
-		SceneEditTransform* editTransform;
-	}
-	data;
+		enum : size_t
+		{
+			Entity,
+			Local,
+			World,
+			Parent,
+			FirstChild,
+			NextSibling,
+			PrevSibling,
+			EditTransform
+		};
+	};
+
+	SoaStorage<Entity, Mat4x4f, Mat4x4f, SceneObjectId, SceneObjectId,
+		SceneObjectId, SceneObjectId, SceneEditTransform> data;
 
 	HashMap<unsigned int, SceneObjectId> entityMap;
 	kokko::SortedArray<unsigned int> updatedEntities;
 	kokko::Array<Mat4x4f> updatedTransforms;
 
-	void Reallocate(unsigned int required);
-
 	// The specified object and all its children are updated
 	// The world transform is calculated and the objects are marked as updated
 	void UpdateWorldTransforms(SceneObjectId id);
@@ -103,18 +103,18 @@ public:
 
 	void Clear();
 
-	Entity GetEntity(SceneObjectId id) const { return data.entity[id.i]; }
-	SceneObjectId GetParent(SceneObjectId id) const { return data.parent[id.i]; }
-	SceneObjectId GetFirstChild(SceneObjectId id) const { return data.firstChild[id.i]; }
-	SceneObjectId GetNextSibling(SceneObjectId id) const { return data.nextSibling[id.i]; }
+	Entity GetEntity(SceneObjectId id) const { return data.Get<Column::Entity>()[id.i]; }
+	SceneObjectId GetParent(SceneObjectId id) const { return data.Get<Column::Parent>()[id.i]; }
+	SceneObjectId GetFirstChild(SceneObjectId id) const { return data.Get<Column::FirstChild>()[id.i]; }
+	SceneObjectId GetNextSibling(SceneObjectId id) const { return data.Get<Column::NextSibling>()[id.i]; }
 
 	void SetParent(SceneObjectId id, SceneObjectId parent);
 
 	void SetLocalTransform(SceneObjectId id, const Mat4x4f& transform);
 	void SetLocalAndEditTransform(SceneObjectId id, const Mat4x4f& local, const SceneEditTransform& edit);
 
-	const Mat4x4f& GetWorldTransform(SceneObjectId id) { return data.world[id.i]; }
-	const Mat4x4f& GetLocalTransform(SceneObjectId id) { return data.local[id.i]; }
+	const Mat4x4f& GetWorldTransform(SceneObjectId id) { return data.Get<Column::World>()[id.i]; }
+	const Mat4x4f& GetLocalTransform(SceneObjectId id) { return data.Get<Column::Local>()[id.i]; }
 
 	const SceneEditTransform& GetEditTransform(SceneObjectId id);
 	void SetEditTransform(SceneObjectId id, const SceneEditTransform& editTransform);
@@ -753,10 +753,7 @@ void TerrainQuadTree::LoadTiles()
 	for (auto itr = nodeHeightCache.begin(), end = nodeHeightCache.end(); itr != end; ++itr)
 	{
 		if (itr->second.lastAccessTime < oldCacheThresholdTime)
-		{
 			nodeHeightCache.Remove(itr);
-			break; // Only remove one entry per update as removal invalidates iterators
-		}
 	}
 }
 
@@ -0,0 +1,696 @@
+#include "Math/BoundingVolumeHierarchy.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "doctest/doctest.h"
+
+#include "Core/Core.hpp"
+
+#include "Math/Frustum.hpp"
+#include "Math/Intersect3D.hpp"
+#include "Math/Random.hpp"
+
+namespace kokko
+{
+
+namespace
+{
+
+// Enlarge dynamic leaves so that small movements don't require reinsertion
+constexpr float FatBoundsScale = 0.1f;
+constexpr float FatBoundsMinMargin = 0.1f;
+
+// Reinsert a leaf if its enlarged bounds have become this much larger than needed
+constexpr float FatBoundsShrinkRatio = 4.0f;
+
+constexpr uint32_t AllPlanesMask = (1 << 6) - 1;
+constexpr size_t MaxTraversalDepth = 128;
+
+struct TraversalEntry
+{
+	uint32_t node;
+	uint32_t planeMask;
+};
+
+BvhDetail::Box CreateFatBox(const AABB& bounds)
+{
+	float margin = FatBoundsMinMargin;
+	Vec3f extents = bounds.extents + bounds.extents * FatBoundsScale + Vec3f(margin, margin, margin);
+	return BvhDetail::Box{ bounds.center - extents, bounds.center + extents };
+}
+
+} // namespace
+
+namespace BvhDetail
+{
+
+Box Box::Union(const Box& a, const Box& b)
+{
+	Box result;
+	result.min = Vec3f(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z));
+	result.max = Vec3f(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z));
+	return result;
+}
+
+bool Box::Contains(const Box& other) const
+{
+	return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+		max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+}
+
+float Box::HalfSurfaceArea() const
+{
+	Vec3f d = max - min;
+	return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+FrustumTest TestFrustum(const FrustumPlanes& frustum, const Box& box, uint32_t& planeMask)
+{
+	Vec3f center = (box.min + box.max) * 0.5f;
+	Vec3f extents = (box.max - box.min) * 0.5f;
+
+	for (uint32_t planeIdx = 0; planeIdx < 6; ++planeIdx)
+	{
+		uint32_t planeBit = 1 << planeIdx;
+		if ((planeMask & planeBit) == 0)
+			continue;
+
+		const Plane& plane = frustum.planes[planeIdx];
+		Vec3f normalAbs(std::abs(plane.normal.x), std::abs(plane.normal.y), std::abs(plane.normal.z));
+
+		const float d = Vec3f::Dot(center, plane.normal) + plane.distance;
+		const float r = Vec3f::Dot(extents, normalAbs);
+
+		if (d + r < 0.0f)
+			return FrustumTest::Outside;
+
+		// Children of a box that is fully inside a plane don't need to test it again
+		if (d - r >= 0.0f)
+			planeMask &= ~planeBit;
+	}
+
+	return planeMask == 0 ? FrustumTest::Inside : FrustumTest::Intersecting;
+}
+
+} // namespace BvhDetail
+
+using BvhDetail::Box;
+using BvhDetail::FrustumTest;
+
+DynamicBvh::DynamicBvh(Allocator* allocator) :
+	nodes(allocator),
+	root(NullNode),
+	freeList(NullNode),
+	leafCount(0)
+{
+}
+
+uint32_t DynamicBvh::Insert(const AABB& bounds, uint32_t userData)
+{
+	uint32_t leaf = AllocateNode();
+
+	Node& node = nodes[leaf];
+	node.box = CreateFatBox(bounds);
+	node.userData = userData;
+	node.height = 0;
+
+	InsertLeaf(leaf);
+	leafCount += 1;
+
+	return leaf;
+}
+
+void DynamicBvh::Remove(uint32_t leaf)
+{
+	assert(leaf < nodes.GetCount() && IsLeaf(leaf));
+
+	RemoveLeaf(leaf);
+	FreeNode(leaf);
+	leafCount -= 1;
+}
+
+bool DynamicBvh::Move(uint32_t leaf, const AABB& bounds)
+{
+	assert(leaf < nodes.GetCount() && IsLeaf(leaf));
+
+	Box exactBox = Box::FromAabb(bounds);
+	Box fatBox = CreateFatBox(bounds);
+	const Box& currentBox = nodes[leaf].box;
+
+	if (currentBox.Contains(exactBox) &&
+		currentBox.HalfSurfaceArea() < fatBox.HalfSurfaceArea() * FatBoundsShrinkRatio)
+		return false;
+
+	RemoveLeaf(leaf);
+	nodes[leaf].box = fatBox;
+	InsertLeaf(leaf);
+
+	return true;
+}
+
+void DynamicBvh::Clear()
+{
+	nodes.Clear();
+	root = NullNode;
+	freeList = NullNode;
+	leafCount = 0;
+}
+
+void DynamicBvh::QueryFrustum(const FrustumPlanes& frustum, Array<uint32_t>& userDataOut) const
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	if (root == NullNode)
+		return;
+
+	TraversalEntry stack[MaxTraversalDepth];
+	size_t stackCount = 0;
+	stack[stackCount++] = TraversalEntry{ root, AllPlanesMask };
+
+	while (stackCount > 0)
+	{
+		TraversalEntry entry = stack[--stackCount];
+		const Node& node = nodes[entry.node];
+
+		FrustumTest result = BvhDetail::TestFrustum(frustum, node.box, entry.planeMask);
+		if (result == FrustumTest::Outside)
+			continue;
+
+		if (result == FrustumTest::Inside)
+			AppendSubtree(entry.node, userDataOut);
+		else if (IsLeaf(entry.node))
+			userDataOut.PushBack(node.userData);
+		else
+		{
+			assert(stackCount + 2 <= MaxTraversalDepth);
+			stack[stackCount++] = TraversalEntry{ node.children[1], entry.planeMask };
+			stack[stackCount++] = TraversalEntry{ node.children[0], entry.planeMask };
+		}
+	}
+}
+
+uint32_t DynamicBvh::AllocateNode()
+{
+	uint32_t node;
+
+	if (freeList != NullNode)
+	{
+		node = freeList;
+		freeList = nodes[node].parent;
+	}
+	else
+	{
+		node = static_cast<uint32_t>(nodes.GetCount());
+		nodes.PushBack();
+	}
+
+	Node& n = nodes[node];
+	n.parent = NullNode;
+	n.children[0] = NullNode;
+	n.children[1] = NullNode;
+	n.userData = 0;
+	n.height = 0;
+
+	return node;
+}
+
+void DynamicBvh::FreeNode(uint32_t node)
+{
+	nodes[node].parent = freeList;
+	nodes[node].height = -1;
+	freeList = node;
+}
+
+void DynamicBvh::InsertLeaf(uint32_t leaf)
+{
+	if (root == NullNode)
+	{
+		root = leaf;
+		nodes[leaf].parent = NullNode;
+		return;
+	}
+
+	// Find the best sibling by walking down the tree, using surface area as the cost
+	const Box leafBox = nodes[leaf].box;
+	uint32_t index = root;
+
+	while (IsLeaf(index) == false)
+	{
+		const Node& node = nodes[index];
+
+		float area = node.box.HalfSurfaceArea();
+		float combinedArea = Box::Union(node.box, leafBox).HalfSurfaceArea();
+
+		// Cost of creating a new parent for this node and the new leaf
+		float cost = 2.0f * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCosts[2];
+		for (int i = 0; i < 2; ++i)
+		{
+			uint32_t child = node.children[i];
+			float unionArea = Box::Union(leafBox, nodes[child].box).HalfSurfaceArea();
+
+			if (IsLeaf(child))
+				childCosts[i] = unionArea + inheritanceCost;
+			else
+				childCosts[i] = unionArea - nodes[child].box.HalfSurfaceArea() + inheritanceCost;
+		}
+
+		if (cost < childCosts[0] && cost < childCosts[1])
+			break;
+
+		index = childCosts[0] < childCosts[1] ? node.children[0] : node.children[1];
+	}
+
+	uint32_t sibling = index;
+
+	uint32_t newParent = AllocateNode();
+	uint32_t oldParent = nodes[sibling].parent;
+
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = Box::Union(leafBox, nodes[sibling].box);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].children[0] = sibling;
+	nodes[newParent].children[1] = leaf;
+
+	if (oldParent != NullNode)
+	{
+		Node& parent = nodes[oldParent];
+		parent.children[parent.children[0] == sibling ? 0 : 1] = newParent;
+	}
+	else
+		root = newParent;
+
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	RefitAncestors(newParent);
+}
+
+void DynamicBvh::RemoveLeaf(uint32_t leaf)
+{
+	if (leaf == root)
+	{
+		root = NullNode;
+		return;
+	}
+
+	uint32_t parent = nodes[leaf].parent;
+	uint32_t grandParent = nodes[parent].parent;
+	uint32_t sibling = nodes[parent].children[nodes[parent].children[0] == leaf ? 1 : 0];
+
+	FreeNode(parent);
+
+	if (grandParent != NullNode)
+	{
+		// Replace parent with the sibling
+		Node& grand = nodes[grandParent];
+		grand.children[grand.children[0] == parent ? 0 : 1] = sibling;
+		nodes[sibling].parent = grandParent;
+
+		RefitAncestors(grandParent);
+	}
+	else
+	{
+		root = sibling;
+		nodes[sibling].parent = NullNode;
+	}
+}
+
+void DynamicBvh::RefitAncestors(uint32_t node)
+{
+	while (node != NullNode)
+	{
+		node = Balance(node);
+
+		Node& n = nodes[node];
+		const Node& child0 = nodes[n.children[0]];
+		const Node& child1 = nodes[n.children[1]];
+
+		n.height = 1 + std::max(child0.height, child1.height);
+		n.box = Box::Union(child0.box, child1.box);
+
+		node = n.parent;
+	}
+}
+
+uint32_t DynamicBvh::Balance(uint32_t node)
+{
+	if (IsLeaf(node) || nodes[node].height < 2)
+		return node;
+
+	const Node& n = nodes[node];
+	int balance = nodes[n.children[1]].height - nodes[n.children[0]].height;
+
+	if (balance > 1)
+		return Rotate(node, 1);
+
+	if (balance < -1)
+		return Rotate(node, 0);
+
+	return node;
+}
+
+uint32_t DynamicBvh::Rotate(uint32_t node, int tallChild)
+{
+	// Promote the taller child to the place of node, node becomes its child
+	uint32_t iA = node;
+	uint32_t iX = nodes[iA].children[tallChild];
+	uint32_t iY = nodes[iA].children[1 - tallChild];
+
+	Node& A = nodes[iA];
+	Node& X = nodes[iX];
+	const Node& Y = nodes[iY];
+
+	uint32_t iF = X.children[0];
+	uint32_t iG = X.children[1];
+
+	X.children[0] = iA;
+	X.parent = A.parent;
+	A.parent = iX;
+
+	if (X.parent != NullNode)
+	{
+		Node& parent = nodes[X.parent];
+		parent.children[parent.children[0] == iA ? 0 : 1] = iX;
+	}
+	else
+		root = iX;
+
+	// The taller grandchild stays under X, the shorter one moves under A
+	uint32_t iKeep = nodes[iF].height > nodes[iG].height ? iF : iG;
+	uint32_t iMove = iKeep == iF ? iG : iF;
+
+	Node& keep = nodes[iKeep];
+	Node& move = nodes[iMove];
+
+	X.children[1] = iKeep;
+	A.children[tallChild] = iMove;
+	move.parent = iA;
+
+	A.box = Box::Union(Y.box, move.box);
+	X.box = Box::Union(A.box, keep.box);
+
+	A.height = 1 + std::max(Y.height, move.height);
+	X.height = 1 + std::max(A.height, keep.height);
+
+	return iX;
+}
+
+void DynamicBvh::AppendSubtree(uint32_t node, Array<uint32_t>& userDataOut) const
+{
+	uint32_t stack[MaxTraversalDepth];
+	size_t stackCount = 0;
+	stack[stackCount++] = node;
+
+	while (stackCount > 0)
+	{
+		const Node& n = nodes[stack[--stackCount]];
+
+		if (n.children[0] == NullNode)
+			userDataOut.PushBack(n.userData);
+		else
+		{
+			assert(stackCount + 2 <= MaxTraversalDepth);
+			stack[stackCount++] = n.children[1];
+			stack[stackCount++] = n.children[0];
+		}
+	}
+}
+
+StaticBvh::StaticBvh(Allocator* allocator) :
+	nodes(allocator),
+	itemUserData(allocator),
+	buildItems(allocator)
+{
+}
+
+void StaticBvh::Build(uint32_t count, const AABB* bounds, const uint32_t* userData)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	Clear();
+
+	if (count == 0)
+		return;
+
+	buildItems.Resize(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		BuildItem& item = buildItems[i];
+		item.box = Box::FromAabb(bounds[i]);
+		item.centroid = bounds[i].center;
+		item.userData = userData[i];
+	}
+
+	nodes.Reserve(2 * (count / MaxItemsPerLeaf + 1));
+	BuildRecursive(buildItems.GetData(), 0, count);
+
+	itemUserData.Resize(count);
+	for (uint32_t i = 0; i < count; ++i)
+		itemUserData[i] = buildItems[i].userData;
+
+	buildItems.Clear();
+}
+
+void StaticBvh::Clear()
+{
+	nodes.Clear();
+	itemUserData.Clear();
+}
+
+void StaticBvh::QueryFrustum(const FrustumPlanes& frustum, Array<uint32_t>& userDataOut) const
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	if (nodes.GetCount() == 0)
+		return;
+
+	TraversalEntry stack[MaxTraversalDepth];
+	size_t stackCount = 0;
+	stack[stackCount++] = TraversalEntry{ 0, AllPlanesMask };
+
+	while (stackCount > 0)
+	{
+		TraversalEntry entry = stack[--stackCount];
+		const Node& node = nodes[entry.node];
+
+		if (entry.planeMask != 0)
+		{
+			Box box{ node.min, node.max };
+			if (BvhDetail::TestFrustum(frustum, box, entry.planeMask) == FrustumTest::Outside)
+				continue;
+		}
+
+		if (node.itemCount != 0)
+		{
+			uint32_t first = node.secondChildOrFirstItem;
+			AppendItems(first, first + node.itemCount, userDataOut);
+		}
+		else
+		{
+			// First child is stored right after its parent
+			assert(stackCount + 2 <= MaxTraversalDepth);
+			stack[stackCount++] = TraversalEntry{ node.secondChildOrFirstItem, entry.planeMask };
+			stack[stackCount++] = TraversalEntry{ entry.node + 1, entry.planeMask };
+		}
+	}
+}
+
+uint32_t StaticBvh::BuildRecursive(BuildItem* items, uint32_t begin, uint32_t end)
+{
+	uint32_t nodeIndex = static_cast<uint32_t>(nodes.GetCount());
+	nodes.PushBack();
+
+	Box box = items[begin].box;
+	Vec3f centroidMin = items[begin].centroid;
+	Vec3f centroidMax = items[begin].centroid;
+
+	for (uint32_t i = begin + 1; i < end; ++i)
+	{
+		box = Box::Union(box, items[i].box);
+
+		for (size_t axis = 0; axis < 3; ++axis)
+		{
+			centroidMin[axis] = std::min(centroidMin[axis], items[i].centroid[axis]);
+			centroidMax[axis] = std::max(centroidMax[axis], items[i].centroid[axis]);
+		}
+	}
+
+	uint32_t count = end - begin;
+	if (count <= MaxItemsPerLeaf)
+	{
+		nodes[nodeIndex] = Node{ box.min, begin, box.max, count };
+		return nodeIndex;
+	}
+
+	// Split at the median centroid along the axis with the largest centroid spread
+	Vec3f spread = centroidMax - centroidMin;
+	size_t axis = 0;
+	if (spread.y > spread[axis])
+		axis = 1;
+	if (spread.z > spread[axis])
+		axis = 2;
+
+	uint32_t middle = begin + count / 2;
+	std::nth_element(items + begin, items + middle, items + end,
+		[axis](const BuildItem& lhs, const BuildItem& rhs) { return lhs.centroid[axis] < rhs.centroid[axis]; });
+
+	BuildRecursive(items, begin, middle);
+	uint32_t secondChild = BuildRecursive(items, middle, end);
+
+	nodes[nodeIndex] = Node{ box.min, secondChild, box.max, 0 };
+	return nodeIndex;
+}
+
+void StaticBvh::AppendItems(uint32_t begin, uint32_t end, Array<uint32_t>& userDataOut) const
+{
+	for (uint32_t item = begin; item < end; ++item)
+		if (itemUserData[item] != InvalidUserData)
+			userDataOut.PushBack(itemUserData[item]);
+}
+
+namespace
+{
+
+void CreateTestBounds(Array<AABB>& boundsOut, uint32_t count)
+{
+	Random::Seed(1234);
+
+	boundsOut.Resize(count);
+	for (AABB& bounds : boundsOut)
+	{
+		bounds.center = Vec3f(Random::Float(-200.0f, 200.0f), Random::Float(-20.0f, 20.0f), Random::Float(-200.0f, 200.0f));
+		bounds.extents = Vec3f(Random::Float(0.1f, 4.0f), Random::Float(0.1f, 4.0f), Random::Float(0.1f, 4.0f));
+	}
+}
+
+FrustumPlanes CreateTestFrustum()
+{
+	ProjectionParameters params;
+	params.SetPerspective(1.2f);
+	params.perspectiveNear = 0.1f;
+	params.perspectiveFar = 150.0f;
+
+	FrustumPlanes frustum;
+	frustum.Update(params, Mat4x4f::Translate(Vec3f(10.0f, 0.0f, 30.0f)));
+	return frustum;
+}
+
+} // namespace
+
+TEST_CASE("DynamicBvh.QueryMatchesLinearTest")
+{
+	Allocator* allocator = Allocator::GetDefault();
+
+	Array<AABB> bounds(allocator);
+	CreateTestBounds(bounds, 2000);
+
+	FrustumPlanes frustum = CreateTestFrustum();
+
+	DynamicBvh tree(allocator);
+	Array<uint32_t> leaves(allocator);
+	for (uint32_t i = 0; i < bounds.GetCount(); ++i)
+		leaves.PushBack(tree.Insert(bounds[i], i));
+
+	CHECK(tree.GetLeafCount() == 2000);
+	CHECK(tree.GetHeight() < 32);
+
+	// Move half of the objects and remove some
+	for (uint32_t i = 0; i < bounds.GetCount(); i += 2)
+	{
+		bounds[i].center += Vec3f(15.0f, 0.0f, -10.0f);
+		tree.Move(leaves[i], bounds[i]);
+	}
+
+	for (uint32_t i = 1; i < bounds.GetCount(); i += 10)
+	{
+		tree.Remove(leaves[i]);
+		leaves[i] = DynamicBvh::NullNode;
+	}
+
+	Array<uint32_t> candidates(allocator);
+	tree.QueryFrustum(frustum, candidates);
+
+	Array<bool> isCandidate(allocator);
+	isCandidate.Resize(bounds.GetCount());
+	for (bool& value : isCandidate)
+		value = false;
+
+	for (uint32_t userData : candidates)
+		isCandidate[userData] = true;
+
+	// Every visible object must be reported, extra candidates are allowed due to enlarged bounds
+	unsigned int visibleCount = 0;
+	for (uint32_t i = 0; i < bounds.GetCount(); ++i)
+	{
+		if (leaves[i] == DynamicBvh::NullNode)
+		{
+			CHECK(isCandidate[i] == false);
+			continue;
+		}
+
+		if (Intersect::FrustumAabb(frustum, bounds[i]))
+		{
+			CHECK(isCandidate[i]);
+			visibleCount += 1;
+		}
+	}
+
+	CHECK(visibleCount > 0);
+	CHECK(candidates.GetCount() < bounds.GetCount());
+}
+
+TEST_CASE("StaticBvh.QueryMatchesLinearTest")
+{
+	Allocator* allocator = Allocator::GetDefault();
+
+	Array<AABB> bounds(allocator);
+	CreateTestBounds(bounds, 2000);
+
+	Array<uint32_t> userData(allocator);
+	for (uint32_t i = 0; i < bounds.GetCount(); ++i)
+		userData.PushBack(i);
+
+	FrustumPlanes frustum = CreateTestFrustum();
+
+	StaticBvh bvh(allocator);
+	bvh.Build(static_cast<uint32_t>(bounds.GetCount()), bounds.GetData(), userData.GetData());
+	CHECK(bvh.GetItemCount() == 2000);
+
+	// Disable every third item
+	for (uint32_t item = 0; item < bvh.GetItemCount(); ++item)
+		if (bvh.GetItemUserData(item) % 3 == 0)
+			bvh.SetItemUserData(item, StaticBvh::InvalidUserData);
+
+	Array<uint32_t> candidates(allocator);
+	bvh.QueryFrustum(frustum, candidates);
+
+	Array<bool> isCandidate(allocator);
+	isCandidate.Resize(bounds.GetCount());
+	for (bool& value : isCandidate)
+		value = false;
+
+	for (uint32_t index : candidates)
+	{
+		CHECK(isCandidate[index] == false);
+		isCandidate[index] = true;
+	}
+
+	for (uint32_t i = 0; i < bounds.GetCount(); ++i)
+	{
+		if (i % 3 == 0)
+			CHECK(isCandidate[i] == false);
+		else if (Intersect::FrustumAabb(frustum, bounds[i]))
+			CHECK(isCandidate[i]);
+	}
+
+	CHECK(candidates.GetCount() < bounds.GetCount());
+}
+
+} // namespace kokko
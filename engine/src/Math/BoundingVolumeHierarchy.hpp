@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Core/Array.hpp"
+
+#include "Math/AABB.hpp"
+#include "Math/Vec3.hpp"
+
+namespace kokko
+{
+
+class Allocator;
+struct FrustumPlanes;
+
+namespace BvhDetail
+{
+
+struct Box
+{
+	Vec3f min;
+	Vec3f max;
+
+	static Box FromAabb(const AABB& aabb) { return Box{ aabb.center - aabb.extents, aabb.center + aabb.extents }; }
+	static Box Union(const Box& a, const Box& b);
+
+	bool Contains(const Box& other) const;
+	float HalfSurfaceArea() const;
+};
+
+// Result of testing a box against the frustum planes that are still active in planeMask
+enum class FrustumTest
+{
+	Outside,
+	Intersecting,
+	Inside
+};
+
+FrustumTest TestFrustum(const FrustumPlanes& frustum, const Box& box, uint32_t& planeMask);
+
+} // namespace BvhDetail
+
+/*
+* Incrementally updated bounding volume hierarchy.
+* Leaves store enlarged bounds, so small movements don't require changes to the tree.
+* Inserts pick the sibling with the lowest surface area cost and tree rotations keep
+* the tree balanced, which keeps queries roughly O(log N + results).
+*/
+class DynamicBvh
+{
+public:
+	static constexpr uint32_t NullNode = UINT32_MAX;
+
+	explicit DynamicBvh(Allocator* allocator);
+
+	// Returns the leaf node that identifies the object in the tree
+	uint32_t Insert(const AABB& bounds, uint32_t userData);
+	void Remove(uint32_t leaf);
+
+	// Returns true if the leaf was reinserted
+	bool Move(uint32_t leaf, const AABB& bounds);
+
+	uint32_t GetUserData(uint32_t leaf) const { return nodes[leaf].userData; }
+	void SetUserData(uint32_t leaf, uint32_t userData) { nodes[leaf].userData = userData; }
+
+	uint32_t GetLeafCount() const { return leafCount; }
+	int GetHeight() const { return root != NullNode ? nodes[root].height : 0; }
+
+	void Clear();
+
+	// Appends userData of every leaf whose enlarged bounds intersect the frustum
+	void QueryFrustum(const FrustumPlanes& frustum, Array<uint32_t>& userDataOut) const;
+
+private:
+	struct Node
+	{
+		BvhDetail::Box box;
+
+		// Next free node when the node isn't in use
+		uint32_t parent;
+		uint32_t children[2];
+		uint32_t userData;
+		int32_t height; // Leaf = 0, free node = -1
+	};
+
+	bool IsLeaf(uint32_t node) const { return nodes[node].children[0] == NullNode; }
+
+	uint32_t AllocateNode();
+	void FreeNode(uint32_t node);
+
+	void InsertLeaf(uint32_t leaf);
+	void RemoveLeaf(uint32_t leaf);
+	void RefitAncestors(uint32_t node);
+	uint32_t Balance(uint32_t node);
+	uint32_t Rotate(uint32_t node, int tallChild);
+
+	void AppendSubtree(uint32_t node, Array<uint32_t>& userDataOut) const;
+
+	Array<Node> nodes;
+	uint32_t root;
+	uint32_t freeList;
+	uint32_t leafCount;
+};
+
+/*
+* Bounding volume hierarchy that is built once and can't be modified afterwards.
+* Nodes are stored in depth-first order, so the first child of an inner node is
+* always the next node. Items can only be disabled, which is cheap enough to
+* handle the occasional object that stops being static.
+*/
+class StaticBvh
+{
+public:
+	static constexpr uint32_t InvalidUserData = UINT32_MAX;
+	static constexpr uint32_t MaxItemsPerLeaf = 4;
+
+	explicit StaticBvh(Allocator* allocator);
+
+	// Items are reordered during the build, use GetItemUserData to map them back
+	void Build(uint32_t count, const AABB* bounds, const uint32_t* userData);
+	void Clear();
+
+	uint32_t GetItemCount() const { return static_cast<uint32_t>(itemUserData.GetCount()); }
+	uint32_t GetItemUserData(uint32_t item) const { return itemUserData[item]; }
+
+	// Set to InvalidUserData to remove the item from query results
+	void SetItemUserData(uint32_t item, uint32_t userData) { itemUserData[item] = userData; }
+
+	// Appends userData of every valid item whose bounds intersect the frustum
+	void QueryFrustum(const FrustumPlanes& frustum, Array<uint32_t>& userDataOut) const;
+
+private:
+	struct Node
+	{
+		Vec3f min;
+		uint32_t secondChildOrFirstItem;
+		Vec3f max;
+		uint32_t itemCount; // Inner node = 0
+	};
+
+	struct BuildItem
+	{
+		BvhDetail::Box box;
+		Vec3f centroid;
+		uint32_t userData;
+	};
+
+	uint32_t BuildRecursive(BuildItem* items, uint32_t begin, uint32_t end);
+	void AppendItems(uint32_t begin, uint32_t end, Array<uint32_t>& userDataOut) const;
+
+	Array<Node> nodes;
+	Array<uint32_t> itemUserData;
+	Array<BuildItem> buildItems;
+};
+
+} // namespace kokko
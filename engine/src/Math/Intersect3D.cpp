@@ -77,42 +77,47 @@ void FrustumAabbN(
 	}
 }
 
-void FrustumAABBMinSize(
-	const FrustumPlanes& frustum,
-	const Mat4x4f& viewProjection,
-	float minimumSize,
-	unsigned int count,
-	const kokko::AABB* bounds,
-	BitPack* intersectedOut)
+namespace
 {
-	KOKKO_PROFILE_FUNCTION();
 
-	const Plane* planes = frustum.planes;
+struct MinSizeVisibilityTest
+{
+	const FrustumPlanes& frustum;
+	const Mat4x4f& viewProjection;
+	float minimumSize;
+
 	Vec3f planeNormalAbs[6];
 	Vec3f boxCornerMultipliers[8];
-	Vec3f half3(0.5f, 0.5f, 0.0f);
 
-	for (int i = 0; i < 6; ++i)
+	MinSizeVisibilityTest(const FrustumPlanes& frustum, const Mat4x4f& viewProjection, float minimumSize) :
+		frustum(frustum),
+		viewProjection(viewProjection),
+		minimumSize(minimumSize)
 	{
-		planeNormalAbs[i].x = std::abs(planes[i].normal.x);
-		planeNormalAbs[i].y = std::abs(planes[i].normal.y);
-		planeNormalAbs[i].z = std::abs(planes[i].normal.z);
-	}
+		const Plane* planes = frustum.planes;
 
-	for (int i = 0; i < 8; ++i)
-	{
-		boxCornerMultipliers[i].x = ((i % 2) * 2.0f - 1.0f);
-		boxCornerMultipliers[i].y = (((i / 2) % 2) * 2.0f - 1.0f);
-		boxCornerMultipliers[i].z = (((i / 4) % 2) * 2.0f - 1.0f);
+		for (int i = 0; i < 6; ++i)
+		{
+			planeNormalAbs[i].x = std::abs(planes[i].normal.x);
+			planeNormalAbs[i].y = std::abs(planes[i].normal.y);
+			planeNormalAbs[i].z = std::abs(planes[i].normal.z);
+		}
+
+		for (int i = 0; i < 8; ++i)
+		{
+			boxCornerMultipliers[i].x = ((i % 2) * 2.0f - 1.0f);
+			boxCornerMultipliers[i].y = (((i / 2) % 2) * 2.0f - 1.0f);
+			boxCornerMultipliers[i].z = (((i / 4) % 2) * 2.0f - 1.0f);
+		}
 	}
 
-	// For each axis aligned bounding box
-	for (unsigned int boxIdx = 0; boxIdx < count; ++boxIdx)
+	bool IsVisible(const kokko::AABB& bounds) const
 	{
-		bool visible = true;
+		const Plane* planes = frustum.planes;
+		const Vec3f half3(0.5f, 0.5f, 0.0f);
 
-		Vec3f center = bounds[boxIdx].center;
-		Vec3f extents = bounds[boxIdx].extents;
+		Vec3f center = bounds.center;
+		Vec3f extents = bounds.extents;
 
 		// For each plane in view frustum
 		for (unsigned int planeIdx = 0; planeIdx < 6; ++planeIdx)
@@ -121,40 +126,70 @@ void FrustumAABBMinSize(
 			const float r = Vec3f::Dot(extents, planeNormalAbs[planeIdx]);
 
 			if (d + r < -planes[planeIdx].distance)
-			{
-				visible = false;
-				break;
-			}
+				return false;
 		}
 
-		if (visible == true)
+		Vec2f min(1e9f, 1e9f);
+		Vec2f max(-1e9f, -1e9f);
+
+		for (unsigned cornerIdx = 0; cornerIdx < 8; ++cornerIdx)
 		{
-			Vec2f min(1e9f, 1e9f);
-			Vec2f max(-1e9f, -1e9f);
+			Vec3f corner = Vec3f::Hadamard(extents, boxCornerMultipliers[cornerIdx]);
 
-			for (unsigned cornerIdx = 0; cornerIdx < 8; ++cornerIdx)
-			{
-				Vec3f corner = Vec3f::Hadamard(extents, boxCornerMultipliers[cornerIdx]);
+			Vec4f proj = viewProjection * Vec4f(center + corner, 1.0f);
+			Vec3f scr = proj.xyz() * (1.0f / proj.w) * 0.5f + half3;
 
-				Vec4f proj = viewProjection * Vec4f(center + corner, 1.0f);
-				Vec3f scr = proj.xyz() * (1.0f / proj.w) * 0.5f + half3;
+			min.x = std::min(scr.x, min.x);
+			min.y = std::min(scr.y, min.y);
+			max.x = std::max(scr.x, max.x);
+			max.y = std::max(scr.y, max.y);
+		}
 
-				min.x = std::min(scr.x, min.x);
-				min.y = std::min(scr.y, min.y);
-				max.x = std::max(scr.x, max.x);
-				max.y = std::max(scr.y, max.y);
-			}
+		float width = max.x - min.x;
+		float height = max.y - min.y;
 
-			float width = max.x - min.x;
-			float height = max.y - min.y;
+		return width * height >= minimumSize;
+	}
+};
 
-			if (width * height < minimumSize)
-			{
-				visible = false;
-			}
-		}
+} // namespace
+
+void FrustumAABBMinSize(
+	const FrustumPlanes& frustum,
+	const Mat4x4f& viewProjection,
+	float minimumSize,
+	unsigned int count,
+	const kokko::AABB* bounds,
+	BitPack* intersectedOut)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	MinSizeVisibilityTest test(frustum, viewProjection, minimumSize);
+
+	// For each axis aligned bounding box
+	for (unsigned int boxIdx = 0; boxIdx < count; ++boxIdx)
+		BitPack::Set(intersectedOut, boxIdx, test.IsVisible(bounds[boxIdx]));
+}
+
+void FrustumAABBMinSizeIndexed(
+	const FrustumPlanes& frustum,
+	const Mat4x4f& viewProjection,
+	float minimumSize,
+	unsigned int indexCount,
+	const uint32_t* indices,
+	const kokko::AABB* bounds,
+	BitPack* intersectedOut)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	MinSizeVisibilityTest test(frustum, viewProjection, minimumSize);
+
+	for (unsigned int i = 0; i < indexCount; ++i)
+	{
+		uint32_t boxIdx = indices[i];
 
-		BitPack::Set(intersectedOut, boxIdx, visible);
+		if (test.IsVisible(bounds[boxIdx]))
+			BitPack::Set(intersectedOut, boxIdx, true);
 	}
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "Math/Vec3.hpp"
 
 struct Mat4x4f;
@@ -39,6 +41,19 @@ void FrustumAABBMinSize(
 	const kokko::AABB* bounds,
 	BitPack* intersectedOut);
 
+/*
+* Calculate visibility with a minimum size for the listed bounding boxes.
+* Only sets the bits of visible boxes, other bits are left unchanged.
+*/
+void FrustumAABBMinSizeIndexed(
+	const FrustumPlanes& frustum,
+	const Mat4x4f& viewProjection,
+	float minimumSize,
+	unsigned int indexCount,
+	const uint32_t* indices,
+	const kokko::AABB* bounds,
+	BitPack* intersectedOut);
+
 /*
 * Calculate visibility for spheres
 */
@@ -479,4 +479,18 @@ Mat4x4f operator*(const Mat4x4f& a, const Mat4x4f& b)
 	return result;
 }
 
+bool operator==(const Mat4x4f& a, const Mat4x4f& b)
+{
+	for (size_t i = 0; i < 16; ++i)
+		if (a[i] != b[i])
+			return false;
+
+	return true;
+}
+
+bool operator!=(const Mat4x4f& a, const Mat4x4f& b)
+{
+	return operator==(a, b) == false;
+}
+
 } // namespace kokko
@@ -56,6 +56,9 @@ Vec4f operator*(const Mat4x4f& m, const Vec4f& v);
 Vec4f operator*(const Vec4f& v, const Mat4x4f& m);
 Mat4x4f operator*(const Mat4x4f& a, const Mat4x4f& b);
 
+bool operator==(const Mat4x4f& a, const Mat4x4f& b);
+bool operator!=(const Mat4x4f& a, const Mat4x4f& b);
+
 struct Mat4x4fBijection
 {
 	Mat4x4f forward;
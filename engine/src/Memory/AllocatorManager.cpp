@@ -2,7 +2,9 @@
 
 #include <cstring>
 
+#include "Memory/FrameAllocator.hpp"
 #include "Memory/MetricAllocator.hpp"
+#include "Memory/PoolAllocator.hpp"
 #include "Memory/TraceAllocator.hpp"
 
 namespace kokko
@@ -14,6 +16,7 @@ AllocatorManager::AllocatorManager(Allocator* allocator) :
 	scopeCount(0),
 	scopeAllocated(0)
 {
+	frameAllocator = this->alloc->MakeNew<FrameAllocator>(this->alloc);
 }
 
 AllocatorManager::~AllocatorManager()
@@ -21,36 +24,46 @@ AllocatorManager::~AllocatorManager()
 	// Delete any not deallocated allocators
 	for (unsigned int i = 0; i < scopeCount; ++i)
 	{
-		this->alloc->MakeDelete(scopes[i]);
+		this->alloc->MakeDelete(scopes[i].allocator);
+		this->alloc->MakeDelete(scopes[i].pool);
 	}
+
+	this->alloc->Deallocate(scopes);
+	this->alloc->MakeDelete(frameAllocator);
 }
 
-Allocator* AllocatorManager::CreateAllocatorScope(const char* name, Allocator* baseAllocator, bool tracing)
+Allocator* AllocatorManager::CreateAllocatorScope(const char* name, Allocator* baseAllocator, bool tracing, bool pooled)
 {
 	if (scopeCount == scopeAllocated)
 	{
 		// Reallocate
 
 		unsigned int newAllocated = scopeAllocated > 0 ? scopeAllocated * 2 : 32;
-		void* newBuffer = this->alloc->Allocate(sizeof(MetricAllocator*) * newAllocated, "AllocatorManager.scopes");
+		void* newBuffer = this->alloc->Allocate(sizeof(Scope) * newAllocated, "AllocatorManager.scopes");
 
 		if (scopeCount > 0)
-		{
-			std::memcpy(newBuffer, scopes, sizeof(MetricAllocator*) * scopeCount);
-			this->alloc->Deallocate(scopes);
-		}
+			std::memcpy(newBuffer, scopes, sizeof(Scope) * scopeCount);
+
+		this->alloc->Deallocate(scopes);
 
-		scopes = static_cast<MetricAllocator**>(newBuffer);
+		scopes = static_cast<Scope*>(newBuffer);
 		scopeAllocated = newAllocated;
 	}
 
+	PoolAllocator* pool = nullptr;
+	if (pooled)
+	{
+		pool = this->alloc->MakeNew<PoolAllocator>(baseAllocator);
+		baseAllocator = pool;
+	}
+
 	MetricAllocator* proxyAllocator = nullptr;
 	if (tracing)
 		proxyAllocator = this->alloc->MakeNew<TraceAllocator>(name, baseAllocator);
 	else
 		proxyAllocator = this->alloc->MakeNew<MetricAllocator>(name, baseAllocator);
 
-	scopes[scopeCount] = proxyAllocator;
+	scopes[scopeCount] = Scope{ proxyAllocator, pool };
 	scopeCount += 1;
 
 	return proxyAllocator;
@@ -61,9 +74,10 @@ void AllocatorManager::DestroyAllocatorScope(Allocator* allocator)
 	// Find right allocator
 	for (unsigned int i = 0; i < scopeCount; ++i)
 	{
-		if (scopes[i] == allocator)
+		if (scopes[i].allocator == allocator)
 		{
-			this->alloc->MakeDelete(scopes[i]);
+			this->alloc->MakeDelete(scopes[i].allocator);
+			this->alloc->MakeDelete(scopes[i].pool);
 
 			if (i != scopeCount - 1)
 			{
@@ -85,17 +99,17 @@ unsigned int AllocatorManager::GetMemoryTrackingScopeCount()
 
 const char* AllocatorManager::GetNameForScopeIndex(unsigned int index) const
 {
-	return scopes[index]->GetMemoryScopeName();
+	return scopes[index].allocator->GetMemoryScopeName();
 }
 
 std::size_t AllocatorManager::GetAllocatedSizeForScopeIndex(unsigned int index) const
 {
-	return scopes[index]->GetTotalAllocationSize();
+	return scopes[index].allocator->GetTotalAllocationSize();
 }
 
 std::size_t AllocatorManager::GetAllocationCountForScopeIndex(unsigned int index) const
 {
-	return scopes[index]->GetTotalAllocationCount();
+	return scopes[index].allocator->GetTotalAllocationCount();
 }
 
 } // namespace kokko
@@ -7,17 +7,27 @@
 namespace kokko
 {
 
+class FrameAllocator;
 class MetricAllocator;
+class PoolAllocator;
 
 class AllocatorManager
 {
 private:
 	Allocator* alloc;
 
-	MetricAllocator** scopes;
+	struct Scope
+	{
+		MetricAllocator* allocator;
+		PoolAllocator* pool;
+	};
+
+	Scope* scopes;
 	unsigned int scopeCount;
 	unsigned int scopeAllocated;
 
+	FrameAllocator* frameAllocator;
+
 public:
 	AllocatorManager(Allocator* allocator);
 	~AllocatorManager();
@@ -28,11 +38,13 @@ public:
 	/// </summary>
 	/// <param name="name">Name for the memory scope</param>
 	/// <param name="baseAllocator">Allocator to use as base allocator</param>
+	/// <param name="tracing">Record every live allocation and its debug tag</param>
+	/// <param name="pooled">Serve small allocations from size class pools on top of baseAllocator</param>
 	/// <returns>
 	/// Allocator that will gather memory statistics. Call <see cref="DestroyAllocatorScope(Allocator*)"/>
 	/// with this return value when your done with the allocator.
 	/// </returns>
-	Allocator* CreateAllocatorScope(const char* name, Allocator* baseAllocator, bool tracing = false);
+	Allocator* CreateAllocatorScope(const char* name, Allocator* baseAllocator, bool tracing = false, bool pooled = false);
 
 	/// <summary>
 	/// Destroy a previously created allocator scope.
@@ -40,6 +52,11 @@ public:
 	/// <param name="allocator">Allocator to destroy</param>
 	void DestroyAllocatorScope(Allocator* allocator);
 
+	/// <summary>
+	/// Get the shared allocator for temporary per-frame allocations.
+	/// </summary>
+	FrameAllocator* GetFrameAllocator() { return frameAllocator; }
+
 	unsigned int GetMemoryTrackingScopeCount();
 
 	const char* GetNameForScopeIndex(unsigned int index) const;
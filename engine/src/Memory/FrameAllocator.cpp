@@ -0,0 +1,388 @@
+#include "Memory/FrameAllocator.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#include "doctest/doctest.h"
+
+#include "Math/Math.hpp"
+
+namespace kokko
+{
+
+namespace
+{
+
+const size_t AllocationHeaderSize = sizeof(size_t);
+
+uintptr_t AlignAddress(uintptr_t address, size_t alignment)
+{
+	return (address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+}
+
+} // namespace
+
+std::atomic<uint64_t> FrameAllocator::nextAllocatorId(1);
+thread_local FrameAllocator::ThreadCache FrameAllocator::threadCache = { 0, nullptr };
+
+FrameAllocator::FrameAllocator(Allocator* baseAllocator, size_t chunkSize) :
+	baseAllocator(baseAllocator),
+	chunkSize(chunkSize),
+	allocatorId(nextAllocatorId.fetch_add(1)),
+	threadStates(nullptr),
+	currentArena(0),
+	lastFrameUsage(0),
+	highWaterMark(0)
+{
+}
+
+FrameAllocator::~FrameAllocator()
+{
+	ThreadState* state = threadStates;
+	while (state != nullptr)
+	{
+		ThreadState* next = state->next;
+
+		ReleaseArena(state->arenas[0]);
+		ReleaseArena(state->arenas[1]);
+		baseAllocator->MakeDelete(state);
+
+		state = next;
+	}
+}
+
+void* FrameAllocator::Allocate(size_t size, const char*)
+{
+	return AllocateFromArena(GetThreadState()->arenas[currentArena], size, DefaultMinAlign);
+}
+
+void* FrameAllocator::AllocateAligned(size_t size, size_t alignment, const char*)
+{
+	assert(Math::IsPowerOfTwo(alignment));
+
+	if (alignment < DefaultMinAlign)
+		alignment = DefaultMinAlign;
+
+	return AllocateFromArena(GetThreadState()->arenas[currentArena], size, alignment);
+}
+
+void FrameAllocator::Deallocate(void* ptr)
+{
+	if (ptr == nullptr || threadCache.allocatorId != allocatorId)
+		return;
+
+	// Only the latest allocation can be returned to the arena,
+	// this helps with arrays that grow in small steps
+	Arena& arena = threadCache.state->arenas[currentArena];
+	if (arena.lastAllocation == ptr)
+	{
+		arena.bytesAllocated -= arena.chunks->used - arena.lastAllocationStart;
+		arena.chunks->used = arena.lastAllocationStart;
+		arena.lastAllocation = nullptr;
+	}
+}
+
+size_t FrameAllocator::GetAllocatedSize(void* ptr)
+{
+	return *(static_cast<size_t*>(ptr) - 1);
+}
+
+void FrameAllocator::EndFrame()
+{
+	std::lock_guard<std::mutex> lock(threadStateMutex);
+
+	size_t frameUsage = 0;
+	for (ThreadState* state = threadStates; state != nullptr; state = state->next)
+		frameUsage += state->arenas[currentArena].bytesAllocated;
+
+	lastFrameUsage = frameUsage;
+	if (frameUsage > highWaterMark)
+		highWaterMark = frameUsage;
+
+	// The other arena was used during the previous frame, so it's now safe to reuse
+	currentArena = currentArena ^ 1;
+
+	for (ThreadState* state = threadStates; state != nullptr; state = state->next)
+		ResetArena(state->arenas[currentArena]);
+}
+
+FrameAllocator::ThreadState* FrameAllocator::GetThreadState()
+{
+	if (threadCache.allocatorId == allocatorId)
+		return threadCache.state;
+
+	std::thread::id threadId = std::this_thread::get_id();
+	ThreadState* state = nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(threadStateMutex);
+
+		// The cache only holds one allocator, so the thread may already have a state here
+		for (ThreadState* existing = threadStates; existing != nullptr; existing = existing->next)
+		{
+			if (existing->threadId == threadId)
+			{
+				state = existing;
+				break;
+			}
+		}
+
+		if (state == nullptr)
+		{
+			state = baseAllocator->MakeNew<ThreadState>();
+			state->threadId = threadId;
+			state->next = threadStates;
+			threadStates = state;
+		}
+	}
+
+	threadCache.allocatorId = allocatorId;
+	threadCache.state = state;
+
+	return state;
+}
+
+void* FrameAllocator::AllocateFromArena(Arena& arena, size_t size, size_t alignment)
+{
+	size_t worstCaseSize = size + alignment + AllocationHeaderSize;
+
+	// Large allocations get their own chunk so they don't make the regular chunks grow
+	if (worstCaseSize > chunkSize / 2)
+	{
+		Chunk* chunk = CreateChunk(worstCaseSize);
+		chunk->next = arena.dedicatedChunks;
+		chunk->used = chunk->capacity;
+		arena.dedicatedChunks = chunk;
+		arena.bytesAllocated += worstCaseSize;
+
+		uintptr_t dataStart = reinterpret_cast<uintptr_t>(chunk + 1);
+		uintptr_t address = AlignAddress(dataStart + AllocationHeaderSize, alignment);
+		*(reinterpret_cast<size_t*>(address) - 1) = size;
+
+		return reinterpret_cast<void*>(address);
+	}
+
+	Chunk* chunk = arena.chunks;
+
+	for (int attempt = 0; attempt < 2; ++attempt)
+	{
+		if (chunk != nullptr)
+		{
+			uintptr_t dataStart = reinterpret_cast<uintptr_t>(chunk + 1);
+			uintptr_t address = AlignAddress(dataStart + chunk->used + AllocationHeaderSize, alignment);
+			size_t newUsed = static_cast<size_t>(address - dataStart) + size;
+
+			if (newUsed <= chunk->capacity)
+			{
+				arena.lastAllocation = reinterpret_cast<void*>(address);
+				arena.lastAllocationStart = chunk->used;
+				arena.bytesAllocated += newUsed - chunk->used;
+
+				chunk->used = newUsed;
+				*(reinterpret_cast<size_t*>(address) - 1) = size;
+
+				return reinterpret_cast<void*>(address);
+			}
+		}
+
+		chunk = CreateChunk(chunkSize);
+		chunk->next = arena.chunks;
+		arena.chunks = chunk;
+	}
+
+	assert(false && "Unreachable, a new chunk always has room for the allocation");
+	return nullptr;
+}
+
+FrameAllocator::Chunk* FrameAllocator::CreateChunk(size_t capacity)
+{
+	void* buffer = baseAllocator->Allocate(sizeof(Chunk) + capacity, "FrameAllocator chunk");
+
+	Chunk* chunk = static_cast<Chunk*>(buffer);
+	chunk->next = nullptr;
+	chunk->capacity = capacity;
+	chunk->used = 0;
+
+	return chunk;
+}
+
+void FrameAllocator::ResetArena(Arena& arena)
+{
+	size_t regularCapacity = 0;
+	size_t regularChunkCount = 0;
+
+	for (Chunk* chunk = arena.chunks; chunk != nullptr; chunk = chunk->next)
+	{
+		regularCapacity += chunk->capacity;
+		regularChunkCount += 1;
+	}
+
+	// If the frame needed more than one chunk, replace them with a single
+	// chunk large enough for the whole frame to avoid allocations next time
+	if (regularChunkCount > 1)
+	{
+		Chunk* dedicated = arena.dedicatedChunks;
+		arena.dedicatedChunks = nullptr;
+
+		ReleaseArena(arena);
+
+		arena.dedicatedChunks = dedicated;
+		arena.chunks = CreateChunk(regularCapacity);
+	}
+	else if (arena.chunks != nullptr)
+	{
+		arena.chunks->used = 0;
+	}
+
+	Chunk* chunk = arena.dedicatedChunks;
+	while (chunk != nullptr)
+	{
+		Chunk* next = chunk->next;
+		baseAllocator->Deallocate(chunk);
+		chunk = next;
+	}
+
+	arena.dedicatedChunks = nullptr;
+	arena.lastAllocation = nullptr;
+	arena.lastAllocationStart = 0;
+	arena.bytesAllocated = 0;
+}
+
+void FrameAllocator::ReleaseArena(Arena& arena)
+{
+	Chunk* lists[] = { arena.chunks, arena.dedicatedChunks };
+
+	for (Chunk* chunk : lists)
+	{
+		while (chunk != nullptr)
+		{
+			Chunk* next = chunk->next;
+			baseAllocator->Deallocate(chunk);
+			chunk = next;
+		}
+	}
+
+	arena.chunks = nullptr;
+	arena.dedicatedChunks = nullptr;
+	arena.lastAllocation = nullptr;
+}
+
+TEST_CASE("FrameAllocator.AllocateAligned")
+{
+	FrameAllocator allocator(Allocator::GetDefault(), 4096);
+
+	for (size_t alignment = 1; alignment <= 256; alignment = alignment << 1)
+	{
+		void* allocation = allocator.AllocateAligned(100, alignment);
+		intptr_t address = reinterpret_cast<intptr_t>(allocation);
+		CHECK(address % alignment == 0);
+		CHECK(allocator.GetAllocatedSize(allocation) == 100);
+	}
+}
+
+TEST_CASE("FrameAllocator.DoubleBuffering")
+{
+	FrameAllocator allocator(Allocator::GetDefault(), 4096);
+
+	uint8_t* frame0 = static_cast<uint8_t*>(allocator.Allocate(64));
+	std::memset(frame0, 0xAB, 64);
+	allocator.EndFrame();
+
+	CHECK(allocator.GetLastFrameUsage() >= 64);
+
+	// Frame 0 memory must stay intact during frame 1
+	uint8_t* frame1 = static_cast<uint8_t*>(allocator.Allocate(64));
+	CHECK(frame1 != frame0);
+	std::memset(frame1, 0xCD, 64);
+	CHECK(frame0[0] == 0xAB);
+	CHECK(frame0[63] == 0xAB);
+	allocator.EndFrame();
+
+	// Frame 0 memory is reused in frame 2
+	void* frame2 = allocator.Allocate(64);
+	CHECK(frame2 == frame0);
+	allocator.EndFrame();
+
+	CHECK(allocator.GetHighWaterMark() >= 64);
+}
+
+TEST_CASE("FrameAllocator.DeallocateLatest")
+{
+	FrameAllocator allocator(Allocator::GetDefault(), 4096);
+
+	void* first = allocator.Allocate(32);
+	void* second = allocator.Allocate(32);
+	allocator.Deallocate(second);
+
+	void* third = allocator.Allocate(32);
+	CHECK(third == second);
+
+	// Only the latest allocation is returned
+	allocator.Deallocate(first);
+	void* fourth = allocator.Allocate(32);
+	CHECK(fourth != first);
+}
+
+TEST_CASE("FrameAllocator.ChunksAreMerged")
+{
+	FrameAllocator allocator(Allocator::GetDefault(), 4096);
+
+	// Fill several chunks and one dedicated allocation
+	for (int i = 0; i < 64; ++i)
+		allocator.Allocate(256);
+	void* large = allocator.Allocate(10000);
+	CHECK(allocator.GetAllocatedSize(large) == 10000);
+
+	allocator.EndFrame();
+	allocator.EndFrame();
+
+	// Same amount of allocations should now fit in one contiguous chunk
+	uint8_t* previous = static_cast<uint8_t*>(allocator.Allocate(256));
+	for (int i = 1; i < 64; ++i)
+	{
+		uint8_t* current = static_cast<uint8_t*>(allocator.Allocate(256));
+		CHECK(current > previous);
+		CHECK(current - previous < 512);
+		previous = current;
+	}
+}
+
+TEST_CASE("FrameAllocator.Threads")
+{
+	FrameAllocator allocator(Allocator::GetDefault(), 4096);
+
+	void* mainAllocation = allocator.Allocate(128);
+	void* threadAllocation = nullptr;
+
+	std::thread thread([&allocator, &threadAllocation]()
+	{
+		threadAllocation = allocator.Allocate(128);
+		std::memset(threadAllocation, 0, 128);
+	});
+	thread.join();
+
+	CHECK(threadAllocation != nullptr);
+	CHECK(threadAllocation != mainAllocation);
+
+	allocator.EndFrame();
+	CHECK(allocator.GetLastFrameUsage() >= 256);
+}
+
+TEST_CASE("FrameAllocator.AlternatingAllocators")
+{
+	FrameAllocator first(Allocator::GetDefault(), 4096);
+	FrameAllocator second(Allocator::GetDefault(), 4096);
+
+	uint8_t* before = static_cast<uint8_t*>(first.Allocate(32));
+	second.Allocate(32);
+	uint8_t* after = static_cast<uint8_t*>(first.Allocate(32));
+
+	// The thread keeps allocating from its existing chunk instead of a new state
+	CHECK(after > before);
+	CHECK(after - before < 4096);
+
+	first.EndFrame();
+	CHECK(first.GetLastFrameUsage() < 4096);
+}
+
+} // namespace kokko
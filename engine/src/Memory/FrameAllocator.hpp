@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "Memory/Allocator.hpp"
+
+namespace kokko
+{
+
+// Linear allocator for temporary allocations that don't outlive the frame after the current one.
+// Each thread allocates from its own arena, so no locking is needed after a thread's first allocation.
+// Arenas are double-buffered: memory allocated during frame N is reclaimed at the end of frame N+1.
+// Deallocate only reclaims memory if it was the latest allocation on the calling thread.
+class FrameAllocator : public Allocator
+{
+public:
+	static const size_t DefaultChunkSize = 1 << 20;
+
+	explicit FrameAllocator(Allocator* baseAllocator, size_t chunkSize = DefaultChunkSize);
+	~FrameAllocator();
+
+	FrameAllocator(const FrameAllocator&) = delete;
+	FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+	virtual void* Allocate(size_t size, const char* debugTag = nullptr) override;
+	virtual void* AllocateAligned(size_t size, size_t alignment, const char* debugTag = nullptr) override;
+	virtual void Deallocate(void* ptr) override;
+	virtual size_t GetAllocatedSize(void* ptr) override;
+
+	// Must be called once per frame while no other thread is using the allocator
+	void EndFrame();
+
+	size_t GetLastFrameUsage() const { return lastFrameUsage; }
+	size_t GetHighWaterMark() const { return highWaterMark; }
+
+private:
+	static const size_t DefaultMinAlign = 16;
+
+	struct Chunk
+	{
+		Chunk* next;
+		size_t capacity;
+		size_t used;
+	};
+
+	struct Arena
+	{
+		Chunk* chunks; // First chunk is the one being allocated from
+		Chunk* dedicatedChunks; // Allocations too large to fit in a regular chunk
+		void* lastAllocation;
+		size_t lastAllocationStart;
+		size_t bytesAllocated;
+	};
+
+	struct ThreadState
+	{
+		ThreadState* next;
+		std::thread::id threadId;
+		Arena arenas[2];
+	};
+
+	struct ThreadCache
+	{
+		uint64_t allocatorId;
+		ThreadState* state;
+	};
+
+	ThreadState* GetThreadState();
+
+	void* AllocateFromArena(Arena& arena, size_t size, size_t alignment);
+	Chunk* CreateChunk(size_t capacity);
+	void ResetArena(Arena& arena);
+	void ReleaseArena(Arena& arena);
+
+	static std::atomic<uint64_t> nextAllocatorId;
+	static thread_local ThreadCache threadCache;
+
+	Allocator* baseAllocator;
+	size_t chunkSize;
+	uint64_t allocatorId;
+
+	std::mutex threadStateMutex;
+	ThreadState* threadStates;
+
+	uint32_t currentArena;
+
+	size_t lastFrameUsage;
+	size_t highWaterMark;
+};
+
+} // namespace kokko
@@ -1,32 +1,59 @@
 #include "Memory/MetricAllocator.hpp"
 
 #include <cassert>
+#include <thread>
+
+#include "doctest/doctest.h"
 
 namespace kokko
 {
 
+namespace
+{
+
+std::atomic<uint32_t> nextThreadShardIndex(0);
+
+} // namespace
+
 MetricAllocator::MetricAllocator(const char* memoryScope, Allocator* allocator) :
 	allocator(allocator),
-	memoryScopeName(memoryScope),
-	allocatedSize(0),
-	allocatedCount(0)
+	memoryScopeName(memoryScope)
 {
+	for (CounterShard& shard : shards)
+	{
+		shard.allocatedSize.store(0, std::memory_order_relaxed);
+		shard.allocatedCount.store(0, std::memory_order_relaxed);
+	}
 }
 
 MetricAllocator::~MetricAllocator()
 {
-	assert(allocatedSize == 0);
-	assert(allocatedCount == 0);
+	assert(GetTotalAllocationSize() == 0);
+	assert(GetTotalAllocationCount() == 0);
+}
+
+MetricAllocator::CounterShard& MetricAllocator::GetThreadShard()
+{
+	thread_local uint32_t shardIndex = nextThreadShardIndex.fetch_add(1, std::memory_order_relaxed) % ShardCount;
+	return shards[shardIndex];
 }
 
 std::size_t MetricAllocator::GetTotalAllocationSize() const
 {
-	return allocatedSize;
+	int64_t total = 0;
+	for (const CounterShard& shard : shards)
+		total += shard.allocatedSize.load(std::memory_order_relaxed);
+
+	return static_cast<std::size_t>(total);
 }
 
 std::size_t MetricAllocator::GetTotalAllocationCount() const
 {
-	return allocatedCount;
+	int64_t total = 0;
+	for (const CounterShard& shard : shards)
+		total += shard.allocatedCount.load(std::memory_order_relaxed);
+
+	return static_cast<std::size_t>(total);
 }
 
 const char* MetricAllocator::GetMemoryScopeName() const
@@ -34,15 +61,19 @@ const char* MetricAllocator::GetMemoryScopeName() const
 	return memoryScopeName;
 }
 
+void MetricAllocator::AddAllocation(size_t size)
+{
+	CounterShard& shard = GetThreadShard();
+	shard.allocatedSize.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+	shard.allocatedCount.fetch_add(1, std::memory_order_relaxed);
+}
+
 void* MetricAllocator::Allocate(size_t size, const char* debugTag)
 {
 	void* result = allocator->Allocate(size, debugTag);
 
 	if (result != nullptr)
-	{
-		allocatedSize += size;
-		allocatedCount += 1;
-	}
+		AddAllocation(size);
 
 	return result;
 }
@@ -52,10 +83,7 @@ void* MetricAllocator::AllocateAligned(size_t size, size_t alignment, const char
 	void* result = allocator->AllocateAligned(size, alignment);
 
 	if (result != nullptr)
-	{
-		allocatedSize += size;
-		allocatedCount += 1;
-	}
+		AddAllocation(size);
 
 	return result;
 }
@@ -66,8 +94,9 @@ void MetricAllocator::Deallocate(void* ptr)
 	{
 		size_t size = allocator->GetAllocatedSize(ptr);
 
-		allocatedSize -= size;
-		allocatedCount -= 1;
+		CounterShard& shard = GetThreadShard();
+		shard.allocatedSize.fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+		shard.allocatedCount.fetch_sub(1, std::memory_order_relaxed);
 
 		allocator->Deallocate(ptr);
 	}
@@ -78,4 +107,46 @@ std::size_t MetricAllocator::GetAllocatedSize(void* ptr)
 	return allocator->GetAllocatedSize(ptr);
 }
 
+TEST_CASE("MetricAllocator.Threads")
+{
+	MetricAllocator allocator("Test", Allocator::GetDefault());
+
+	const int threadCount = 4;
+	const int allocationCount = 1000;
+	void* allocations[threadCount][allocationCount];
+
+	std::thread threads[threadCount];
+	for (int t = 0; t < threadCount; ++t)
+	{
+		threads[t] = std::thread([&allocator, &allocations, t]()
+		{
+			for (int i = 0; i < allocationCount; ++i)
+				allocations[t][i] = allocator.Allocate(16);
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	CHECK(allocator.GetTotalAllocationCount() == threadCount * allocationCount);
+	CHECK(allocator.GetTotalAllocationSize() == threadCount * allocationCount * 16);
+
+	// Free everything on another thread than where it was allocated
+	for (int t = 0; t < threadCount; ++t)
+	{
+		threads[t] = std::thread([&allocator, &allocations, t]()
+		{
+			int source = (t + 1) % threadCount;
+			for (int i = 0; i < allocationCount; ++i)
+				allocator.Deallocate(allocations[source][i]);
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	CHECK(allocator.GetTotalAllocationCount() == 0);
+	CHECK(allocator.GetTotalAllocationSize() == 0);
+}
+
 } // namespace kokko
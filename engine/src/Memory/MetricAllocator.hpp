@@ -1,17 +1,37 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+
 #include "Memory/Allocator.hpp"
 
 namespace kokko
 {
 
+// Counters are split into shards by thread so allocations from multiple threads
+// don't contend on the same cache line. Totals are aggregated when read.
 class MetricAllocator : public Allocator
 {
 private:
+	static const size_t ShardCount = 16;
+
+	struct CounterShard
+	{
+		// Allocations can be freed on a different thread, so a single shard can go negative
+		std::atomic<int64_t> allocatedSize;
+		std::atomic<int64_t> allocatedCount;
+
+		// Keep shards on separate cache lines
+		uint8_t padding[64 - 2 * sizeof(std::atomic<int64_t>)];
+	};
+
 	Allocator* allocator;
 	const char* memoryScopeName;
-	std::size_t allocatedSize;
-	std::size_t allocatedCount;
+	CounterShard shards[ShardCount];
+
+	CounterShard& GetThreadShard();
+
+	void AddAllocation(size_t size);
 
 public:
 	MetricAllocator(const char* memoryScope, Allocator* allocator);
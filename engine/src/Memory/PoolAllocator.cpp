@@ -0,0 +1,494 @@
+#include "Memory/PoolAllocator.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <thread>
+
+#include "doctest/doctest.h"
+
+#include "Math/Math.hpp"
+
+namespace kokko
+{
+
+std::atomic<uint64_t> PoolAllocator::nextAllocatorId(1);
+thread_local PoolAllocator::ThreadCacheEntry PoolAllocator::threadCaches[MaxCachedAllocators] = {};
+std::mutex PoolAllocator::liveMutex;
+PoolAllocator* PoolAllocator::liveAllocators = nullptr;
+
+PoolAllocator::PoolAllocator(Allocator* baseAllocator) :
+	baseAllocator(baseAllocator),
+	allocatorId(nextAllocatorId.fetch_add(1)),
+	prevLive(nullptr),
+	nextLive(nullptr),
+	sharedClasses{},
+	pages(nullptr),
+	threadStates(nullptr)
+{
+	static_assert(sizeof(BlockHeader) == MinBlockSize, "Block header must keep blocks aligned");
+
+	std::lock_guard<std::mutex> lock(liveMutex);
+	nextLive = liveAllocators;
+	if (liveAllocators != nullptr)
+		liveAllocators->prevLive = this;
+	liveAllocators = this;
+}
+
+PoolAllocator::~PoolAllocator()
+{
+	{
+		std::lock_guard<std::mutex> lock(liveMutex);
+		if (prevLive != nullptr)
+			prevLive->nextLive = nextLive;
+		else
+			liveAllocators = nextLive;
+		if (nextLive != nullptr)
+			nextLive->prevLive = prevLive;
+	}
+
+	ThreadState* state = threadStates;
+	while (state != nullptr)
+	{
+		ThreadState* next = state->next;
+		baseAllocator->MakeDelete(state);
+		state = next;
+	}
+
+	Page* page = pages;
+	while (page != nullptr)
+	{
+		Page* next = page->next;
+		baseAllocator->Deallocate(page);
+		page = next;
+	}
+
+	// Entries on other threads are left behind and reclaimed when those threads run out
+	// of free entries. Allocator IDs are never reused, so stale entries can't match.
+	for (ThreadCacheEntry& entry : threadCaches)
+		if (entry.allocatorId == allocatorId)
+			entry = ThreadCacheEntry{};
+}
+
+void* PoolAllocator::Allocate(size_t size, const char* debugTag)
+{
+	return AllocateAligned(size, MinBlockSize, debugTag);
+}
+
+void* PoolAllocator::AllocateAligned(size_t size, size_t alignment, const char* debugTag)
+{
+	assert(Math::IsPowerOfTwo(alignment));
+
+	if (size > MaxBlockSize || alignment > MinBlockSize)
+		return AllocateLarge(size, alignment, debugTag);
+
+	uint32_t sizeClass = GetSizeClass(size);
+	FreeBlock* block = nullptr;
+
+	ThreadState* state = GetThreadState();
+	if (state != nullptr)
+	{
+		SizeClass& cache = state->caches[sizeClass];
+		if (cache.freeList == nullptr)
+			RefillCache(cache, sizeClass);
+
+		block = cache.freeList;
+		cache.freeList = block->next;
+		cache.freeCount -= 1;
+	}
+	else
+	{
+		// This thread has no cache slots left, use the shared free list directly
+		std::lock_guard<std::mutex> lock(mutex);
+
+		SizeClass& shared = sharedClasses[sizeClass];
+		if (shared.freeList == nullptr)
+			AllocatePage(sizeClass);
+
+		block = shared.freeList;
+		shared.freeList = block->next;
+		shared.freeCount -= 1;
+	}
+
+	BlockHeader* header = reinterpret_cast<BlockHeader*>(block);
+	header->size = size;
+	header->sizeClass = sizeClass;
+	header->offset = 0;
+
+	return header + 1;
+}
+
+void PoolAllocator::Deallocate(void* ptr)
+{
+	if (ptr == nullptr)
+		return;
+
+	BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+	uint32_t sizeClass = header->sizeClass;
+
+	if (sizeClass == LargeAllocation)
+	{
+		baseAllocator->Deallocate(static_cast<uint8_t*>(ptr) - header->offset);
+		return;
+	}
+
+	assert(sizeClass < SizeClassCount);
+
+	FreeBlock* block = reinterpret_cast<FreeBlock*>(header);
+
+	ThreadState* state = GetThreadState();
+	if (state != nullptr)
+	{
+		SizeClass& cache = state->caches[sizeClass];
+		block->next = cache.freeList;
+		cache.freeList = block;
+		cache.freeCount += 1;
+
+		// Don't let a thread that only frees memory hoard all the blocks
+		if (cache.freeCount > TransferBatchSize * 2)
+			FlushCache(cache, sizeClass, TransferBatchSize);
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		SizeClass& shared = sharedClasses[sizeClass];
+		block->next = shared.freeList;
+		shared.freeList = block;
+		shared.freeCount += 1;
+	}
+}
+
+size_t PoolAllocator::GetAllocatedSize(void* ptr)
+{
+	return (static_cast<BlockHeader*>(ptr) - 1)->size;
+}
+
+uint32_t PoolAllocator::GetSizeClass(size_t size)
+{
+	uint32_t sizeClass = 0;
+	size_t blockSize = MinBlockSize;
+
+	while (blockSize < size)
+	{
+		blockSize = blockSize << 1;
+		sizeClass += 1;
+	}
+
+	return sizeClass;
+}
+
+size_t PoolAllocator::GetBlockStride(uint32_t sizeClass)
+{
+	return sizeof(BlockHeader) + (MinBlockSize << sizeClass);
+}
+
+PoolAllocator::ThreadState* PoolAllocator::GetThreadState()
+{
+	ThreadCacheEntry* freeEntry = nullptr;
+
+	for (ThreadCacheEntry& entry : threadCaches)
+	{
+		if (entry.allocatorId == allocatorId)
+			return entry.state;
+
+		if (freeEntry == nullptr && entry.allocatorId == 0)
+			freeEntry = &entry;
+	}
+
+	if (freeEntry == nullptr)
+		freeEntry = ReclaimCacheEntries();
+
+	if (freeEntry == nullptr)
+		return nullptr;
+
+	ThreadState* state = baseAllocator->MakeNew<ThreadState>();
+	std::memset(state->caches, 0, sizeof(state->caches));
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		state->next = threadStates;
+		threadStates = state;
+	}
+
+	freeEntry->allocatorId = allocatorId;
+	freeEntry->state = state;
+
+	return state;
+}
+
+PoolAllocator::ThreadCacheEntry* PoolAllocator::ReclaimCacheEntries()
+{
+	ThreadCacheEntry* freeEntry = nullptr;
+
+	std::lock_guard<std::mutex> lock(liveMutex);
+
+	for (ThreadCacheEntry& entry : threadCaches)
+	{
+		bool live = false;
+		for (PoolAllocator* allocator = liveAllocators; allocator != nullptr; allocator = allocator->nextLive)
+		{
+			if (allocator->allocatorId == entry.allocatorId)
+			{
+				live = true;
+				break;
+			}
+		}
+
+		if (live == false)
+		{
+			// The thread state was already released by the destroyed allocator
+			entry = ThreadCacheEntry{};
+
+			if (freeEntry == nullptr)
+				freeEntry = &entry;
+		}
+	}
+
+	return freeEntry;
+}
+
+void* PoolAllocator::AllocateLarge(size_t size, size_t alignment, const char* debugTag)
+{
+	// Header goes right before the returned pointer, and alignment is always enough to fit it
+	if (alignment < MinBlockSize)
+		alignment = MinBlockSize;
+
+	uint8_t* base = static_cast<uint8_t*>(baseAllocator->AllocateAligned(size + alignment, alignment, debugTag));
+	if (base == nullptr)
+		return nullptr;
+
+	uint8_t* result = base + alignment;
+
+	BlockHeader* header = reinterpret_cast<BlockHeader*>(result) - 1;
+	header->size = size;
+	header->sizeClass = LargeAllocation;
+	header->offset = static_cast<uint32_t>(alignment);
+
+	return result;
+}
+
+void PoolAllocator::AllocatePage(uint32_t sizeClass)
+{
+	uint8_t* buffer = static_cast<uint8_t*>(baseAllocator->AllocateAligned(PageSize, MinBlockSize, "PoolAllocator page"));
+
+	Page* page = reinterpret_cast<Page*>(buffer);
+	page->next = pages;
+	pages = page;
+
+	size_t stride = GetBlockStride(sizeClass);
+	size_t blockCount = (PageSize - MinBlockSize) / stride;
+
+	SizeClass& shared = sharedClasses[sizeClass];
+
+	// Link blocks so that they're handed out in address order
+	uint8_t* blockStart = buffer + MinBlockSize;
+	for (size_t i = blockCount; i > 0; --i)
+	{
+		FreeBlock* block = reinterpret_cast<FreeBlock*>(blockStart + (i - 1) * stride);
+		block->next = shared.freeList;
+		shared.freeList = block;
+	}
+
+	shared.freeCount += static_cast<uint32_t>(blockCount);
+}
+
+void PoolAllocator::RefillCache(SizeClass& cache, uint32_t sizeClass)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	SizeClass& shared = sharedClasses[sizeClass];
+	if (shared.freeList == nullptr)
+		AllocatePage(sizeClass);
+
+	for (uint32_t i = 0; i < TransferBatchSize && shared.freeList != nullptr; ++i)
+	{
+		FreeBlock* block = shared.freeList;
+		shared.freeList = block->next;
+		shared.freeCount -= 1;
+
+		block->next = cache.freeList;
+		cache.freeList = block;
+		cache.freeCount += 1;
+	}
+}
+
+void PoolAllocator::FlushCache(SizeClass& cache, uint32_t sizeClass, uint32_t keepCount)
+{
+	uint32_t flushCount = cache.freeCount - keepCount;
+
+	// Detach the blocks to flush before taking the lock
+	FreeBlock* first = cache.freeList;
+	FreeBlock* last = first;
+	for (uint32_t i = 1; i < flushCount; ++i)
+		last = last->next;
+
+	cache.freeList = last->next;
+	cache.freeCount = keepCount;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	SizeClass& shared = sharedClasses[sizeClass];
+	last->next = shared.freeList;
+	shared.freeList = first;
+	shared.freeCount += flushCount;
+}
+
+TEST_CASE("PoolAllocator.SizeClasses")
+{
+	PoolAllocator allocator(Allocator::GetDefault());
+
+	const size_t sizes[] = { 1, 16, 17, 100, 512, 1024, 1025, 5000 };
+	void* allocations[KOKKO_ARRAY_ITEMS(sizes)];
+
+	for (size_t i = 0; i < KOKKO_ARRAY_ITEMS(sizes); ++i)
+	{
+		allocations[i] = allocator.Allocate(sizes[i]);
+		CHECK(reinterpret_cast<uintptr_t>(allocations[i]) % 16 == 0);
+		CHECK(allocator.GetAllocatedSize(allocations[i]) == sizes[i]);
+		std::memset(allocations[i], 0xAB, sizes[i]);
+	}
+
+	for (size_t i = 0; i < KOKKO_ARRAY_ITEMS(sizes); ++i)
+		allocator.Deallocate(allocations[i]);
+}
+
+TEST_CASE("PoolAllocator.AllocateAligned")
+{
+	PoolAllocator allocator(Allocator::GetDefault());
+
+	for (size_t alignment = 1; alignment <= 256; alignment = alignment << 1)
+	{
+		void* allocation = allocator.AllocateAligned(100, alignment);
+		intptr_t address = reinterpret_cast<intptr_t>(allocation);
+		CHECK(address % alignment == 0);
+		CHECK(allocator.GetAllocatedSize(allocation) == 100);
+		allocator.Deallocate(allocation);
+	}
+}
+
+TEST_CASE("PoolAllocator.ReuseBlocks")
+{
+	PoolAllocator allocator(Allocator::GetDefault());
+
+	void* first = allocator.Allocate(24);
+	allocator.Deallocate(first);
+
+	void* second = allocator.Allocate(32);
+	CHECK(second == first);
+	allocator.Deallocate(second);
+}
+
+TEST_CASE("PoolAllocator.Threads")
+{
+	PoolAllocator allocator(Allocator::GetDefault());
+
+	const int threadCount = 4;
+	const int allocationCount = 2000;
+	static void* allocations[threadCount][allocationCount];
+
+	std::thread threads[threadCount];
+	for (int t = 0; t < threadCount; ++t)
+	{
+		threads[t] = std::thread([&allocator, t]()
+		{
+			for (int i = 0; i < allocationCount; ++i)
+			{
+				size_t size = 8 + (i % 64) * 16;
+				allocations[t][i] = allocator.Allocate(size);
+				std::memset(allocations[t][i], t, size);
+			}
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	for (int t = 0; t < threadCount; ++t)
+	{
+		for (int i = 0; i < allocationCount; ++i)
+		{
+			size_t size = 8 + (i % 64) * 16;
+			const uint8_t* bytes = static_cast<const uint8_t*>(allocations[t][i]);
+			CHECK(allocator.GetAllocatedSize(allocations[t][i]) == size);
+			CHECK(bytes[0] == t);
+			CHECK(bytes[size - 1] == t);
+		}
+	}
+
+	// Free on a different thread than where the allocation was made
+	for (int t = 0; t < threadCount; ++t)
+	{
+		threads[t] = std::thread([&allocator, t]()
+		{
+			int source = (t + 1) % threadCount;
+			for (int i = 0; i < allocationCount; ++i)
+				allocator.Deallocate(allocations[source][i]);
+		});
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+TEST_CASE("PoolAllocator.ReclaimCacheEntries")
+{
+	// Allocators are used on a worker thread but destroyed on this thread,
+	// so the worker's cache entries are left behind every round
+	const int roundCount = 4;
+	const int allocatorCount = 12;
+	std::atomic<int> usedRound(-1);
+	std::atomic<int> createdRound(0);
+	Allocator* baseAllocator = Allocator::GetDefault();
+	PoolAllocator* allocators[allocatorCount] = {};
+	bool usedThreadCache[roundCount][allocatorCount] = {};
+
+	for (PoolAllocator*& allocator : allocators)
+		allocator = baseAllocator->MakeNew<PoolAllocator>(baseAllocator);
+
+	std::thread worker([&]()
+	{
+		for (int round = 0; round < roundCount; ++round)
+		{
+			while (createdRound.load() != round)
+				std::this_thread::yield();
+
+			for (int i = 0; i < allocatorCount; ++i)
+			{
+				// Blocks are moved into the thread cache in reverse order,
+				// the shared free list hands them out in address order
+				void* first = allocators[i]->Allocate(16);
+				void* second = allocators[i]->Allocate(16);
+				usedThreadCache[round][i] = first > second;
+				allocators[i]->Deallocate(second);
+				allocators[i]->Deallocate(first);
+			}
+
+			usedRound.store(round);
+		}
+	});
+
+	for (int round = 0; round < roundCount; ++round)
+	{
+		while (usedRound.load() != round)
+			std::this_thread::yield();
+
+		for (PoolAllocator*& allocator : allocators)
+		{
+			baseAllocator->MakeDelete(allocator);
+			allocator = baseAllocator->MakeNew<PoolAllocator>(baseAllocator);
+		}
+
+		createdRound.store(round + 1);
+	}
+
+	worker.join();
+
+	for (PoolAllocator* allocator : allocators)
+		baseAllocator->MakeDelete(allocator);
+
+	for (int round = 0; round < roundCount; ++round)
+		for (int i = 0; i < allocatorCount; ++i)
+			CHECK(usedThreadCache[round][i]);
+}
+
+} // namespace kokko
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "Memory/Allocator.hpp"
+
+namespace kokko
+{
+
+// Allocates small blocks from size class free lists (16, 32, 64, ... 1024 bytes).
+// Each thread keeps a small cache of free blocks per size class, so most allocations
+// and deallocations don't need any synchronization. Larger or over-aligned allocations
+// are forwarded to the base allocator.
+class PoolAllocator : public Allocator
+{
+public:
+	static const size_t SizeClassCount = 7;
+	static const size_t MinBlockSize = 16;
+	static const size_t MaxBlockSize = MinBlockSize << (SizeClassCount - 1);
+
+	explicit PoolAllocator(Allocator* baseAllocator);
+	~PoolAllocator();
+
+	PoolAllocator(const PoolAllocator&) = delete;
+	PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+	virtual void* Allocate(size_t size, const char* debugTag = nullptr) override;
+	virtual void* AllocateAligned(size_t size, size_t alignment, const char* debugTag = nullptr) override;
+	virtual void Deallocate(void* ptr) override;
+	virtual size_t GetAllocatedSize(void* ptr) override;
+
+private:
+	static const size_t PageSize = 64 * 1024;
+	static const uint32_t TransferBatchSize = 32;
+	static const uint32_t MaxCachedAllocators = 16;
+	static const uint32_t LargeAllocation = UINT32_MAX;
+
+	struct BlockHeader
+	{
+		size_t size;
+		uint32_t sizeClass;
+		uint32_t offset; // From the base allocation, only used by large allocations
+	};
+
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	struct Page
+	{
+		Page* next;
+	};
+
+	struct SizeClass
+	{
+		FreeBlock* freeList;
+		uint32_t freeCount;
+	};
+
+	struct ThreadState
+	{
+		ThreadState* next;
+		SizeClass caches[SizeClassCount];
+	};
+
+	struct ThreadCacheEntry
+	{
+		uint64_t allocatorId;
+		ThreadState* state;
+	};
+
+	static uint32_t GetSizeClass(size_t size);
+	static size_t GetBlockStride(uint32_t sizeClass);
+
+	ThreadState* GetThreadState();
+
+	// Frees cache entries of this thread whose allocator has been destroyed
+	static ThreadCacheEntry* ReclaimCacheEntries();
+
+	void* AllocateLarge(size_t size, size_t alignment, const char* debugTag);
+
+	// Carve a new page into free blocks on the shared list, mutex must be held
+	void AllocatePage(uint32_t sizeClass);
+
+	// Move blocks between the shared free list and a thread's cache
+	void RefillCache(SizeClass& cache, uint32_t sizeClass);
+	void FlushCache(SizeClass& cache, uint32_t sizeClass, uint32_t keepCount);
+
+	static std::atomic<uint64_t> nextAllocatorId;
+	static thread_local ThreadCacheEntry threadCaches[MaxCachedAllocators];
+
+	// Live allocators, used to find cache entries left behind by destroyed allocators
+	static std::mutex liveMutex;
+	static PoolAllocator* liveAllocators;
+
+	Allocator* baseAllocator;
+	uint64_t allocatorId;
+
+	PoolAllocator* prevLive;
+	PoolAllocator* nextLive;
+
+	std::mutex mutex;
+	SizeClass sharedClasses[SizeClassCount];
+	Page* pages;
+	ThreadState* threadStates;
+};
+
+} // namespace kokko
@@ -19,17 +19,26 @@ TraceAllocator::~TraceAllocator()
 	assert(allocations.GetCount() == 0);
 }
 
+void TraceAllocator::AddTrace(void* ptr, const char* debugTag)
+{
+	if (ptr != nullptr)
+	{
+		std::lock_guard<std::mutex> lock(allocationsMutex);
+		allocations.Insert(GetKey(ptr))->second = debugTag;
+	}
+}
+
 void* TraceAllocator::Allocate(std::size_t size, const char* debugTag)
 {
 	void* ptr = MetricAllocator::Allocate(size);
-	allocations.Insert(AllocationInfo{ ptr, debugTag });
+	AddTrace(ptr, debugTag);
 	return ptr;
 }
 
 void* TraceAllocator::AllocateAligned(size_t size, size_t alignment, const char* debugTag)
 {
 	void* ptr = MetricAllocator::AllocateAligned(size, alignment);
-	allocations.Insert(AllocationInfo{ ptr, debugTag });
+	AddTrace(ptr, debugTag);
 	return ptr;
 }
 
@@ -37,9 +46,12 @@ void TraceAllocator::Deallocate(void* ptr)
 {
 	if (ptr != nullptr)
 	{
-		intptr_t index = allocations.Find(AllocationInfo{ ptr, nullptr });
-		assert(index >= 0);
-		allocations.Remove(index);
+		std::lock_guard<std::mutex> lock(allocationsMutex);
+
+		auto pair = allocations.Lookup(GetKey(ptr));
+		assert(pair != nullptr);
+		if (pair != nullptr)
+			allocations.Remove(pair);
 	}
 
 	MetricAllocator::Deallocate(ptr);
@@ -47,16 +59,19 @@ void TraceAllocator::Deallocate(void* ptr)
 
 void TraceAllocator::OutputAllocations(FILE* stream)
 {
+	std::lock_guard<std::mutex> lock(allocationsMutex);
+
 	fprintf(stream, "TraceAllocator (%s):\n", GetMemoryScopeName());
 
 	if (allocations.GetCount() > 0)
 	{
 		fprintf(stream, "\t%zu allocations, %zu bytes total\n", GetTotalAllocationCount(), GetTotalAllocationSize());
 
-		for (const AllocationInfo& alloc : allocations)
+		for (auto& alloc : allocations)
 		{
-			const char* tag = alloc.tag != nullptr ? alloc.tag : "Unnamed";
-			fprintf(stream, "\t%p: %8zu B, %s\n", alloc.ptr, GetAllocatedSize(alloc.ptr), tag);
+			void* ptr = reinterpret_cast<void*>(static_cast<uintptr_t>(alloc.first));
+			const char* tag = alloc.second != nullptr ? alloc.second : "Unnamed";
+			fprintf(stream, "\t%p: %8zu B, %s\n", ptr, GetAllocatedSize(ptr), tag);
 		}
 	}
 	else
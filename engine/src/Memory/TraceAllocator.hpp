@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <cstdio>
+#include <mutex>
 
-#include "Core/SortedArray.hpp"
+#include "Core/HashMap.hpp"
 
 #include "Memory/MetricAllocator.hpp"
 
@@ -12,17 +14,13 @@ namespace kokko
 class TraceAllocator : public MetricAllocator
 {
 private:
-	struct AllocationInfo
-	{
-		void* ptr;
-		const char* tag;
+	// Allocation address to debug tag
+	HashMap<uint64_t, const char*> allocations;
+	std::mutex allocationsMutex;
 
-		bool operator<(const AllocationInfo& other) const { return ptr < other.ptr; }
-		bool operator>(const AllocationInfo& other) const { return ptr > other.ptr; }
-		bool operator==(const AllocationInfo& other) const { return ptr == other.ptr; }
-	};
+	static uint64_t GetKey(void* ptr) { return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr)); }
 
-	kokko::SortedArray<AllocationInfo> allocations;
+	void AddTrace(void* ptr, const char* debugTag);
 
 public:
 	TraceAllocator(const char* memoryScope, Allocator* allocator);
@@ -14,17 +14,14 @@ const char* CameraSystem::ProjectionTypeDisplayNames[] = { "Perspective", "Ortho
 CameraSystem::CameraSystem(Allocator* allocator) :
 	allocator(allocator),
 	entityMap(allocator),
+	data(allocator, "CameraSystem.data"),
 	activeCamera(Entity::Null)
 {
-	data = InstanceData{};
-	data.count = 1; // Reserve index 0 as CameraId::Null value
-
-	this->Reallocate(16);
+	data.Add(); // Reserve index 0 as CameraId::Null value
 }
 
 CameraSystem::~CameraSystem()
 {
-	allocator->Deallocate(data.buffer);
 }
 
 const char* CameraSystem::GetProjectionTypeName(ProjectionType type)
@@ -39,37 +36,6 @@ const char* CameraSystem::GetProjectionTypeDisplayName(ProjectionType type)
 	return ProjectionTypeDisplayNames[index];
 }
 
-void CameraSystem::Reallocate(unsigned int required)
-{
-	if (required <= data.allocated)
-		return;
-
-	required = static_cast<unsigned int>(Math::UpperPowerOfTwo(required));
-
-	// Reserve same amount in entity map
-	entityMap.Reserve(required);
-
-	InstanceData newData;
-	unsigned int bytes = required * (sizeof(Entity) + sizeof(CameraComponent));
-
-	newData.buffer = allocator->Allocate(bytes, "CameraSystem.data.buffer");
-	newData.count = data.count;
-	newData.allocated = required;
-
-	newData.entity = static_cast<Entity*>(newData.buffer);
-	newData.components = reinterpret_cast<CameraComponent*>(newData.entity + required);
-
-	if (data.buffer != nullptr)
-	{
-		std::memcpy(newData.entity, data.entity, data.count * sizeof(Entity));
-		std::memcpy(newData.components, data.components, data.count * sizeof(CameraComponent));
-
-		allocator->Deallocate(data.buffer);
-	}
-
-	data = newData;
-}
-
 CameraId CameraSystem::AddCamera(Entity entity)
 {
 	CameraId id;
@@ -79,12 +45,14 @@ CameraId CameraSystem::AddCamera(Entity entity)
 
 void CameraSystem::AddCamera(unsigned int count, const Entity* entities, CameraId* cameraIdsOut)
 {
-	if (data.count + count > data.allocated)
-		this->Reallocate(data.count + count);
+	unsigned int first = data.Add(count);
+
+	// Reserve same amount in entity map
+	entityMap.Reserve(data.GetCapacity());
 
 	for (unsigned int i = 0; i < count; ++i)
 	{
-		unsigned int id = data.count + i;
+		unsigned int id = first + i;
 
 		Entity e = entities[i];
 
@@ -94,75 +62,70 @@ void CameraSystem::AddCamera(unsigned int count, const Entity* entities, CameraI
 		auto mapPair = entityMap.Insert(e.id);
 		mapPair->second.i = id;
 
-		data.entity[id] = e;
-		data.components[id] = CameraComponent{ ProjectionParameters(), 1.0f };
+		data.Get<Column::Entity>()[id] = e;
+		data.Get<Column::Component>()[id] = CameraComponent{ ProjectionParameters(), 1.0f };
 
 		cameraIdsOut[i].i = id;
 	}
-
-	data.count += count;
 }
 
 void CameraSystem::RemoveCamera(CameraId id)
 {
 	assert(id != CameraId::Null);
-	assert(id.i < data.count);
+	assert(id.i < data.GetCount());
 
 	// Remove from entity map
-	Entity entity = data.entity[id.i];
+	Entity entity = data.Get<Column::Entity>()[id.i];
 	auto* pair = entityMap.Lookup(entity.id);
 	if (pair != nullptr)
 		entityMap.Remove(pair);
 
 	// Update active camera if the active camera is removed
-	if (activeCamera == entity && data.count > 2)
+	if (activeCamera == entity && data.GetCount() > 2)
 	{
-		unsigned int swapIdx = (id.i == data.count - 1) ? 1 : data.count - 1;
-		activeCamera = data.entity[swapIdx];
+		unsigned int swapIdx = (id.i == data.GetCount() - 1) ? 1 : data.GetCount() - 1;
+		activeCamera = data.Get<Column::Entity>()[swapIdx];
 	}
 
-	if (data.count > 2 && id.i + 1 < data.count) // We need to swap another object
+	if (id.i + 1 < data.GetCount()) // We need to swap another object
 	{
-		unsigned int swapIdx = data.count - 1;
+		unsigned int swapIdx = data.GetCount() - 1;
 
 		// Update the swapped objects id in the entity map
-		auto* swapKv = entityMap.Lookup(data.entity[swapIdx].id);
+		auto* swapKv = entityMap.Lookup(data.Get<Column::Entity>()[swapIdx].id);
 		if (swapKv != nullptr)
 			swapKv->second = id;
-
-		data.entity[id.i] = data.entity[swapIdx];
-		data.components[id.i] = data.components[swapIdx];
 	}
 
-	--data.count;
+	data.RemoveSwap(id.i);
 }
 
 void CameraSystem::RemoveAll()
 {
 	entityMap.Clear();
-	data.count = 1;
+	data.SetCount(1);
 
 	activeCamera = Entity::Null;
 }
 
 const ProjectionParameters& CameraSystem::GetProjection(CameraId id) const
 {
-	return data.components[id.i].projection;
+	return data.Get<Column::Component>()[id.i].projection;
 }
 
 void CameraSystem::SetProjection(CameraId id, const ProjectionParameters& parameters)
 {
-	data.components[id.i].projection = parameters;
+	data.Get<Column::Component>()[id.i].projection = parameters;
 }
 
 float CameraSystem::GetExposure(CameraId id) const
 {
-	return data.components[id.i].exposure;
+	return data.Get<Column::Component>()[id.i].exposure;
 }
 
 void CameraSystem::SetExposure(CameraId id, float exposure)
 {
-	data.components[id.i].exposure = exposure;
+	data.Get<Column::Component>()[id.i].exposure = exposure;
 }
 
 Entity CameraSystem::GetActiveCamera() const
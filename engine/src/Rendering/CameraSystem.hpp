@@ -5,6 +5,7 @@
 #include "Core/Array.hpp"
 #include "Core/HashMap.hpp"
 #include "Core/BitPack.hpp"
+#include "Core/SoaStorage.hpp"
 
 #include "Engine/Entity.hpp"
 
@@ -59,7 +60,7 @@ public:
 
 	void RemoveAll();
 
-	Entity GetEntity(CameraId id) const { return data.entity[id.i]; }
+	Entity GetEntity(CameraId id) const { return data.Get<Column::Entity>()[id.i]; }
 
 	const ProjectionParameters& GetProjection(CameraId id) const;
 	void SetProjection(CameraId id, const ProjectionParameters& parameters);
@@ -79,20 +80,14 @@ private:
 
 	HashMap<unsigned int, CameraId> entityMap;
 
-	struct InstanceData
+	struct Column
 	{
-		unsigned int count;
-		unsigned int allocated;
-		void* buffer;
+		enum : size_t { Entity, Component };
+	};
 
-		Entity* entity;
-		CameraComponent* components;
-	}
-	data;
+	SoaStorage<Entity, CameraComponent> data;
 
 	Entity activeCamera;
-
-	void Reallocate(unsigned int required);
 };
 
 } // namespace kokko
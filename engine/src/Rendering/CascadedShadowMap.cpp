@@ -12,6 +12,21 @@ namespace kokko
 namespace CascadedShadowMap
 {
 
+namespace
+{
+
+// Cascade diameter is split into this many steps when snapping to the cache grid.
+// Shadow cascade resolution must be divisible by this, so that steps are whole texels.
+constexpr float CacheGridDivisions = 16.0f;
+
+// Snapped sphere center can be up to half a step away from the original on each axis
+constexpr float CacheGridMaxOffset = 0.8660254f; // sqrt(3) / 2
+
+// Radius is rounded up to a multiple of this, so that floating point noise doesn't change it
+constexpr float CacheGridRadiusQuantum = 1.0f / 16.0f;
+
+} // namespace
+
 int GetShadowCascadeResolution()
 {
 	return 1536;
@@ -26,6 +41,7 @@ void CalculateCascadeFrusta(
 	const Vec3f& lightDirection,
 	const Mat4x4f& cameraTransform,
 	const ProjectionParameters& projection,
+	bool snapToCacheGrid,
 	Mat4x4fBijection* transformsOut,
 	ProjectionParameters* projectionsOut)
 {
@@ -98,6 +114,21 @@ void CalculateCascadeFrusta(
 			radius = (sphereCenter - fp.points[0]).Magnitude() * roundingMarginFactor;
 		}
 
+		if (snapToCacheGrid)
+		{
+			// Enlarge the radius so that the snapped sphere still contains the original one
+			radius = radius / (1.0f - 2.0f * CacheGridMaxOffset / CacheGridDivisions);
+			radius = std::ceil(radius / CacheGridRadiusQuantum) * CacheGridRadiusQuantum;
+
+			float step = radius * 2.0f / CacheGridDivisions;
+
+			// Snap the center in light space, including depth so the depth range stays the same
+			float x = std::round(Vec3f::Dot(sphereCenter, lightDirX) / step) * step;
+			float y = std::round(Vec3f::Dot(sphereCenter, lightDirY) / step) * step;
+			float z = std::round(Vec3f::Dot(sphereCenter, lightDirection) / step) * step;
+			sphereCenter = lightDirX * x + lightDirY * y + lightDirection * z;
+		}
+
 		Vec3f from = sphereCenter - lightDirection * radius;
 
 		Mat4x4f lightModelTransform = Mat4x4f::LookAt(from, sphereCenter, up);
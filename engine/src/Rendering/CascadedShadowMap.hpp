@@ -14,10 +14,13 @@ constexpr unsigned int MaxCascadeCount = 4;
 unsigned int GetCascadeCount();
 int GetShadowCascadeResolution();
 
+// If snapToCacheGrid is set, cascades move in large texel aligned steps and stay
+// unchanged while the camera moves within a step, which allows caching their contents
 void CalculateCascadeFrusta(
 	const Vec3f& lightDirection,
 	const Mat4x4f& cameraTransform,
 	const ProjectionParameters& projection,
+	bool snapToCacheGrid,
 	Mat4x4fBijection* transformsOut,
 	ProjectionParameters* projectionsOut);
 
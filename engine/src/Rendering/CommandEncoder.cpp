@@ -29,13 +29,13 @@ CommandEncoderDebugScope CommandEncoder::CreateDebugScope(uint32_t id, kokko::Co
 
 void CommandEncoder::BeginDebugScope(uint32_t id, kokko::ConstStringView message)
 {
-	uint32_t messageOffset = CopyCommandData(message.str, message.len);
+	const char* messageCopy = static_cast<const char*>(CopyCommandData(message.str, message.len));
 
 	CmdBeginDebugScope data{
 		CommandType::BeginDebugScope,
 		id,
-		messageOffset,
-		static_cast<uint32_t>(message.len)
+		static_cast<uint32_t>(message.len),
+		messageCopy
 	};
 
 	CopyCommand(&data, sizeof(data));
@@ -417,6 +417,25 @@ void CommandEncoder::BindTextureToShader(
 	CopyCommand(&data, sizeof(data));
 }
 
+void CommandEncoder::BindImageTexture(
+	uint32_t imageUnit,
+	render::TextureId texture,
+	int32_t level,
+	RenderBufferAccess access,
+	RenderTextureSizedFormat format)
+{
+	CmdBindImageTexture data{
+		CommandType::BindImageTexture,
+		imageUnit,
+		texture,
+		level,
+		access,
+		format
+	};
+
+	CopyCommand(&data, sizeof(data));
+}
+
 // ======================
 // ==== VERTEX ARRAY ====
 // ======================
@@ -451,19 +470,15 @@ void CommandEncoder::MemoryBarrier(const MemoryBarrierFlags& barrier)
 
 void CommandEncoder::CopyCommand(const void* ptr, size_t size)
 {
-	size_t offset = buffer->commands.GetCount();
-	buffer->commands.Resize(offset + size);
-	std::memcpy(&buffer->commands[offset], ptr, size);
+	std::memcpy(buffer->AllocateCommand(size), ptr, size);
 }
 
-uint32_t CommandEncoder::CopyCommandData(const void* ptr, size_t size)
+const void* CommandEncoder::CopyCommandData(const void* ptr, size_t size)
 {
-	uint32_t offset = static_cast<uint32_t>(buffer->commandData.GetCount());
-	buffer->commandData.Resize(offset + size);
-
-	std::memcpy(&buffer->commandData[offset], ptr, size);
+	void* dest = buffer->AllocateData(size);
+	std::memcpy(dest, ptr, size);
 
-	return offset;
+	return dest;
 }
 
 } // namespace render
@@ -19,7 +19,7 @@ class Allocator;
 namespace render
 {
 
-struct CommandBuffer;
+class CommandBuffer;
 struct ResourceMap;
 
 class CommandEncoder
@@ -118,6 +118,12 @@ public:
 		int32_t uniformLocation,
 		uint32_t textureUnit,
 		render::TextureId texture);
+	void BindImageTexture(
+		uint32_t imageUnit,
+		render::TextureId texture,
+		int32_t level,
+		RenderBufferAccess access,
+		RenderTextureSizedFormat format);
 
 	// Vertex arrays
 
@@ -129,7 +135,7 @@ public:
 
 private:
 	void CopyCommand(const void* ptr, size_t size);
-	uint32_t CopyCommandData(const void* ptr, size_t size);
+	const void* CopyCommandData(const void* ptr, size_t size);
 
 	Allocator* allocator;
 	CommandBuffer* buffer;
@@ -8,7 +8,7 @@ class Allocator;
 namespace render
 {
 
-struct CommandBuffer;
+class CommandBuffer;
 
 class CommandExecutor
 {
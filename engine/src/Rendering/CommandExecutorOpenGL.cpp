@@ -31,30 +31,35 @@ void CommandExecutorOpenGL::Execute(const CommandBuffer* commandBuffer)
 	KOKKO_PROFILE_FUNCTION();
 
 	cmdBuffer = commandBuffer;
-	uint32_t commandOffset = 0;
 
 	commandHistory.Clear();
 
-	uint32_t end = static_cast<uint32_t>(cmdBuffer->commands.GetCount());
-	while (commandOffset < end)
+	// Commands never cross page boundaries
+	for (const CommandBuffer::Page* page = cmdBuffer->GetFirstCommandPage(); page != nullptr; page = page->next)
 	{
-		const uint8_t* commandBegin = &cmdBuffer->commands[commandOffset];
-		CommandType type = *reinterpret_cast<const CommandType*>(commandBegin);
-		size_t bytesProcessed = ParseCommand(type, commandBegin);
+		const uint8_t* pageData = page->GetData();
+		size_t commandOffset = 0;
 
-		if (bytesProcessed == 0)
+		while (commandOffset < page->used)
 		{
-			assert(false && "Unrecognized command type");
-			KK_LOG_ERROR("Unrecognized command type: {}", static_cast<uint32_t>(type));
-			break;
-		}
+			const uint8_t* commandBegin = pageData + commandOffset;
+			CommandType type = *reinterpret_cast<const CommandType*>(commandBegin);
+			size_t bytesProcessed = ParseCommand(type, commandBegin);
+
+			if (bytesProcessed == 0)
+			{
+				assert(false && "Unrecognized command type");
+				KK_LOG_ERROR("Unrecognized command type: {}", static_cast<uint32_t>(type));
+				return;
+			}
 
-		if (commandHistory.GetCount() == MaxCommandHistoryCount)
-			commandHistory.Pop();
+			if (commandHistory.GetCount() == MaxCommandHistoryCount)
+				commandHistory.Pop();
 
-		commandHistory.Push(type);
+			commandHistory.Push(type);
 
-		commandOffset += static_cast<uint32_t>(bytesProcessed);
+			commandOffset += bytesProcessed;
+		}
 	}
 }
 
@@ -69,7 +74,7 @@ size_t CommandExecutorOpenGL::ParseCommand(CommandType type, const uint8_t* comm
 	case CommandType::BeginDebugScope:
 	{
 		auto cmd = reinterpret_cast<const CmdBeginDebugScope*>(commandBegin);
-		auto message = reinterpret_cast<const char*>(&cmdBuffer->commandData[cmd->messageOffset]);
+		const char* message = cmd->message;
 		glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, cmd->id, cmd->messageLength, message);
 		debugScopeStack.PushBack(ConstStringView(message, cmd->messageLength));
 		return sizeof(*cmd);
@@ -351,6 +356,14 @@ size_t CommandExecutorOpenGL::ParseCommand(CommandType type, const uint8_t* comm
 		return sizeof(*cmd);
 	}
 
+	case CommandType::BindImageTexture:
+	{
+		auto cmd = reinterpret_cast<const CmdBindImageTexture*>(commandBegin);
+		glBindImageTexture(cmd->imageUnit, cmd->texture.i, cmd->level, GL_FALSE, 0,
+			ConvertBufferAccess(cmd->access), ConvertTextureSizedFormat(cmd->format));
+		return sizeof(*cmd);
+	}
+
 	// ======================
 	// ==== VERTEX ARRAY ====
 	// ======================
@@ -16,20 +16,18 @@ const LightId LightId::Null = LightId{ 0 };
 const char* LightManager::LightTypeNames[] = { "directional", "point", "spot" };
 const char* LightManager::LightTypeDisplayNames[] = { "Directional", "Point", "Spot" };
 
-LightManager::LightManager(Allocator* allocator) :
+LightManager::LightManager(Allocator* allocator, Allocator* frameAllocator) :
 	allocator(allocator),
+	frameAllocator(frameAllocator),
 	entityMap(allocator),
-	intersectResult(allocator)
+	intersectResult(allocator),
+	data(allocator, "LightManager.data")
 {
-	data = InstanceData{};
-	data.count = 1; // Reserve index 0 as LightId::Null value
-
-	this->Reallocate(16);
+	data.Add(); // Reserve index 0 as LightId::Null value
 }
 
 LightManager::~LightManager()
 {
-	allocator->Deallocate(data.buffer);
 }
 
 const char* LightManager::GetLightTypeName(LightType type)
@@ -44,50 +42,6 @@ const char* LightManager::GetLightTypeDisplayName(LightType type)
 	return LightTypeDisplayNames[index];
 }
 
-void LightManager::Reallocate(unsigned int required)
-{
-	if (required <= data.allocated)
-		return;
-
-	required = static_cast<unsigned int>(Math::UpperPowerOfTwo(required));
-
-	// Reserve same amount in entity map
-	entityMap.Reserve(required);
-
-	InstanceData newData;
-	unsigned int bytes = required * (sizeof(Entity) + sizeof(LightType) + sizeof(Vec3f) + sizeof(Vec4f) +
-		sizeof(Mat3x3f) + sizeof(float) * 2 + sizeof(bool));
-
-	newData.buffer = allocator->Allocate(bytes, "LightManager.data.buffer");
-	newData.count = data.count;
-	newData.allocated = required;
-
-	newData.entity = static_cast<Entity*>(newData.buffer);
-	newData.position = reinterpret_cast<Vec3f*>(newData.entity + required);
-	newData.orientation = reinterpret_cast<Mat3x3f*>(newData.position + required);
-	newData.type = reinterpret_cast<LightType*>(newData.orientation + required);
-	newData.colorAndIntensity = reinterpret_cast<Vec4f*>(newData.type + required);
-	newData.radius = reinterpret_cast<float*>(newData.colorAndIntensity + required);
-	newData.angle = reinterpret_cast<float*>(newData.radius + required);
-	newData.shadowCasting = reinterpret_cast<bool*>(newData.angle + required);
-
-	if (data.buffer != nullptr)
-	{
-		std::memcpy(newData.entity, data.entity, data.count * sizeof(Entity));
-		std::memcpy(newData.position, data.position, data.count * sizeof(Vec3f));
-		std::memcpy(newData.orientation, data.orientation, data.count * sizeof(Mat3x3f));
-		std::memcpy(newData.type, data.type, data.count * sizeof(LightType));
-		std::memcpy(newData.colorAndIntensity, data.colorAndIntensity, data.count * sizeof(Vec4f));
-		std::memcpy(newData.radius, data.radius, data.count * sizeof(float));
-		std::memcpy(newData.angle, data.angle, data.count * sizeof(float));
-		std::memcpy(newData.shadowCasting, data.shadowCasting, data.count * sizeof(bool));
-
-		allocator->Deallocate(data.buffer);
-	}
-
-	data = newData;
-}
-
 float LightManager::CalculateDefaultRadius(Vec4f colorAndIntensity)
 {
 	// TODO: This does not behave as expected with HDR rendering
@@ -110,8 +64,8 @@ void LightManager::NotifyUpdatedTransforms(size_t count, const Entity* entities,
 		if (id != LightId::Null)
 		{
 			const Mat4x4f& t = transforms[entityIdx];
-			data.position[id.i] = (t * origin).xyz();
-			data.orientation[id.i] = t.Get3x3();
+			data.Get<Column::Position>()[id.i] = (t * origin).xyz();
+			data.Get<Column::Orientation>()[id.i] = t.Get3x3();
 		}
 	}
 }
@@ -125,78 +79,69 @@ LightId LightManager::AddLight(Entity entity)
 
 void LightManager::AddLight(unsigned int count, const Entity* entities, LightId* lightIdsOut)
 {
-	if (data.count + count > data.allocated)
-		this->Reallocate(data.count + count);
+	unsigned int first = data.Add(count);
+
+	// Reserve same amount in entity map
+	entityMap.Reserve(data.GetCapacity());
 
 	for (unsigned int i = 0; i < count; ++i)
 	{
-		unsigned int id = data.count + i;
+		unsigned int id = first + i;
 
 		Entity e = entities[i];
 
 		auto mapPair = entityMap.Insert(e.id);
 		mapPair->second.i = id;
 
-		data.entity[id] = e;
-		data.position[id] = Vec3f();
-		data.orientation[id] = Mat3x3f();
-		data.type[id] = LightType::Point;
-		data.colorAndIntensity[id] = Vec4f(1.0f, 1.0f, 1.0f, 1.0f);
-		data.radius[id] = 1.0f;
-		data.angle[id] = Math::DegreesToRadians(60.0f);
-		data.shadowCasting[id] = false;
+		data.Get<Column::Entity>()[id] = e;
+		data.Get<Column::Position>()[id] = Vec3f();
+		data.Get<Column::Orientation>()[id] = Mat3x3f();
+		data.Get<Column::Type>()[id] = LightType::Point;
+		data.Get<Column::ColorAndIntensity>()[id] = Vec4f(1.0f, 1.0f, 1.0f, 1.0f);
+		data.Get<Column::Radius>()[id] = 1.0f;
+		data.Get<Column::Angle>()[id] = Math::DegreesToRadians(60.0f);
+		data.Get<Column::ShadowCasting>()[id] = false;
 
 		lightIdsOut[i].i = id;
 	}
-
-	data.count += count;
 }
 
 void LightManager::RemoveLight(LightId id)
 {
 	assert(id != LightId::Null);
-	assert(id.i < data.count);
+	assert(id.i < data.GetCount());
 
 	// Remove from entity map
-	Entity entity = data.entity[id.i];
+	Entity entity = data.Get<Column::Entity>()[id.i];
 	auto* pair = entityMap.Lookup(entity.id);
 	if (pair != nullptr)
 		entityMap.Remove(pair);
 
-	if (data.count > 2 && id.i + 1 < data.count) // We need to swap another object
+	if (id.i + 1 < data.GetCount()) // We need to swap another object
 	{
-		unsigned int swapIdx = data.count - 1;
+		unsigned int swapIdx = data.GetCount() - 1;
 
 		// Update the swapped objects id in the entity map
-		auto* swapKv = entityMap.Lookup(data.entity[swapIdx].id);
+		auto* swapKv = entityMap.Lookup(data.Get<Column::Entity>()[swapIdx].id);
 		if (swapKv != nullptr)
 			swapKv->second = id;
-
-		data.entity[id.i] = data.entity[swapIdx];
-		data.position[id.i] = data.position[swapIdx];
-		data.orientation[id.i] = data.orientation[swapIdx];
-		data.type[id.i] = data.type[swapIdx];
-		data.colorAndIntensity[id.i] = data.colorAndIntensity[swapIdx];
-		data.radius[id.i] = data.radius[swapIdx];
-		data.angle[id.i] = data.angle[swapIdx];
-		data.shadowCasting[id.i] = data.shadowCasting[swapIdx];
 	}
 
-	--data.count;
+	data.RemoveSwap(id.i);
 }
 
 void LightManager::RemoveAll()
 {
 	entityMap.Clear();
-	data.count = 1;
+	data.SetCount(1);
 }
 
 void LightManager::GetDirectionalLights(Array<LightId>& output)
 {
 	output.Clear();
 
-	for (unsigned int i = 1; i < data.count; ++i)
-		if (data.type[i] == LightType::Directional)
+	for (unsigned int i = 1; i < data.GetCount(); ++i)
+		if (data.Get<Column::Type>()[i] == LightType::Directional)
 			output.PushBack(LightId{ i });
 }
 
@@ -206,20 +151,20 @@ void LightManager::GetNonDirectionalLightsWithinFrustum(const FrustumPlanes& fru
 
 	output.Clear();
 
-	unsigned int lights = data.count - 1;
+	unsigned int lights = data.GetCount() - 1;
 
 	if (lights > 0)
 	{
-		Array<BitPack> intersectResult(allocator);
+		Array<BitPack> intersectResult(frameAllocator);
 		intersectResult.Resize(BitPack::CalculateRequired(lights));
 		BitPack* intersected = intersectResult.GetData();
-		Vec3f* positions = data.position + 1;
-		float* radii = data.radius + 1;
+		Vec3f* positions = data.Get<Column::Position>() + 1;
+		float* radii = data.Get<Column::Radius>() + 1;
 
 		Intersect::FrustumSphere(frustum, lights, positions, radii, intersected);
 
-		for (unsigned int i = 1; i < data.count; ++i)
-			if (data.type[i] != LightType::Directional && BitPack::Get(intersected, i - 1))
+		for (unsigned int i = 1; i < data.GetCount(); ++i)
+			if (data.Get<Column::Type>()[i] != LightType::Directional && BitPack::Get(intersected, i - 1))
 				output.PushBack(LightId{ i });
 	}
 }
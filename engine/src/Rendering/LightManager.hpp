@@ -3,6 +3,7 @@
 #include "Core/Array.hpp"
 #include "Core/HashMap.hpp"
 #include "Core/BitPack.hpp"
+#include "Core/SoaStorage.hpp"
 
 #include "Engine/Entity.hpp"
 
@@ -23,37 +24,26 @@ class LightManager : public TransformUpdateReceiver
 {
 private:
 	Allocator* allocator;
+	Allocator* frameAllocator;
 
 	HashMap<unsigned int, LightId> entityMap;
 	Array<BitPack> intersectResult;
 
-	struct InstanceData
+	struct Column
 	{
-		unsigned int count;
-		unsigned int allocated;
-		void* buffer;
-
-		Entity* entity;
-		Vec3f* position;
-		Mat3x3f* orientation;
-		LightType* type;
-		Vec4f* colorAndIntensity;
-		float* radius;
-		float* angle;
-		bool* shadowCasting;
-	}
-	data;
+		enum : size_t { Entity, Position, Orientation, Type, ColorAndIntensity, Radius, Angle, ShadowCasting };
+	};
+
+	SoaStorage<Entity, Vec3f, Mat3x3f, LightType, Vec4f, float, float, bool> data;
 
 	static const size_t LightTypeCount = 3;
 	static const char* LightTypeNames[LightTypeCount];
 	static const char* LightTypeDisplayNames[LightTypeCount];
 
-	void Reallocate(unsigned int required);
-
 	static float CalculateDefaultRadius(Vec4f colorAndIntensity);
 
 public:
-	LightManager(Allocator* allocator);
+	LightManager(Allocator* allocator, Allocator* frameAllocator);
 	~LightManager();
 
 	static const char* GetLightTypeName(LightType type);
@@ -74,38 +64,38 @@ public:
 
 	void RemoveAll();
 
-	Entity GetEntity(LightId id) const { return data.entity[id.i]; }
-	Vec3f GetPosition(LightId id) const { return data.position[id.i]; }
-	Mat3x3f GetOrientation(LightId id) const { return data.orientation[id.i]; }
+	Entity GetEntity(LightId id) const { return data.Get<Column::Entity>()[id.i]; }
+	Vec3f GetPosition(LightId id) const { return data.Get<Column::Position>()[id.i]; }
+	Mat3x3f GetOrientation(LightId id) const { return data.Get<Column::Orientation>()[id.i]; }
 
-	LightType GetLightType(LightId id) const { return data.type[id.i]; }
-	void SetLightType(LightId id, LightType type) { data.type[id.i] = type; }
+	LightType GetLightType(LightId id) const { return data.Get<Column::Type>()[id.i]; }
+	void SetLightType(LightId id, LightType type) { data.Get<Column::Type>()[id.i] = type; }
 
-	Vec3f GetColor(LightId id) const { return data.colorAndIntensity[id.i].xyz(); }
+	Vec3f GetColor(LightId id) const { return data.Get<Column::ColorAndIntensity>()[id.i].xyz(); }
 	void SetColor(LightId id, Vec3f color)
 	{
-		data.colorAndIntensity[id.i] = Vec4f(color, data.colorAndIntensity[id.i].w);
+		data.Get<Column::ColorAndIntensity>()[id.i] = Vec4f(color, data.Get<Column::ColorAndIntensity>()[id.i].w);
 	}
 
-	float GetIntensity(LightId id) const { return data.colorAndIntensity[id.i].w; }
-	void SetIntensity(LightId id, float intensity) { data.colorAndIntensity[id.i].w = intensity; }
+	float GetIntensity(LightId id) const { return data.Get<Column::ColorAndIntensity>()[id.i].w; }
+	void SetIntensity(LightId id, float intensity) { data.Get<Column::ColorAndIntensity>()[id.i].w = intensity; }
 
 	Vec3f GetLightEnergy(LightId id) const {
-		return data.colorAndIntensity[id.i].xyz() * data.colorAndIntensity[id.i].w;
+		return data.Get<Column::ColorAndIntensity>()[id.i].xyz() * data.Get<Column::ColorAndIntensity>()[id.i].w;
 	}
 
-	float GetRadius(LightId id) const { return data.radius[id.i]; }
-	void SetRadius(LightId id, float radius) { data.radius[id.i] = radius; }
+	float GetRadius(LightId id) const { return data.Get<Column::Radius>()[id.i]; }
+	void SetRadius(LightId id, float radius) { data.Get<Column::Radius>()[id.i] = radius; }
 	void SetRadiusFromColor(LightId id)
 	{
-		data.radius[id.i] = CalculateDefaultRadius(data.colorAndIntensity[id.i]);
+		data.Get<Column::Radius>()[id.i] = CalculateDefaultRadius(data.Get<Column::ColorAndIntensity>()[id.i]);
 	}
 
-	float GetSpotAngle(LightId id) const { return data.angle[id.i]; }
-	void SetSpotAngle(LightId id, float angle) { data.angle[id.i] = angle; }
+	float GetSpotAngle(LightId id) const { return data.Get<Column::Angle>()[id.i]; }
+	void SetSpotAngle(LightId id, float angle) { data.Get<Column::Angle>()[id.i] = angle; }
 
-	bool GetShadowCasting(LightId id) const { return data.shadowCasting[id.i]; }
-	void SetShadowCasting(LightId id, bool shadowCasting) { data.shadowCasting[id.i] = shadowCasting; }
+	bool GetShadowCasting(LightId id) const { return data.Get<Column::ShadowCasting>()[id.i]; }
+	void SetShadowCasting(LightId id, bool shadowCasting) { data.Get<Column::ShadowCasting>()[id.i] = shadowCasting; }
 
 	void GetDirectionalLights(Array<LightId>& output);
 	void GetNonDirectionalLightsWithinFrustum(const FrustumPlanes& frustum, Array<LightId>& output);
@@ -105,6 +105,13 @@ public:
 
 				parseAndSetMaterial(materialNode, 0);
 			}
+
+			bool occluder = false;
+			auto occluderNode = map.find_child("occluder");
+			if (occluderNode.valid() && occluderNode.has_val())
+				occluderNode >> occluder;
+
+			meshComponentSystem->SetOccluder(componentId, occluder);
 		}
 	}
 
@@ -173,6 +180,9 @@ public:
 					}
 				}
 			}
+
+			if (meshComponentSystem->IsOccluder(componentId))
+				componentNode["occluder"] << true;
 		}
 	}
 };
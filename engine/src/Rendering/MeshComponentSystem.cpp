@@ -1,10 +1,15 @@
 #include "Rendering/MeshComponentSystem.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+
+#include "Core/Core.hpp"
 
 #include "Engine/Entity.hpp"
 
 #include "Math/AABB.hpp"
+#include "Math/Frustum.hpp"
 #include "Math/Mat4x4.hpp"
 
 #include "Resources/MaterialData.hpp"
@@ -16,6 +21,27 @@ namespace kokko
 
 const MeshComponentId MeshComponentId::Null = MeshComponentId{ 0 };
 
+namespace
+{
+
+// Objects that haven't moved for this many frames are considered static
+constexpr uint32_t StaticSettleFrames = 60;
+
+// How often to check if the static BVH should be rebuilt
+constexpr uint32_t StaticCheckInterval = 60;
+
+// Settled objects in the dynamic tree required before a rebuild is worth it
+constexpr uint32_t StaticRebuildMinCount = 128;
+
+// Changed bounds are only tracked up to this count per frame
+constexpr size_t MaxChangedBoundsCount = 4096;
+
+// A coarser level is only chosen when its error is this much under the limit,
+// so objects near a switching distance don't flicker between levels
+constexpr float LodHysteresis = 0.75f;
+
+} // namespace
+
 template <typename ItemType, typename SizeType, SizeType MaxCount>
 MeshComponentSystem::CompactStorage<ItemType, SizeType, MaxCount>::CompactStorage() : count(0) { }
 
@@ -27,7 +53,8 @@ void MeshComponentSystem::CompactStorage<ItemType, SizeType, MaxCount>::Resize(S
 	SizeType oldCount = count;
 	count = newCount;
 
-	for (SizeType i = oldCount, end = (newCount > MaxCount ? MaxCount : newCount); i != newCount; ++i)
+	// Only newly added items need to be cleared
+	for (SizeType i = oldCount; i < newCount; ++i)
 		data[i] = ItemType{};
 }
 
@@ -45,21 +72,37 @@ ArrayView<const ItemType> MeshComponentSystem::CompactStorage<ItemType, SizeType
 
 template class MeshComponentSystem::CompactStorage<MaterialId, uint16_t, 7>;
 template class MeshComponentSystem::CompactStorage<TransparencyType, uint8_t, 7>;
+template class MeshComponentSystem::CompactStorage<MeshDrawPacket, uint8_t, 7>;
+
+static_assert(sizeof(MeshDrawPacket) == 16, "Draw packets should be kept compact");
+
+MeshComponentSystem::ChangedBounds::ChangedBounds(Allocator* allocator) :
+	staticObjects(allocator),
+	dynamicObjects(allocator),
+	overflow(false)
+{
+}
 
 MeshComponentSystem::MeshComponentSystem(Allocator* allocator, ModelManager* modelManager) :
 	allocator(allocator),
 	modelManager(modelManager),
-	data{},
-	entityMap(allocator)
+	data(allocator, "MeshComponentSystem.data"),
+	entityMap(allocator),
+	dynamicBvh(allocator),
+	staticBvh(allocator),
+	staticRemovedCount(0),
+	frameIndex(0),
+	lastStaticCheckFrame(0),
+	staticBuildIndices(allocator),
+	staticBuildBounds(allocator),
+	changedBounds(allocator)
 {
-	data.count = 1;
-
-	Reallocate(256);
+	data.Reserve(256);
+	data.Add(); // Reserve index 0 as MeshComponentId::Null value
 }
 
 MeshComponentSystem::~MeshComponentSystem()
 {
-	allocator->Deallocate(data.buffer);
 }
 
 void MeshComponentSystem::NotifyUpdatedTransforms(size_t count, const Entity* entities, const Mat4x4f* transforms)
@@ -71,19 +114,10 @@ void MeshComponentSystem::NotifyUpdatedTransforms(size_t count, const Entity* en
 
 		if (id != MeshComponentId::Null)
 		{
-			unsigned int dataIdx = id.i;
-
-			// Recalculate bounding box
-			MeshId meshId = data.mesh[dataIdx];
-
-			if (meshId != MeshId::Null)
-			{
-				const AABB& bounds = modelManager->GetModelMeshes(meshId.modelId)[meshId.meshIndex].aabb;
-				data.bounds[dataIdx] = bounds.Transform(transforms[entityIdx]);
-			}
-
-			// Set world transform
-			data.transform[dataIdx] = transforms[entityIdx];
+			// Set world transform and recalculate bounding box
+			data.Get<Column::Transform>()[id.i] = transforms[entityIdx];
+			UpdateBounds(id.i);
+			UpdateLodErrors(id.i);
 		}
 	}
 }
@@ -103,139 +137,395 @@ MeshComponentId MeshComponentSystem::AddComponent(Entity entity)
 
 void MeshComponentSystem::AddComponents(unsigned int count, const Entity* entities, MeshComponentId* idsOut)
 {
-	if (data.count + count > data.allocated)
-		Reallocate(data.count + count);
+	unsigned int first = data.Add(count);
+
+	// Reserve same amount in entity map
+	entityMap.Reserve(data.GetCapacity());
 
 	for (unsigned int i = 0; i < count; ++i)
 	{
-		unsigned int id = data.count + i;
+		unsigned int id = first + i;
 
 		Entity e = entities[i];
 
 		auto mapPair = entityMap.Insert(e.id);
 		mapPair->second = id;
 
-		data.entity[id] = e;
-		data.mesh[id] = MeshId::Null;
-		data.material[id] = MaterialStorage();
-		data.transparency[id] = TransparencyStorage();
-		data.bounds[id] = AABB();
-		data.transform[id] = Mat4x4f();
+		data.Get<Column::Entity>()[id] = e;
+		data.Get<Column::Mesh>()[id] = MeshId::Null;
+		data.Get<Column::Material>()[id] = MaterialStorage();
+		data.Get<Column::Transparency>()[id] = TransparencyStorage();
+		data.Get<Column::DrawPackets>()[id] = DrawPacketStorage();
+		data.Get<Column::Lod>()[id] = LodState{};
+		data.Get<Column::Bounds>()[id] = AABB();
+		data.Get<Column::Transform>()[id] = Mat4x4f();
+		data.Get<Column::Culling>()[id] = CullingState{ 0, frameIndex, CullingTree::None };
+		data.Get<Column::Occluder>()[id] = false;
 
 		idsOut[i].i = id;
 	}
-
-	data.count += count;
 }
 
 void MeshComponentSystem::RemoveComponent(MeshComponentId id)
 {
 	assert(id != MeshComponentId::Null);
-	assert(id.i < data.count);
+	assert(id.i < data.GetCount());
 
 	// Remove from entity map
-	Entity entity = data.entity[id.i];
+	Entity entity = data.Get<Column::Entity>()[id.i];
 	auto* pair = entityMap.Lookup(entity.id);
 	if (pair != nullptr)
 		entityMap.Remove(pair);
 
-	if (data.count > 2 && id.i + 1 < data.count) // We need to swap another object
+	RecordChange(id.i);
+	RemoveFromCulling(id.i);
+
+	if (id.i + 1 < data.GetCount()) // We need to swap another object
 	{
-		unsigned int swapIdx = data.count - 1;
+		unsigned int swapIdx = data.GetCount() - 1;
 
 		// Update the swapped objects id in the entity map
-		auto* swapKv = entityMap.Lookup(data.entity[swapIdx].id);
+		auto* swapKv = entityMap.Lookup(data.Get<Column::Entity>()[swapIdx].id);
 		if (swapKv != nullptr)
 			swapKv->second = id.i;
 
-		data.entity[id.i] = data.entity[swapIdx];
-		data.mesh[id.i] = data.mesh[swapIdx];
-		data.material[id.i] = data.material[swapIdx];
-		data.transparency[id.i] = data.transparency[swapIdx];
-		data.bounds[id.i] = data.bounds[swapIdx];
-		data.transform[id.i] = data.transform[swapIdx];
+		// Update the swapped objects id in the culling structures
+		const CullingState& swapCulling = data.Get<Column::Culling>()[swapIdx];
+		if (swapCulling.tree == CullingTree::Dynamic)
+			dynamicBvh.SetUserData(swapCulling.handle, id.i);
+		else if (swapCulling.tree == CullingTree::Static)
+			staticBvh.SetItemUserData(swapCulling.handle, id.i);
 	}
 
-	--data.count;
+	data.RemoveSwap(id.i);
 }
 
 void MeshComponentSystem::RemoveAll()
 {
 	entityMap.Clear();
-	data.count = 1;
+	data.SetCount(1);
+
+	dynamicBvh.Clear();
+	staticBvh.Clear();
+	staticRemovedCount = 0;
+
+	changedBounds.overflow = true;
 }
 
 void MeshComponentSystem::SetMesh(MeshComponentId id, MeshId meshId, uint32_t partCount)
 {
-	data.mesh[id.i] = meshId;
-	data.material[id.i].Resize(partCount);
-	data.transparency[id.i].Resize(partCount);
+	data.Get<Column::Mesh>()[id.i] = meshId;
+	data.Get<Column::Material>()[id.i].Resize(partCount);
+
+	if (meshId != MeshId::Null && data.Get<Column::Occluder>()[id.i])
+		modelManager->CreateMeshOccluder(meshId);
+	data.Get<Column::Transparency>()[id.i].Resize(partCount);
+
+	UpdateDrawPackets(id.i, partCount);
+	UpdateLodErrors(id.i);
+	UpdateBounds(id.i);
 }
 
 MeshId MeshComponentSystem::GetMeshId(MeshComponentId id) const
 {
-	return data.mesh[id.i];
+	return data.Get<Column::Mesh>()[id.i];
 }
 
 void MeshComponentSystem::SetMaterial(MeshComponentId id, uint32_t partIndex, MaterialId materialId, TransparencyType transparency)
 {
-	auto materials = data.material[id.i].GetDataView();
+	auto materials = data.Get<Column::Material>()[id.i].GetDataView();
 	assert(partIndex < materials.GetCount());
 	materials[partIndex] = materialId;
 
-	auto transparencies = data.transparency[id.i].GetDataView();
+	auto transparencies = data.Get<Column::Transparency>()[id.i].GetDataView();
 	assert(partIndex < transparencies.GetCount());
 	transparencies[partIndex] = transparency;
+
+	// Transparency decides if the object casts shadows
+	RecordChange(id.i);
 }
 
 ArrayView<const MaterialId> MeshComponentSystem::GetMaterialIds(MeshComponentId id) const
 {
-	return data.material[id.i].GetDataView();
+	return data.Get<Column::Material>()[id.i].GetDataView();
 }
 
 ArrayView<const TransparencyType> MeshComponentSystem::GetTransparencyTypes(MeshComponentId id) const
 {
-	return data.transparency[id.i].GetDataView();
+	return data.Get<Column::Transparency>()[id.i].GetDataView();
+}
+
+ArrayView<const MeshDrawPacket> MeshComponentSystem::GetDrawPackets(MeshComponentId id) const
+{
+	return data.Get<Column::DrawPackets>()[id.i].GetDataView();
+}
+
+MeshDrawPacket MeshComponentSystem::GetDrawPacket(MeshComponentId id, uint32_t partIndex, uint32_t lod) const
+{
+	MeshDrawPacket packet = data.Get<Column::DrawPackets>()[id.i].GetDataView()[partIndex];
+
+	if (lod != 0)
+	{
+		const ModelMeshLod& range = data.Get<Column::Lod>()[id.i].parts[partIndex].lods[lod];
+		packet.indexCount = range.count;
+		packet.indexOffset = range.indexOffset;
+	}
+
+	return packet;
+}
+
+uint32_t MeshComponentSystem::SelectLod(MeshComponentId id, uint32_t viewportIndex, float pixelsPerUnit, float maxErrorPx)
+{
+	assert(viewportIndex < LodState::MaxViewportCount);
+
+	LodState& state = data.Get<Column::Lod>()[id.i];
+
+	if (state.lodCount <= 1)
+		return 0;
+
+	uint32_t lod = std::min<uint32_t>(state.selected[viewportIndex], state.lodCount - 1);
+
+	// Refine while the current level is too coarse
+	while (lod > 0 && state.errors[lod] * pixelsPerUnit > maxErrorPx)
+		lod -= 1;
+
+	// Coarsen while the next level is clearly under the limit
+	while (lod + 1 < state.lodCount && state.errors[lod + 1] * pixelsPerUnit <= maxErrorPx * LodHysteresis)
+		lod += 1;
+
+	state.selected[viewportIndex] = static_cast<uint8_t>(lod);
+
+	return lod;
+}
+
+void MeshComponentSystem::SetOccluder(MeshComponentId id, bool occluder)
+{
+	data.Get<Column::Occluder>()[id.i] = occluder;
+
+	MeshId meshId = data.Get<Column::Mesh>()[id.i];
+	if (occluder && meshId != MeshId::Null)
+		modelManager->CreateMeshOccluder(meshId);
+}
+
+bool MeshComponentSystem::IsOccluder(MeshComponentId id) const
+{
+	return data.Get<Column::Occluder>()[id.i];
 }
 
-void MeshComponentSystem::Reallocate(unsigned int required)
+
+void MeshComponentSystem::UpdateCullingStructures()
 {
-	if (required <= data.allocated)
+	KOKKO_PROFILE_FUNCTION();
+
+	frameIndex += 1;
+
+	if (frameIndex - lastStaticCheckFrame < StaticCheckInterval)
 		return;
 
-	required = static_cast<unsigned int>(Math::UpperPowerOfTwo(required));
+	lastStaticCheckFrame = frameIndex;
 
-	// Reserve same amount in entity map
-	entityMap.Reserve(required);
+	uint32_t settledCount = 0;
+	if (dynamicBvh.GetLeafCount() >= StaticRebuildMinCount)
+	{
+		const CullingState* culling = data.Get<Column::Culling>();
+		for (unsigned int i = 1, count = data.GetCount(); i < count; ++i)
+			if (culling[i].tree == CullingTree::Dynamic && frameIndex - culling[i].lastMovedFrame >= StaticSettleFrames)
+				settledCount += 1;
+	}
+
+	bool tooManyRemoved = staticRemovedCount > 0 && staticRemovedCount * 2 > staticBvh.GetItemCount();
+
+	if (settledCount >= StaticRebuildMinCount || tooManyRemoved)
+		RebuildStaticBvh();
+}
+
+void MeshComponentSystem::QueryCullingCandidates(const FrustumPlanes& frustum, Array<uint32_t>& indicesOut) const
+{
+	staticBvh.QueryFrustum(frustum, indicesOut);
+	dynamicBvh.QueryFrustum(frustum, indicesOut);
+}
+
+void MeshComponentSystem::ClearChangedBounds()
+{
+	changedBounds.staticObjects.Clear();
+	changedBounds.dynamicObjects.Clear();
+	changedBounds.overflow = false;
+}
 
-	InstanceData newData;
-	unsigned int bytes = required * (sizeof(Entity) + sizeof(MeshId) + sizeof(MaterialStorage) +
-		sizeof(TransparencyStorage) + sizeof(AABB) + sizeof(Mat4x4f));
+void MeshComponentSystem::RecordChange(unsigned int index)
+{
+	CullingTree tree = data.Get<Column::Culling>()[index].tree;
+
+	// Objects that aren't in either tree don't have valid bounds
+	if (tree != CullingTree::None)
+		RecordChange(data.Get<Column::Bounds>()[index], tree == CullingTree::Static);
+}
+
+void MeshComponentSystem::RecordChange(const AABB& bounds, bool staticObject)
+{
+	if (changedBounds.overflow)
+		return;
+
+	Array<AABB>& changes = staticObject ? changedBounds.staticObjects : changedBounds.dynamicObjects;
+
+	if (changes.GetCount() < MaxChangedBoundsCount)
+		changes.PushBack(bounds);
+	else
+		changedBounds.overflow = true;
+}
+
+void MeshComponentSystem::UpdateBounds(unsigned int index)
+{
+	// Record both the old and the new bounds
+	RecordChange(index);
+
+	MeshId meshId = data.Get<Column::Mesh>()[index];
+
+	if (meshId == MeshId::Null)
+	{
+		RemoveFromCulling(index);
+		return;
+	}
+
+	const AABB& meshBounds = modelManager->GetModelMeshes(meshId.modelId)[meshId.meshIndex].aabb;
+	AABB bounds = meshBounds.Transform(data.Get<Column::Transform>()[index]);
+	data.Get<Column::Bounds>()[index] = bounds;
+
+	CullingState& culling = data.Get<Column::Culling>()[index];
+	culling.lastMovedFrame = frameIndex;
+
+	if (culling.tree == CullingTree::Dynamic)
+	{
+		dynamicBvh.Move(culling.handle, bounds);
+		RecordChange(index);
+		return;
+	}
+
+	// Static objects that move are moved to the dynamic tree
+	RemoveFromCulling(index);
+
+	culling.handle = dynamicBvh.Insert(bounds, index);
+	culling.tree = CullingTree::Dynamic;
+
+	// Objects that appear or stop being static count as static changes
+	RecordChange(bounds, true);
+}
+
+void MeshComponentSystem::UpdateDrawPackets(unsigned int index, uint32_t partCount)
+{
+	MeshId meshId = data.Get<Column::Mesh>()[index];
+	DrawPacketStorage& storage = data.Get<Column::DrawPackets>()[index];
+	LodState& lodState = data.Get<Column::Lod>()[index];
+
+	lodState = LodState{};
+
+	if (meshId == MeshId::Null)
+	{
+		storage.Resize(0);
+		return;
+	}
+
+	const ModelMesh& mesh = modelManager->GetModelMeshes(meshId.modelId)[meshId.meshIndex];
+	ArrayView<const ModelMeshPart> parts = modelManager->GetModelMeshParts(meshId.modelId);
 
-	newData.buffer = this->allocator->Allocate(bytes, "MeshComponentSystem.data.buffer");
-	newData.count = data.count;
-	newData.allocated = required;
+	assert(partCount <= mesh.partCount);
+	storage.Resize(static_cast<uint8_t>(partCount));
 
-	newData.entity = static_cast<Entity*>(newData.buffer);
-	newData.mesh = reinterpret_cast<MeshId*>(newData.entity + required);
-	newData.material = reinterpret_cast<MaterialStorage*>(newData.mesh + required);
-	newData.transparency = reinterpret_cast<TransparencyStorage*>(newData.material + required);
-	newData.bounds = reinterpret_cast<AABB*>(newData.transparency + required);
-	newData.transform = reinterpret_cast<Mat4x4f*>(newData.bounds + required);
+	ArrayView<MeshDrawPacket> packets = storage.GetDataView();
 
-	if (data.buffer != nullptr)
+	for (uint32_t i = 0; i < partCount; ++i)
 	{
-		std::memcpy(newData.entity, data.entity, data.count * sizeof(Entity));
-		std::memcpy(newData.mesh, data.mesh, data.count * sizeof(MeshId));
-		std::memcpy(newData.material, data.material, data.count * sizeof(MaterialStorage));
-		std::memcpy(newData.transparency, data.transparency, data.count * sizeof(TransparencyStorage));
-		std::memcpy(newData.bounds, data.bounds, data.count * sizeof(AABB));
-		std::memcpy(newData.transform, data.transform, data.count * sizeof(Mat4x4f));
-
-		this->allocator->Deallocate(data.buffer);
+		const ModelMeshPart& part = parts[mesh.partOffset + i];
+
+		MeshDrawPacket& packet = packets[i];
+		packet.vertexArrayId = part.vertexArrayId;
+		packet.indexCount = part.count;
+		packet.indexOffset = part.indexOffset;
+		packet.indexType = mesh.indexType;
+		packet.primitiveMode = mesh.primitiveMode;
 	}
 
-	data = newData;
+	lodState.parts = &parts[mesh.partOffset];
+	lodState.lodCount = mesh.lodCount;
+}
+
+void MeshComponentSystem::UpdateLodErrors(unsigned int index)
+{
+	MeshId meshId = data.Get<Column::Mesh>()[index];
+
+	if (meshId == MeshId::Null)
+		return;
+
+	const ModelMesh& mesh = modelManager->GetModelMeshes(meshId.modelId)[meshId.meshIndex];
+	const Mat4x4f& transform = data.Get<Column::Transform>()[index];
+	LodState& lodState = data.Get<Column::Lod>()[index];
+
+	// Errors grow with the largest scale of the transform
+	float maxScaleSq = 0.0f;
+	for (size_t axis = 0; axis < 3; ++axis)
+	{
+		Vec3f column(transform[axis * 4 + 0], transform[axis * 4 + 1], transform[axis * 4 + 2]);
+		maxScaleSq = std::max(maxScaleSq, column.SqrMagnitude());
+	}
+
+	float scale = std::sqrt(maxScaleSq);
+	for (uint32_t lod = 0; lod < ModelMesh::MaxLodCount; ++lod)
+		lodState.errors[lod] = mesh.lodErrors[lod] * scale;
+}
+
+void MeshComponentSystem::RemoveFromCulling(unsigned int index)
+{
+	CullingState& culling = data.Get<Column::Culling>()[index];
+
+	if (culling.tree == CullingTree::Dynamic)
+	{
+		dynamicBvh.Remove(culling.handle);
+	}
+	else if (culling.tree == CullingTree::Static)
+	{
+		staticBvh.SetItemUserData(culling.handle, StaticBvh::InvalidUserData);
+		staticRemovedCount += 1;
+	}
+
+	culling.tree = CullingTree::None;
+}
+
+void MeshComponentSystem::RebuildStaticBvh()
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	staticBuildIndices.Clear();
+	staticBuildBounds.Clear();
+
+	CullingState* culling = data.Get<Column::Culling>();
+	const AABB* bounds = data.Get<Column::Bounds>();
+
+	for (unsigned int i = 1, count = data.GetCount(); i < count; ++i)
+	{
+		CullingState& state = culling[i];
+
+		bool settled = state.tree == CullingTree::Dynamic &&
+			frameIndex - state.lastMovedFrame >= StaticSettleFrames;
+
+		if (settled)
+			dynamicBvh.Remove(state.handle);
+		else if (state.tree != CullingTree::Static)
+			continue;
+
+		staticBuildIndices.PushBack(i);
+		staticBuildBounds.PushBack(bounds[i]);
+	}
+
+	uint32_t itemCount = static_cast<uint32_t>(staticBuildIndices.GetCount());
+	staticBvh.Build(itemCount, staticBuildBounds.GetData(), staticBuildIndices.GetData());
+	staticRemovedCount = 0;
+
+	for (uint32_t item = 0; item < itemCount; ++item)
+	{
+		CullingState& state = culling[staticBvh.GetItemUserData(item)];
+		state.handle = item;
+		state.tree = CullingTree::Static;
+	}
 }
 
 }
\ No newline at end of file
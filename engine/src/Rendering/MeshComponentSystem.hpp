@@ -1,24 +1,33 @@
 #pragma once
 
+#include "Core/Array.hpp"
 #include "Core/ArrayView.hpp"
 #include "Core/HashMap.hpp"
+#include "Core/SoaStorage.hpp"
+
+#include "Engine/Entity.hpp"
 
 #include "Graphics/TransformUpdateReceiver.hpp"
 
+#include "Math/AABB.hpp"
+#include "Math/BoundingVolumeHierarchy.hpp"
+#include "Math/Mat4x4.hpp"
+
+#include "Rendering/RenderResourceId.hpp"
+#include "Rendering/RenderTypes.hpp"
 #include "Rendering/TransparencyType.hpp"
 
+#include "Resources/MaterialData.hpp"
+#include "Resources/MeshId.hpp"
+#include "Resources/ModelManager.hpp"
+
 namespace kokko
 {
 
 class Allocator;
-class ModelManager;
 class Renderer;
 
-struct AABB;
-struct Entity;
-struct Mat4x4f;
-struct MaterialId;
-struct MeshId;
+struct FrustumPlanes;
 
 struct MeshComponentId
 {
@@ -30,11 +39,34 @@ struct MeshComponentId
 	static const MeshComponentId Null;
 };
 
+// Everything needed to draw one part of a mesh, so drawing doesn't need to look up the model
+struct alignas(16) MeshDrawPacket
+{
+	render::VertexArrayId vertexArrayId;
+	uint32_t indexCount;
+	uint32_t indexOffset;
+	RenderIndexType indexType;
+	RenderPrimitiveMode primitiveMode;
+};
+
 class MeshComponentSystem : public TransformUpdateReceiver
 {
 	friend class kokko::Renderer;
 
 public:
+	// Bounds of objects before and after they changed, used to find out which cached shadow maps need updates.
+	// Objects that have settled into the static BVH are tracked separately from objects that move often.
+	struct ChangedBounds
+	{
+		explicit ChangedBounds(Allocator* allocator);
+
+		Array<AABB> staticObjects;
+		Array<AABB> dynamicObjects;
+
+		// Too many changes to track, everything should be considered changed
+		bool overflow;
+	};
+
 	MeshComponentSystem(Allocator* allocator, ModelManager* modelManager);
 	~MeshComponentSystem();
 
@@ -55,9 +87,30 @@ public:
 	ArrayView<const MaterialId> GetMaterialIds(MeshComponentId id) const;
 	ArrayView<const TransparencyType> GetTransparencyTypes(MeshComponentId id) const;
 
-private:
-	void Reallocate(unsigned int required);
+	// Draw packets are updated when the mesh is set, one for each mesh part
+	ArrayView<const MeshDrawPacket> GetDrawPackets(MeshComponentId id) const;
+
+	// Draw packet of a mesh part at a level of detail
+	MeshDrawPacket GetDrawPacket(MeshComponentId id, uint32_t partIndex, uint32_t lod) const;
+
+	// Chooses the coarsest level of detail whose error stays under maxErrorPx pixels,
+	// using the level previously chosen for the viewport to avoid switching back and forth
+	uint32_t SelectLod(MeshComponentId id, uint32_t viewportIndex, float pixelsPerUnit, float maxErrorPx);
+
+	// Occluders are rasterized by software occlusion culling to hide the objects behind them
+	void SetOccluder(MeshComponentId id, bool occluder);
+	bool IsOccluder(MeshComponentId id) const;
 
+	// Moves objects that haven't moved in a while to the static culling BVH, call once per frame
+	void UpdateCullingStructures();
+
+	// Appends the index of every component whose bounds may intersect the frustum
+	void QueryCullingCandidates(const FrustumPlanes& frustum, Array<uint32_t>& indicesOut) const;
+
+	const ChangedBounds& GetChangedBounds() const { return changedBounds; }
+	void ClearChangedBounds();
+
+private:
 	Allocator* allocator;
 	ModelManager* modelManager;
 
@@ -78,23 +131,65 @@ private:
 	using MaterialStorage = CompactStorage<MaterialId, uint16_t, 7>;
 	using TransparencyStorage = CompactStorage<TransparencyType, uint8_t, 7>;
 
-	struct InstanceData
+	// Packed into two cache lines
+	using DrawPacketStorage = CompactStorage<MeshDrawPacket, uint8_t, 7>;
+
+	struct LodState
+	{
+		static constexpr uint32_t MaxViewportCount = 8;
+
+		const ModelMeshPart* parts; // Index ranges of simplified levels, owned by ModelManager
+		float errors[ModelMesh::MaxLodCount]; // In world space
+		uint8_t lodCount;
+		uint8_t selected[MaxViewportCount];
+	};
+
+	enum class CullingTree : uint8_t
+	{
+		None,
+		Dynamic,
+		Static
+	};
+
+	struct CullingState
+	{
+		uint32_t handle; // Leaf node in dynamicBvh or item in staticBvh
+		uint32_t lastMovedFrame;
+		CullingTree tree;
+	};
+
+	struct Column
 	{
-		unsigned int count;
-		unsigned int allocated;
-		void* buffer;
-
-		Entity* entity;
-		MeshId* mesh;
-		MaterialStorage* material;
-		TransparencyStorage* transparency;
-		AABB* bounds;
-		Mat4x4f* transform;
-	}
-	data;
+		enum : size_t { Entity, Mesh, Material, Transparency, DrawPackets, Lod, Bounds, Transform, Culling, Occluder };
+	};
+
+	SoaStorage<Entity, MeshId, MaterialStorage, TransparencyStorage, DrawPacketStorage,
+		LodState, AABB, Mat4x4f, CullingState, bool> data;
 
 	// Look up table from entity to component id / index
 	HashMap<unsigned int, unsigned int> entityMap;
+
+	// Objects that have moved recently are kept in an incrementally updated tree,
+	// the rest are in a static BVH that is rebuilt when enough objects have settled
+	DynamicBvh dynamicBvh;
+	StaticBvh staticBvh;
+	uint32_t staticRemovedCount;
+
+	uint32_t frameIndex;
+	uint32_t lastStaticCheckFrame;
+
+	Array<uint32_t> staticBuildIndices;
+	Array<AABB> staticBuildBounds;
+
+	ChangedBounds changedBounds;
+
+	void RecordChange(unsigned int index);
+	void RecordChange(const AABB& bounds, bool staticObject);
+	void UpdateBounds(unsigned int index);
+	void UpdateDrawPackets(unsigned int index, uint32_t partCount);
+	void UpdateLodErrors(unsigned int index);
+	void RemoveFromCulling(unsigned int index);
+	void RebuildStaticBvh();
 };
 
 }
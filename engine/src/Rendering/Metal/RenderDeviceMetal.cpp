@@ -43,6 +43,12 @@ void DeviceMetal::GetIntegerValue(RenderDeviceParameter parameter, int* valueOut
     //glGetIntegerv(ConvertDeviceParameter(parameter), valueOut);
 }
 
+ConstStringView DeviceMetal::GetStringValue(RenderDeviceString name)
+{
+    //return ConstStringView(reinterpret_cast<const char*>(glGetString(ConvertDeviceString(name))));
+    return ConstStringView();
+}
+
 void DeviceMetal::SetDebugMessageCallback(DebugCallbackFn callback)
 {
     //debugUserData.callback = callback;
@@ -158,6 +164,21 @@ void DeviceMetal::SetTextureSubImage2D(
     //    ConvertTextureBaseFormat(format), ConvertTextureDataType(type), data);
 }
 
+void DeviceMetal::SetTextureSubImageCompressed2D(
+    TextureId texture,
+    int level,
+    int xOffset,
+    int yOffset,
+    int width,
+    int height,
+    RenderTextureSizedFormat format,
+    int dataSize,
+    const void* data)
+{
+    //glCompressedTextureSubImage2D(texture.i, level, xOffset, yOffset, width, height,
+    //    ConvertTextureSizedFormat(format), dataSize, data);
+}
+
 void DeviceMetal::SetTextureSubImage3D(
     TextureId texture,
     int level,
@@ -175,6 +196,18 @@ void DeviceMetal::SetTextureSubImage3D(
     //    ConvertTextureBaseFormat(format), ConvertTextureDataType(type), data);
 }
 
+void DeviceMetal::GetTextureImage(
+    TextureId texture,
+    int level,
+    RenderTextureBaseFormat format,
+    RenderTextureDataType type,
+    int bufferSize,
+    void* dataOut)
+{
+    //glGetTextureImage(texture.i, level,
+    //    ConvertTextureBaseFormat(format), ConvertTextureDataType(type), bufferSize, dataOut);
+}
+
 void DeviceMetal::GenerateTextureMipmaps(TextureId texture)
 {
     //glGenerateTextureMipmap(texture.i);
@@ -250,6 +283,35 @@ void DeviceMetal::GetShaderProgramInfoLog(unsigned int shaderProgram, unsigned i
     //glGetProgramInfoLog(shaderProgram, maxLength, nullptr, logOut);
 }
 
+void DeviceMetal::SetShaderProgramBinaryRetrievable(unsigned int shaderProgram)
+{
+    //glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+int DeviceMetal::GetShaderProgramBinaryLength(unsigned int shaderProgram)
+{
+    //return GetShaderProgramParameterInt(shaderProgram, GL_PROGRAM_BINARY_LENGTH);
+    return 0;
+}
+
+void DeviceMetal::GetShaderProgramBinary(
+    unsigned int shaderProgram,
+    int bufferSize,
+    uint32_t* formatOut,
+    void* binaryOut)
+{
+    //glGetProgramBinary(shaderProgram, bufferSize, nullptr, formatOut, binaryOut);
+}
+
+void DeviceMetal::SetShaderProgramBinary(
+    unsigned int shaderProgram,
+    uint32_t format,
+    const void* binary,
+    int length)
+{
+    //glProgramBinary(shaderProgram, format, binary, length);
+}
+
 // SHADER STAGE
 
 unsigned int DeviceMetal::CreateShaderStage(RenderShaderStage stage)
@@ -27,6 +27,7 @@ public:
     virtual kokko::CommandBuffer* CreateCommandBuffer(Allocator* allocator) override;
 
     virtual void GetIntegerValue(RenderDeviceParameter parameter, int* valueOut) override;
+    virtual ConstStringView GetStringValue(RenderDeviceString name) override;
 
     virtual void SetDebugMessageCallback(DebugCallbackFn callback) override;
     virtual void SetObjectLabel(RenderObjectType type, unsigned int object, ConstStringView label) override;
@@ -72,6 +73,16 @@ public:
         RenderTextureBaseFormat format,
         RenderTextureDataType type,
         const void* data) override;
+    virtual void SetTextureSubImageCompressed2D(
+        TextureId texture,
+        int level,
+        int xOffset,
+        int yOffset,
+        int width,
+        int height,
+        RenderTextureSizedFormat format,
+        int dataSize,
+        const void* data) override;
     virtual void SetTextureSubImage3D(
         TextureId texture,
         int level,
@@ -84,6 +95,13 @@ public:
         RenderTextureBaseFormat format,
         RenderTextureDataType type,
         const void* data) override;
+    virtual void GetTextureImage(
+        TextureId texture,
+        int level,
+        RenderTextureBaseFormat format,
+        RenderTextureDataType type,
+        int bufferSize,
+        void* dataOut) override;
     virtual void GenerateTextureMipmaps(TextureId texture) override;
 
     virtual void CreateSamplers(uint32_t count, const RenderSamplerParameters* params, SamplerId* samplersOut) override;
@@ -97,6 +115,18 @@ public:
     virtual int GetShaderProgramInfoLogLength(unsigned int shaderProgram) override;
     virtual int GetShaderProgramParameterInt(unsigned int shaderProgram, unsigned int parameter) override;
     virtual void GetShaderProgramInfoLog(unsigned int shaderProgram, unsigned int maxLength, char* logOut) override;
+    virtual void SetShaderProgramBinaryRetrievable(unsigned int shaderProgram) override;
+    virtual int GetShaderProgramBinaryLength(unsigned int shaderProgram) override;
+    virtual void GetShaderProgramBinary(
+        unsigned int shaderProgram,
+        int bufferSize,
+        uint32_t* formatOut,
+        void* binaryOut) override;
+    virtual void SetShaderProgramBinary(
+        unsigned int shaderProgram,
+        uint32_t format,
+        const void* binary,
+        int length) override;
 
     virtual unsigned int CreateShaderStage(RenderShaderStage stage) override;
     virtual void DestroyShaderStage(unsigned int shaderStage) override;
@@ -0,0 +1,376 @@
+#include "Rendering/OcclusionCulling.hpp"
+
+#include <algorithm>
+
+#include "Core/Core.hpp"
+#include "Core/Hash.hpp"
+
+#include "Math/AABB.hpp"
+#include "Math/Math.hpp"
+
+#include "Rendering/CommandEncoder.hpp"
+#include "Rendering/RenderDevice.hpp"
+#include "Rendering/RenderTypes.hpp"
+#include "Rendering/StaticUniformBuffer.hpp"
+#include "Rendering/Uniform.hpp"
+
+#include "Resources/ShaderManager.hpp"
+
+namespace kokko
+{
+
+namespace
+{
+
+constexpr uint32_t HiZGroupSize = 8;
+constexpr uint32_t CullGroupSize = 64;
+
+struct CullUniformBlock
+{
+	alignas(16) Mat4x4f viewProjection;
+	alignas(8) Vec2i depthSize;
+	alignas(4) int hiZLevelCount;
+	alignas(4) uint32_t drawCount;
+};
+
+struct HiZUniformBlock
+{
+	alignas(8) Vec2i sourceSize;
+	alignas(8) Vec2i destSize;
+	alignas(4) int sourceLevel;
+};
+
+} // Anonymous namespace
+
+OcclusionCulling::OcclusionCulling(Allocator* allocator, render::Device* device, ShaderManager* shaderManager) :
+	allocator(allocator),
+	device(device),
+	shaderManager(shaderManager),
+	hiZShaderId(ShaderId::Null),
+	earlyCullShaderId(ShaderId::Null),
+	lateCullShaderId(ShaderId::Null),
+	drawBounds(allocator),
+	drawCommands(allocator),
+	uniformStagingBuffer(allocator),
+	drawBufferCapacity(0),
+	visibilityBufferCapacity(0),
+	hiZUniformBlockStride(0),
+	hiZDepthSize(0, 0),
+	hiZLevelCount(0)
+{
+}
+
+OcclusionCulling::~OcclusionCulling()
+{
+}
+
+void OcclusionCulling::Initialize()
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	hiZShaderId = shaderManager->FindShaderByPath(ConstStringView("engine/shaders/occlusion/hi_z_downsample.glsl"));
+	earlyCullShaderId = shaderManager->FindShaderByPath(ConstStringView("engine/shaders/occlusion/occlusion_cull_early.glsl"));
+	lateCullShaderId = shaderManager->FindShaderByPath(ConstStringView("engine/shaders/occlusion/occlusion_cull_late.glsl"));
+
+	int aligment = 0;
+	device->GetIntegerValue(RenderDeviceParameter::UniformBufferOffsetAlignment, &aligment);
+	hiZUniformBlockStride = Math::RoundUpToMultiple(static_cast<int>(sizeof(HiZUniformBlock)), aligment);
+
+	unsigned int hiZBufferSize = hiZUniformBlockStride * MaxHiZLevelCount;
+	uniformStagingBuffer.Resize(hiZBufferSize);
+
+	render::BufferId buffers[2];
+	device->CreateBuffers(2, buffers);
+	cullUniformBufferId = buffers[0];
+	hiZUniformBufferId = buffers[1];
+
+	device->SetBufferStorage(cullUniformBufferId, sizeof(CullUniformBlock), nullptr, BufferStorageFlags::Dynamic);
+	device->SetBufferStorage(hiZUniformBufferId, hiZBufferSize, nullptr, BufferStorageFlags::Dynamic);
+
+	device->SetObjectLabel(RenderObjectType::Buffer, cullUniformBufferId.i,
+		ConstStringView("OcclusionCulling cull uniform buffer"));
+	device->SetObjectLabel(RenderObjectType::Buffer, hiZUniformBufferId.i,
+		ConstStringView("OcclusionCulling Hi-Z uniform buffer"));
+}
+
+void OcclusionCulling::Deinitialize()
+{
+	DestroyHiZTexture();
+
+	render::BufferId* buffers[] = {
+		&cullUniformBufferId, &hiZUniformBufferId, &drawBoundsBufferId, &drawCommandBufferId, &visibilityBufferId
+	};
+
+	for (render::BufferId* buffer : buffers)
+	{
+		if (*buffer != 0)
+		{
+			device->DestroyBuffers(1, buffer);
+			*buffer = render::BufferId();
+		}
+	}
+
+	drawBufferCapacity = 0;
+	visibilityBufferCapacity = 0;
+}
+
+bool OcclusionCulling::IsInitialized() const
+{
+	return cullUniformBufferId != 0 &&
+		hiZShaderId != ShaderId::Null &&
+		earlyCullShaderId != ShaderId::Null &&
+		lateCullShaderId != ShaderId::Null;
+}
+
+void OcclusionCulling::ClearDraws()
+{
+	drawBounds.Clear();
+	drawCommands.Clear();
+}
+
+void OcclusionCulling::AddDraw(uint32_t objectIndex, const AABB& bounds, uint32_t indexCount, uint32_t firstIndex)
+{
+	drawBounds.PushBack(DrawBounds{ bounds.center, objectIndex, bounds.extents, 0 });
+	drawCommands.PushBack(DrawCommand{ indexCount, 1, firstIndex, 0, 0 });
+}
+
+void OcclusionCulling::Upload(const Mat4x4f& viewProjection, const Vec2i& depthSize, uint32_t objectCount)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	if (hiZDepthSize != depthSize)
+	{
+		DestroyHiZTexture();
+		CreateHiZTexture(depthSize);
+	}
+
+	if (objectCount > visibilityBufferCapacity)
+	{
+		if (visibilityBufferId != 0)
+			device->DestroyBuffers(1, &visibilityBufferId);
+
+		visibilityBufferCapacity = Math::UpperPowerOfTwo(objectCount);
+
+		// Everything starts out visible, so new objects are drawn in the early pass
+		Array<uint32_t> initialVisibility(allocator);
+		initialVisibility.Resize(visibilityBufferCapacity);
+		for (uint32_t& visible : initialVisibility)
+			visible = 1;
+
+		unsigned int size = static_cast<unsigned int>(visibilityBufferCapacity * sizeof(uint32_t));
+		device->CreateBuffers(1, &visibilityBufferId);
+		device->SetBufferStorage(visibilityBufferId, size, initialVisibility.GetData(), BufferStorageFlags::None);
+		device->SetObjectLabel(RenderObjectType::Buffer, visibilityBufferId.i,
+			ConstStringView("OcclusionCulling visibility buffer"));
+	}
+
+	size_t drawCount = drawBounds.GetCount();
+
+	if (drawCount > drawBufferCapacity)
+	{
+		if (drawBoundsBufferId != 0)
+		{
+			device->DestroyBuffers(1, &drawBoundsBufferId);
+			device->DestroyBuffers(1, &drawCommandBufferId);
+		}
+
+		drawBufferCapacity = Math::UpperPowerOfTwo(drawCount);
+
+		unsigned int boundsSize = static_cast<unsigned int>(drawBufferCapacity * sizeof(DrawBounds));
+		unsigned int commandSize = static_cast<unsigned int>(drawBufferCapacity * 2 * sizeof(DrawCommand));
+
+		device->CreateBuffers(1, &drawBoundsBufferId);
+		device->SetBufferStorage(drawBoundsBufferId, boundsSize, nullptr, BufferStorageFlags::Dynamic);
+		device->SetObjectLabel(RenderObjectType::Buffer, drawBoundsBufferId.i,
+			ConstStringView("OcclusionCulling draw bounds buffer"));
+
+		device->CreateBuffers(1, &drawCommandBufferId);
+		device->SetBufferStorage(drawCommandBufferId, commandSize, nullptr, BufferStorageFlags::Dynamic);
+		device->SetObjectLabel(RenderObjectType::Buffer, drawCommandBufferId.i,
+			ConstStringView("OcclusionCulling draw command buffer"));
+	}
+
+	if (drawCount == 0)
+		return;
+
+	// Late pass commands start out as a copy, the culling shader only writes instance counts
+	drawCommands.Resize(drawCount * 2);
+	for (size_t i = 0; i < drawCount; ++i)
+		drawCommands[drawCount + i] = drawCommands[i];
+
+	device->SetBufferSubData(drawBoundsBufferId, 0,
+		static_cast<unsigned int>(drawCount * sizeof(DrawBounds)), drawBounds.GetData());
+	device->SetBufferSubData(drawCommandBufferId, 0,
+		static_cast<unsigned int>(drawCommands.GetCount() * sizeof(DrawCommand)), drawCommands.GetData());
+
+	CullUniformBlock uniforms;
+	uniforms.viewProjection = viewProjection;
+	uniforms.depthSize = depthSize;
+	uniforms.hiZLevelCount = hiZLevelCount;
+	uniforms.drawCount = static_cast<uint32_t>(drawCount);
+
+	device->SetBufferSubData(cullUniformBufferId, 0, sizeof(CullUniformBlock), &uniforms);
+}
+
+intptr_t OcclusionCulling::GetEarlyDrawOffset(uint32_t draw) const
+{
+	return static_cast<intptr_t>(draw * sizeof(DrawCommand));
+}
+
+intptr_t OcclusionCulling::GetLateDrawOffset(uint32_t draw) const
+{
+	return static_cast<intptr_t>((drawBounds.GetCount() + draw) * sizeof(DrawCommand));
+}
+
+void OcclusionCulling::EncodeEarlyCull(render::CommandEncoder* encoder)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	uint32_t drawCount = GetDrawCount();
+	if (drawCount == 0)
+		return;
+
+	auto scope = encoder->CreateDebugScope(0, ConstStringView("OcclusionCulling_Early"));
+
+	const ShaderData& shader = shaderManager->GetShaderData(earlyCullShaderId);
+	encoder->UseShaderProgram(shader.driverId);
+
+	encoder->BindBufferBase(RenderBufferTarget::UniformBuffer, UniformBlockBinding::Object, cullUniformBufferId);
+	encoder->BindBufferBase(RenderBufferTarget::ShaderStorageBuffer, 0, drawBoundsBufferId);
+	encoder->BindBufferBase(RenderBufferTarget::ShaderStorageBuffer, 1, drawCommandBufferId);
+	encoder->BindBufferBase(RenderBufferTarget::ShaderStorageBuffer, 2, visibilityBufferId);
+
+	encoder->DispatchCompute((drawCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+
+	// Commands are read by the following indirect draws
+	MemoryBarrierFlags barrier{};
+	barrier.shaderStorage = true;
+	barrier.command = true;
+	encoder->MemoryBarrier(barrier);
+}
+
+void OcclusionCulling::EncodeLateCull(render::CommandEncoder* encoder, render::TextureId depthTexture)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	uint32_t drawCount = GetDrawCount();
+	if (drawCount == 0)
+		return;
+
+	MemoryBarrierFlags textureFetchBarrier{};
+	textureFetchBarrier.textureFetch = true;
+
+	{
+		auto scope = encoder->CreateDebugScope(0, ConstStringView("OcclusionCulling_BuildHiZ"));
+
+		const ShaderData& shader = shaderManager->GetShaderData(hiZShaderId);
+		const TextureUniform* sourceUniform = shader.uniforms.FindTextureUniformByNameHash("source_texture"_hash);
+		encoder->UseShaderProgram(shader.driverId);
+
+		for (int level = 0; level < hiZLevelCount; ++level)
+		{
+			const Vec2i& size = hiZLevelSizes[level];
+
+			encoder->BindBufferRange(RenderBufferTarget::UniformBuffer, UniformBlockBinding::Object,
+				hiZUniformBufferId, level * hiZUniformBlockStride, sizeof(HiZUniformBlock));
+
+			// Each level is reduced from the previous one, the first level from the depth buffer
+			render::TextureId source = level == 0 ? depthTexture : hiZTextureId;
+			if (sourceUniform != nullptr)
+				encoder->BindTextureToShader(sourceUniform->uniformLocation, 0, source);
+
+			encoder->BindImageTexture(0, hiZTextureId, level,
+				RenderBufferAccess::WriteOnly, RenderTextureSizedFormat::R32F);
+
+			encoder->DispatchCompute(
+				(size.x + HiZGroupSize - 1) / HiZGroupSize, (size.y + HiZGroupSize - 1) / HiZGroupSize, 1);
+
+			encoder->MemoryBarrier(textureFetchBarrier);
+		}
+	}
+
+	{
+		auto scope = encoder->CreateDebugScope(0, ConstStringView("OcclusionCulling_Late"));
+
+		const ShaderData& shader = shaderManager->GetShaderData(lateCullShaderId);
+		const TextureUniform* hiZUniform = shader.uniforms.FindTextureUniformByNameHash("hi_z_texture"_hash);
+		encoder->UseShaderProgram(shader.driverId);
+
+		if (hiZUniform != nullptr)
+			encoder->BindTextureToShader(hiZUniform->uniformLocation, 0, hiZTextureId);
+
+		encoder->BindBufferBase(RenderBufferTarget::UniformBuffer, UniformBlockBinding::Object, cullUniformBufferId);
+		encoder->BindBufferBase(RenderBufferTarget::ShaderStorageBuffer, 0, drawBoundsBufferId);
+		encoder->BindBufferBase(RenderBufferTarget::ShaderStorageBuffer, 1, drawCommandBufferId);
+		encoder->BindBufferBase(RenderBufferTarget::ShaderStorageBuffer, 2, visibilityBufferId);
+
+		encoder->DispatchCompute((drawCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+
+		MemoryBarrierFlags barrier{};
+		barrier.shaderStorage = true;
+		barrier.command = true;
+		encoder->MemoryBarrier(barrier);
+	}
+}
+
+void OcclusionCulling::BindDrawCommandBuffer(render::CommandEncoder* encoder)
+{
+	encoder->BindBuffer(RenderBufferTarget::DrawIndirectBuffer, drawCommandBufferId);
+}
+
+void OcclusionCulling::CreateHiZTexture(const Vec2i& depthSize)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	hiZDepthSize = depthSize;
+	hiZLevelCount = 0;
+
+	if (depthSize.x <= 0 || depthSize.y <= 0)
+		return;
+
+	// First level is half the size of the depth buffer, odd sizes are rounded down
+	// and the extra texels are included in the last row and column
+	Vec2i size(std::max(depthSize.x / 2, 1), std::max(depthSize.y / 2, 1));
+
+	for (;;)
+	{
+		hiZLevelSizes[hiZLevelCount] = size;
+		hiZLevelCount += 1;
+
+		if ((size.x == 1 && size.y == 1) || hiZLevelCount == MaxHiZLevelCount)
+			break;
+
+		size = Vec2i(std::max(size.x / 2, 1), std::max(size.y / 2, 1));
+	}
+
+	device->CreateTextures(RenderTextureTarget::Texture2d, 1, &hiZTextureId);
+	device->SetTextureStorage2D(hiZTextureId, hiZLevelCount, RenderTextureSizedFormat::R32F,
+		hiZLevelSizes[0].x, hiZLevelSizes[0].y);
+	device->SetObjectLabel(RenderObjectType::Texture, hiZTextureId.i, ConstStringView("OcclusionCulling Hi-Z texture"));
+
+	// Level sizes only change with the depth buffer size, so the uniforms can be uploaded once
+	uint8_t* staging = uniformStagingBuffer.GetData();
+	for (int level = 0; level < hiZLevelCount; ++level)
+	{
+		HiZUniformBlock* block = reinterpret_cast<HiZUniformBlock*>(staging + level * hiZUniformBlockStride);
+		block->sourceSize = level == 0 ? depthSize : hiZLevelSizes[level - 1];
+		block->destSize = hiZLevelSizes[level];
+		block->sourceLevel = level == 0 ? 0 : level - 1;
+	}
+
+	device->SetBufferSubData(hiZUniformBufferId, 0, hiZUniformBlockStride * hiZLevelCount, staging);
+}
+
+void OcclusionCulling::DestroyHiZTexture()
+{
+	if (hiZTextureId != 0)
+	{
+		device->DestroyTextures(1, &hiZTextureId);
+		hiZTextureId = render::TextureId();
+	}
+
+	hiZDepthSize = Vec2i(0, 0);
+	hiZLevelCount = 0;
+}
+
+} // namespace kokko
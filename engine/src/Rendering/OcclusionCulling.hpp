@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Core/Array.hpp"
+
+#include "Math/Mat4x4.hpp"
+#include "Math/Vec2.hpp"
+#include "Math/Vec3.hpp"
+
+#include "Rendering/RenderResourceId.hpp"
+
+#include "Resources/ShaderId.hpp"
+
+namespace kokko
+{
+
+class Allocator;
+class ShaderManager;
+
+struct AABB;
+
+namespace render
+{
+class CommandEncoder;
+class Device;
+}
+
+/*
+* Two-phase GPU occlusion culling for the opaque geometry of the fullscreen viewport.
+* The early pass draws objects that were visible last frame. A hierarchical depth
+* pyramid is then built from the resulting depth buffer and every draw is tested
+* against it. The late pass draws objects that became visible, so moving occluders
+* don't cause objects to pop in a frame late. Draws are issued as indirect draws
+* whose instance counts are written by the culling shaders.
+*/
+class OcclusionCulling
+{
+public:
+	OcclusionCulling(Allocator* allocator, render::Device* device, ShaderManager* shaderManager);
+	~OcclusionCulling();
+
+	void Initialize();
+	void Deinitialize();
+
+	bool IsInitialized() const;
+
+	// Draws must be added in the same order as they are drawn
+	void ClearDraws();
+	void AddDraw(uint32_t objectIndex, const AABB& bounds, uint32_t indexCount, uint32_t firstIndex);
+
+	void Upload(const Mat4x4f& viewProjection, const Vec2i& depthSize, uint32_t objectCount);
+
+	uint32_t GetDrawCount() const { return static_cast<uint32_t>(drawBounds.GetCount()); }
+	intptr_t GetEarlyDrawOffset(uint32_t draw) const;
+	intptr_t GetLateDrawOffset(uint32_t draw) const;
+
+	// Writes the early pass draw commands
+	void EncodeEarlyCull(render::CommandEncoder* encoder);
+
+	// Builds the depth pyramid and writes the late pass draw commands
+	void EncodeLateCull(render::CommandEncoder* encoder, render::TextureId depthTexture);
+
+	void BindDrawCommandBuffer(render::CommandEncoder* encoder);
+
+private:
+	static constexpr uint32_t MaxHiZLevelCount = 16;
+
+	struct DrawBounds
+	{
+		Vec3f center;
+		uint32_t objectIndex;
+		Vec3f extents;
+		uint32_t padding;
+	};
+
+	struct DrawCommand
+	{
+		uint32_t count;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t baseVertex;
+		uint32_t baseInstance;
+	};
+
+	void CreateHiZTexture(const Vec2i& depthSize);
+	void DestroyHiZTexture();
+
+	Allocator* allocator;
+	render::Device* device;
+	ShaderManager* shaderManager;
+
+	ShaderId hiZShaderId;
+	ShaderId earlyCullShaderId;
+	ShaderId lateCullShaderId;
+
+	Array<DrawBounds> drawBounds;
+	Array<DrawCommand> drawCommands;
+	Array<uint8_t> uniformStagingBuffer;
+
+	render::BufferId cullUniformBufferId;
+	render::BufferId hiZUniformBufferId;
+	render::BufferId drawBoundsBufferId;
+	render::BufferId drawCommandBufferId;
+	render::BufferId visibilityBufferId;
+
+	size_t drawBufferCapacity;
+	size_t visibilityBufferCapacity;
+	unsigned int hiZUniformBlockStride;
+
+	render::TextureId hiZTextureId;
+	Vec2i hiZDepthSize;
+	Vec2i hiZLevelSizes[MaxHiZLevelCount];
+	int hiZLevelCount;
+};
+
+} // namespace kokko
@@ -63,6 +63,7 @@ enum class CommandType : uint16_t
 	SetViewport,
 
 	BindTextureToShader,
+	BindImageTexture,
 
 	BindVertexArray,
 
@@ -81,8 +82,8 @@ struct Command
 struct CmdBeginDebugScope : public Command
 {
 	uint32_t id;
-	uint32_t messageOffset;
 	uint32_t messageLength;
+	const char* message;
 };
 
 // =================
@@ -280,6 +281,15 @@ struct CmdBindTextureToShader : public Command
 	render::TextureId texture;
 };
 
+struct CmdBindImageTexture : public Command
+{
+	uint32_t imageUnit;
+	render::TextureId texture;
+	int32_t level;
+	RenderBufferAccess access;
+	RenderTextureSizedFormat format;
+};
+
 // ======================
 // ==== VERTEX ARRAY ====
 // ======================
@@ -0,0 +1,197 @@
+#include "Rendering/RenderCommandBuffer.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#include "doctest/doctest.h"
+
+#include "Core/Core.hpp"
+
+#include "Memory/Allocator.hpp"
+
+namespace kokko
+{
+namespace render
+{
+
+CommandBuffer::CommandBuffer(Allocator* allocator) :
+	allocator(allocator),
+	commands{ nullptr, nullptr },
+	data{ nullptr, nullptr },
+	freePages(nullptr),
+	freePageCount(0),
+	usedPageCount(0)
+{
+}
+
+CommandBuffer::~CommandBuffer()
+{
+	ReleasePages(commands);
+	ReleasePages(data);
+
+	while (freePages != nullptr)
+	{
+		Page* next = freePages->next;
+		DeallocatePage(freePages);
+		freePages = next;
+	}
+}
+
+void* CommandBuffer::AllocateCommand(size_t size)
+{
+	assert(size <= PageSize);
+
+	return Allocate(commands, size);
+}
+
+void* CommandBuffer::AllocateData(size_t size)
+{
+	return Allocate(data, size);
+}
+
+void CommandBuffer::Clear()
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	size_t framePageCount = usedPageCount;
+
+	ReleasePages(commands);
+	ReleasePages(data);
+	usedPageCount = 0;
+
+	// Keep as many pages as the last frame needed, so memory used by a spike is eventually released
+	while (freePageCount > framePageCount)
+	{
+		Page* page = freePages;
+		freePages = page->next;
+		freePageCount -= 1;
+
+		DeallocatePage(page);
+	}
+}
+
+void* CommandBuffer::Allocate(PageList& list, size_t size)
+{
+	Page* page = list.last;
+
+	if (page == nullptr || page->capacity - page->used < size)
+	{
+		page = AcquirePage(size);
+
+		if (list.last != nullptr)
+			list.last->next = page;
+		else
+			list.first = page;
+
+		list.last = page;
+	}
+
+	void* ptr = page->GetData() + page->used;
+	page->used += size;
+
+	return ptr;
+}
+
+CommandBuffer::Page* CommandBuffer::AcquirePage(size_t minCapacity)
+{
+	Page* page;
+
+	if (minCapacity <= PageSize && freePages != nullptr)
+	{
+		page = freePages;
+		freePages = page->next;
+		freePageCount -= 1;
+	}
+	else
+	{
+		// Payloads larger than a page get a dedicated page
+		size_t capacity = minCapacity > PageSize ? minCapacity : PageSize;
+		void* mem = allocator->AllocateAligned(sizeof(Page) + capacity, alignof(std::max_align_t), "CommandBuffer.Page");
+
+		page = static_cast<Page*>(mem);
+		page->capacity = capacity;
+	}
+
+	if (page->capacity == PageSize)
+		usedPageCount += 1;
+
+	page->next = nullptr;
+	page->used = 0;
+
+	return page;
+}
+
+void CommandBuffer::ReleasePages(PageList& list)
+{
+	Page* page = list.first;
+
+	while (page != nullptr)
+	{
+		Page* next = page->next;
+
+		if (page->capacity == PageSize)
+		{
+			page->next = freePages;
+			freePages = page;
+			freePageCount += 1;
+		}
+		else
+		{
+			DeallocatePage(page);
+		}
+
+		page = next;
+	}
+
+	list.first = nullptr;
+	list.last = nullptr;
+}
+
+void CommandBuffer::DeallocatePage(Page* page)
+{
+	allocator->Deallocate(page);
+}
+
+TEST_CASE("CommandBuffer.PagesAreRecycled")
+{
+	CommandBuffer buffer(Allocator::GetDefault());
+
+	constexpr size_t CommandSize = 40;
+	constexpr size_t CommandCount = CommandBuffer::PageSize / CommandSize * 3;
+
+	for (int frame = 0; frame < 2; ++frame)
+	{
+		for (size_t i = 0; i < CommandCount; ++i)
+		{
+			void* command = buffer.AllocateCommand(CommandSize);
+			std::memset(command, static_cast<int>(i & 0xff), CommandSize);
+		}
+
+		// Commands don't cross pages, so each page is walked separately
+		size_t commandIndex = 0;
+		size_t pageCount = 0;
+		bool contentsMatch = true;
+
+		for (const CommandBuffer::Page* page = buffer.GetFirstCommandPage(); page != nullptr; page = page->next)
+		{
+			pageCount += 1;
+
+			for (size_t offset = 0; offset < page->used; offset += CommandSize, ++commandIndex)
+				if (page->GetData()[offset] != (commandIndex & 0xff))
+					contentsMatch = false;
+		}
+
+		CHECK(contentsMatch);
+		CHECK(commandIndex == CommandCount);
+		CHECK(pageCount == 3);
+
+		buffer.Clear();
+	}
+
+	void* largeData = buffer.AllocateData(CommandBuffer::PageSize * 2);
+	CHECK(largeData != nullptr);
+	buffer.Clear();
+}
+
+} // namespace render
+} // namespace kokko
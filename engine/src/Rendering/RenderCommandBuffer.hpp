@@ -1,31 +1,76 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
-#include "Core/Array.hpp"
-
 namespace kokko
 {
 
+class Allocator;
+
 namespace render
 {
 
-struct CommandBuffer
+/*
+* Stores encoded commands and their payload data in linked fixed-size pages, so the
+* stream never has to be reallocated and copied as it grows. Commands never cross a
+* page boundary. Pages are recycled when the buffer is cleared, and the pool is
+* trimmed to what the previous frame used.
+*/
+class CommandBuffer
 {
-	explicit CommandBuffer(Allocator* allocator) :
-		commands(allocator),
-		commandData(allocator)
+public:
+	static const size_t PageSize = 64 * 1024;
+
+	struct Page
 	{
-	}
+		Page* next;
+		size_t capacity;
+		size_t used;
+
+		uint8_t* GetData() { return reinterpret_cast<uint8_t*>(this + 1); }
+		const uint8_t* GetData() const { return reinterpret_cast<const uint8_t*>(this + 1); }
+	};
+
+	explicit CommandBuffer(Allocator* allocator);
+	~CommandBuffer();
+
+	CommandBuffer(const CommandBuffer&) = delete;
+	CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+	// Returns memory for a command of size bytes, which must be at most PageSize
+	void* AllocateCommand(size_t size);
 
-	void Clear()
+	// Returns memory for command payload data that stays valid until Clear
+	void* AllocateData(size_t size);
+
+	const Page* GetFirstCommandPage() const { return commands.first; }
+
+	// Recycles all pages, keeping enough of them for a frame as large as this one
+	void Clear();
+
+private:
+	struct PageList
 	{
-		commands.Clear();
-		commandData.Clear();
-	}
+		Page* first;
+		Page* last;
+	};
+
+	void* Allocate(PageList& list, size_t size);
+	Page* AcquirePage(size_t minCapacity);
+	void ReleasePages(PageList& list);
+	void DeallocatePage(Page* page);
+
+	Allocator* allocator;
+
+	PageList commands;
+	PageList data;
+
+	Page* freePages;
+	size_t freePageCount;
 
-	Array<uint8_t> commands;
-	Array<uint8_t> commandData;
+	// Regular sized pages used since the last Clear
+	size_t usedPageCount;
 };
 
 } // namespace render
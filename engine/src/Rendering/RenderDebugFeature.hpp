@@ -11,7 +11,18 @@ enum class RenderDebugFeatureFlag : uint32_t
 	DrawBounds = 1 << 0,
 	DrawNormals = 1 << 1,
 	DrawTerrainTiles = 1 << 2,
-	ExperimentalTerrainShadows = 1 << 3
+	ExperimentalTerrainShadows = 1 << 3,
+	OcclusionCulling = 1 << 4,
+	SoftwareOcclusionCulling = 1 << 5,
+	ShadowCascadeCaching = 1 << 6,
+	SsaoTemporalAccumulation = 1 << 7
+};
+
+enum class SsaoResolution : uint8_t
+{
+	Full,
+	Half,
+	Quarter
 };
 
 }
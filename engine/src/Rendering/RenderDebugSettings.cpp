@@ -5,7 +5,8 @@ namespace kokko
 
 RenderDebugSettings::RenderDebugSettings() :
 	debugEntity(Entity::Null),
-	featureFlags(0)
+	featureFlags(0),
+	ssaoResolution(SsaoResolution::Full)
 {
 }
 
@@ -33,4 +34,14 @@ void RenderDebugSettings::SetFeatureEnabled(RenderDebugFeatureFlag feature, bool
 		featureFlags &= ~static_cast<uint32_t>(feature);
 }
 
+SsaoResolution RenderDebugSettings::GetSsaoResolution() const
+{
+	return ssaoResolution;
+}
+
+void RenderDebugSettings::SetSsaoResolution(SsaoResolution resolution)
+{
+	ssaoResolution = resolution;
+}
+
 }
@@ -18,9 +18,13 @@ public:
 	bool IsFeatureEnabled(RenderDebugFeatureFlag feature) const;
 	void SetFeatureEnabled(RenderDebugFeatureFlag feature, bool enabled);
 
+	SsaoResolution GetSsaoResolution() const;
+	void SetSsaoResolution(SsaoResolution resolution);
+
 private:
 	Entity debugEntity;
 	uint32_t featureFlags;
+	SsaoResolution ssaoResolution;
 };
 
 }
@@ -46,6 +46,7 @@ public:
 	virtual ::kokko::CommandBuffer* CreateCommandBuffer(Allocator* allocator) { return nullptr; }
 
 	virtual void GetIntegerValue(RenderDeviceParameter parameter, int* valueOut) = 0;
+	virtual ConstStringView GetStringValue(RenderDeviceString name) = 0;
 
 	virtual void SetDebugMessageCallback(DebugCallbackFn callback) = 0;
 	virtual void SetObjectLabel(RenderObjectType type, unsigned int object, ConstStringView label) = 0;
@@ -76,6 +77,11 @@ public:
 
 	virtual void CreateTextures(RenderTextureTarget type, unsigned int count, TextureId* texturesOut) = 0;
 	virtual void DestroyTextures(unsigned int count, const TextureId* textures) = 0;
+
+	// Bindless textures can be sampled through a handle without binding them
+	virtual bool IsBindlessTextureSupported() const { return false; }
+	// Returns a handle that is resident for the lifetime of the texture
+	virtual uint64_t GetResidentTextureHandle(TextureId) { return 0; }
 	virtual void SetTextureStorage2D(
 		TextureId texture,
 		int levels,
@@ -92,6 +98,16 @@ public:
 		RenderTextureBaseFormat format,
 		RenderTextureDataType type,
 		const void* data) = 0;
+	virtual void SetTextureSubImageCompressed2D(
+		TextureId texture,
+		int level,
+		int xOffset,
+		int yOffset,
+		int width,
+		int height,
+		RenderTextureSizedFormat format,
+		int dataSize,
+		const void* data) = 0;
 	virtual void SetTextureSubImage3D(
 		TextureId texture,
 		int level,
@@ -104,6 +120,14 @@ public:
 		RenderTextureBaseFormat format,
 		RenderTextureDataType type,
 		const void* data) = 0;
+	// Reads back a whole mip level, cubemap faces are returned one after another
+	virtual void GetTextureImage(
+		TextureId texture,
+		int level,
+		RenderTextureBaseFormat format,
+		RenderTextureDataType type,
+		int bufferSize,
+		void* dataOut) = 0;
 	virtual void GenerateTextureMipmaps(TextureId texture) = 0;
 
 	virtual void CreateSamplers(uint32_t count, const RenderSamplerParameters* params, SamplerId* samplersOut) = 0;
@@ -117,6 +141,20 @@ public:
 	virtual bool GetShaderProgramLinkStatus(unsigned int shaderProgram) = 0;
 	virtual int GetShaderProgramInfoLogLength(unsigned int shaderProgram) = 0;
 	virtual void GetShaderProgramInfoLog(unsigned int shaderProgram, unsigned int maxLength, char* logOut) = 0;
+	// Must be set before linking the program for GetShaderProgramBinary to be reliable
+	virtual void SetShaderProgramBinaryRetrievable(unsigned int shaderProgram) = 0;
+	virtual int GetShaderProgramBinaryLength(unsigned int shaderProgram) = 0;
+	virtual void GetShaderProgramBinary(
+		unsigned int shaderProgram,
+		int bufferSize,
+		uint32_t* formatOut,
+		void* binaryOut) = 0;
+	// Check GetShaderProgramLinkStatus afterwards, the driver can reject old binaries
+	virtual void SetShaderProgramBinary(
+		unsigned int shaderProgram,
+		uint32_t format,
+		const void* binary,
+		int length) = 0;
 
 	virtual unsigned int CreateShaderStage(RenderShaderStage stage) = 0;
 	virtual void DestroyShaderStage(unsigned int shaderStage) = 0;
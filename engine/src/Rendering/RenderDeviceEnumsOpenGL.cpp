@@ -2,6 +2,20 @@
 
 #include "System/IncludeOpenGL.hpp"
 
+// S3TC formats are not part of core OpenGL, so the loader doesn't define them
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
 namespace kokko
 {
 
@@ -15,6 +29,17 @@ uint32_t ConvertDeviceParameter(RenderDeviceParameter parameter)
 	}
 }
 
+uint32_t ConvertDeviceString(RenderDeviceString name)
+{
+	switch (name)
+	{
+	case RenderDeviceString::Vendor: return GL_VENDOR;
+	case RenderDeviceString::Renderer: return GL_RENDERER;
+	case RenderDeviceString::Version: return GL_VERSION;
+	default: return 0;
+	}
+}
+
 uint32_t ConvertClipOriginMode(RenderClipOriginMode origin)
 {
 	switch (origin)
@@ -118,6 +143,7 @@ uint32_t ConvertTextureDataType(RenderTextureDataType type)
 	case RenderTextureDataType::SignedShort: return GL_SHORT;
 	case RenderTextureDataType::UnsignedInt: return GL_UNSIGNED_INT;
 	case RenderTextureDataType::SignedInt: return GL_INT;
+	case RenderTextureDataType::HalfFloat: return GL_HALF_FLOAT;
 	case RenderTextureDataType::Float: return GL_FLOAT;
 	default: return 0;
 	}
@@ -151,6 +177,14 @@ uint32_t ConvertTextureSizedFormat(RenderTextureSizedFormat format)
 	case RenderTextureSizedFormat::D32F_S8: return GL_DEPTH32F_STENCIL8;
 	case RenderTextureSizedFormat::D24_S8: return GL_DEPTH24_STENCIL8;
 	case RenderTextureSizedFormat::STENCIL_INDEX8: return GL_STENCIL_INDEX8;
+	case RenderTextureSizedFormat::BC1_RGBA: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case RenderTextureSizedFormat::BC1_SRGB_A: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+	case RenderTextureSizedFormat::BC3_RGBA: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case RenderTextureSizedFormat::BC3_SRGB_A: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+	case RenderTextureSizedFormat::BC4_R: return GL_COMPRESSED_RED_RGTC1;
+	case RenderTextureSizedFormat::BC5_RG: return GL_COMPRESSED_RG_RGTC2;
+	case RenderTextureSizedFormat::BC7_RGBA: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	case RenderTextureSizedFormat::BC7_SRGB_A: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
 	default: return 0;
 	}
 }
@@ -339,6 +373,8 @@ uint32_t ConvertVertexElemType(RenderVertexElemType type)
 	switch (type)
 	{
 	case RenderVertexElemType::Float: return GL_FLOAT;
+	case RenderVertexElemType::HalfFloat: return GL_HALF_FLOAT;
+	case RenderVertexElemType::Snorm10_10_10_2: return GL_INT_2_10_10_10_REV;
 	default: return 0;
 	}
 }
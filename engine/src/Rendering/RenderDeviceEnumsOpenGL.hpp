@@ -8,6 +8,7 @@ namespace kokko
 {
 
 uint32_t ConvertDeviceParameter(RenderDeviceParameter parameter);
+uint32_t ConvertDeviceString(RenderDeviceString name);
 uint32_t ConvertClipOriginMode(RenderClipOriginMode origin);
 uint32_t ConvertClipDepthMode(RenderClipDepthMode depth);
 uint32_t ConvertCullFace(RenderCullFace face);
@@ -30,6 +30,34 @@ static void DebugMessageCallback(
 	if (data->callback)
 		data->callback(message);
 }
+
+// GL_ARB_bindless_texture isn't part of the loaded OpenGL functions, so it's loaded separately
+using GetTextureHandleFn = GLuint64(APIENTRYP)(GLuint texture);
+using MakeTextureHandleResidentFn = void(APIENTRYP)(GLuint64 handle);
+using IsTextureHandleResidentFn = GLboolean(APIENTRYP)(GLuint64 handle);
+
+GetTextureHandleFn getTextureHandle = nullptr;
+MakeTextureHandleResidentFn makeTextureHandleResident = nullptr;
+IsTextureHandleResidentFn isTextureHandleResident = nullptr;
+
+void LoadBindlessTextureFunctions()
+{
+	if (glfwExtensionSupported("GL_ARB_bindless_texture") == GLFW_FALSE)
+		return;
+
+	getTextureHandle = reinterpret_cast<GetTextureHandleFn>(glfwGetProcAddress("glGetTextureHandleARB"));
+	makeTextureHandleResident = reinterpret_cast<MakeTextureHandleResidentFn>(
+		glfwGetProcAddress("glMakeTextureHandleResidentARB"));
+	isTextureHandleResident = reinterpret_cast<IsTextureHandleResidentFn>(
+		glfwGetProcAddress("glIsTextureHandleResidentARB"));
+
+	if (getTextureHandle == nullptr || makeTextureHandleResident == nullptr || isTextureHandleResident == nullptr)
+	{
+		getTextureHandle = nullptr;
+		makeTextureHandleResident = nullptr;
+		isTextureHandleResident = nullptr;
+	}
+}
 }
 
 DeviceOpenGL::DeviceOpenGL() :
@@ -42,6 +70,8 @@ void DeviceOpenGL::InitializeDefaults()
 	glEnable(GL_FRAMEBUFFER_SRGB);
 	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 	glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+
+	LoadBindlessTextureFunctions();
 }
 
 void DeviceOpenGL::GetIntegerValue(RenderDeviceParameter parameter, int* valueOut)
@@ -49,6 +79,15 @@ void DeviceOpenGL::GetIntegerValue(RenderDeviceParameter parameter, int* valueOu
 	glGetIntegerv(ConvertDeviceParameter(parameter), valueOut);
 }
 
+ConstStringView DeviceOpenGL::GetStringValue(RenderDeviceString name)
+{
+	const GLubyte* str = glGetString(ConvertDeviceString(name));
+	if (str == nullptr)
+		return ConstStringView();
+
+	return ConstStringView(reinterpret_cast<const char*>(str));
+}
+
 void DeviceOpenGL::SetDebugMessageCallback(DebugCallbackFn callback)
 {
 	debugUserData.callback = callback;
@@ -136,6 +175,24 @@ void DeviceOpenGL::DestroyTextures(unsigned int count, const TextureId* textures
 	glDeleteTextures(count, &textures[0].i);
 }
 
+bool DeviceOpenGL::IsBindlessTextureSupported() const
+{
+	return getTextureHandle != nullptr;
+}
+
+uint64_t DeviceOpenGL::GetResidentTextureHandle(TextureId texture)
+{
+	if (getTextureHandle == nullptr || texture == TextureId())
+		return 0;
+
+	// The handle of a texture is always the same, and deleting the texture releases it
+	GLuint64 handle = getTextureHandle(texture.i);
+	if (isTextureHandleResident(handle) == GL_FALSE)
+		makeTextureHandleResident(handle);
+
+	return handle;
+}
+
 void DeviceOpenGL::SetTextureStorage2D(
 	TextureId texture,
 	int levels,
@@ -162,6 +219,21 @@ void DeviceOpenGL::SetTextureSubImage2D(
 		ConvertTextureBaseFormat(format), ConvertTextureDataType(type), data);
 }
 
+void DeviceOpenGL::SetTextureSubImageCompressed2D(
+	TextureId texture,
+	int level,
+	int xOffset,
+	int yOffset,
+	int width,
+	int height,
+	RenderTextureSizedFormat format,
+	int dataSize,
+	const void* data)
+{
+	glCompressedTextureSubImage2D(texture.i, level, xOffset, yOffset, width, height,
+		ConvertTextureSizedFormat(format), dataSize, data);
+}
+
 void DeviceOpenGL::SetTextureSubImage3D(
 	TextureId texture,
 	int level,
@@ -179,6 +251,18 @@ void DeviceOpenGL::SetTextureSubImage3D(
 		ConvertTextureBaseFormat(format), ConvertTextureDataType(type), data);
 }
 
+void DeviceOpenGL::GetTextureImage(
+	TextureId texture,
+	int level,
+	RenderTextureBaseFormat format,
+	RenderTextureDataType type,
+	int bufferSize,
+	void* dataOut)
+{
+	glGetTextureImage(texture.i, level,
+		ConvertTextureBaseFormat(format), ConvertTextureDataType(type), bufferSize, dataOut);
+}
+
 void DeviceOpenGL::GenerateTextureMipmaps(TextureId texture)
 {
 	glGenerateTextureMipmap(texture.i);
@@ -252,6 +336,36 @@ void DeviceOpenGL::GetShaderProgramInfoLog(unsigned int shaderProgram, unsigned
 	glGetProgramInfoLog(shaderProgram, maxLength, nullptr, logOut);
 }
 
+void DeviceOpenGL::SetShaderProgramBinaryRetrievable(unsigned int shaderProgram)
+{
+	glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+int DeviceOpenGL::GetShaderProgramBinaryLength(unsigned int shaderProgram)
+{
+	return GetShaderProgramParameterInt(shaderProgram, GL_PROGRAM_BINARY_LENGTH);
+}
+
+void DeviceOpenGL::GetShaderProgramBinary(
+	unsigned int shaderProgram,
+	int bufferSize,
+	uint32_t* formatOut,
+	void* binaryOut)
+{
+	GLenum format = 0;
+	glGetProgramBinary(shaderProgram, bufferSize, nullptr, &format, binaryOut);
+	*formatOut = format;
+}
+
+void DeviceOpenGL::SetShaderProgramBinary(
+	unsigned int shaderProgram,
+	uint32_t format,
+	const void* binary,
+	int length)
+{
+	glProgramBinary(shaderProgram, format, binary, length);
+}
+
 // SHADER STAGE
 
 unsigned int DeviceOpenGL::CreateShaderStage(RenderShaderStage stage)
@@ -342,7 +456,9 @@ void DeviceOpenGL::SetVertexAttribFormat(
 	RenderVertexElemType elementType,
 	uint32_t offset)
 {
-	glVertexArrayAttribFormat(va.i, attributeIndex, size, ConvertVertexElemType(elementType), GL_FALSE, offset);
+	// Packed integer values are always used as normalized floats
+	GLboolean normalized = elementType == RenderVertexElemType::Snorm10_10_10_2 ? GL_TRUE : GL_FALSE;
+	glVertexArrayAttribFormat(va.i, attributeIndex, size, ConvertVertexElemType(elementType), normalized, offset);
 }
 
 void DeviceOpenGL::SetVertexAttribBinding(
@@ -27,6 +27,7 @@ public:
 	virtual void InitializeDefaults() override;
 
 	virtual void GetIntegerValue(RenderDeviceParameter parameter, int* valueOut) override;
+	virtual ConstStringView GetStringValue(RenderDeviceString name) override;
 
 	virtual void SetDebugMessageCallback(DebugCallbackFn callback) override;
 	virtual void SetObjectLabel(RenderObjectType type, unsigned int object, ConstStringView label) override;
@@ -59,6 +60,8 @@ public:
 	virtual void DestroyTextures(
 		unsigned int count,
 		const TextureId* textures) override;
+	virtual bool IsBindlessTextureSupported() const override;
+	virtual uint64_t GetResidentTextureHandle(TextureId texture) override;
 	virtual void SetTextureStorage2D(
 		TextureId texture,
 		int levels,
@@ -75,6 +78,16 @@ public:
 		RenderTextureBaseFormat format,
 		RenderTextureDataType type,
 		const void* data) override;
+	virtual void SetTextureSubImageCompressed2D(
+		TextureId texture,
+		int level,
+		int xOffset,
+		int yOffset,
+		int width,
+		int height,
+		RenderTextureSizedFormat format,
+		int dataSize,
+		const void* data) override;
 	virtual void SetTextureSubImage3D(
 		TextureId texture,
 		int level,
@@ -87,6 +100,13 @@ public:
 		RenderTextureBaseFormat format,
 		RenderTextureDataType type,
 		const void* data) override;
+	virtual void GetTextureImage(
+		TextureId texture,
+		int level,
+		RenderTextureBaseFormat format,
+		RenderTextureDataType type,
+		int bufferSize,
+		void* dataOut) override;
 	virtual void GenerateTextureMipmaps(TextureId texture) override;
 
 	void CreateSamplers(uint32_t count, const RenderSamplerParameters* params, SamplerId* samplersOut) override;
@@ -100,6 +120,18 @@ public:
 	virtual int GetShaderProgramInfoLogLength(unsigned int shaderProgram) override;
 	virtual int GetShaderProgramParameterInt(unsigned int shaderProgram, unsigned int parameter) override;
 	virtual void GetShaderProgramInfoLog(unsigned int shaderProgram, unsigned int maxLength, char* logOut) override;
+	virtual void SetShaderProgramBinaryRetrievable(unsigned int shaderProgram) override;
+	virtual int GetShaderProgramBinaryLength(unsigned int shaderProgram) override;
+	virtual void GetShaderProgramBinary(
+		unsigned int shaderProgram,
+		int bufferSize,
+		uint32_t* formatOut,
+		void* binaryOut) override;
+	virtual void SetShaderProgramBinary(
+		unsigned int shaderProgram,
+		uint32_t format,
+		const void* binary,
+		int length) override;
 
 	virtual unsigned int CreateShaderStage(RenderShaderStage stage) override;
 	virtual void DestroyShaderStage(unsigned int shaderStage) override;
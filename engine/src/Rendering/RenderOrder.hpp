@@ -7,10 +7,21 @@
 namespace kokko
 {
 
+/*
+* Sort key of a render command. Commands are sorted by the order word only, so commands
+* with an equal order are kept in submission order. Object data is stored in a side
+* table of the command list and referenced by payloadIndex.
+*/
+struct RenderCommandKey
+{
+	uint64_t order;
+	uint32_t payloadIndex;
+};
+
 struct RenderOrderConfiguration
 {
-	static const uint64_t CallbackMaterialId = (1 << 11) - 1;
-	static const uint16_t MaxFeatureObjectId = (1 << 14) - 1;
+	static const uint64_t CallbackMaterialId = (1 << 16) - 1;
+	static const uint16_t MaxFeatureObjectId = (1 << 16) - 1;
 
 	RenderOrderConfiguration()
 	{
@@ -22,26 +33,16 @@ struct RenderOrderConfiguration
 
 		// For transparents
 
-		transparentDepth.SetDefinition(20, command.shift);
+		transparentDepth.SetDefinition(24, command.shift);
 
 		// For opaques
 
-		opaqueDepth.SetDefinition(8, command.shift);
-		opaquePadding.SetDefinition(12, opaqueDepth.shift);
+		opaqueDepth.SetDefinition(16, command.shift);
+		opaquePadding.SetDefinition(8, opaqueDepth.shift);
 
 		// For all draw commands
 
-		materialId.SetDefinition(11, opaquePadding.shift);
-
-		// For regular mesh component draw commands
-
-		renderObject.SetDefinition(20, materialId.shift);
-		meshPart.SetDefinition(3, renderObject.shift);
-
-		// For custom renderer / graphics feature commands
-
-		featureIndex.SetDefinition(7, materialId.shift);
-		featureObjectId.SetDefinition(14, featureIndex.shift);
+		materialId.SetDefinition(16, opaquePadding.shift);
 
 		// CONTROL COMMANDS
 
@@ -64,10 +65,6 @@ struct RenderOrderConfiguration
 	BitfieldVariable<uint64_t> opaqueDepth;
 	BitfieldVariable<uint64_t> opaquePadding;
 	BitfieldVariable<uint64_t> materialId;
-	BitfieldVariable<uint64_t> renderObject;
-	BitfieldVariable<uint64_t> meshPart;
-	BitfieldVariable<uint64_t> featureIndex; // Or custom renderer index
-	BitfieldVariable<uint64_t> featureObjectId;
 	BitfieldVariable<uint64_t> commandType;
 	BitfieldVariable<uint64_t> commandData;
 
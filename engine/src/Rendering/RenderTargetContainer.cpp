@@ -2,6 +2,8 @@
 
 #include <cassert>
 
+#include "Math/Math.hpp"
+
 #include "Memory/Allocator.hpp"
 
 #include "Rendering/RenderDevice.hpp"
@@ -12,7 +14,8 @@ namespace kokko
 RenderTargetContainer::RenderTargetContainer(Allocator* allocator, kokko::render::Device* renderDevice) :
 	allocator(allocator),
 	renderDevice(renderDevice),
-	renderTargetCount(0)
+	renderTargets(allocator),
+	frameIndex(0)
 {
 }
 
@@ -23,49 +26,94 @@ RenderTargetContainer::~RenderTargetContainer()
 
 RenderTarget RenderTargetContainer::AcquireRenderTarget(Vec2i size, RenderTextureSizedFormat format)
 {
-	for (size_t i = 0; i < renderTargetCount; ++i)
+	Vec2i bucketSize(
+		Math::RoundUpToMultiple(size.x, SizeBucketStep),
+		Math::RoundUpToMultiple(size.y, SizeBucketStep));
+
+	TargetInfo* bestFit = nullptr;
+	TargetInfo* freeSlot = nullptr;
+	TargetInfo* leastRecentlyUsed = nullptr;
+
+	for (TargetInfo& targetInfo : renderTargets)
 	{
-		TargetInfo& targetInfo = renderTargets[i];
+		if (targetInfo.inUse)
+			continue;
+
+		if (targetInfo.target.framebuffer == kokko::render::FramebufferId())
+		{
+			if (freeSlot == nullptr)
+				freeSlot = &targetInfo;
+
+			continue;
+		}
 
-		if (targetInfo.inUse == false && targetInfo.target.colorFormat == format &&
-			targetInfo.target.size.x == size.x && targetInfo.target.size.y == size.y)
+		// Allow textures one bucket larger than needed, so that shrinking doesn't reallocate
+		Vec2i textureSize = targetInfo.target.textureSize;
+		if (targetInfo.target.colorFormat == format &&
+			textureSize.x >= size.x && textureSize.y >= size.y &&
+			textureSize.x <= bucketSize.x + SizeBucketStep && textureSize.y <= bucketSize.y + SizeBucketStep)
 		{
-			targetInfo.inUse = true;
+			if (bestFit == nullptr || textureSize.x * textureSize.y <
+				bestFit->target.textureSize.x * bestFit->target.textureSize.y)
+				bestFit = &targetInfo;
 
-			return targetInfo.target;
+			continue;
 		}
+
+		// Targets used during this or the previous frame are likely to be acquired again soon
+		if (targetInfo.lastUsedFrame + 1 < frameIndex &&
+			(leastRecentlyUsed == nullptr || targetInfo.lastUsedFrame < leastRecentlyUsed->lastUsedFrame))
+			leastRecentlyUsed = &targetInfo;
 	}
 
-	if (renderTargetCount < MaxRenderTargetCount)
+	if (bestFit != nullptr)
 	{
-		kokko::render::FramebufferId framebuffer;
-		kokko::render::TextureId texture;
+		bestFit->target.size = size;
+		bestFit->lastUsedFrame = frameIndex;
+		bestFit->inUse = true;
 
-		renderDevice->CreateFramebuffers(1, &framebuffer);
-		renderDevice->CreateTextures(RenderTextureTarget::Texture2d, 1, &texture);
-		renderDevice->SetTextureStorage2D(texture, 1, format, size.x, size.y);
-		renderDevice->AttachFramebufferTexture(framebuffer, RenderFramebufferAttachment::Color0, texture, 0);
+		return bestFit->target;
+	}
+
+	// Replace a stale target before growing the pool, so that a framebuffer that
+	// is resized every frame doesn't keep targets of every intermediate size alive
+	if (freeSlot == nullptr && leastRecentlyUsed != nullptr)
+	{
+		DestroyRenderTarget(*leastRecentlyUsed);
+		freeSlot = leastRecentlyUsed;
+	}
 
-		TargetInfo& targetInfo = renderTargets[renderTargetCount];
+	if (freeSlot == nullptr)
+	{
+		freeSlot = &renderTargets.PushBack();
+		freeSlot->target = RenderTarget{};
+		freeSlot->target.id = static_cast<unsigned int>(renderTargets.GetCount() - 1);
+	}
 
-		targetInfo.target.id = static_cast<unsigned int>(renderTargetCount);
-		targetInfo.target.size = size;
-		targetInfo.target.colorFormat = format;
-		targetInfo.target.colorTexture = texture;
-		targetInfo.target.framebuffer = framebuffer;
-		targetInfo.inUse = true;
+	kokko::render::FramebufferId framebuffer;
+	kokko::render::TextureId texture;
 
-		renderTargetCount += 1;
+	renderDevice->CreateFramebuffers(1, &framebuffer);
+	renderDevice->CreateTextures(RenderTextureTarget::Texture2d, 1, &texture);
+	renderDevice->SetTextureStorage2D(texture, 1, format, bucketSize.x, bucketSize.y);
+	renderDevice->AttachFramebufferTexture(framebuffer, RenderFramebufferAttachment::Color0, texture, 0);
 
-		return targetInfo.target;
-	}
+	TargetInfo& targetInfo = *freeSlot;
+
+	targetInfo.target.size = size;
+	targetInfo.target.textureSize = bucketSize;
+	targetInfo.target.colorFormat = format;
+	targetInfo.target.colorTexture = texture;
+	targetInfo.target.framebuffer = framebuffer;
+	targetInfo.lastUsedFrame = frameIndex;
+	targetInfo.inUse = true;
 
-	return RenderTarget{};
+	return targetInfo.target;
 }
 
 void RenderTargetContainer::ReleaseRenderTarget(unsigned int renderTargetId)
 {
-	if (renderTargetId < renderTargetCount)
+	if (renderTargetId < renderTargets.GetCount())
 	{
 		renderTargets[renderTargetId].inUse = false;
 	}
@@ -73,31 +121,63 @@ void RenderTargetContainer::ReleaseRenderTarget(unsigned int renderTargetId)
 
 bool RenderTargetContainer::ConfirmAllTargetsAreUnused()
 {
-	for (size_t i = 0; i < renderTargetCount; ++i)
+	for (const TargetInfo& targetInfo : renderTargets)
 	{
-		assert(renderTargets[i].inUse == false);
+		assert(targetInfo.inUse == false);
 
-		if (renderTargets[i].inUse)
+		if (targetInfo.inUse)
 			return false;
 	}
 
 	return true;
 }
 
+void RenderTargetContainer::EndFrame()
+{
+	bool anyStale = false;
+	for (const TargetInfo& targetInfo : renderTargets)
+		anyStale = anyStale || IsStale(targetInfo);
+
+	if (anyStale)
+	{
+		auto scope = renderDevice->CreateDebugScope(0, kokko::ConstStringView("RenderTargets_DestroyUnused"));
+
+		for (TargetInfo& targetInfo : renderTargets)
+			if (IsStale(targetInfo))
+				DestroyRenderTarget(targetInfo);
+	}
+
+	frameIndex += 1;
+}
+
+bool RenderTargetContainer::IsStale(const TargetInfo& targetInfo) const
+{
+	return targetInfo.inUse == false && targetInfo.target.framebuffer != kokko::render::FramebufferId() &&
+		frameIndex - targetInfo.lastUsedFrame >= MaxUnusedFrameCount;
+}
+
+void RenderTargetContainer::DestroyRenderTarget(TargetInfo& targetInfo)
+{
+	renderDevice->DestroyFramebuffers(1, &targetInfo.target.framebuffer);
+	renderDevice->DestroyTextures(1, &targetInfo.target.colorTexture);
+
+	unsigned int id = targetInfo.target.id;
+	targetInfo.target = RenderTarget{};
+	targetInfo.target.id = id;
+	targetInfo.inUse = false;
+}
+
 void RenderTargetContainer::DestroyAllRenderTargets()
 {
 	auto scope = renderDevice->CreateDebugScope(0, kokko::ConstStringView("RenderTargets_DestroyTargets"));
 
-	for (size_t i = 0; i < renderTargetCount; ++i)
+	for (TargetInfo& targetInfo : renderTargets)
 	{
-		renderDevice->DestroyFramebuffers(1, &renderTargets[i].target.framebuffer);
-		renderDevice->DestroyTextures(1, &renderTargets[i].target.colorTexture);
-
-		renderTargets[i].target = RenderTarget{};
-		renderTargets[i].inUse = false;
+		if (targetInfo.target.framebuffer != kokko::render::FramebufferId())
+			DestroyRenderTarget(targetInfo);
 	}
 
-	renderTargetCount = 0;
+	renderTargets.Clear();
 }
 
 } // namespace kokko
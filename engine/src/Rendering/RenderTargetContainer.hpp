@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
+#include "Core/Array.hpp"
+
 #include "Math/Vec2.hpp"
 
 #include "Rendering/RenderTypes.hpp"
@@ -18,30 +23,53 @@ class Device;
 struct RenderTarget
 {
 	unsigned int id;
+
+	// Area that was requested, passes render to and sample from this area only
 	Vec2i size;
 
+	// Size of the color texture, rounded up from the requested size
+	Vec2i textureSize;
+
 	RenderTextureSizedFormat colorFormat;
 	kokko::render::TextureId colorTexture;
 
 	kokko::render::FramebufferId framebuffer;
 };
 
+/*
+* Pool of transient render targets. Texture sizes are rounded up to a multiple of
+* SizeBucketStep, and a target can be acquired for any size that fits in its texture,
+* as long as the texture is at most one step larger than needed. A resize therefore
+* only creates new targets when the size crosses into a new bucket, and shrinking
+* back and forth reuses the larger targets. Shaders that sample a pooled target must
+* scale and clamp their texture coordinates to the requested area.
+*
+* Released targets are reused by later acquires, also within the same frame, so
+* targets whose lifetimes don't overlap share a texture. Targets that haven't been
+* used for a number of frames are destroyed. Targets used during the current or the
+* previous frame are never replaced, the pool grows instead.
+*/
 class RenderTargetContainer
 {
 private:
-	static const size_t MaxRenderTargetCount = 32;
+	static const uint32_t MaxUnusedFrameCount = 8;
+	static const int SizeBucketStep = 64;
 
 	struct TargetInfo
 	{
 		RenderTarget target;
+		uint32_t lastUsedFrame;
 		bool inUse;
 	};
 
 	Allocator* allocator;
 	kokko::render::Device* renderDevice;
 
-	TargetInfo renderTargets[MaxRenderTargetCount];
-	size_t renderTargetCount;
+	Array<TargetInfo> renderTargets;
+	uint32_t frameIndex;
+
+	bool IsStale(const TargetInfo& targetInfo) const;
+	void DestroyRenderTarget(TargetInfo& targetInfo);
 
 public:
 	RenderTargetContainer(Allocator* allocator, kokko::render::Device* renderDevice);
@@ -52,6 +80,9 @@ public:
 
 	bool ConfirmAllTargetsAreUnused();
 
+	// Destroys targets that haven't been used recently
+	void EndFrame();
+
 	void DestroyAllRenderTargets();
 };
 
@@ -1,9 +1,34 @@
 #include "Rendering/RenderTypes.hpp"
 
+#include <cstring>
+
 namespace kokko
 {
 
 BufferStorageFlags BufferStorageFlags::None = BufferStorageFlags{};
 BufferStorageFlags BufferStorageFlags::Dynamic = BufferStorageFlags{ true, false, false, false, false };
 
+uint32_t ReadRenderIndex(const uint8_t* indexData, RenderIndexType indexType, uint32_t index)
+{
+	switch (indexType)
+	{
+	case RenderIndexType::UnsignedByte:
+		return indexData[index];
+	case RenderIndexType::UnsignedShort:
+	{
+		uint16_t value;
+		std::memcpy(&value, indexData + index * sizeof(uint16_t), sizeof(value));
+		return value;
+	}
+	case RenderIndexType::UnsignedInt:
+	{
+		uint32_t value;
+		std::memcpy(&value, indexData + index * sizeof(uint32_t), sizeof(value));
+		return value;
+	}
+	default:
+		return index;
+	}
+}
+
 } // namespace kokko
@@ -53,6 +53,13 @@ enum class RenderDeviceParameter
 	UniformBufferOffsetAlignment
 };
 
+enum class RenderDeviceString
+{
+	Vendor,
+	Renderer,
+	Version
+};
+
 enum class RenderDebugSource
 {
 	Api,
@@ -173,6 +180,7 @@ enum class RenderTextureDataType
 	SignedShort,
 	UnsignedInt,
 	SignedInt,
+	HalfFloat,
 	Float
 };
 
@@ -211,7 +219,15 @@ enum class RenderTextureSizedFormat
 	D16,
 	D32F_S8,
 	D24_S8,
-	STENCIL_INDEX8
+	STENCIL_INDEX8,
+	BC1_RGBA,
+	BC1_SRGB_A,
+	BC3_RGBA,
+	BC3_SRGB_A,
+	BC4_R,
+	BC5_RG,
+	BC7_RGBA,
+	BC7_SRGB_A
 };
 
 enum class RenderFramebufferTarget
@@ -270,6 +286,9 @@ enum class RenderIndexType : uint8_t
 	UnsignedInt
 };
 
+// Reads an index from index buffer data. With RenderIndexType::None, returns index itself.
+uint32_t ReadRenderIndex(const uint8_t* indexData, RenderIndexType indexType, uint32_t index);
+
 enum class RenderPrimitiveMode : uint8_t
 {
 	Points,
@@ -334,7 +353,9 @@ enum class RenderDepthCompareFunc
 
 enum class RenderVertexElemType
 {
-	Float
+	Float,
+	HalfFloat,
+	Snorm10_10_10_2 // Packed into 32 bits, element count must be 4
 };
 
 struct ClearMask
@@ -18,6 +18,7 @@ struct RenderViewport
 	float farMinusNear;
 	float minusNear;
 	float objectMinScreenSizePx;
+	float lodMaxErrorPx;
 
 	Mat4x4fBijection view;
 	Mat4x4f projection;
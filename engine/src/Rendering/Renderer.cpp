@@ -1,5 +1,6 @@
 #include "Rendering/Renderer.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <cstring>
@@ -38,6 +39,7 @@
 #include "Rendering/Framebuffer.hpp"
 #include "Rendering/LightManager.hpp"
 #include "Rendering/MeshComponentSystem.hpp"
+#include "Rendering/OcclusionCulling.hpp"
 #include "Rendering/PostProcessRenderer.hpp"
 #include "Rendering/PostProcessRenderPass.hpp"
 #include "Rendering/CommandEncoder.hpp"
@@ -47,6 +49,7 @@
 #include "Rendering/RenderPassType.hpp"
 #include "Rendering/RenderTargetContainer.hpp"
 #include "Rendering/RenderViewport.hpp"
+#include "Rendering/SoftwareOcclusionCulling.hpp"
 #include "Rendering/StaticUniformBuffer.hpp"
 #include "Rendering/Uniform.hpp"
 
@@ -83,6 +86,41 @@ RenderPassType ConvertTransparencyToPass(TransparencyType transparency)
 		return RenderPassType::OpaqueGeometry;
 	}
 }
+
+uint32_t GetIndexSize(RenderIndexType indexType)
+{
+	switch (indexType)
+	{
+	case RenderIndexType::UnsignedShort:
+		return sizeof(uint16_t);
+	case RenderIndexType::UnsignedInt:
+		return sizeof(uint32_t);
+	default:
+		return sizeof(uint8_t);
+	}
+}
+
+// Size of one world space unit in pixels at the nearest point of the bounds
+float CalculateLodPixelsPerUnit(const RenderViewport& viewport, const AABB& bounds)
+{
+	float radius = bounds.extents.Magnitude();
+	float depth = Vec3f::Dot(bounds.center - viewport.position, viewport.forward) - radius;
+
+	// Clip space w is the depth with perspective projections and one with orthographic projections
+	const Mat4x4f& projection = viewport.projection;
+	float w = std::max(projection[15] - projection[11] * depth, 1e-3f);
+
+	return projection[5] * 0.5f * viewport.viewportRectangle.size.y / w;
+}
+
+bool AnyIntersects(const FrustumPlanes& frustum, const Array<AABB>& bounds)
+{
+	for (size_t i = 0, count = bounds.GetCount(); i < count; ++i)
+		if (Intersect::FrustumAabb(frustum, bounds[i]))
+			return true;
+
+	return false;
+}
 }
 
 struct DebugNormalUniformBlock
@@ -97,6 +135,7 @@ Renderer::Renderer(
 	Allocator* allocator,
 	kokko::render::Device* renderDevice,
 	kokko::render::CommandEncoder* commandEncoder,
+	JobSystem* jobSystem,
 	kokko::MeshComponentSystem* componentSystem,
 	Scene* scene,
 	CameraSystem* cameraSystem,
@@ -107,6 +146,7 @@ Renderer::Renderer(
 	allocator(allocator),
 	device(renderDevice),
 	encoder(commandEncoder),
+	jobSystem(jobSystem),
 	componentSystem(componentSystem),
 	targetFramebufferId(0),
 	viewportData(nullptr),
@@ -125,8 +165,12 @@ Renderer::Renderer(
 	textureManager(resourceManagers.textureManager),
 	renderDebug(renderDebug),
 	lockCullingCamera(false),
+	useOcclusionCulling(false),
+	shadowFrameIndex(0),
 	commandList(allocator),
 	objectVisibility(allocator),
+	cullingCandidates(allocator),
+	visibleObjects(allocator),
 	lightResultArray(allocator),
 	graphicsFeatures(allocator),
 	normalDebugBufferId(0)
@@ -137,12 +181,20 @@ Renderer::Renderer(
 	renderTargetContainer = MakeUnique<RenderTargetContainer>(allocator, allocator, renderDevice);
 	postProcessRenderer = MakeUnique<kokko::PostProcessRenderer>(
 		allocator, encoder, modelManager, shaderManager, renderTargetContainer.Get());
+	occlusionCulling = MakeUnique<OcclusionCulling>(allocator, allocator, renderDevice, shaderManager);
+	softwareOcclusion = MakeUnique<SoftwareOcclusionCulling>(allocator, allocator);
 
 	shadowMaterial = MaterialId::Null;
 	fallbackMeshMaterial = MaterialId::Null;
 
 	objectUniformBlockStride = 0;
 	objectsPerUniformBuffer = 0;
+
+	for (unsigned int i = 0; i < CascadedShadowMap::MaxCascadeCount; ++i)
+	{
+		shadowCascadeCache[i] = ShadowCascadeCache{};
+		shadowCascadeUpdate[i] = true;
+	}
 }
 
 Renderer::~Renderer()
@@ -162,6 +214,7 @@ void Renderer::Initialize()
 		objectsPerUniformBuffer = ObjectUniformBufferSize / objectUniformBlockStride;
 
 		postProcessRenderer->Initialize();
+		occlusionCulling->Initialize();
 
 		{
 			KOKKO_PROFILE_SCOPE("Allocate viewport data");
@@ -184,16 +237,6 @@ void Renderer::Initialize()
 				viewportData[i].uniformBlockObject = buffers[i];
 			}
 		}
-
-		{
-			const char* path = "engine/materials/forward/shadow_depth.material";
-			shadowMaterial = materialManager->FindMaterialByPath(kokko::ConstStringView(path));
-		}
-
-		{
-			const char* path = "engine/materials/deferred_geometry/fallback.material";
-			fallbackMeshMaterial = materialManager->FindMaterialByPath(kokko::ConstStringView(path));
-		}
 	}
 
 	{
@@ -232,6 +275,21 @@ void Renderer::Initialize()
 			feature->Initialize(parameters);
 		}
 	}
+
+	{
+		// Materials wait for their shaders to link, so they are loaded after all other shader compiles are issued
+
+		const kokko::ConstStringView materialPaths[] = {
+			kokko::ConstStringView("engine/materials/forward/shadow_depth.material"),
+			kokko::ConstStringView("engine/materials/deferred_geometry/fallback.material")
+		};
+
+		MaterialId materialIds[KOKKO_ARRAY_ITEMS(materialPaths)];
+		materialManager->FindMaterialsByPath(ArrayView<const kokko::ConstStringView>(materialPaths), materialIds);
+
+		shadowMaterial = materialIds[0];
+		fallbackMeshMaterial = materialIds[1];
+	}
 }
 
 void Renderer::Deinitialize()
@@ -249,6 +307,8 @@ void Renderer::Deinitialize()
 
 	graphicsFeatures.Clear();
 
+	occlusionCulling->Deinitialize();
+
 	for (unsigned int i = 0; i < FramesInFlightCount; ++i)
 	{
 		if (objectUniformBufferLists[i].GetCount() > 0)
@@ -308,15 +368,16 @@ void Renderer::Render(Window* window, const Optional<CameraParameters>& editorCa
 	if (targetFramebuffer.IsInitialized() == false)
 		return;
 
-	if (targetFramebuffer.GetSize() != renderGraphResources->GetFullscreenViewportSize())
-		renderTargetContainer->DestroyAllRenderTargets();
-
 	renderGraphResources->VerifyResourcesAreCreated(targetFramebuffer.GetSize());
 
 	targetFramebufferId = targetFramebuffer.GetFramebufferId();
 
+	useOcclusionCulling = renderDebug->IsFeatureEnabled(RenderDebugFeatureFlag::OcclusionCulling) &&
+		occlusionCulling->IsInitialized();
+
 	unsigned int objectDrawCount = PopulateCommandList(editorCamera, targetFramebuffer);
 	UpdateUniformBuffers(objectDrawCount);
+	materialManager->UploadDirtyUniforms();
 
 	intptr_t objectDrawsProcessed = 0;
 
@@ -352,18 +413,61 @@ void Renderer::Render(Window* window, const Optional<CameraParameters>& editorCa
 
 	auto scope = encoder->CreateDebugScope(0, kokko::ConstStringView("Renderer_Render"));
 
-	uint64_t* itr = commandList.commands.GetData();
-	uint64_t* end = itr + commandList.commands.GetCount();
+	// With occlusion culling, fullscreen opaque geometry is drawn in two passes.
+	// The late pass replays the same commands once the depth pyramid has been built.
+	RenderCommandKey* occlusionRangeBegin = nullptr;
+	intptr_t occlusionRangeObjectDraws = 0;
+	uint32_t occlusionDrawIndex = 0;
+	bool occlusionLatePass = false;
+
+	RenderCommandKey* itr = commandList.commands.GetData();
+	RenderCommandKey* end = itr + commandList.commands.GetCount();
 	for (; itr != end; ++itr)
 	{
-		uint64_t command = *itr;
+		RenderCommandKey command = *itr;
+		bool inOcclusionRange = useOcclusionCulling && IsFullscreenOpaqueDraw(command.order);
+
+		if (inOcclusionRange && occlusionRangeBegin == nullptr)
+		{
+			occlusionCulling->EncodeEarlyCull(encoder);
+			occlusionCulling->BindDrawCommandBuffer(encoder);
+
+			occlusionRangeBegin = itr;
+			occlusionRangeObjectDraws = objectDrawsProcessed;
+
+			// Reset state cache
+			lastVpIdx = MaxViewportCount;
+			lastShaderProgram = render::ShaderId();
+			lastMaterialId = MaterialId{ 0 };
+		}
+		else if (inOcclusionRange == false && occlusionRangeBegin != nullptr && occlusionLatePass == false)
+		{
+			// There's always a command after the range, because the skybox pass is started with a control command
+			render::TextureId depthTexture = renderGraphResources->GetGeometryBuffer().GetDepthTextureId();
+			occlusionCulling->EncodeLateCull(encoder, depthTexture);
+			occlusionCulling->BindDrawCommandBuffer(encoder);
+
+			// Replay the range, the object uniform blocks from the early pass are reused
+			itr = occlusionRangeBegin;
+			command = *itr;
+			inOcclusionRange = true;
+			objectDrawsProcessed = occlusionRangeObjectDraws;
+			occlusionDrawIndex = 0;
+			occlusionLatePass = true;
+
+			// Reset state cache
+			lastVpIdx = MaxViewportCount;
+			lastShaderProgram = render::ShaderId();
+			lastMaterialId = MaterialId{ 0 };
+		}
 
 		// If command is not control command, draw object
-		if (ParseControlCommand(command) == false)
+		if (ParseControlCommand(command.order) == false)
 		{
-			uint64_t mat = renderOrder.materialId.GetValue(command);
-			uint64_t vpIdx = renderOrder.viewportIndex.GetValue(command);
+			uint64_t mat = renderOrder.materialId.GetValue(command.order);
+			uint64_t vpIdx = renderOrder.viewportIndex.GetValue(command.order);
 			const RenderViewport& viewport = viewportData[vpIdx];
+			const RendererCommandPayload& payload = commandList.GetPayload(command);
 
 			if (mat != RenderOrderConfiguration::CallbackMaterialId)
 			{
@@ -372,8 +476,8 @@ void Renderer::Render(Window* window, const Optional<CameraParameters>& editorCa
 				if (matId == MaterialId::Null)
 					matId = fallbackMeshMaterial;
 
-				uint64_t objIdx = renderOrder.renderObject.GetValue(command);
-				uint16_t meshPart = static_cast<uint16_t>(renderOrder.meshPart.GetValue(command));
+				uint32_t objIdx = payload.renderObject;
+				uint16_t meshPart = payload.meshPart;
 
 				// Update viewport uniform block
 				if (vpIdx != lastVpIdx)
@@ -388,7 +492,7 @@ void Renderer::Render(Window* window, const Optional<CameraParameters>& editorCa
 				{
 					lastMaterialId = matId;
 					render::ShaderId matShaderId = materialManager->GetMaterialShaderDeviceId(matId);
-					render::BufferId matUniformBuffer = materialManager->GetMaterialUniformBufferId(matId);
+					size_t matUniformBlockSize = materialManager->GetMaterialUniformBlockSize(matId);
 
 					if (matShaderId != lastShaderProgram)
 					{
@@ -396,10 +500,16 @@ void Renderer::Render(Window* window, const Optional<CameraParameters>& editorCa
 						lastShaderProgram = matShaderId;
 					}
 
-					BindMaterialTextures(materialManager->GetMaterialUniforms(matId));
+					// Materials with bindless textures have their texture handles in the uniform block
+					const UniformData& matUniforms = materialManager->GetMaterialUniforms(matId);
+					if (matUniforms.HasTextureHandlesInBuffer() == false)
+						BindMaterialTextures(matUniforms);
 
-					// Bind material uniform block to shader
-					encoder->BindBufferBase(RenderBufferTarget::UniformBuffer, UniformBlockBinding::Material, matUniformBuffer);
+					// Bind material uniform block range of the shared material buffer to shader
+					if (matUniformBlockSize > 0)
+						encoder->BindBufferRange(RenderBufferTarget::UniformBuffer, UniformBlockBinding::Material,
+							materialManager->GetUniformBufferId(), materialManager->GetMaterialUniformBlockOffset(matId),
+							matUniformBlockSize);
 				}
 
 				// Bind object transform uniform block to shader
@@ -411,20 +521,34 @@ void Renderer::Render(Window* window, const Optional<CameraParameters>& editorCa
 				encoder->BindBufferRange(RenderBufferTarget::UniformBuffer, UniformBlockBinding::Object,
 					objUniformBuffers[bufferIndex], objectInBuffer * objectUniformBlockStride, rangeSize);
 
-				MeshId meshId = componentSystem->data.mesh[objIdx];
-				auto& mesh = modelManager->GetModelMeshes(meshId.modelId)[meshId.meshIndex];
-				auto& part = modelManager->GetModelMeshParts(meshId.modelId)[mesh.partOffset + meshPart];
-				encoder->BindVertexArray(part.vertexArrayId);
-				encoder->DrawIndexed(mesh.primitiveMode, mesh.indexType, part.count, part.indexOffset, 0);
+				// Mesh parts are drawn from precomputed packets instead of looking up the model data
+				MeshDrawPacket packet = componentSystem->GetDrawPacket(MeshComponentId{ objIdx }, meshPart, payload.lod);
+				encoder->BindVertexArray(packet.vertexArrayId);
+
+				if (inOcclusionRange)
+				{
+					intptr_t offset = occlusionLatePass ?
+						occlusionCulling->GetLateDrawOffset(occlusionDrawIndex) :
+						occlusionCulling->GetEarlyDrawOffset(occlusionDrawIndex);
+
+					encoder->DrawIndexedIndirect(packet.primitiveMode, packet.indexType, offset);
+					occlusionDrawIndex += 1;
+				}
+				else
+					encoder->DrawIndexed(packet.primitiveMode, packet.indexType, packet.indexCount, packet.indexOffset, 0);
 
 				objectDrawsProcessed += 1;
 			}
 			else // Render with callback
 			{
-				uint64_t featureIndex = renderOrder.featureIndex.GetValue(command);
+				// Callbacks were already rendered in the early pass
+				if (inOcclusionRange && occlusionLatePass)
+					continue;
+
+				uint64_t featureIndex = payload.featureIndex;
 
 				featureRenderParams.renderingViewportIndex = vpIdx;
-				featureRenderParams.featureObjectId = renderOrder.featureObjectId.GetValue(command);
+				featureRenderParams.featureObjectId = payload.featureObjectId;
 
 				graphicsFeatures[featureIndex]->Render(featureRenderParams);
 
@@ -436,6 +560,9 @@ void Renderer::Render(Window* window, const Optional<CameraParameters>& editorCa
 				// TODO: manage sampler state more robustly
 				encoder->BindSampler(0, render::SamplerId());
 
+				if (inOcclusionRange)
+					occlusionCulling->BindDrawCommandBuffer(encoder);
+
 				// TODO: Figure how to restore viewport and other relevant state
 			}
 		}
@@ -444,6 +571,7 @@ void Renderer::Render(Window* window, const Optional<CameraParameters>& editorCa
 	commandList.Clear();
 
 	renderTargetContainer->ConfirmAllTargetsAreUnused();
+	renderTargetContainer->EndFrame();
 
 	currentFrameIndex = (currentFrameIndex + 1) % FramesInFlightCount;
 
@@ -517,18 +645,23 @@ void Renderer::UpdateUniformBuffers(size_t objectDrawCount)
 
 	size_t objectDrawsProcessed = 0;
 
-	uint64_t* itr = commandList.commands.GetData();
-	uint64_t* end = itr + commandList.commands.GetCount();
+	if (useOcclusionCulling)
+		occlusionCulling->ClearDraws();
+
+	RenderCommandKey* itr = commandList.commands.GetData();
+	RenderCommandKey* end = itr + commandList.commands.GetCount();
 	for (; itr != end; ++itr)
 	{
-		uint64_t command = *itr;
-		uint64_t mat = renderOrder.materialId.GetValue(command);
-		uint64_t vpIdx = renderOrder.viewportIndex.GetValue(command);
-		uint64_t objIdx = renderOrder.renderObject.GetValue(command);
+		const RenderCommandKey& command = *itr;
+		uint64_t mat = renderOrder.materialId.GetValue(command.order);
+		uint64_t vpIdx = renderOrder.viewportIndex.GetValue(command.order);
 
 		// Is regular draw command
-		if (IsDrawCommand(command) && mat != RenderOrderConfiguration::CallbackMaterialId)
+		if (IsDrawCommand(command.order) && mat != RenderOrderConfiguration::CallbackMaterialId)
 		{
+			const RendererCommandPayload& payload = commandList.GetPayload(command);
+			uint32_t objIdx = payload.renderObject;
+
 			intptr_t bufferIndex = objectDrawsProcessed / objectsPerUniformBuffer;
 			intptr_t objectInBuffer = objectDrawsProcessed % objectsPerUniformBuffer;
 
@@ -544,15 +677,32 @@ void Renderer::UpdateUniformBuffers(size_t objectDrawCount)
 
 			TransformUniformBlock* tu = reinterpret_cast<TransformUniformBlock*>(stagingBuffer + objectUniformBlockStride * objectInBuffer);
 
-			const Mat4x4f& model = componentSystem->data.transform[objIdx];
+			const Mat4x4f& model = componentSystem->data.Get<MeshComponentSystem::Column::Transform>()[objIdx];
 			tu->MVP = viewportData[vpIdx].viewProjection * model;
 			tu->MV = viewportData[vpIdx].view.inverse * model;
 			tu->M = model;
 
+			// Collect draws for occlusion culling in the same order they are rendered
+			if (useOcclusionCulling && IsFullscreenOpaqueDraw(command.order))
+			{
+				uint16_t meshPart = payload.meshPart;
+				MeshDrawPacket packet = componentSystem->GetDrawPacket(MeshComponentId{ objIdx }, meshPart, payload.lod);
+				const AABB& bounds = componentSystem->data.Get<MeshComponentSystem::Column::Bounds>()[objIdx];
+
+				occlusionCulling->AddDraw(objIdx, bounds,
+					packet.indexCount, packet.indexOffset / GetIndexSize(packet.indexType));
+			}
+
 			objectDrawsProcessed += 1;
 		}
 	}
 
+	if (useOcclusionCulling)
+	{
+		occlusionCulling->Upload(viewportData[viewportIndexFullscreen].viewProjection,
+			renderGraphResources->GetFullscreenViewportSize(), componentSystem->data.GetCount());
+	}
+
 	if (prevBufferIndex >= 0)
 	{
 		unsigned int updateSize = static_cast<unsigned int>((objectDrawsProcessed % objectsPerUniformBuffer) * objectUniformBlockStride);
@@ -565,6 +715,13 @@ bool Renderer::IsDrawCommand(uint64_t orderKey)
 	return renderOrder.command.GetValue(orderKey) == static_cast<uint64_t>(RendererCommandType::Draw);
 }
 
+bool Renderer::IsFullscreenOpaqueDraw(uint64_t orderKey)
+{
+	return IsDrawCommand(orderKey) &&
+		renderOrder.viewportIndex.GetValue(orderKey) == viewportIndexFullscreen &&
+		renderOrder.viewportPass.GetValue(orderKey) == static_cast<uint64_t>(RenderPassType::OpaqueGeometry);
+}
+
 bool Renderer::ParseControlCommand(uint64_t orderKey)
 {
 	if (renderOrder.command.GetValue(orderKey) == static_cast<uint64_t>(RendererCommandType::Draw))
@@ -596,12 +753,6 @@ bool Renderer::ParseControlCommand(uint64_t orderKey)
 
 			// Bind shadow framebuffer before any shadow cascade draws
 			encoder->BindFramebuffer(shadowBuffer.GetFramebufferId());
-
-			// Set viewport size to full framebuffer size before clearing
-			encoder->SetViewport(0, 0, shadowBuffer.GetWidth(), shadowBuffer.GetHeight());
-
-			// Clear shadow framebuffer
-			encoder->Clear(ClearMask{false, true, false});
 		}
 
 		if (viewportIndex >= viewportIndicesShadowCascade.start &&
@@ -610,6 +761,15 @@ bool Renderer::ParseControlCommand(uint64_t orderKey)
 			const auto& rect = viewportData[viewportIndex].viewportRectangle;
 
 			encoder->SetViewport(rect.position.x, rect.position.y, rect.size.x, rect.size.y);
+
+			// Cached cascades keep the depth rendered on an earlier frame
+			if (shadowCascadeUpdate[viewportIndex - viewportIndicesShadowCascade.start])
+			{
+				encoder->ScissorTestEnable();
+				encoder->SetScissorRectangle(rect.position.x, rect.position.y, rect.size.x, rect.size.y);
+				encoder->Clear(ClearMask{false, true, false});
+				encoder->ScissorTestDisable();
+			}
 		}
 
 		if (viewportIndex == viewportIndexFullscreen)
@@ -703,6 +863,15 @@ unsigned int Renderer::PopulateCommandList(const Optional<CameraParameters>& edi
 	const float mainViewportMinObjectSize = 50.0f;
 	const float shadowViewportMinObjectSize = 30.0f;
 
+	// Shadow map texels are filtered, so shadow casters can be simplified further
+	const float mainViewportLodMaxError = 1.0f;
+	const float shadowViewportLodMaxError = 4.0f;
+
+	static_assert(MaxViewportCount <= MeshComponentSystem::LodState::MaxViewportCount,
+		"Every viewport needs its own selected level of detail");
+
+	bool cacheShadows = renderDebug->IsFeatureEnabled(RenderDebugFeatureFlag::ShadowCascadeCaching);
+
 	// Get camera transforms
 
 	CameraParameters cameraParameters = GetCameraParameters(editorCamera, targetFramebuffer);
@@ -730,6 +899,7 @@ unsigned int Renderer::PopulateCommandList(const Optional<CameraParameters>& edi
 
 	// Reset the used viewport count
 	viewportCount = 0;
+	viewportIndicesShadowCascade = Range<unsigned int>();
 
 	// Update directional light viewports
 	lightManager->GetDirectionalLights(lightResultArray);
@@ -748,7 +918,7 @@ unsigned int Renderer::PopulateCommandList(const Optional<CameraParameters>& edi
 				Mat3x3f orientation = lightManager->GetOrientation(id);
 				Vec3f lightDir = orientation * Vec3f(0.0f, 0.0f, -1.0f);
 
-				CascadedShadowMap::CalculateCascadeFrusta(lightDir, cameraTransforms.forward, projectionParams, cascadeViewTransforms, lightProjections);
+				CascadedShadowMap::CalculateCascadeFrusta(lightDir, cameraTransforms.forward, projectionParams, cacheShadows, cascadeViewTransforms, lightProjections);
 
 				viewportIndicesShadowCascade = Range<unsigned int>(viewportCount, viewportCount + shadowCascadeCount);
 
@@ -768,6 +938,7 @@ unsigned int Renderer::PopulateCommandList(const Optional<CameraParameters>& edi
 					vp.farMinusNear = lightProjections[cascade].orthographicFar - lightProjections[cascade].orthographicNear;
 					vp.minusNear = -lightProjections[cascade].orthographicNear;
 					vp.objectMinScreenSizePx = shadowViewportMinObjectSize;
+					vp.lodMaxErrorPx = shadowViewportLodMaxError;
 					vp.view.forward = forwardTransform;
 					vp.view.inverse = inverseTransform;
 					vp.projection = lightProjections[cascade].GetProjectionMatrix(reverseDepth);
@@ -802,6 +973,7 @@ unsigned int Renderer::PopulateCommandList(const Optional<CameraParameters>& edi
 			vp.farMinusNear = projectionParams.perspectiveFar - projectionParams.perspectiveNear;
 			vp.minusNear = -projectionParams.perspectiveNear;
 			vp.objectMinScreenSizePx = mainViewportMinObjectSize;
+			vp.lodMaxErrorPx = mainViewportLodMaxError;
 			vp.view.forward = cameraTransforms.forward;
 			vp.view.inverse = cameraTransforms.inverse;
 			vp.projection = cameraProjection;
@@ -840,7 +1012,7 @@ unsigned int Renderer::PopulateCommandList(const Optional<CameraParameters>& edi
 
 	// Create draw commands for render objects in scene
 
-	unsigned int componentCount = componentSystem->data.count;
+	unsigned int componentCount = componentSystem->data.GetCount();
 	unsigned int visRequired = BitPack::CalculateRequired(componentCount);
 	objectVisibility.Resize(static_cast<size_t>(visRequired) * viewportCount);
 
@@ -848,24 +1020,60 @@ unsigned int Renderer::PopulateCommandList(const Optional<CameraParameters>& edi
 
 	BitPack* vis[MaxViewportCount];
 
+	componentSystem->UpdateCullingStructures();
+
+	UpdateShadowCascadeCache(cacheShadows);
+	componentSystem->ClearChangedBounds();
+
 	for (size_t vpIdx = 0; vpIdx < viewportCount; ++vpIdx)
 	{
 		vis[vpIdx] = objectVisibility.GetData() + visRequired * vpIdx;
+		std::memset(vis[vpIdx], 0, sizeof(BitPack) * visRequired);
+
+		// Objects aren't drawn into cached shadow cascades
+		if (vpIdx >= viewportIndicesShadowCascade.start && vpIdx < viewportIndicesShadowCascade.end &&
+			shadowCascadeUpdate[vpIdx - viewportIndicesShadowCascade.start] == false)
+			continue;
 
 		const FrustumPlanes& frustum = viewportData[vpIdx].frustum;
 		const Mat4x4f& viewProjection = viewportData[vpIdx].viewProjection;
 		const Vec2i viewPortSize = viewportData[vpIdx].viewportRectangle.size;
 		float minSize = viewportData[vpIdx].objectMinScreenSizePx / (viewPortSize.x * viewPortSize.y);
 
-		Intersect::FrustumAABBMinSize(frustum, viewProjection, minSize, componentCount,
-			componentSystem->data.bounds, vis[vpIdx]);
+		// Only objects in BVH nodes that intersect the frustum need to be tested
+		cullingCandidates.Clear();
+		componentSystem->QueryCullingCandidates(frustum, cullingCandidates);
+
+		Intersect::FrustumAABBMinSizeIndexed(frustum, viewProjection, minSize,
+			static_cast<unsigned int>(cullingCandidates.GetCount()), cullingCandidates.GetData(),
+			componentSystem->data.Get<MeshComponentSystem::Column::Bounds>(), vis[vpIdx]);
+	}
+
+	if (renderDebug->IsFeatureEnabled(RenderDebugFeatureFlag::SoftwareOcclusionCulling))
+	{
+		Mat4x4f cullingViewProjection = cameraProjection * cullingTransform.inverse;
+		CullOccludedObjects(cullingViewProjection, vis[fsvp], visRequired);
+	}
+
+	// Collect objects that are visible in any viewport, skipping groups of invisible objects
+	visibleObjects.Clear();
+	for (unsigned int packIdx = 0; packIdx < visRequired; ++packIdx)
+	{
+		BitPack::DataType anyVisible = 0;
+		for (size_t vpIdx = 0; vpIdx < viewportCount; ++vpIdx)
+			anyVisible |= vis[vpIdx][packIdx].data;
+
+		for (unsigned int bit = 0; anyVisible != 0; ++bit, anyVisible >>= 1)
+			if (anyVisible & 1)
+				visibleObjects.PushBack(packIdx * BitPack::BitsPerPack + bit);
 	}
 
 	unsigned int objectDrawCount = 0;
 
-	for (unsigned int i = 1; i < componentCount; ++i)
+	for (uint32_t i : visibleObjects)
 	{
-		Vec3f objPos = (componentSystem->data.transform[i] * Vec4f(0.0f, 0.0f, 0.0f, 1.0f)).xyz();
+		Vec3f objPos = (componentSystem->data.Get<MeshComponentSystem::Column::Transform>()[i] * Vec4f(0.0f, 0.0f, 0.0f, 1.0f)).xyz();
+		const AABB& bounds = componentSystem->data.Get<MeshComponentSystem::Column::Bounds>()[i];
 
 		// Test visibility in shadow viewports
 		for (unsigned int vpIdx = 0, count = numShadowViewports; vpIdx < count; ++vpIdx)
@@ -875,6 +1083,9 @@ unsigned int Renderer::PopulateCommandList(const Optional<CameraParameters>& edi
 				const RenderViewport& vp = viewportData[vpIdx];
 
 				float depth = CalculateDepth(objPos, vp.position, vp.forward, vp.farMinusNear, vp.minusNear);
+				uint32_t lod = componentSystem->SelectLod(MeshComponentId{ i }, vpIdx,
+					CalculateLodPixelsPerUnit(vp, bounds), vp.lodMaxErrorPx);
+
 				auto transparencies = componentSystem->GetTransparencyTypes(MeshComponentId{ i });
 				uint8_t partCount = static_cast<uint8_t>(transparencies.GetCount());
 				for (size_t partIndex = 0; partIndex != partCount; ++partIndex)
@@ -882,7 +1093,7 @@ unsigned int Renderer::PopulateCommandList(const Optional<CameraParameters>& edi
 					if (static_cast<uint8_t>(transparencies[partIndex]) <= compareTrIdx)
 					{
 						// TODO: Render all mesh parts in one draw call since all of them use the same material
-						commandList.AddDraw(vpIdx, RenderPassType::OpaqueGeometry, depth, shadowMaterial, i, partIndex);
+						commandList.AddDraw(vpIdx, RenderPassType::OpaqueGeometry, depth, shadowMaterial, i, partIndex, lod);
 					}
 				}
 
@@ -893,19 +1104,20 @@ unsigned int Renderer::PopulateCommandList(const Optional<CameraParameters>& edi
 		// Test visibility in fullscreen viewport
 		if (BitPack::Get(vis[fsvp], i))
 		{
-			uint32_t meshIndex = componentSystem->data.mesh[i].meshIndex;
+			uint32_t meshIndex = componentSystem->data.Get<MeshComponentSystem::Column::Mesh>()[i].meshIndex;
 			auto id = MeshComponentId{ i };
 			auto materials = componentSystem->GetMaterialIds(id);
 			auto transparencies = componentSystem->GetTransparencyTypes(id);
 			const RenderViewport& vp = viewportData[fsvp];
 
 			float depth = CalculateDepth(objPos, vp.position, vp.forward, vp.farMinusNear, vp.minusNear);
+			uint32_t lod = componentSystem->SelectLod(id, fsvp, CalculateLodPixelsPerUnit(vp, bounds), vp.lodMaxErrorPx);
 
 			uint8_t partCount = static_cast<uint8_t>(materials.GetCount());
 			for (size_t partIndex = 0; partIndex != partCount; ++partIndex)
 			{
 				RenderPassType pass = ConvertTransparencyToPass(transparencies[partIndex]);
-				commandList.AddDraw(fsvp, pass, depth, materials[partIndex], i, partIndex);
+				commandList.AddDraw(fsvp, pass, depth, materials[partIndex], i, partIndex, lod);
 
 				objectDrawCount += 1;
 			}
@@ -976,6 +1188,105 @@ unsigned int Renderer::PopulateCommandList(const Optional<CameraParameters>& edi
 	return objectDrawCount;
 }
 
+void Renderer::UpdateShadowCascadeCache(bool cachingEnabled)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	// Near cascades cover a small area, so moving objects are updated immediately
+	constexpr unsigned int NearCascadeCount = 2;
+	constexpr uint32_t FarCascadeUpdateInterval = 4;
+
+	const MeshComponentSystem::ChangedBounds& changes = componentSystem->GetChangedBounds();
+	unsigned int cascadeCount = viewportIndicesShadowCascade.GetLength();
+
+	shadowFrameIndex += 1;
+
+	for (unsigned int cascade = 0; cascade < CascadedShadowMap::MaxCascadeCount; ++cascade)
+	{
+		ShadowCascadeCache& cache = shadowCascadeCache[cascade];
+
+		if (cascade >= cascadeCount)
+		{
+			cache.valid = false;
+			shadowCascadeUpdate[cascade] = true;
+			continue;
+		}
+
+		const RenderViewport& vp = viewportData[viewportIndicesShadowCascade.start + cascade];
+
+		// Light direction or camera movement changes the view-projection of the cascade
+		bool update = cachingEnabled == false || cache.valid == false || changes.overflow ||
+			cache.viewProjection != vp.viewProjection ||
+			AnyIntersects(vp.frustum, changes.staticObjects);
+
+		if (update == false && cache.dynamicChanges == false)
+			cache.dynamicChanges = AnyIntersects(vp.frustum, changes.dynamicObjects);
+
+		if (update == false && cache.dynamicChanges)
+			update = cascade < NearCascadeCount ||
+				shadowFrameIndex - cache.lastUpdateFrame >= FarCascadeUpdateInterval;
+
+		if (update)
+		{
+			cache.viewProjection = vp.viewProjection;
+			cache.lastUpdateFrame = shadowFrameIndex;
+			cache.valid = true;
+			cache.dynamicChanges = false;
+		}
+
+		shadowCascadeUpdate[cascade] = update;
+	}
+}
+
+void Renderer::CullOccludedObjects(const Mat4x4f& viewProjection, BitPack* visibility, unsigned int visRequired)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	const MeshId* meshes = componentSystem->data.Get<MeshComponentSystem::Column::Mesh>();
+	const AABB* bounds = componentSystem->data.Get<MeshComponentSystem::Column::Bounds>();
+	const Mat4x4f* transforms = componentSystem->data.Get<MeshComponentSystem::Column::Transform>();
+	const bool* occluderFlags = componentSystem->data.Get<MeshComponentSystem::Column::Occluder>();
+
+	softwareOcclusion->BeginFrame(viewProjection);
+
+	// Only occluders that are themselves visible can hide anything
+	for (unsigned int packIdx = 0; packIdx < visRequired; ++packIdx)
+	{
+		BitPack::DataType visible = visibility[packIdx].data;
+		for (unsigned int bit = 0; visible != 0; ++bit, visible >>= 1)
+		{
+			unsigned int index = packIdx * BitPack::BitsPerPack + bit;
+			if ((visible & 1) && occluderFlags[index] && meshes[index] != MeshId::Null)
+			{
+				const ModelMeshOccluder& occluder = modelManager->GetMeshOccluder(meshes[index]);
+				softwareOcclusion->AddOccluder(transforms[index], occluder.positions, occluder.vertexCount,
+					occluder.indices, occluder.indexCount);
+			}
+		}
+	}
+
+	if (softwareOcclusion->HasOccluders() == false)
+		return;
+
+	softwareOcclusion->Rasterize(jobSystem);
+
+	for (unsigned int packIdx = 0; packIdx < visRequired; ++packIdx)
+	{
+		BitPack::DataType visible = visibility[packIdx].data;
+		for (unsigned int bit = 0; visible != 0; ++bit, visible >>= 1)
+		{
+			unsigned int index = packIdx * BitPack::BitsPerPack + bit;
+			if ((visible & 1) && occluderFlags[index] == false &&
+				softwareOcclusion->IsVisible(bounds[index]) == false)
+				visibility[packIdx].Set(bit, false);
+		}
+	}
+
+	const SoftwareOcclusionCulling::Stats& stats = softwareOcclusion->GetStats();
+	KOKKO_PROFILE_COUNTER("Software occlusion triangles", stats.triangleCount);
+	KOKKO_PROFILE_COUNTER("Software occlusion culled objects", stats.culledCount);
+}
+
 void Renderer::DebugRender(DebugVectorRenderer* vectorRenderer)
 {
 	KOKKO_PROFILE_FUNCTION();
@@ -997,14 +1308,14 @@ void Renderer::DebugRender(DebugVectorRenderer* vectorRenderer)
 			// Draw normals
 
 			auto shaderPath = kokko::ConstStringView("engine/shaders/debug/debug_normal.glsl");
-			ShaderId shaderId = shaderManager->FindShaderByPath(shaderPath);
+			ShaderId shaderId = shaderManager->WaitForShader(shaderManager->FindShaderByPath(shaderPath));
 			if (shaderId == ShaderId::Null)
 				return;
 
 			const ShaderData& shader = shaderManager->GetShaderData(shaderId);
 			encoder->UseShaderProgram(shader.driverId);
 
-			const Mat4x4f& model = componentSystem->data.transform[component.i];
+			const Mat4x4f& model = componentSystem->data.Get<MeshComponentSystem::Column::Transform>()[component.i];
 			DebugNormalUniformBlock uniforms;
 			uniforms.MVP = viewportData[viewportIndexFullscreen].viewProjection * model;
 			uniforms.MV = viewportData[viewportIndexFullscreen].view.inverse * model;
@@ -1039,8 +1350,8 @@ void Renderer::DebugRender(DebugVectorRenderer* vectorRenderer)
 		Color color(1.0f, 1.0f, 1.0f, 1.0f);
 
 		// Draw bounds
-		AABB* bounds = componentSystem->data.bounds;
-		for (unsigned int idx = 1, count = componentSystem->data.count; idx < count; ++idx)
+		AABB* bounds = componentSystem->data.Get<MeshComponentSystem::Column::Bounds>();
+		for (unsigned int idx = 1, count = componentSystem->data.GetCount(); idx < count; ++idx)
 		{
 			Vec3f pos = bounds[idx].center;
 			Vec3f scale = bounds[idx].extents * 2.0f;
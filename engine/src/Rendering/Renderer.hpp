@@ -12,6 +12,7 @@
 
 #include "Math/Mat4x4.hpp"
 
+#include "Rendering/CascadedShadowMap.hpp"
 #include "Rendering/Framebuffer.hpp"
 #include "Rendering/Light.hpp"
 #include "Rendering/RendererCommandList.hpp"
@@ -28,16 +29,19 @@ class DebugVectorRenderer;
 class EnvironmentSystem;
 class GraphicsFeature;
 class Framebuffer;
+class JobSystem;
 class LightManager;
 class MaterialManager;
 class MeshComponentSystem;
 class ModelManager;
+class OcclusionCulling;
 class PostProcessRenderer;
 class RenderDebugSettings;
 class RenderGraphResources;
 class RenderTargetContainer;
 class Scene;
 class ShaderManager;
+class SoftwareOcclusionCulling;
 class TextureManager;
 class UniformData;
 class Window;
@@ -64,11 +68,14 @@ private:
 	Allocator* allocator;
 	kokko::render::Device* device;
 	render::CommandEncoder* encoder;
+	JobSystem* jobSystem;
 	MeshComponentSystem* componentSystem;
 
 	UniquePtr<RenderGraphResources> renderGraphResources;
 	UniquePtr<RenderTargetContainer> renderTargetContainer;
 	UniquePtr<PostProcessRenderer> postProcessRenderer;
+	UniquePtr<OcclusionCulling> occlusionCulling;
+	UniquePtr<SoftwareOcclusionCulling> softwareOcclusion;
 	
 	render::FramebufferId targetFramebufferId;
 
@@ -102,8 +109,24 @@ private:
 	bool lockCullingCamera;
 	Mat4x4fBijection lockCullingCameraTransform;
 
+	bool useOcclusionCulling;
+
+	struct ShadowCascadeCache
+	{
+		Mat4x4f viewProjection;
+		uint32_t lastUpdateFrame;
+		bool valid;
+		bool dynamicChanges; // Moving objects have changed the cascade since the last update
+	};
+
+	ShadowCascadeCache shadowCascadeCache[CascadedShadowMap::MaxCascadeCount];
+	bool shadowCascadeUpdate[CascadedShadowMap::MaxCascadeCount];
+	uint32_t shadowFrameIndex;
+
 	RendererCommandList commandList;
 	Array<BitPack> objectVisibility;
+	Array<uint32_t> cullingCandidates;
+	Array<uint32_t> visibleObjects;
 
 	Array<LightId> lightResultArray;
 
@@ -120,15 +143,23 @@ private:
 	unsigned int PopulateCommandList(const Optional<CameraParameters>& editorCamera,
 		const render::Framebuffer& targetFramebuffer);
 
+	// Decides which shadow cascades need to be rendered this frame
+	void UpdateShadowCascadeCache(bool cachingEnabled);
+
+	// Hides objects that are behind occluder meshes in the visibility bits of a viewport
+	void CullOccludedObjects(const Mat4x4f& viewProjection, BitPack* visibility, unsigned int visRequired);
+
 	void UpdateUniformBuffers(size_t objectDrawCount);
 
 	bool IsDrawCommand(uint64_t orderKey);
+	bool IsFullscreenOpaqueDraw(uint64_t orderKey);
 	bool ParseControlCommand(uint64_t orderKey);
 
 public:
 	Renderer(Allocator* allocator,
 		render::Device* renderDevice,
 		render::CommandEncoder* commandEncoder,
+		JobSystem* jobSystem,
 		MeshComponentSystem* componentSystem,
 		Scene* scene,
 		CameraSystem* cameraSystem,
@@ -1,11 +1,21 @@
 #include "Rendering/RendererCommandList.hpp"
 
+#include <cassert>
+
 #include "Core/Core.hpp"
 #include "Core/Sort.hpp"
 
 namespace kokko
 {
 
+namespace
+{
+uint64_t GetCommandOrder(const RenderCommandKey& command)
+{
+	return command.order;
+}
+}
+
 void RendererCommandList::AddControl(
 	unsigned int viewport,
 	RenderPassType pass,
@@ -20,7 +30,7 @@ void RendererCommandList::AddControl(
 	renderOrder.commandType.AssignValue(c, static_cast<uint64_t>(type));
 	renderOrder.commandData.AssignValue(c, data);
 
-	commands.PushBack(c);
+	commands.PushBack(RenderCommandKey{ c, 0 });
 }
 
 void RendererCommandList::AddControl(
@@ -51,7 +61,7 @@ void RendererCommandList::AddControl(
 
 	renderOrder.commandData.AssignValue(c, offset);
 
-	commands.PushBack(c);
+	commands.PushBack(RenderCommandKey{ c, 0 });
 }
 
 void RendererCommandList::AddDraw(
@@ -60,7 +70,8 @@ void RendererCommandList::AddDraw(
 	float depth,
 	MaterialId material,
 	unsigned int renderObjectId,
-	unsigned int meshPart)
+	unsigned int meshPart,
+	unsigned int lod)
 {
 	depth = (depth > 1.0f ? 1.0f : (depth < 0.0f ? 0.0f : depth));
 
@@ -83,11 +94,16 @@ void RendererCommandList::AddDraw(
 		renderOrder.opaqueDepth.AssignValue(c, intDepth);
 	}
 
+	// The material field is 16 bits and its largest value marks callback commands
+	assert(material.i < RenderOrderConfiguration::CallbackMaterialId);
 	renderOrder.materialId.AssignValue(c, material.i);
-	renderOrder.renderObject.AssignValue(c, renderObjectId);
-	renderOrder.meshPart.AssignValue(c, meshPart);
 
-	commands.PushBack(c);
+	RendererCommandPayload payload{};
+	payload.renderObject = renderObjectId;
+	payload.meshPart = static_cast<uint16_t>(meshPart);
+	payload.lod = static_cast<uint8_t>(lod);
+
+	AddCommand(c, payload);
 }
 
 void RendererCommandList::AddDrawWithCallback(
@@ -119,10 +135,12 @@ void RendererCommandList::AddDrawWithCallback(
 	}
 
 	renderOrder.materialId.AssignValue(c, RenderOrderConfiguration::CallbackMaterialId);
-	renderOrder.featureIndex.AssignValue(c, callbackIndex);
-	renderOrder.featureObjectId.AssignValue(c, static_cast<uint64_t>(featureObjectId));
 
-	commands.PushBack(c);
+	RendererCommandPayload payload{};
+	payload.featureIndex = static_cast<uint16_t>(callbackIndex);
+	payload.featureObjectId = featureObjectId;
+
+	AddCommand(c, payload);
 }
 
 void RendererCommandList::AddGraphicsFeatureWithOrder(unsigned int viewport, RenderPassType pass, uint32_t order, unsigned int featureIndex, uint16_t featureObjectId)
@@ -141,22 +159,35 @@ void RendererCommandList::AddGraphicsFeatureWithOrder(unsigned int viewport, Ren
 		renderOrder.opaqueDepth.AssignValue(c, order);
 
 	renderOrder.materialId.AssignValue(c, RenderOrderConfiguration::CallbackMaterialId);
-	renderOrder.featureIndex.AssignValue(c, featureIndex);
-	renderOrder.featureObjectId.AssignValue(c, static_cast<uint64_t>(featureObjectId));
 
-	commands.PushBack(c);
+	RendererCommandPayload payload{};
+	payload.featureIndex = static_cast<uint16_t>(featureIndex);
+	payload.featureObjectId = featureObjectId;
+
+	AddCommand(c, payload);
+}
+
+void RendererCommandList::AddCommand(uint64_t order, const RendererCommandPayload& payload)
+{
+	uint32_t payloadIndex = static_cast<uint32_t>(payloads.GetCount());
+	payloads.PushBack(payload);
+
+	commands.PushBack(RenderCommandKey{ order, payloadIndex });
 }
 
 void RendererCommandList::Sort()
 {
 	KOKKO_PROFILE_FUNCTION();
 
-	ShellSortAsc(commands.GetData(), commands.GetCount());
+	// Only the keys are moved, payloads stay in submission order
+	sortBuffer.Resize(commands.GetCount());
+	RadixSortAsc(commands.GetData(), sortBuffer.GetData(), commands.GetCount(), GetCommandOrder);
 }
 
 void RendererCommandList::Clear()
 {
 	commands.Clear();
+	payloads.Clear();
 	commandData.Clear();
 }
 
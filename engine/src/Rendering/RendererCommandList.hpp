@@ -24,19 +24,38 @@ enum class RendererControlType
 	BeginPass
 };
 
+// Object data of a draw command, referenced from the command's sort key
+struct RendererCommandPayload
+{
+	uint32_t renderObject;
+	uint16_t meshPart;
+	uint16_t featureIndex;
+	uint16_t featureObjectId;
+	uint8_t lod;
+};
+
 struct RendererCommandList
 {
 	RendererCommandList(Allocator* allocator) :
 		commands(allocator),
+		sortBuffer(allocator),
+		payloads(allocator),
 		commandData(allocator)
 	{
 	}
 
 	RenderOrderConfiguration renderOrder;
 
-	Array<uint64_t> commands;
+	Array<RenderCommandKey> commands;
+	Array<RenderCommandKey> sortBuffer;
+	Array<RendererCommandPayload> payloads;
 	Array<uint8_t> commandData;
 
+	const RendererCommandPayload& GetPayload(const RenderCommandKey& command) const
+	{
+		return payloads[command.payloadIndex];
+	}
+
 	void AddControl(
 		unsigned int viewport,
 		RenderPassType pass,
@@ -56,7 +75,8 @@ struct RendererCommandList
 		float depth,
 		MaterialId material,
 		unsigned int objIndex,
-		unsigned int meshPart);
+		unsigned int meshPart,
+		unsigned int lod = 0);
 
 	void AddDrawWithCallback(
 		unsigned int viewport,
@@ -76,6 +96,9 @@ struct RendererCommandList
 	void Sort();
 
 	void Clear();
+
+private:
+	void AddCommand(uint64_t order, const RendererCommandPayload& payload);
 };
 
 } // namespace kokko
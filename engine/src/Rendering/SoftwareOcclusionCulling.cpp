@@ -0,0 +1,522 @@
+#include "Rendering/SoftwareOcclusionCulling.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#ifdef KOKKO_USE_SSE
+#include <immintrin.h>
+#endif
+
+#include "doctest/doctest.h"
+
+#include "Core/Core.hpp"
+
+#include "Engine/JobHelpers.hpp"
+#include "Engine/JobSystem.hpp"
+
+#include "Math/AABB.hpp"
+#include "Math/Projection.hpp"
+
+#include "Memory/Allocator.hpp"
+
+namespace kokko
+{
+
+namespace
+{
+
+// Triangles with a smaller area in pixels can't cover any pixel centers reliably
+constexpr float MinTriangleArea = 1e-6f;
+
+enum OutCode : uint32_t
+{
+	OutCode_Left = 1 << 0,
+	OutCode_Right = 1 << 1,
+	OutCode_Bottom = 1 << 2,
+	OutCode_Top = 1 << 3,
+	OutCode_Far = 1 << 4
+};
+
+uint32_t CalculateOutCode(const Vec4f& v)
+{
+	uint32_t code = 0;
+	if (v.x < -v.w) code |= OutCode_Left;
+	if (v.x > v.w) code |= OutCode_Right;
+	if (v.y < -v.w) code |= OutCode_Bottom;
+	if (v.y > v.w) code |= OutCode_Top;
+	if (v.z < 0.0f) code |= OutCode_Far;
+	return code;
+}
+
+// With reversed depth, the near plane is at z = w
+float NearPlaneDistance(const Vec4f& v)
+{
+	return v.w - v.z;
+}
+
+} // namespace
+
+SoftwareOcclusionCulling::SoftwareOcclusionCulling(Allocator* allocator, int width, int height) :
+	allocator(allocator),
+	width(width),
+	height(height),
+	depthBuffer(nullptr),
+	occluders(allocator),
+	triangles(allocator),
+	clipVertices(allocator),
+	bands(allocator),
+	stats(Stats{})
+{
+	assert(width > 0 && width % 4 == 0);
+	assert(height > 0);
+
+	size_t depthBytes = sizeof(float) * width * height;
+	depthBuffer = static_cast<float*>(allocator->AllocateAligned(depthBytes, 16, "SoftwareOcclusionCulling.depthBuffer"));
+	std::memset(depthBuffer, 0, depthBytes);
+
+	for (int row = 0; row < height; row += BandHeight)
+		bands.PushBack(Band{ row, std::min(row + BandHeight, height) });
+}
+
+SoftwareOcclusionCulling::~SoftwareOcclusionCulling()
+{
+	allocator->Deallocate(depthBuffer);
+}
+
+void SoftwareOcclusionCulling::BeginFrame(const Mat4x4f& viewProjection)
+{
+	this->viewProjection = viewProjection;
+
+	// Zero is the far plane with reversed depth
+	std::memset(depthBuffer, 0, sizeof(float) * width * height);
+
+	occluders.Clear();
+	triangles.Clear();
+	stats = Stats{};
+}
+
+void SoftwareOcclusionCulling::AddOccluder(const Mat4x4f& transform, const Vec3f* positions, uint32_t vertexCount,
+	const uint32_t* indices, uint32_t indexCount)
+{
+	assert(indexCount % 3 == 0);
+
+	if (indexCount == 0)
+		return;
+
+	occluders.PushBack(Occluder{ transform, positions, indices, vertexCount, indexCount });
+}
+
+void SoftwareOcclusionCulling::Rasterize(JobSystem* jobSystem)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	SetupTriangles();
+
+	if (triangles.GetCount() == 0)
+		return;
+
+	if (jobSystem != nullptr && bands.GetCount() > 1)
+	{
+		// Each band only writes its own rows of the depth buffer
+		JobHelpers::ParallelFor(jobSystem, 0, bands.GetCount(), 1, [this](size_t begin, size_t end)
+		{
+			RasterizeBands(this, &bands[begin], end - begin);
+		});
+	}
+	else
+	{
+		RasterizeBands(this, bands.GetData(), bands.GetCount());
+	}
+}
+
+bool SoftwareOcclusionCulling::IsVisible(const AABB& bounds)
+{
+	stats.testedCount += 1;
+
+	Vec2f screenMin(static_cast<float>(width), static_cast<float>(height));
+	Vec2f screenMax(0.0f, 0.0f);
+	float nearestDepth = 0.0f;
+
+	for (int i = 0; i < 8; ++i)
+	{
+		Vec3f corner(
+			bounds.center.x + ((i & 1) ? bounds.extents.x : -bounds.extents.x),
+			bounds.center.y + ((i & 2) ? bounds.extents.y : -bounds.extents.y),
+			bounds.center.z + ((i & 4) ? bounds.extents.z : -bounds.extents.z));
+
+		Vec4f clip = viewProjection * Vec4f(corner, 1.0f);
+
+		// Bounds that cross the near plane always cover the closest depth
+		if (NearPlaneDistance(clip) < 0.0f || clip.w <= 0.0f)
+			return true;
+
+		Vec3f screen = ClipToScreen(clip);
+		screenMin.x = std::min(screenMin.x, screen.x);
+		screenMin.y = std::min(screenMin.y, screen.y);
+		screenMax.x = std::max(screenMax.x, screen.x);
+		screenMax.y = std::max(screenMax.y, screen.y);
+		nearestDepth = std::max(nearestDepth, screen.z);
+	}
+
+	// Test every pixel the bounds touch
+	int minX = std::max(static_cast<int>(std::floor(std::max(screenMin.x, 0.0f))), 0);
+	int minY = std::max(static_cast<int>(std::floor(std::max(screenMin.y, 0.0f))), 0);
+	int maxX = std::min(static_cast<int>(std::ceil(std::min(screenMax.x, static_cast<float>(width)))), width) - 1;
+	int maxY = std::min(static_cast<int>(std::ceil(std::min(screenMax.y, static_cast<float>(height)))), height) - 1;
+
+	if (minX > maxX || minY > maxY)
+		return true;
+
+	for (int y = minY; y <= maxY; ++y)
+	{
+		const float* row = depthBuffer + y * width;
+		int x = minX;
+
+#ifdef KOKKO_USE_SSE
+		const __m128 depth = _mm_set1_ps(nearestDepth);
+		for (; x + 3 <= maxX; x += 4)
+		{
+			__m128 visible = _mm_cmple_ps(_mm_loadu_ps(row + x), depth);
+			if (_mm_movemask_ps(visible) != 0)
+				return true;
+		}
+#endif
+
+		for (; x <= maxX; ++x)
+			if (row[x] <= nearestDepth)
+				return true;
+	}
+
+	stats.culledCount += 1;
+
+	return false;
+}
+
+void SoftwareOcclusionCulling::SetupTriangles()
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	stats.occluderCount = static_cast<uint32_t>(occluders.GetCount());
+
+	for (const Occluder& occluder : occluders)
+	{
+		Mat4x4f mvp = viewProjection * occluder.transform;
+
+		clipVertices.Resize(occluder.vertexCount);
+		for (uint32_t i = 0; i < occluder.vertexCount; ++i)
+			clipVertices[i] = mvp * Vec4f(occluder.positions[i], 1.0f);
+
+		for (uint32_t i = 0; i + 2 < occluder.indexCount; i += 3)
+		{
+			Vec4f v[3] = {
+				clipVertices[occluder.indices[i + 0]],
+				clipVertices[occluder.indices[i + 1]],
+				clipVertices[occluder.indices[i + 2]]
+			};
+
+			// Skip triangles that are completely outside one of the frustum planes
+			if ((CalculateOutCode(v[0]) & CalculateOutCode(v[1]) & CalculateOutCode(v[2])) != 0)
+				continue;
+
+			ClipAndAddTriangle(v);
+		}
+	}
+
+	stats.triangleCount = static_cast<uint32_t>(triangles.GetCount());
+}
+
+void SoftwareOcclusionCulling::ClipAndAddTriangle(const Vec4f* v)
+{
+	float dist[3] = { NearPlaneDistance(v[0]), NearPlaneDistance(v[1]), NearPlaneDistance(v[2]) };
+
+	if (dist[0] >= 0.0f && dist[1] >= 0.0f && dist[2] >= 0.0f)
+	{
+		AddScreenTriangle(v[0], v[1], v[2]);
+		return;
+	}
+
+	// Clipping a triangle against a single plane produces at most a quad
+	Vec4f polygon[4];
+	int count = 0;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		int next = (i + 1) % 3;
+
+		if (dist[i] >= 0.0f)
+			polygon[count++] = v[i];
+
+		if ((dist[i] >= 0.0f) != (dist[next] >= 0.0f))
+		{
+			float t = dist[i] / (dist[i] - dist[next]);
+			polygon[count++] = v[i] + (v[next] - v[i]) * t;
+		}
+	}
+
+	for (int i = 1; i + 1 < count; ++i)
+		AddScreenTriangle(polygon[0], polygon[i], polygon[i + 1]);
+}
+
+void SoftwareOcclusionCulling::AddScreenTriangle(const Vec4f& a, const Vec4f& b, const Vec4f& c)
+{
+	Triangle tri;
+	tri.vertices[0] = ClipToScreen(a);
+	tri.vertices[1] = ClipToScreen(b);
+	tri.vertices[2] = ClipToScreen(c);
+
+	const Vec3f& v0 = tri.vertices[0];
+	const Vec3f& v1 = tri.vertices[1];
+	const Vec3f& v2 = tri.vertices[2];
+
+	// Occluders are rendered double-sided, but the edge functions expect counter-clockwise order
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+	if (std::fabs(area) < MinTriangleArea)
+		return;
+
+	if (area < 0.0f)
+		std::swap(tri.vertices[1], tri.vertices[2]);
+
+	float minX = std::min(v0.x, std::min(v1.x, v2.x));
+	float minY = std::min(v0.y, std::min(v1.y, v2.y));
+	float maxX = std::max(v0.x, std::max(v1.x, v2.x));
+	float maxY = std::max(v0.y, std::max(v1.y, v2.y));
+
+	// Clamp before converting to integers, screen coordinates can be huge after clipping
+	float maxPixelX = static_cast<float>(width - 1);
+	float maxPixelY = static_cast<float>(height - 1);
+	tri.minX = static_cast<int>(std::floor(std::min(std::max(minX, 0.0f), maxPixelX)));
+	tri.minY = static_cast<int>(std::floor(std::min(std::max(minY, 0.0f), maxPixelY)));
+	tri.maxX = static_cast<int>(std::ceil(std::min(std::max(maxX, 0.0f), maxPixelX)));
+	tri.maxY = static_cast<int>(std::ceil(std::min(std::max(maxY, 0.0f), maxPixelY)));
+
+	triangles.PushBack(tri);
+}
+
+Vec3f SoftwareOcclusionCulling::ClipToScreen(const Vec4f& clip) const
+{
+	float invW = 1.0f / clip.w;
+
+	return Vec3f(
+		(clip.x * invW * 0.5f + 0.5f) * width,
+		(clip.y * invW * 0.5f + 0.5f) * height,
+		clip.z * invW);
+}
+
+void SoftwareOcclusionCulling::RasterizeTriangle(const Triangle& tri, int rowBegin, int rowEnd)
+{
+	int minY = std::max(tri.minY, rowBegin);
+	int maxY = std::min(tri.maxY, rowEnd - 1);
+
+	if (minY > maxY)
+		return;
+
+	const Vec3f& v0 = tri.vertices[0];
+	const Vec3f& v1 = tri.vertices[1];
+	const Vec3f& v2 = tri.vertices[2];
+
+	// Edge functions are positive inside the triangle, each is zero on the edge opposite of its vertex
+	float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = -(a0 * v1.x + b0 * v1.y);
+	float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = -(a1 * v2.x + b1 * v2.y);
+	float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = -(a2 * v0.x + b2 * v0.y);
+
+	// Depth is linear in screen space, so it can be stepped as a plane
+	float invArea = 1.0f / (a2 * v2.x + b2 * v2.y + c2);
+	float zx = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * invArea;
+	float zy = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * invArea;
+	float zc = (c0 * v0.z + c1 * v1.z + c2 * v2.z) * invArea;
+
+	// Start from an aligned group of 4 pixels, the buffer width is a multiple of 4
+	int minX = tri.minX & ~3;
+	int maxX = tri.maxX;
+
+	float startX = minX + 0.5f;
+
+	for (int y = minY; y <= maxY; ++y)
+	{
+		float py = y + 0.5f;
+		float e0 = a0 * startX + b0 * py + c0;
+		float e1 = a1 * startX + b1 * py + c1;
+		float e2 = a2 * startX + b2 * py + c2;
+		float z = zx * startX + zy * py + zc;
+
+		float* row = depthBuffer + y * width;
+
+#ifdef KOKKO_USE_SSE
+		const __m128 offsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+		const __m128 zero = _mm_setzero_ps();
+
+		__m128 edge0 = _mm_add_ps(_mm_set1_ps(e0), _mm_mul_ps(_mm_set1_ps(a0), offsets));
+		__m128 edge1 = _mm_add_ps(_mm_set1_ps(e1), _mm_mul_ps(_mm_set1_ps(a1), offsets));
+		__m128 edge2 = _mm_add_ps(_mm_set1_ps(e2), _mm_mul_ps(_mm_set1_ps(a2), offsets));
+		__m128 depth = _mm_add_ps(_mm_set1_ps(z), _mm_mul_ps(_mm_set1_ps(zx), offsets));
+
+		const __m128 step0 = _mm_set1_ps(a0 * 4.0f);
+		const __m128 step1 = _mm_set1_ps(a1 * 4.0f);
+		const __m128 step2 = _mm_set1_ps(a2 * 4.0f);
+		const __m128 stepZ = _mm_set1_ps(zx * 4.0f);
+
+		for (int x = minX; x <= maxX; x += 4)
+		{
+			__m128 inside = _mm_and_ps(_mm_cmpge_ps(edge0, zero),
+				_mm_and_ps(_mm_cmpge_ps(edge1, zero), _mm_cmpge_ps(edge2, zero)));
+
+			if (_mm_movemask_ps(inside) != 0)
+			{
+				__m128 previous = _mm_load_ps(row + x);
+				__m128 closest = _mm_max_ps(previous, depth);
+				_mm_store_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closest), _mm_andnot_ps(inside, previous)));
+			}
+
+			edge0 = _mm_add_ps(edge0, step0);
+			edge1 = _mm_add_ps(edge1, step1);
+			edge2 = _mm_add_ps(edge2, step2);
+			depth = _mm_add_ps(depth, stepZ);
+		}
+#else
+		for (int x = minX; x <= maxX; ++x)
+		{
+			if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f)
+				row[x] = std::max(row[x], z);
+
+			e0 += a0;
+			e1 += a1;
+			e2 += a2;
+			z += zx;
+		}
+#endif
+	}
+}
+
+void SoftwareOcclusionCulling::RasterizeBands(SoftwareOcclusionCulling* culling, Band* bands, size_t count)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	for (size_t bandIdx = 0; bandIdx < count; ++bandIdx)
+	{
+		const Band& band = bands[bandIdx];
+
+		for (const Triangle& tri : culling->triangles)
+			culling->RasterizeTriangle(tri, band.rowBegin, band.rowEnd);
+	}
+}
+
+namespace
+{
+
+Mat4x4f CreateTestViewProjection()
+{
+	ProjectionParameters params;
+	params.SetPerspective(1.2f);
+	params.aspect = 2.0f;
+	params.perspectiveNear = 0.1f;
+	params.perspectiveFar = 100.0f;
+
+	// Camera is at the origin, looking towards negative Z
+	return params.GetProjectionMatrix(true);
+}
+
+void AddTestQuad(SoftwareOcclusionCulling& culling, const Vec3f* corners)
+{
+	static const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+	culling.AddOccluder(Mat4x4f(), corners, 4, indices, 6);
+}
+
+} // namespace
+
+TEST_CASE("SoftwareOcclusionCulling.NoOccluders")
+{
+	SoftwareOcclusionCulling culling(Allocator::GetDefault());
+	culling.BeginFrame(CreateTestViewProjection());
+	culling.Rasterize(nullptr);
+
+	CHECK(culling.HasOccluders() == false);
+	CHECK(culling.IsVisible(AABB{ Vec3f(0.0f, 0.0f, -20.0f), Vec3f(1.0f, 1.0f, 1.0f) }));
+	CHECK(culling.GetStats().culledCount == 0);
+}
+
+TEST_CASE("SoftwareOcclusionCulling.QuadOccluder")
+{
+	SoftwareOcclusionCulling culling(Allocator::GetDefault());
+	culling.BeginFrame(CreateTestViewProjection());
+
+	const Vec3f quad[] = {
+		Vec3f(-1.0f, -1.0f, -5.0f), Vec3f(1.0f, -1.0f, -5.0f),
+		Vec3f(1.0f, 1.0f, -5.0f), Vec3f(-1.0f, 1.0f, -5.0f)
+	};
+	AddTestQuad(culling, quad);
+	culling.Rasterize(nullptr);
+
+	CHECK(culling.GetStats().triangleCount == 2);
+
+	// Behind the quad
+	CHECK(culling.IsVisible(AABB{ Vec3f(0.0f, 0.0f, -20.0f), Vec3f(0.2f, 0.2f, 0.2f) }) == false);
+
+	// In front of the quad
+	CHECK(culling.IsVisible(AABB{ Vec3f(0.0f, 0.0f, -3.0f), Vec3f(0.2f, 0.2f, 0.2f) }));
+
+	// Behind the quad, but partially outside of it
+	CHECK(culling.IsVisible(AABB{ Vec3f(4.0f, 0.0f, -20.0f), Vec3f(0.5f, 0.5f, 0.5f) }));
+
+	// Crosses the near plane
+	CHECK(culling.IsVisible(AABB{ Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 1.0f, 1.0f) }));
+
+	CHECK(culling.GetStats().testedCount == 4);
+	CHECK(culling.GetStats().culledCount == 1);
+}
+
+TEST_CASE("SoftwareOcclusionCulling.NearPlaneClipping")
+{
+	SoftwareOcclusionCulling culling(Allocator::GetDefault());
+	culling.BeginFrame(CreateTestViewProjection());
+
+	// Tilted plane that starts behind the camera and crosses the view direction at z = -22.5
+	const Vec3f quad[] = {
+		Vec3f(-50.0f, -10.0f, 5.0f), Vec3f(50.0f, -10.0f, 5.0f),
+		Vec3f(50.0f, 10.0f, -50.0f), Vec3f(-50.0f, 10.0f, -50.0f)
+	};
+	AddTestQuad(culling, quad);
+	culling.Rasterize(nullptr);
+
+	CHECK(culling.GetStats().triangleCount > 2);
+	CHECK(culling.IsVisible(AABB{ Vec3f(0.0f, 0.0f, -80.0f), Vec3f(1.0f, 1.0f, 1.0f) }) == false);
+	CHECK(culling.IsVisible(AABB{ Vec3f(0.0f, 0.0f, -10.0f), Vec3f(1.0f, 1.0f, 1.0f) }));
+}
+
+TEST_CASE("SoftwareOcclusionCulling.JobsMatchSingleThreaded")
+{
+	Allocator* allocator = Allocator::GetDefault();
+
+	const Vec3f quadA[] = {
+		Vec3f(-3.0f, -2.0f, -6.0f), Vec3f(1.0f, -2.0f, -8.0f),
+		Vec3f(1.0f, 2.0f, -8.0f), Vec3f(-3.0f, 2.0f, -6.0f)
+	};
+	const Vec3f quadB[] = {
+		Vec3f(-1.0f, -4.0f, -12.0f), Vec3f(6.0f, -4.0f, -12.0f),
+		Vec3f(6.0f, 1.0f, -10.0f), Vec3f(-1.0f, 1.0f, -10.0f)
+	};
+
+	SoftwareOcclusionCulling singleThreaded(allocator);
+	singleThreaded.BeginFrame(CreateTestViewProjection());
+	AddTestQuad(singleThreaded, quadA);
+	AddTestQuad(singleThreaded, quadB);
+	singleThreaded.Rasterize(nullptr);
+
+	JobSystem jobSystem(allocator, 3);
+	jobSystem.Initialize();
+
+	SoftwareOcclusionCulling multiThreaded(allocator);
+	multiThreaded.BeginFrame(CreateTestViewProjection());
+	AddTestQuad(multiThreaded, quadA);
+	AddTestQuad(multiThreaded, quadB);
+	multiThreaded.Rasterize(&jobSystem);
+
+	jobSystem.Deinitialize();
+
+	Vec2i size = singleThreaded.GetSize();
+	size_t depthBytes = sizeof(float) * size.x * size.y;
+	CHECK(std::memcmp(singleThreaded.GetDepthBuffer(), multiThreaded.GetDepthBuffer(), depthBytes) == 0);
+}
+
+} // namespace kokko
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Core/Array.hpp"
+
+#include "Math/Mat4x4.hpp"
+#include "Math/Vec2.hpp"
+#include "Math/Vec3.hpp"
+#include "Math/Vec4.hpp"
+
+namespace kokko
+{
+
+class Allocator;
+class JobSystem;
+
+struct AABB;
+
+/*
+* Occlusion culling on the CPU using a software rasterizer. Designated occluder meshes
+* are rendered into a low resolution depth buffer and the screen space bounds of other
+* objects are tested against it, so hidden objects never generate draw commands.
+* The depth buffer is split into horizontal bands that are rasterized on worker threads.
+* Depth uses the same reversed range as the renderer, so larger values are closer.
+*/
+class SoftwareOcclusionCulling
+{
+public:
+	static constexpr int DefaultWidth = 256;
+	static constexpr int DefaultHeight = 128;
+
+	struct Stats
+	{
+		uint32_t occluderCount;
+		uint32_t triangleCount;
+		uint32_t testedCount;
+		uint32_t culledCount;
+	};
+
+	// Width must be a multiple of 4
+	SoftwareOcclusionCulling(Allocator* allocator, int width = DefaultWidth, int height = DefaultHeight);
+	~SoftwareOcclusionCulling();
+
+	// Clears the depth buffer, occluders and stats
+	void BeginFrame(const Mat4x4f& viewProjection);
+
+	// Geometry is referenced until Rasterize has been called
+	void AddOccluder(const Mat4x4f& transform, const Vec3f* positions, uint32_t vertexCount,
+		const uint32_t* indices, uint32_t indexCount);
+
+	// Rasterizes all added occluders, on the calling thread if jobSystem is null
+	void Rasterize(JobSystem* jobSystem);
+
+	// Returns false if the bounds are completely hidden behind occluders
+	bool IsVisible(const AABB& bounds);
+
+	bool HasOccluders() const { return occluders.GetCount() != 0; }
+	const Stats& GetStats() const { return stats; }
+
+	Vec2i GetSize() const { return Vec2i(width, height); }
+	const float* GetDepthBuffer() const { return depthBuffer; }
+
+private:
+	static constexpr int BandHeight = 16;
+
+	struct Occluder
+	{
+		Mat4x4f transform;
+		const Vec3f* positions;
+		const uint32_t* indices;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+	};
+
+	// Vertices are in screen space with depth in z, ordered counter-clockwise
+	struct Triangle
+	{
+		Vec3f vertices[3];
+		int minX;
+		int maxX;
+		int minY;
+		int maxY;
+	};
+
+	struct Band
+	{
+		int rowBegin;
+		int rowEnd;
+	};
+
+	void SetupTriangles();
+	void ClipAndAddTriangle(const Vec4f* clipVertices);
+	void AddScreenTriangle(const Vec4f& a, const Vec4f& b, const Vec4f& c);
+	Vec3f ClipToScreen(const Vec4f& clip) const;
+
+	void RasterizeTriangle(const Triangle& triangle, int rowBegin, int rowEnd);
+	static void RasterizeBands(SoftwareOcclusionCulling* culling, Band* bands, size_t count);
+
+	Allocator* allocator;
+
+	int width;
+	int height;
+	float* depthBuffer;
+
+	Mat4x4f viewProjection;
+
+	Array<Occluder> occluders;
+	Array<Triangle> triangles;
+	Array<Vec4f> clipVertices;
+	Array<Band> bands;
+
+	Stats stats;
+};
+
+} // namespace kokko
@@ -19,8 +19,8 @@ UniformTypeInfo::UniformTypeInfo(unsigned int size, unsigned int alignment,
 
 // Must match order with UniformDataType
 const UniformTypeInfo UniformTypeInfo::Types[] = {
-	UniformTypeInfo(4, 4, "", false, true), // Texture2D
-	UniformTypeInfo(4, 4, "", false, true), // TextureCube
+	UniformTypeInfo(8, 8, "sampler2D", false, true), // Texture2D
+	UniformTypeInfo(8, 8, "samplerCube", false, true), // TextureCube
 	UniformTypeInfo(64, 16, "mat4x4", false, false),
 	UniformTypeInfo(64, 16, "mat4x4", true, false),
 	UniformTypeInfo(48, 16, "mat3x3", false, false),
@@ -56,6 +56,7 @@ struct BufferUniform : ShaderUniform
 struct TextureUniform : ShaderUniform
 {
 	int uniformLocation;
+	unsigned int bufferObjectOffset; // Offset of the bindless texture handle in the uniform buffer
 	TextureId textureId;
 	kokko::render::TextureId textureObject;
 };
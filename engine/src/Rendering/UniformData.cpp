@@ -29,6 +29,7 @@ void UniformData::Initialize(const UniformList& from)
 
 	definitions.uniformDataSize = from.uniformDataSize;
 	definitions.uniformBufferSize = from.uniformBufferSize;
+	definitions.textureHandlesInBuffer = from.textureHandlesInBuffer;
 	definitions.bufferUniformCount = from.bufferUniformCount;
 	definitions.textureUniformCount = from.textureUniformCount;
 	definitions.bufferUniforms = nullptr;
@@ -80,6 +81,11 @@ unsigned int UniformData::GetUniformBufferSize() const
 	return definitions.uniformBufferSize;
 }
 
+bool UniformData::HasTextureHandlesInBuffer() const
+{
+	return definitions.textureHandlesInBuffer;
+}
+
 ArrayView<BufferUniform> UniformData::GetBufferUniforms()
 {
 	return ArrayView<BufferUniform>(definitions.bufferUniforms, definitions.bufferUniformCount);
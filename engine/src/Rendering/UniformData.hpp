@@ -27,6 +27,7 @@ public:
 	void Release();
 
 	unsigned int GetUniformBufferSize() const;
+	bool HasTextureHandlesInBuffer() const;
 
 	// Access properties and textures
 
@@ -16,6 +16,9 @@ struct UniformList
 	size_t uniformDataSize = 0; // CPU side
 	unsigned int uniformBufferSize = 0; // GPU side
 
+	// Texture uniforms are sampled using bindless handles stored in the uniform buffer
+	bool textureHandlesInBuffer = false;
+
 	size_t bufferUniformCount = 0;
 	size_t textureUniformCount = 0;
 	BufferUniform* bufferUniforms = nullptr;
@@ -27,6 +27,17 @@ struct VertexAttribute
 	int stride = 0;
 	RenderVertexElemType elemType = RenderVertexElemType::Float;
 
+	// Size of one value of the attribute in bytes
+	unsigned int GetSize() const
+	{
+		switch (elemType)
+		{
+		case RenderVertexElemType::HalfFloat: return elemCount * sizeof(uint16_t);
+		case RenderVertexElemType::Snorm10_10_10_2: return sizeof(uint32_t);
+		default: return elemCount * sizeof(float);
+		}
+	}
+
 	static VertexAttribute pos2;
 	static VertexAttribute pos3;
 	static VertexAttribute pos4;
@@ -68,7 +79,7 @@ struct VertexFormat
 		for (unsigned int i = 0; i < attributeCount; ++i)
 		{
 			attributes[i].offset = size;
-			size += attributes[i].elemCount * sizeof(float);
+			size += attributes[i].GetSize();
 		}
 
 		for (unsigned int i = 0; i < attributeCount; ++i)
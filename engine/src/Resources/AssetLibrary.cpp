@@ -34,6 +34,8 @@ void CreateBaseMetadataJson(rapidjson::Document& document, uint64_t hash, const
 	document.AddMember("uid", uidValue, alloc);	
 }
 
+const char* const TextureCompressionNames[] = { "none", "bc1", "bc3", "bc4", "bc5", "bc7" };
+
 void CreateTextureMetadataJson(rapidjson::Document& document, uint64_t hash, const kokko::Uid& uid,
 	const TextureAssetMetadata& metadata)
 {
@@ -46,6 +48,10 @@ void CreateTextureMetadataJson(rapidjson::Document& document, uint64_t hash, con
 
 	rapidjson::Value linearValue(metadata.preferLinear);
 	document.AddMember("prefer_linear", linearValue, alloc);
+
+	const char* compressionName = TextureCompressionNames[static_cast<size_t>(metadata.compression)];
+	rapidjson::Value compressionValue(rapidjson::StringRef(compressionName));
+	document.AddMember("compression", compressionValue, alloc);
 }
 
 int32_t LoadTextureMetadata(const rapidjson::Document& document, Array<TextureAssetMetadata>& metadataArray)
@@ -60,6 +66,16 @@ int32_t LoadTextureMetadata(const rapidjson::Document& document, Array<TextureAs
 	if (preferLinearItr != document.MemberEnd() && preferLinearItr->value.IsBool())
 		metadata.preferLinear = preferLinearItr->value.GetBool();
 
+	auto compressionItr = document.FindMember("compression");
+	if (compressionItr != document.MemberEnd() && compressionItr->value.IsString())
+	{
+		ConstStringView compressionStr(compressionItr->value.GetString(), compressionItr->value.GetStringLength());
+
+		for (size_t i = 0; i < KOKKO_ARRAY_ITEMS(TextureCompressionNames); ++i)
+			if (compressionStr.ValueEquals(TextureCompressionNames[i]))
+				metadata.compression = static_cast<TextureCompression>(i);
+	}
+
 	int32_t index = static_cast<int32_t>(metadataArray.GetCount());
 	metadataArray.PushBack(metadata);
 	return index;
@@ -39,6 +39,7 @@ public:
 	ConstStringView GetFilename() const { return filename; }
 	Uid GetUid() const { return uid; }
 	AssetType GetType() const { return type; }
+	uint64_t GetContentHash() const { return contentHash; }
 
 private:
 	friend class AssetLibrary;
@@ -15,10 +15,21 @@ enum class AssetType : uint8_t
 	Texture
 };
 
+enum class TextureCompression : uint8_t
+{
+	None,
+	BC1,
+	BC3,
+	BC4,
+	BC5,
+	BC7
+};
+
 struct TextureAssetMetadata
 {
 	bool generateMipmaps = true;
 	bool preferLinear = false;
+	TextureCompression compression = TextureCompression::None;
 };
 
 }
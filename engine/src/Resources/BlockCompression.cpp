@@ -0,0 +1,581 @@
+#include "Resources/BlockCompression.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "doctest/doctest.h"
+
+namespace kokko
+{
+
+namespace BlockCompression
+{
+
+namespace
+{
+
+// Find the principal axis of the pixel values with power iteration.
+// Returns the mean and the minimum and maximum projections along the axis.
+template <size_t ChannelCount>
+void FindPrincipalAxis(const uint8_t* rgbaPixels, float* meanOut, float* axisOut, float& minOut, float& maxOut)
+{
+	float mean[ChannelCount] = {};
+	for (size_t i = 0; i < BlockPixelCount; ++i)
+		for (size_t c = 0; c < ChannelCount; ++c)
+			mean[c] += rgbaPixels[i * 4 + c];
+
+	for (size_t c = 0; c < ChannelCount; ++c)
+		mean[c] *= 1.0f / BlockPixelCount;
+
+	float covariance[ChannelCount][ChannelCount] = {};
+	for (size_t i = 0; i < BlockPixelCount; ++i)
+	{
+		float d[ChannelCount];
+		for (size_t c = 0; c < ChannelCount; ++c)
+			d[c] = rgbaPixels[i * 4 + c] - mean[c];
+
+		for (size_t r = 0; r < ChannelCount; ++r)
+			for (size_t c = 0; c < ChannelCount; ++c)
+				covariance[r][c] += d[r] * d[c];
+	}
+
+	float axis[ChannelCount];
+	for (size_t c = 0; c < ChannelCount; ++c)
+		axis[c] = 1.0f;
+
+	for (int iteration = 0; iteration < 8; ++iteration)
+	{
+		float next[ChannelCount] = {};
+		float largest = 0.0f;
+
+		for (size_t r = 0; r < ChannelCount; ++r)
+		{
+			for (size_t c = 0; c < ChannelCount; ++c)
+				next[r] += covariance[r][c] * axis[c];
+
+			float absValue = next[r] < 0.0f ? -next[r] : next[r];
+			if (absValue > largest)
+				largest = absValue;
+		}
+
+		// All pixels are the same, any axis will do
+		if (largest < 1e-6f)
+			break;
+
+		for (size_t c = 0; c < ChannelCount; ++c)
+			axis[c] = next[c] / largest;
+	}
+
+	float lengthSq = 0.0f;
+	for (size_t c = 0; c < ChannelCount; ++c)
+		lengthSq += axis[c] * axis[c];
+
+	float invLength = 1.0f / std::sqrt(lengthSq);
+	for (size_t c = 0; c < ChannelCount; ++c)
+		axis[c] *= invLength;
+
+	minOut = 0.0f;
+	maxOut = 0.0f;
+
+	for (size_t i = 0; i < BlockPixelCount; ++i)
+	{
+		float t = 0.0f;
+		for (size_t c = 0; c < ChannelCount; ++c)
+			t += (rgbaPixels[i * 4 + c] - mean[c]) * axis[c];
+
+		if (t < minOut)
+			minOut = t;
+		if (t > maxOut)
+			maxOut = t;
+	}
+
+	for (size_t c = 0; c < ChannelCount; ++c)
+	{
+		meanOut[c] = mean[c];
+		axisOut[c] = axis[c];
+	}
+}
+
+int ClampToByte(float value)
+{
+	int rounded = static_cast<int>(value + 0.5f);
+	return rounded < 0 ? 0 : (rounded > 255 ? 255 : rounded);
+}
+
+uint16_t PackRgb565(const int* rgb)
+{
+	uint16_t r = static_cast<uint16_t>((rgb[0] * 31 + 127) / 255);
+	uint16_t g = static_cast<uint16_t>((rgb[1] * 63 + 127) / 255);
+	uint16_t b = static_cast<uint16_t>((rgb[2] * 31 + 127) / 255);
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void UnpackRgb565(uint16_t packed, int* rgbOut)
+{
+	int r = (packed >> 11) & 0x1f;
+	int g = (packed >> 5) & 0x3f;
+	int b = packed & 0x1f;
+	rgbOut[0] = (r << 3) | (r >> 2);
+	rgbOut[1] = (g << 2) | (g >> 4);
+	rgbOut[2] = (b << 3) | (b >> 2);
+}
+
+int ColorDistanceSq(const uint8_t* pixel, const int* color, size_t channelCount)
+{
+	int sum = 0;
+	for (size_t c = 0; c < channelCount; ++c)
+	{
+		int d = pixel[c] - color[c];
+		sum += d * d;
+	}
+	return sum;
+}
+
+void BuildBC1Palette(uint16_t color0, uint16_t color1, int palette[4][3])
+{
+	UnpackRgb565(color0, palette[0]);
+	UnpackRgb565(color1, palette[1]);
+
+	for (size_t c = 0; c < 3; ++c)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+}
+
+// Writes an opaque four-color block. Color 0 is always larger than color 1.
+void EncodeColorBlock(const uint8_t* rgbaPixels, uint8_t* blockOut)
+{
+	float mean[3], axis[3], minT, maxT;
+	FindPrincipalAxis<3>(rgbaPixels, mean, axis, minT, maxT);
+
+	int endpointA[3], endpointB[3];
+	for (size_t c = 0; c < 3; ++c)
+	{
+		endpointA[c] = ClampToByte(mean[c] + axis[c] * maxT);
+		endpointB[c] = ClampToByte(mean[c] + axis[c] * minT);
+	}
+
+	uint16_t color0 = PackRgb565(endpointA);
+	uint16_t color1 = PackRgb565(endpointB);
+
+	if (color0 < color1)
+	{
+		uint16_t temp = color0;
+		color0 = color1;
+		color1 = temp;
+	}
+
+	uint32_t indices = 0;
+
+	if (color0 != color1)
+	{
+		int palette[4][3];
+		BuildBC1Palette(color0, color1, palette);
+
+		for (size_t i = 0; i < BlockPixelCount; ++i)
+		{
+			uint32_t bestIndex = 0;
+			int bestDistance = ColorDistanceSq(&rgbaPixels[i * 4], palette[0], 3);
+
+			for (uint32_t p = 1; p < 4; ++p)
+			{
+				int distance = ColorDistanceSq(&rgbaPixels[i * 4], palette[p], 3);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = p;
+				}
+			}
+
+			indices |= bestIndex << (i * 2);
+		}
+	}
+
+	blockOut[0] = static_cast<uint8_t>(color0 & 0xff);
+	blockOut[1] = static_cast<uint8_t>(color0 >> 8);
+	blockOut[2] = static_cast<uint8_t>(color1 & 0xff);
+	blockOut[3] = static_cast<uint8_t>(color1 >> 8);
+	std::memcpy(&blockOut[4], &indices, sizeof(indices));
+}
+
+void BuildChannelPalette(int value0, int value1, int palette[8])
+{
+	palette[0] = value0;
+	palette[1] = value1;
+
+	// Eight value mode, value0 > value1
+	for (int i = 2; i < 8; ++i)
+		palette[i] = ((8 - i) * value0 + (i - 1) * value1) / 7;
+}
+
+// Writes an eight-value interpolated block for one channel. Used by BC3 alpha, BC4 and BC5.
+void EncodeChannelBlock(const uint8_t* rgbaPixels, size_t channel, uint8_t* blockOut)
+{
+	int minValue = 255;
+	int maxValue = 0;
+
+	for (size_t i = 0; i < BlockPixelCount; ++i)
+	{
+		int value = rgbaPixels[i * 4 + channel];
+		if (value < minValue)
+			minValue = value;
+		if (value > maxValue)
+			maxValue = value;
+	}
+
+	uint64_t indices = 0;
+
+	if (maxValue != minValue)
+	{
+		int palette[8];
+		BuildChannelPalette(maxValue, minValue, palette);
+
+		for (size_t i = 0; i < BlockPixelCount; ++i)
+		{
+			int value = rgbaPixels[i * 4 + channel];
+			uint64_t bestIndex = 0;
+			int bestDistance = 256;
+
+			for (uint64_t p = 0; p < 8; ++p)
+			{
+				int distance = value > palette[p] ? value - palette[p] : palette[p] - value;
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = p;
+				}
+			}
+
+			indices |= bestIndex << (i * 3);
+		}
+	}
+
+	blockOut[0] = static_cast<uint8_t>(maxValue);
+	blockOut[1] = static_cast<uint8_t>(minValue);
+
+	for (size_t i = 0; i < 6; ++i)
+		blockOut[2 + i] = static_cast<uint8_t>((indices >> (i * 8)) & 0xff);
+}
+
+const int BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+void WriteBits(uint8_t* block, size_t& bitOffset, uint32_t value, size_t bitCount)
+{
+	for (size_t i = 0; i < bitCount; ++i, ++bitOffset)
+	{
+		if ((value >> i) & 1)
+			block[bitOffset / 8] |= static_cast<uint8_t>(1 << (bitOffset % 8));
+	}
+}
+
+struct BC7Mode6Endpoints
+{
+	int quantized[2][4]; // 7-bit values
+	int pBit[2];
+};
+
+void BuildBC7Mode6Palette(const BC7Mode6Endpoints& endpoints, int palette[16][4])
+{
+	int expanded[2][4];
+	for (size_t e = 0; e < 2; ++e)
+		for (size_t c = 0; c < 4; ++c)
+			expanded[e][c] = (endpoints.quantized[e][c] << 1) | endpoints.pBit[e];
+
+	for (size_t i = 0; i < 16; ++i)
+	{
+		int w = BC7Weights4[i];
+		for (size_t c = 0; c < 4; ++c)
+			palette[i][c] = ((64 - w) * expanded[0][c] + w * expanded[1][c] + 32) >> 6;
+	}
+}
+
+} // namespace
+
+void EncodeBC1(const uint8_t* rgbaPixels, uint8_t* blockOut)
+{
+	EncodeColorBlock(rgbaPixels, blockOut);
+}
+
+void EncodeBC3(const uint8_t* rgbaPixels, uint8_t* blockOut)
+{
+	EncodeChannelBlock(rgbaPixels, 3, blockOut);
+	EncodeColorBlock(rgbaPixels, blockOut + 8);
+}
+
+void EncodeBC4(const uint8_t* rgbaPixels, uint8_t* blockOut)
+{
+	EncodeChannelBlock(rgbaPixels, 0, blockOut);
+}
+
+void EncodeBC5(const uint8_t* rgbaPixels, uint8_t* blockOut)
+{
+	EncodeChannelBlock(rgbaPixels, 0, blockOut);
+	EncodeChannelBlock(rgbaPixels, 1, blockOut + 8);
+}
+
+void EncodeBC7(const uint8_t* rgbaPixels, uint8_t* blockOut)
+{
+	float mean[4], axis[4], minT, maxT;
+	FindPrincipalAxis<4>(rgbaPixels, mean, axis, minT, maxT);
+
+	float endpointValues[2][4];
+	for (size_t c = 0; c < 4; ++c)
+	{
+		endpointValues[0][c] = mean[c] + axis[c] * minT;
+		endpointValues[1][c] = mean[c] + axis[c] * maxT;
+	}
+
+	BC7Mode6Endpoints bestEndpoints{};
+	uint8_t bestIndices[BlockPixelCount] = {};
+	int bestError = -1;
+
+	// Try every p-bit combination and keep the one with the lowest error
+	for (int pBits = 0; pBits < 4; ++pBits)
+	{
+		BC7Mode6Endpoints endpoints;
+		endpoints.pBit[0] = pBits & 1;
+		endpoints.pBit[1] = (pBits >> 1) & 1;
+
+		for (size_t e = 0; e < 2; ++e)
+		{
+			for (size_t c = 0; c < 4; ++c)
+			{
+				int q = static_cast<int>((endpointValues[e][c] - endpoints.pBit[e]) * 0.5f + 0.5f);
+				endpoints.quantized[e][c] = q < 0 ? 0 : (q > 127 ? 127 : q);
+			}
+		}
+
+		int palette[16][4];
+		BuildBC7Mode6Palette(endpoints, palette);
+
+		uint8_t indices[BlockPixelCount];
+		int totalError = 0;
+
+		for (size_t i = 0; i < BlockPixelCount; ++i)
+		{
+			uint8_t bestIndex = 0;
+			int bestDistance = ColorDistanceSq(&rgbaPixels[i * 4], palette[0], 4);
+
+			for (uint8_t p = 1; p < 16; ++p)
+			{
+				int distance = ColorDistanceSq(&rgbaPixels[i * 4], palette[p], 4);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = p;
+				}
+			}
+
+			indices[i] = bestIndex;
+			totalError += bestDistance;
+		}
+
+		if (bestError < 0 || totalError < bestError)
+		{
+			bestError = totalError;
+			bestEndpoints = endpoints;
+			std::memcpy(bestIndices, indices, sizeof(indices));
+		}
+	}
+
+	// The most significant bit of the anchor index is implicitly zero,
+	// swap the endpoints if the first pixel would need it
+	if (bestIndices[0] & 0x8)
+	{
+		for (size_t c = 0; c < 4; ++c)
+		{
+			int temp = bestEndpoints.quantized[0][c];
+			bestEndpoints.quantized[0][c] = bestEndpoints.quantized[1][c];
+			bestEndpoints.quantized[1][c] = temp;
+		}
+
+		int tempPBit = bestEndpoints.pBit[0];
+		bestEndpoints.pBit[0] = bestEndpoints.pBit[1];
+		bestEndpoints.pBit[1] = tempPBit;
+
+		for (size_t i = 0; i < BlockPixelCount; ++i)
+			bestIndices[i] = static_cast<uint8_t>(15 - bestIndices[i]);
+	}
+
+	std::memset(blockOut, 0, 16);
+	size_t bitOffset = 0;
+
+	WriteBits(blockOut, bitOffset, 1 << 6, 7); // Mode 6
+
+	for (size_t c = 0; c < 4; ++c)
+	{
+		WriteBits(blockOut, bitOffset, bestEndpoints.quantized[0][c], 7);
+		WriteBits(blockOut, bitOffset, bestEndpoints.quantized[1][c], 7);
+	}
+
+	WriteBits(blockOut, bitOffset, bestEndpoints.pBit[0], 1);
+	WriteBits(blockOut, bitOffset, bestEndpoints.pBit[1], 1);
+
+	WriteBits(blockOut, bitOffset, bestIndices[0], 3);
+	for (size_t i = 1; i < BlockPixelCount; ++i)
+		WriteBits(blockOut, bitOffset, bestIndices[i], 4);
+}
+
+namespace
+{
+
+void DecodeBC1(const uint8_t* block, uint8_t* rgbaPixelsOut)
+{
+	uint16_t color0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+	uint16_t color1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+	uint32_t indices;
+	std::memcpy(&indices, &block[4], sizeof(indices));
+
+	int palette[4][3];
+	BuildBC1Palette(color0, color1, palette);
+
+	for (size_t i = 0; i < BlockPixelCount; ++i)
+	{
+		uint32_t index = (indices >> (i * 2)) & 0x3;
+		for (size_t c = 0; c < 3; ++c)
+			rgbaPixelsOut[i * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+		rgbaPixelsOut[i * 4 + 3] = 255;
+	}
+}
+
+void DecodeChannelBlock(const uint8_t* block, size_t channel, uint8_t* rgbaPixelsOut)
+{
+	int palette[8];
+	BuildChannelPalette(block[0], block[1], palette);
+
+	uint64_t indices = 0;
+	for (size_t i = 0; i < 6; ++i)
+		indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+
+	for (size_t i = 0; i < BlockPixelCount; ++i)
+		rgbaPixelsOut[i * 4 + channel] = static_cast<uint8_t>(palette[(indices >> (i * 3)) & 0x7]);
+}
+
+uint32_t ReadBits(const uint8_t* block, size_t& bitOffset, size_t bitCount)
+{
+	uint32_t value = 0;
+	for (size_t i = 0; i < bitCount; ++i, ++bitOffset)
+		value |= ((block[bitOffset / 8] >> (bitOffset % 8)) & 1) << i;
+	return value;
+}
+
+void DecodeBC7Mode6(const uint8_t* block, uint8_t* rgbaPixelsOut)
+{
+	size_t bitOffset = 0;
+	CHECK(ReadBits(block, bitOffset, 7) == (1 << 6));
+
+	BC7Mode6Endpoints endpoints;
+	for (size_t c = 0; c < 4; ++c)
+	{
+		endpoints.quantized[0][c] = ReadBits(block, bitOffset, 7);
+		endpoints.quantized[1][c] = ReadBits(block, bitOffset, 7);
+	}
+
+	endpoints.pBit[0] = ReadBits(block, bitOffset, 1);
+	endpoints.pBit[1] = ReadBits(block, bitOffset, 1);
+
+	int palette[16][4];
+	BuildBC7Mode6Palette(endpoints, palette);
+
+	for (size_t i = 0; i < BlockPixelCount; ++i)
+	{
+		uint32_t index = ReadBits(block, bitOffset, i == 0 ? 3 : 4);
+		for (size_t c = 0; c < 4; ++c)
+			rgbaPixelsOut[i * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+	}
+}
+
+void CreateGradientBlock(uint8_t* rgbaPixelsOut)
+{
+	// Values lie on a line in color space, as is typical for a smooth block
+	for (size_t i = 0; i < BlockPixelCount; ++i)
+	{
+		uint8_t* pixel = &rgbaPixelsOut[i * 4];
+		pixel[0] = static_cast<uint8_t>(40 + i * 12);
+		pixel[1] = static_cast<uint8_t>(200 - i * 8);
+		pixel[2] = static_cast<uint8_t>(90 + i * 4);
+		pixel[3] = static_cast<uint8_t>(255 - i * 10);
+	}
+}
+
+int MaxChannelError(const uint8_t* a, const uint8_t* b, size_t firstChannel, size_t channelCount)
+{
+	int maxError = 0;
+	for (size_t i = 0; i < BlockPixelCount; ++i)
+	{
+		for (size_t c = firstChannel; c < firstChannel + channelCount; ++c)
+		{
+			int d = a[i * 4 + c] - b[i * 4 + c];
+			d = d < 0 ? -d : d;
+			if (d > maxError)
+				maxError = d;
+		}
+	}
+	return maxError;
+}
+
+} // namespace
+
+TEST_CASE("BlockCompression.BC1")
+{
+	uint8_t source[BlockPixelCount * 4];
+	uint8_t decoded[BlockPixelCount * 4];
+	uint8_t block[8];
+
+	CreateGradientBlock(source);
+	EncodeBC1(source, block);
+	DecodeBC1(block, decoded);
+	CHECK(MaxChannelError(source, decoded, 0, 3) <= 32);
+
+	std::memset(source, 128, sizeof(source));
+	EncodeBC1(source, block);
+	DecodeBC1(block, decoded);
+	CHECK(MaxChannelError(source, decoded, 0, 3) <= 4);
+}
+
+TEST_CASE("BlockCompression.BC4AndBC5")
+{
+	uint8_t source[BlockPixelCount * 4];
+	uint8_t decoded[BlockPixelCount * 4] = {};
+	uint8_t block[16];
+
+	CreateGradientBlock(source);
+
+	EncodeBC4(source, block);
+	DecodeChannelBlock(block, 0, decoded);
+	CHECK(MaxChannelError(source, decoded, 0, 1) <= 16);
+
+	EncodeBC5(source, block);
+	DecodeChannelBlock(block, 0, decoded);
+	DecodeChannelBlock(block + 8, 1, decoded);
+	CHECK(MaxChannelError(source, decoded, 0, 2) <= 16);
+}
+
+TEST_CASE("BlockCompression.BC7")
+{
+	uint8_t source[BlockPixelCount * 4];
+	uint8_t decoded[BlockPixelCount * 4];
+	uint8_t block[16];
+
+	CreateGradientBlock(source);
+	EncodeBC7(source, block);
+	DecodeBC7Mode6(block, decoded);
+	CHECK(MaxChannelError(source, decoded, 0, 4) <= 4);
+
+	for (size_t i = 0; i < BlockPixelCount; ++i)
+	{
+		source[i * 4 + 0] = 10;
+		source[i * 4 + 1] = 250;
+		source[i * 4 + 2] = 77;
+		source[i * 4 + 3] = 255;
+	}
+
+	EncodeBC7(source, block);
+	DecodeBC7Mode6(block, decoded);
+	CHECK(MaxChannelError(source, decoded, 0, 4) <= 1);
+}
+
+} // namespace BlockCompression
+
+} // namespace kokko
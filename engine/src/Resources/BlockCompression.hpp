@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kokko
+{
+
+// CPU encoders for GPU block-compressed texture formats.
+// All functions take one 4x4 block of RGBA8 pixels (64 bytes, row-major)
+// and write the compressed block to the output pointer.
+
+namespace BlockCompression
+{
+
+static const size_t BlockWidth = 4;
+static const size_t BlockPixelCount = 16;
+
+// RGB color, alpha is ignored. Writes 8 bytes.
+void EncodeBC1(const uint8_t* rgbaPixels, uint8_t* blockOut);
+
+// RGB color with interpolated alpha. Writes 16 bytes.
+void EncodeBC3(const uint8_t* rgbaPixels, uint8_t* blockOut);
+
+// Single channel, uses the red channel. Writes 8 bytes.
+void EncodeBC4(const uint8_t* rgbaPixels, uint8_t* blockOut);
+
+// Two channels, uses the red and green channels. Writes 16 bytes.
+void EncodeBC5(const uint8_t* rgbaPixels, uint8_t* blockOut);
+
+// RGBA color with a single subset (mode 6). Writes 16 bytes.
+void EncodeBC7(const uint8_t* rgbaPixels, uint8_t* blockOut);
+
+} // namespace BlockCompression
+
+} // namespace kokko
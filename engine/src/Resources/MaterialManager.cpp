@@ -1,6 +1,7 @@
 #include "Resources/MaterialManager.hpp"
 
 #include <cassert>
+#include <cstring>
 
 #include "rapidjson/document.h"
 
@@ -9,6 +10,8 @@
 
 #include "Engine/Engine.hpp"
 
+#include "Math/Math.hpp"
+
 #include "Memory/Allocator.hpp"
 
 #include "Rendering/RenderDevice.hpp"
@@ -25,6 +28,24 @@ namespace kokko
 
 const MaterialId MaterialId::Null = MaterialId{ 0 };
 
+namespace
+{
+constexpr size_t InitialUniformArenaSize = 64 * 1024;
+}
+
+MaterialManager::UniformArena::UniformArena(Allocator* allocator) :
+	bufferId(),
+	capacity(0),
+	used(0),
+	alignment(0),
+	staging(allocator),
+	freeRanges(allocator),
+	dirtyMaterials(allocator),
+	uploadBegin(0),
+	uploadEnd(0)
+{
+}
+
 MaterialManager::MaterialManager(
 	Allocator* allocator,
 	kokko::AssetLoader* assetLoader,
@@ -36,7 +57,8 @@ MaterialManager::MaterialManager(
 	renderDevice(renderDevice),
 	shaderManager(shaderManager),
 	textureManager(textureManager),
-	uidMap(allocator)
+	uidMap(allocator),
+	uniformArena(allocator)
 {
 	data = InstanceData{};
 	data.count = 1; // Reserve index 0 as Null instance
@@ -53,6 +75,9 @@ MaterialManager::~MaterialManager()
 		data.material[i].uniformData.Release();
 	}
 
+	if (uniformArena.bufferId != 0)
+		renderDevice->DestroyBuffers(1, &uniformArena.bufferId);
+
 	allocator->Deallocate(data.buffer);
 }
 
@@ -95,6 +120,8 @@ MaterialId MaterialManager::CreateMaterial()
 
 		// If there are no freelist entries, first <objectCount> indices must be in use
 		id.i = data.count;
+
+		assert(id.i < MaxMaterialCount);
 	}
 	else
 	{
@@ -106,7 +133,9 @@ MaterialId MaterialManager::CreateMaterial()
 	data.material[id.i].transparency = TransparencyType::Opaque;
 	data.material[id.i].shaderId = ShaderId{};
 	data.material[id.i].cachedShaderDeviceId = kokko::render::ShaderId();
-	data.material[id.i].uniformBufferObject = kokko::render::BufferId();
+	data.material[id.i].uniformBlockOffset = 0;
+	data.material[id.i].uniformBlockSize = 0;
+	data.material[id.i].uniformsDirty = false;
 	data.material[id.i].uniformData = kokko::UniformData(allocator);
 
 	++data.count;
@@ -122,6 +151,7 @@ void MaterialManager::RemoveMaterial(MaterialId id)
 	if (mapPair != nullptr)
 		uidMap.Remove(mapPair);
 
+	ReleaseUniformBlock(data.material[id.i]);
 	data.material[id.i].uniformData.Release();
 
 	// Material isn't the last one
@@ -190,6 +220,31 @@ MaterialId MaterialManager::FindMaterialByPath(kokko::ConstStringView path)
 	return MaterialId::Null;
 }
 
+void MaterialManager::FindMaterialsByPath(ArrayView<const kokko::ConstStringView> paths, MaterialId* idsOut)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	Array<uint8_t> file(allocator);
+	kokko::MaterialSerializer serializer(allocator, this, shaderManager, textureManager);
+
+	for (const kokko::ConstStringView& path : paths)
+	{
+		auto uidResult = assetLoader->GetAssetUidByVirtualPath(path);
+		if (uidResult.HasValue() == false || uidMap.Lookup(uidResult.GetValue()) != nullptr)
+			continue;
+
+		file.Clear();
+		if (assetLoader->LoadAsset(uidResult.GetValue(), file).success)
+		{
+			kokko::ConstStringView fileStr(reinterpret_cast<const char*>(file.GetData()), file.GetCount());
+			serializer.StartShaderLoad(fileStr);
+		}
+	}
+
+	for (size_t i = 0, count = paths.GetCount(); i < count; ++i)
+		idsOut[i] = FindMaterialByPath(paths[i]);
+}
+
 kokko::Uid MaterialManager::GetMaterialUid(MaterialId id) const
 {
 	return data.material[id.i].uid;
@@ -218,8 +273,7 @@ void MaterialManager::SetMaterialShader(MaterialId id, ShaderId shaderId)
 
 	MaterialData& material = data.material[id.i];
 
-	if (material.uniformBufferObject != 0)
-		renderDevice->DestroyBuffers(1, &material.uniformBufferObject);
+	ReleaseUniformBlock(material);
 
 	if (shaderId == ShaderId::Null)
 	{
@@ -238,43 +292,189 @@ void MaterialManager::SetMaterialShader(MaterialId id, ShaderId shaderId)
 
 	material.uniformData.Initialize(shader.uniforms);
 
-	if (material.uniformData.GetBufferUniforms().GetCount() > 0)
+	if (material.uniformData.GetUniformBufferSize() > 0)
 	{
-		// Create GPU uniform buffer and allocate storage
+		// Reserve the material's range from the shared uniform buffer
+
+		size_t blockSize = material.uniformData.GetUniformBufferSize();
+		material.uniformBlockOffset = AllocateUniformBlock(blockSize);
+		material.uniformBlockSize = Math::RoundUpToMultiple(blockSize, uniformArena.alignment);
 
-		renderDevice->CreateBuffers(1, &material.uniformBufferObject);
-		renderDevice->SetBufferStorage(material.uniformBufferObject, material.uniformData.GetUniformBufferSize(),
-			nullptr, BufferStorageFlags::Dynamic);
+		MarkUniformsDirty(id);
 	}
 }
 
-void MaterialManager::UpdateUniformsToGPU(MaterialId id)
+void MaterialManager::MarkUniformsDirty(MaterialId id)
+{
+	MaterialData& material = data.material[id.i];
+
+	if (material.uniformBlockSize == 0 || material.uniformsDirty)
+		return;
+
+	material.uniformsDirty = true;
+	uniformArena.dirtyMaterials.PushBack(id);
+}
+
+void MaterialManager::UploadDirtyUniforms()
 {
 	KOKKO_PROFILE_FUNCTION();
-	
-	const MaterialData& material = data.material[id.i];
-	const kokko::UniformData& uniforms = material.uniformData;
 
-	unsigned int uniformBufferSize = uniforms.GetUniformBufferSize();
+	UniformArena& arena = uniformArena;
 
-	// Update uniform buffer object on the GPU
-	if (uniformBufferSize > 0)
+	for (MaterialId id : arena.dirtyMaterials)
 	{
-		static const size_t stackBufferSize = 2048;
-		unsigned char stackBuffer[stackBufferSize];
-		unsigned char* uniformBuffer = nullptr;
+		MaterialData& material = data.material[id.i];
+
+		// Material might have been removed after it was marked dirty
+		if (material.uniformsDirty == false)
+			continue;
+
+		uint8_t* block = arena.staging.GetData() + material.uniformBlockOffset;
+		material.uniformData.WriteToUniformBuffer(block);
+		material.uniformsDirty = false;
+
+		if (material.uniformData.HasTextureHandlesInBuffer())
+		{
+			for (const TextureUniform& uniform : material.uniformData.GetTextureUniforms())
+			{
+				uint64_t handle = renderDevice->GetResidentTextureHandle(uniform.textureObject);
+				std::memcpy(block + uniform.bufferObjectOffset, &handle, sizeof(handle));
+			}
+		}
+
+		size_t blockEnd = material.uniformBlockOffset + material.uniformBlockSize;
 
-		if (uniformBufferSize <= stackBufferSize)
-			uniformBuffer = stackBuffer;
+		if (arena.uploadBegin == arena.uploadEnd)
+		{
+			arena.uploadBegin = material.uniformBlockOffset;
+			arena.uploadEnd = blockEnd;
+		}
 		else
-			uniformBuffer = static_cast<unsigned char*>(allocator->Allocate(uniformBufferSize, "MaterialManager.UpdateUniformsToGPU() uniformBuffer"));
+		{
+			arena.uploadBegin = material.uniformBlockOffset < arena.uploadBegin ? material.uniformBlockOffset : arena.uploadBegin;
+			arena.uploadEnd = blockEnd > arena.uploadEnd ? blockEnd : arena.uploadEnd;
+		}
+	}
+
+	arena.dirtyMaterials.Clear();
 
-		uniforms.WriteToUniformBuffer(uniformBuffer);
+	if (arena.uploadBegin != arena.uploadEnd)
+	{
+		renderDevice->SetBufferSubData(arena.bufferId, static_cast<unsigned int>(arena.uploadBegin),
+			static_cast<unsigned int>(arena.uploadEnd - arena.uploadBegin), arena.staging.GetData() + arena.uploadBegin);
 
-		renderDevice->SetBufferSubData(material.uniformBufferObject, 0, uniformBufferSize, uniformBuffer);
+		arena.uploadBegin = 0;
+		arena.uploadEnd = 0;
+	}
+}
 
-		if (uniformBuffer != stackBuffer)
-			allocator->Deallocate(uniformBuffer);
+size_t MaterialManager::AllocateUniformBlock(size_t size)
+{
+	UniformArena& arena = uniformArena;
+
+	if (arena.alignment == 0)
+	{
+		int alignment = 0;
+		renderDevice->GetIntegerValue(RenderDeviceParameter::UniformBufferOffsetAlignment, &alignment);
+		arena.alignment = alignment > 0 ? static_cast<size_t>(alignment) : 256;
+	}
+
+	size = Math::RoundUpToMultiple(size, arena.alignment);
+
+	// First fit from released blocks
+	for (size_t i = 0, count = arena.freeRanges.GetCount(); i < count; ++i)
+	{
+		UniformBlockRange& range = arena.freeRanges[i];
+		if (range.size >= size)
+		{
+			size_t offset = range.offset;
+			range.offset += size;
+			range.size -= size;
+
+			if (range.size == 0)
+				arena.freeRanges.Remove(i);
+
+			return offset;
+		}
+	}
+
+	if (arena.used + size > arena.capacity)
+		GrowUniformArena(arena.used + size);
+
+	size_t offset = arena.used;
+	arena.used += size;
+
+	return offset;
+}
+
+void MaterialManager::ReleaseUniformBlock(MaterialData& material)
+{
+	if (material.uniformBlockSize == 0)
+		return;
+
+	UniformArena& arena = uniformArena;
+	UniformBlockRange block{ material.uniformBlockOffset, material.uniformBlockSize };
+
+	material.uniformBlockOffset = 0;
+	material.uniformBlockSize = 0;
+	material.uniformsDirty = false;
+
+	// Keep free ranges sorted by offset and merge neighbours
+	size_t index = 0;
+	size_t count = arena.freeRanges.GetCount();
+	while (index < count && arena.freeRanges[index].offset < block.offset)
+		index += 1;
+
+	if (index > 0)
+	{
+		UniformBlockRange& previous = arena.freeRanges[index - 1];
+		if (previous.offset + previous.size == block.offset)
+		{
+			block.offset = previous.offset;
+			block.size += previous.size;
+			arena.freeRanges.Remove(index - 1);
+			index -= 1;
+			count -= 1;
+		}
+	}
+
+	if (index < count)
+	{
+		UniformBlockRange& next = arena.freeRanges[index];
+		if (block.offset + block.size == next.offset)
+		{
+			block.size += next.size;
+			arena.freeRanges.Remove(index);
+		}
+	}
+
+	arena.freeRanges.Insert(index, block);
+}
+
+void MaterialManager::GrowUniformArena(size_t required)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	UniformArena& arena = uniformArena;
+
+	size_t newCapacity = arena.capacity > 0 ? arena.capacity : InitialUniformArenaSize;
+	while (newCapacity < required)
+		newCapacity *= 2;
+
+	if (arena.bufferId != 0)
+		renderDevice->DestroyBuffers(1, &arena.bufferId);
+
+	renderDevice->CreateBuffers(1, &arena.bufferId);
+	renderDevice->SetBufferStorage(arena.bufferId, static_cast<unsigned int>(newCapacity), nullptr, BufferStorageFlags::Dynamic);
+
+	arena.staging.Resize(newCapacity);
+	arena.capacity = newCapacity;
+
+	// The new buffer has no contents, upload everything that has been written so far
+	if (arena.used > 0)
+	{
+		arena.uploadBegin = 0;
+		arena.uploadEnd = arena.used;
 	}
 }
 
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #include "Core/Array.hpp"
+#include "Core/ArrayView.hpp"
 #include "Core/HashMap.hpp"
 #include "Core/StringView.hpp"
 #include "Core/Uid.hpp"
@@ -36,11 +38,40 @@ private:
 		ShaderId shaderId;
 		kokko::render::ShaderId cachedShaderDeviceId;
 
-		kokko::render::BufferId uniformBufferObject;
+		// Range of the material's uniform block in the shared uniform buffer
+		size_t uniformBlockOffset;
+		size_t uniformBlockSize;
+		bool uniformsDirty;
 
 		kokko::UniformData uniformData;
 	};
 
+	struct UniformBlockRange
+	{
+		size_t offset;
+		size_t size;
+	};
+
+	// All material uniform blocks are sub-allocated from one buffer.
+	// The staging buffer mirrors the buffer contents on the CPU.
+	struct UniformArena
+	{
+		explicit UniformArena(Allocator* allocator);
+
+		kokko::render::BufferId bufferId;
+		size_t capacity;
+		size_t used;
+		size_t alignment;
+
+		Array<uint8_t> staging;
+		Array<UniformBlockRange> freeRanges;
+		Array<MaterialId> dirtyMaterials;
+
+		// Range of the staging buffer that needs to be uploaded
+		size_t uploadBegin;
+		size_t uploadEnd;
+	};
+
 	Allocator* allocator;
 	kokko::AssetLoader* assetLoader;
 	kokko::render::Device* renderDevice;
@@ -61,11 +92,20 @@ private:
 	unsigned int freeListFirst;
 	HashMap<kokko::Uid, MaterialId> uidMap;
 
+	UniformArena uniformArena;
+
 	void Reallocate(unsigned int required);
 
+	size_t AllocateUniformBlock(size_t size);
+	void ReleaseUniformBlock(MaterialData& material);
+	void GrowUniformArena(size_t required);
+
 	friend class kokko::MaterialSerializer;
 
 public:
+	// Material ids are packed into 16 bits of render command keys, and the largest value is reserved
+	static const unsigned int MaxMaterialCount = (1 << 16) - 1;
+
 	MaterialManager(
 		Allocator* allocator,
 		kokko::AssetLoader* assetLoader,
@@ -81,6 +121,9 @@ public:
 	MaterialId FindMaterialByUid(const kokko::Uid& uid);
 	MaterialId FindMaterialByPath(kokko::ConstStringView path);
 
+	// Starts compiling the shaders of all materials before waiting for any of them
+	void FindMaterialsByPath(ArrayView<const kokko::ConstStringView> paths, MaterialId* idsOut);
+
 	kokko::Uid GetMaterialUid(MaterialId id) const;
 
 	TransparencyType GetMaterialTransparency(MaterialId id) const;
@@ -96,10 +139,18 @@ public:
 
 	kokko::render::ShaderId GetMaterialShaderDeviceId(MaterialId id) const
 	{ return data.material[id.i].cachedShaderDeviceId; }
-	kokko::render::BufferId GetMaterialUniformBufferId(MaterialId id) const
-	{ return data.material[id.i].uniformBufferObject; }
-
-	void UpdateUniformsToGPU(MaterialId id);
+	kokko::render::BufferId GetUniformBufferId() const
+	{ return uniformArena.bufferId; }
+	size_t GetMaterialUniformBlockOffset(MaterialId id) const
+	{ return data.material[id.i].uniformBlockOffset; }
+	size_t GetMaterialUniformBlockSize(MaterialId id) const
+	{ return data.material[id.i].uniformBlockSize; }
+
+	// Queues the material's uniform block to be uploaded by UploadDirtyUniforms
+	void MarkUniformsDirty(MaterialId id);
+
+	// Uploads all queued uniform blocks with a single buffer update
+	void UploadDirtyUniforms();
 };
 
 } // namespace kokko
@@ -45,6 +45,21 @@ const rapidjson::Value* FindVariableValue(const rapidjson::Value& variablesArray
 	return nullptr;
 }
 
+// Starts loading the shader referenced by the material, returns ShaderId::Null if there is none
+kokko::ShaderId FindMaterialShader(kokko::ShaderManager* shaderManager, const rapidjson::Document& doc)
+{
+	rapidjson::Value::ConstMemberIterator shaderItr = doc.FindMember("shader");
+	if (shaderItr == doc.MemberEnd() || shaderItr->value.IsString() == false)
+		return kokko::ShaderId::Null;
+
+	auto uidResult = kokko::Uid::FromString(
+		kokko::ArrayView(shaderItr->value.GetString(), shaderItr->value.GetStringLength()));
+	if (uidResult.HasValue() == false)
+		return kokko::ShaderId::Null;
+
+	return shaderManager->FindShaderByUid(uidResult.GetValue());
+}
+
 } // Anonymous namespace
 
 namespace kokko
@@ -66,6 +81,16 @@ MaterialSerializer::~MaterialSerializer()
 {
 }
 
+void MaterialSerializer::StartShaderLoad(ConstStringView config)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	rapidjson::Document doc;
+	doc.Parse(config.str, config.len);
+
+	FindMaterialShader(shaderManager, doc);
+}
+
 bool MaterialSerializer::DeserializeMaterial(MaterialId id, ConstStringView config)
 {
 	KOKKO_PROFILE_FUNCTION();
@@ -80,14 +105,8 @@ bool MaterialSerializer::DeserializeMaterial(MaterialId id, ConstStringView conf
 	if (shaderItr == doc.MemberEnd() || shaderItr->value.IsString() == false)
 		return false;
 
-	ShaderId shaderId = ShaderId::Null;
-
-	auto uidResult = Uid::FromString(ArrayView(shaderItr->value.GetString(), shaderItr->value.GetStringLength()));
-	if (uidResult.HasValue())
-	{
-		Uid shaderUid = uidResult.GetValue();
-		shaderId = shaderManager->FindShaderByUid(shaderUid);
-	}
+	// Materials can't use a shader that failed to compile
+	ShaderId shaderId = shaderManager->WaitForShader(FindMaterialShader(shaderManager, doc));
 
 	// This initializes material uniforms from the shader's data
 	materialManager->SetMaterialShader(id, shaderId);
@@ -151,7 +170,7 @@ bool MaterialSerializer::DeserializeMaterial(MaterialId id, ConstStringView conf
 		uniform.textureObject = texture.textureObjectId;
 	}
 
-	materialManager->UpdateUniformsToGPU(id);
+	materialManager->MarkUniformsDirty(id);
 
 	return true;
 }
@@ -23,6 +23,9 @@ public:
 		TextureManager* textureManager);
 	~MaterialSerializer();
 
+	// Starts compiling the shader of the material without waiting for it
+	void StartShaderLoad(ConstStringView config);
+
 	bool DeserializeMaterial(MaterialId id, ConstStringView config);
 	void SerializeToString(MaterialId id, String& out);
 
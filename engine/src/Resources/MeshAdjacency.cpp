@@ -0,0 +1,67 @@
+#include "Resources/MeshAdjacency.hpp"
+
+#include <cstring>
+
+#include "doctest/doctest.h"
+
+namespace kokko
+{
+
+void BuildVertexTriangleAdjacency(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount,
+	Array<uint32_t>& offsetsOut, Array<uint32_t>& trianglesOut)
+{
+	offsetsOut.Resize(vertexCount + 1);
+	uint32_t* offsets = offsetsOut.GetData();
+	std::memset(offsets, 0, sizeof(uint32_t) * (vertexCount + 1));
+
+	for (uint32_t i = 0; i < indexCount; ++i)
+		offsets[indices[i]] += 1;
+
+	uint32_t start = 0;
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		uint32_t count = offsets[v];
+		offsets[v] = start;
+		start += count;
+	}
+
+	trianglesOut.Resize(indexCount);
+
+	// Offsets are advanced while filling, after which each one points to the start of the next vertex
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t vertex = indices[i];
+		trianglesOut[offsets[vertex]] = i / 3;
+		offsets[vertex] += 1;
+	}
+
+	for (uint32_t v = vertexCount; v > 0; --v)
+		offsets[v] = offsets[v - 1];
+
+	offsets[0] = 0;
+}
+
+TEST_CASE("MeshAdjacency.BuildVertexTriangleAdjacency")
+{
+	// Two triangles sharing the edge 1-2, vertex 4 is unused
+	const uint32_t indices[] = { 0, 1, 2, 2, 1, 3 };
+
+	Allocator* allocator = Allocator::GetDefault();
+	Array<uint32_t> offsets(allocator);
+	Array<uint32_t> triangles(allocator);
+	BuildVertexTriangleAdjacency(indices, 6, 5, offsets, triangles);
+
+	const uint32_t expectedOffsets[] = { 0, 1, 3, 5, 6, 6 };
+	const uint32_t expectedTriangles[] = { 0, 0, 1, 0, 1, 1 };
+
+	REQUIRE(offsets.GetCount() == 6);
+	REQUIRE(triangles.GetCount() == 6);
+
+	for (uint32_t i = 0; i < 6; ++i)
+		CHECK(offsets[i] == expectedOffsets[i]);
+
+	for (uint32_t i = 0; i < 6; ++i)
+		CHECK(triangles[i] == expectedTriangles[i]);
+}
+
+} // namespace kokko
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Core/Array.hpp"
+
+namespace kokko
+{
+
+// Lists the triangles around each vertex of an indexed triangle list. The triangles of
+// vertex v are trianglesOut[offsetsOut[v]] up to trianglesOut[offsetsOut[v + 1]], so
+// offsetsOut has vertexCount + 1 items.
+void BuildVertexTriangleAdjacency(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount,
+	Array<uint32_t>& offsetsOut, Array<uint32_t>& trianglesOut);
+
+} // namespace kokko
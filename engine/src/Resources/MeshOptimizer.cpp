@@ -0,0 +1,458 @@
+#include "Resources/MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "doctest/doctest.h"
+
+#include "Core/Core.hpp"
+#include "Core/Sort.hpp"
+
+#include "Resources/MeshAdjacency.hpp"
+
+namespace kokko
+{
+
+namespace
+{
+
+// Splitting clusters for overdraw may make the cache order this much worse
+constexpr float OverdrawAcmrTolerance = 1.05f;
+
+// Maps floats to integers that sort in the same order
+uint32_t FloatSortBits(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return (bits & 0x80000000u) != 0 ? ~bits : bits | 0x80000000u;
+}
+
+} // namespace
+
+MeshOptimizer::MeshOptimizer(Allocator* allocator) :
+	allocator(allocator),
+	adjacencyOffsets(allocator),
+	adjacencyTriangles(allocator),
+	liveTriangles(allocator),
+	cacheTimes(allocator),
+	emitted(allocator),
+	deadEnds(allocator),
+	candidates(allocator),
+	hardBoundaries(allocator),
+	clusters(allocator),
+	clusterSortBuffer(allocator),
+	clusterCenters(allocator),
+	clusterNormals(allocator)
+{
+}
+
+void MeshOptimizer::OptimizeTriangleOrder(const Vec3f* positions, uint32_t vertexCount,
+	const uint32_t* indices, uint32_t indexCount, uint32_t* indicesOut, uint32_t cacheSize)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	assert(indexCount % 3 == 0);
+	assert(indices != indicesOut);
+
+	if (indexCount == 0 || vertexCount == 0)
+		return;
+
+	OptimizeCache(indices, indexCount, vertexCount, indicesOut, cacheSize);
+
+	if (positions == nullptr)
+		return;
+
+	SplitClusters(indicesOut, indexCount, vertexCount, cacheSize);
+
+	if (clusters.GetCount() < 2)
+		return;
+
+	SortClusters(positions, indicesOut);
+
+	// Gather the triangles of the sorted clusters into the output
+
+	Array<uint32_t>& scratch = adjacencyTriangles;
+	scratch.Resize(indexCount);
+	std::memcpy(scratch.GetData(), indicesOut, sizeof(uint32_t) * indexCount);
+
+	uint32_t outputCount = 0;
+	for (const Cluster& cluster : clusters)
+	{
+		uint32_t count = (cluster.triangleEnd - cluster.triangleBegin) * 3;
+		std::memcpy(indicesOut + outputCount, scratch.GetData() + cluster.triangleBegin * 3, sizeof(uint32_t) * count);
+		outputCount += count;
+	}
+
+	assert(outputCount == indexCount);
+}
+
+uint32_t MeshOptimizer::OptimizeVertexOrder(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount,
+	uint32_t* remapOut)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	for (uint32_t v = 0; v < vertexCount; ++v)
+		remapOut[v] = UnusedVertex;
+
+	uint32_t usedCount = 0;
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t& remapped = remapOut[indices[i]];
+		if (remapped == UnusedVertex)
+		{
+			remapped = usedCount;
+			usedCount += 1;
+		}
+
+		indices[i] = remapped;
+	}
+
+	return usedCount;
+}
+
+float MeshOptimizer::CalculateAcmr(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount,
+	uint32_t cacheSize)
+{
+	if (indexCount < 3)
+		return 0.0f;
+
+	// A vertex is in the cache if fewer than cacheSize misses have happened since it was loaded
+	cacheTimes.Resize(vertexCount);
+	std::memset(cacheTimes.GetData(), 0, sizeof(uint32_t) * vertexCount);
+
+	uint32_t time = cacheSize;
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t vertex = indices[i];
+		if (time - cacheTimes[vertex] >= cacheSize)
+		{
+			cacheTimes[vertex] = time;
+			time += 1;
+		}
+	}
+
+	return static_cast<float>(time - cacheSize) / (indexCount / 3);
+}
+
+void MeshOptimizer::OptimizeCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount,
+	uint32_t* indicesOut, uint32_t cacheSize)
+{
+	// Tipsify: Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+
+	const uint32_t triangleCount = indexCount / 3;
+
+	BuildVertexTriangleAdjacency(indices, indexCount, vertexCount, adjacencyOffsets, adjacencyTriangles);
+
+	liveTriangles.Resize(vertexCount);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+		liveTriangles[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+
+	cacheTimes.Resize(vertexCount);
+	std::memset(cacheTimes.GetData(), 0, sizeof(uint32_t) * vertexCount);
+
+	emitted.Resize(triangleCount);
+	std::memset(emitted.GetData(), 0, triangleCount);
+
+	deadEnds.Clear();
+	candidates.Clear();
+	hardBoundaries.Clear();
+	scanCursor = 0;
+
+	uint32_t time = cacheSize + 1;
+	uint32_t outputCount = 0;
+
+	// Fan out triangles around one vertex at a time and continue from a vertex still in the cache
+
+	int64_t fanVertex = GetNextVertex(vertexCount, cacheSize, time, 0);
+	while (fanVertex >= 0)
+	{
+		candidates.Clear();
+
+		const uint32_t adjacencyEnd = adjacencyOffsets[fanVertex + 1];
+		for (uint32_t adj = adjacencyOffsets[fanVertex]; adj < adjacencyEnd; ++adj)
+		{
+			uint32_t triangle = adjacencyTriangles[adj];
+			if (emitted[triangle] != 0)
+				continue;
+
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				uint32_t vertex = indices[triangle * 3 + corner];
+				indicesOut[outputCount++] = vertex;
+
+				deadEnds.PushBack(vertex);
+				candidates.PushBack(vertex);
+				liveTriangles[vertex] -= 1;
+
+				if (time - cacheTimes[vertex] > cacheSize)
+				{
+					cacheTimes[vertex] = time;
+					time += 1;
+				}
+			}
+
+			emitted[triangle] = 1;
+		}
+
+		fanVertex = GetNextVertex(vertexCount, cacheSize, time, outputCount / 3);
+	}
+
+	assert(outputCount == indexCount);
+}
+
+int64_t MeshOptimizer::GetNextVertex(uint32_t vertexCount, uint32_t cacheSize, uint32_t time,
+	uint32_t emittedTriangles)
+{
+	// Prefer the candidate that stays in the cache the longest after its remaining triangles are emitted
+
+	int64_t best = -1;
+	int64_t bestPriority = -1;
+
+	for (uint32_t vertex : candidates)
+	{
+		if (liveTriangles[vertex] == 0)
+			continue;
+
+		int64_t priority = 0;
+		uint32_t age = time - cacheTimes[vertex];
+		if (age + 2 * liveTriangles[vertex] <= cacheSize)
+			priority = age;
+
+		if (priority > bestPriority)
+		{
+			bestPriority = priority;
+			best = vertex;
+		}
+	}
+
+	if (best >= 0)
+		return best;
+
+	// Dead end, use the most recently used vertex that still has triangles left
+	while (deadEnds.GetCount() != 0)
+	{
+		uint32_t vertex = deadEnds.GetBack();
+		deadEnds.PopBack();
+
+		if (liveTriangles[vertex] != 0)
+			return vertex;
+	}
+
+	// Jumping elsewhere in the mesh starts from a cold cache, so the order can be changed there
+	for (; scanCursor < vertexCount; ++scanCursor)
+	{
+		if (liveTriangles[scanCursor] != 0)
+		{
+			if (emittedTriangles != 0)
+				hardBoundaries.PushBack(emittedTriangles);
+
+			return scanCursor;
+		}
+	}
+
+	return -1;
+}
+
+void MeshOptimizer::SplitClusters(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount,
+	uint32_t cacheSize)
+{
+	// Clusters that start from a cold cache can be split further, as long as their own cache
+	// efficiency stays close to the whole mesh
+
+	const uint32_t triangleCount = indexCount / 3;
+	const float maxAcmr = CalculateAcmr(indices, indexCount, vertexCount, cacheSize) * OverdrawAcmrTolerance;
+
+	std::memset(cacheTimes.GetData(), 0, sizeof(uint32_t) * vertexCount);
+	hardBoundaries.PushBack(triangleCount);
+
+	clusters.Clear();
+	clusterCenters.Clear();
+	clusterNormals.Clear();
+
+	uint32_t time = cacheSize;
+	uint32_t clusterBegin = 0;
+	uint32_t clusterMisses = 0;
+	uint32_t boundaryIndex = 0;
+
+	for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			uint32_t vertex = indices[triangle * 3 + corner];
+			if (time - cacheTimes[vertex] >= cacheSize)
+			{
+				cacheTimes[vertex] = time;
+				time += 1;
+				clusterMisses += 1;
+			}
+		}
+
+		uint32_t clusterEnd = triangle + 1;
+		bool hardBoundary = hardBoundaries[boundaryIndex] == clusterEnd;
+		bool softBoundary = clusterMisses <= maxAcmr * (clusterEnd - clusterBegin);
+
+		if (hardBoundary || softBoundary || clusterEnd == triangleCount)
+		{
+			clusters.PushBack(Cluster{ clusterBegin, clusterEnd, 0.0f });
+			clusterBegin = clusterEnd;
+			clusterMisses = 0;
+
+			// Make every vertex miss the cache
+			time += cacheSize;
+		}
+
+		if (hardBoundary)
+			boundaryIndex += 1;
+	}
+}
+
+void MeshOptimizer::SortClusters(const Vec3f* positions, const uint32_t* indices)
+{
+	// Clusters that are far out from the center and facing away from it are likely to occlude
+	// the rest of the mesh, so they are drawn first
+
+	Vec3f meshCenterSum;
+	float meshAreaSum = 0.0f;
+
+	for (Cluster& cluster : clusters)
+	{
+		Vec3f normalSum;
+		Vec3f centerSum;
+		float areaSum = 0.0f;
+
+		for (uint32_t triangle = cluster.triangleBegin; triangle < cluster.triangleEnd; ++triangle)
+		{
+			const Vec3f& a = positions[indices[triangle * 3 + 0]];
+			const Vec3f& b = positions[indices[triangle * 3 + 1]];
+			const Vec3f& c = positions[indices[triangle * 3 + 2]];
+
+			Vec3f normal = Vec3f::Cross(b - a, c - a);
+			float area = normal.Magnitude();
+
+			normalSum += normal;
+			centerSum += (a + b + c) * (area / 3.0f);
+			areaSum += area;
+		}
+
+		meshCenterSum += centerSum;
+		meshAreaSum += areaSum;
+
+		// The key is finished once the center of the mesh is known
+		clusterCenters.PushBack(areaSum > 0.0f ? centerSum * (1.0f / areaSum) : Vec3f());
+		float normalLength = normalSum.Magnitude();
+		clusterNormals.PushBack(normalLength > 0.0f ? normalSum * (1.0f / normalLength) : Vec3f());
+	}
+
+	Vec3f meshCenter = meshAreaSum > 0.0f ? meshCenterSum * (1.0f / meshAreaSum) : Vec3f();
+
+	for (uint32_t i = 0, count = clusters.GetCount(); i < count; ++i)
+		clusters[i].sortKey = Vec3f::Dot(clusterCenters[i] - meshCenter, clusterNormals[i]);
+
+	clusterSortBuffer.Resize(clusters.GetCount());
+	RadixSortAsc(clusters.GetData(), clusterSortBuffer.GetData(), clusters.GetCount(), GetClusterSortKey);
+}
+
+uint64_t MeshOptimizer::GetClusterSortKey(const Cluster& cluster)
+{
+	// Largest key first
+	return ~FloatSortBits(cluster.sortKey) & 0xFFFFFFFFu;
+}
+
+namespace
+{
+
+// Grid of quads on the XY-plane, with a bump that rises towards the viewer
+void CreateTestGrid(uint32_t side, Array<Vec3f>& positions, Array<uint32_t>& indices)
+{
+	for (uint32_t y = 0; y <= side; ++y)
+	{
+		for (uint32_t x = 0; x <= side; ++x)
+		{
+			float dx = x - side * 0.5f;
+			float dy = y - side * 0.5f;
+			positions.PushBack(Vec3f(static_cast<float>(x), static_cast<float>(y), side * 0.5f - (dx * dx + dy * dy) * 0.1f));
+		}
+	}
+
+	for (uint32_t y = 0; y < side; ++y)
+	{
+		for (uint32_t x = 0; x < side; ++x)
+		{
+			uint32_t i = y * (side + 1) + x;
+			uint32_t quad[] = { i, i + 1, i + side + 1, i + side + 1, i + 1, i + side + 2 };
+			indices.InsertBack(quad, KOKKO_ARRAY_ITEMS(quad));
+		}
+	}
+}
+
+} // namespace
+
+TEST_CASE("MeshOptimizer.TriangleOrder")
+{
+	Allocator* allocator = Allocator::GetDefault();
+	Array<Vec3f> positions(allocator);
+	Array<uint32_t> indices(allocator);
+	CreateTestGrid(64, positions, indices);
+
+	const uint32_t vertexCount = static_cast<uint32_t>(positions.GetCount());
+	const uint32_t indexCount = static_cast<uint32_t>(indices.GetCount());
+
+	Array<uint32_t> result(allocator);
+	result.Resize(indexCount);
+
+	MeshOptimizer optimizer(allocator);
+	optimizer.OptimizeTriangleOrder(positions.GetData(), vertexCount, indices.GetData(), indexCount, result.GetData());
+
+	// Rows of a wide grid don't fit in the cache, so most vertices are transformed twice
+	float originalAcmr = optimizer.CalculateAcmr(indices.GetData(), indexCount, vertexCount);
+	float optimizedAcmr = optimizer.CalculateAcmr(result.GetData(), indexCount, vertexCount);
+	CHECK(originalAcmr > 0.9f);
+	CHECK(optimizedAcmr < 0.8f);
+
+	// The same triangles with the same winding are drawn
+	Array<uint64_t> originalTriangles(allocator);
+	Array<uint64_t> resultTriangles(allocator);
+	for (uint32_t i = 0; i < indexCount; i += 3)
+	{
+		// Rotate the smallest index first
+		auto makeKey = [](const uint32_t* tri)
+		{
+			uint32_t first = tri[0] < tri[1] ? (tri[0] < tri[2] ? 0 : 2) : (tri[1] < tri[2] ? 1 : 2);
+			return (uint64_t(tri[first]) << 40) | (uint64_t(tri[(first + 1) % 3]) << 20) | tri[(first + 2) % 3];
+		};
+
+		originalTriangles.PushBack(makeKey(&indices[i]));
+		resultTriangles.PushBack(makeKey(&result[i]));
+	}
+
+	std::sort(originalTriangles.GetData(), originalTriangles.GetData() + originalTriangles.GetCount());
+	std::sort(resultTriangles.GetData(), resultTriangles.GetData() + resultTriangles.GetCount());
+	for (uint32_t i = 0; i < originalTriangles.GetCount(); ++i)
+		CHECK(originalTriangles[i] == resultTriangles[i]);
+}
+
+TEST_CASE("MeshOptimizer.VertexOrder")
+{
+	Allocator* allocator = Allocator::GetDefault();
+
+	uint32_t indices[] = { 5, 2, 7, 7, 2, 0, 0, 2, 5 };
+	uint32_t remap[8];
+
+	MeshOptimizer optimizer(allocator);
+	uint32_t usedCount = optimizer.OptimizeVertexOrder(indices, KOKKO_ARRAY_ITEMS(indices), KOKKO_ARRAY_ITEMS(remap), remap);
+
+	CHECK(usedCount == 4);
+
+	const uint32_t expectedIndices[] = { 0, 1, 2, 2, 1, 3, 3, 1, 0 };
+	for (uint32_t i = 0; i < KOKKO_ARRAY_ITEMS(indices); ++i)
+		CHECK(indices[i] == expectedIndices[i]);
+
+	CHECK(remap[5] == 0);
+	CHECK(remap[2] == 1);
+	CHECK(remap[7] == 2);
+	CHECK(remap[0] == 3);
+	CHECK(remap[1] == MeshOptimizer::UnusedVertex);
+}
+
+} // namespace kokko
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Core/Array.hpp"
+
+#include "Math/Vec3.hpp"
+
+namespace kokko
+{
+
+class Allocator;
+
+/*
+* Reorders indexed triangle lists for the GPU. Triangles are ordered with Tipsify, so that
+* vertices are reused while they are still in the post-transform cache, and the resulting
+* clusters are sorted so that outward facing parts of the mesh are drawn first, which reduces
+* overdraw. Vertices can then be renumbered in the order they are used, so vertex fetch
+* reads memory linearly.
+*/
+class MeshOptimizer
+{
+public:
+	static constexpr uint32_t DefaultCacheSize = 16;
+	static constexpr uint32_t UnusedVertex = ~0u;
+
+	explicit MeshOptimizer(Allocator* allocator);
+
+	// Writes indexCount indices to indicesOut, which must not alias indices.
+	// If positions is null, clusters are kept in cache order.
+	void OptimizeTriangleOrder(const Vec3f* positions, uint32_t vertexCount,
+		const uint32_t* indices, uint32_t indexCount, uint32_t* indicesOut,
+		uint32_t cacheSize = DefaultCacheSize);
+
+	// Renumbers the vertices in indices in the order of first use. remapOut receives the new
+	// index of each original vertex, or UnusedVertex. Returns the number of used vertices.
+	uint32_t OptimizeVertexOrder(uint32_t* indices, uint32_t indexCount, uint32_t vertexCount,
+		uint32_t* remapOut);
+
+	// Average number of vertex shader invocations per triangle with a FIFO cache
+	float CalculateAcmr(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount,
+		uint32_t cacheSize = DefaultCacheSize);
+
+private:
+	struct Cluster
+	{
+		uint32_t triangleBegin;
+		uint32_t triangleEnd;
+		float sortKey;
+	};
+
+	void OptimizeCache(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount,
+		uint32_t* indicesOut, uint32_t cacheSize);
+	int64_t GetNextVertex(uint32_t vertexCount, uint32_t cacheSize, uint32_t time, uint32_t emittedTriangles);
+	void SplitClusters(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount,
+		uint32_t cacheSize);
+	void SortClusters(const Vec3f* positions, const uint32_t* indices);
+
+	static uint64_t GetClusterSortKey(const Cluster& cluster);
+
+	Allocator* allocator;
+
+	// Triangles around each vertex, offsets has one extra item at the end
+	Array<uint32_t> adjacencyOffsets;
+	Array<uint32_t> adjacencyTriangles;
+
+	Array<uint32_t> liveTriangles; // Triangles not yet emitted, per vertex
+	Array<uint32_t> cacheTimes;
+	Array<uint8_t> emitted;
+	Array<uint32_t> deadEnds;
+	Array<uint32_t> candidates;
+	uint32_t scanCursor = 0;
+
+	Array<uint32_t> hardBoundaries; // Triangles where the cache order had to jump
+	Array<Cluster> clusters;
+	Array<Cluster> clusterSortBuffer;
+	Array<Vec3f> clusterCenters;
+	Array<Vec3f> clusterNormals;
+};
+
+} // namespace kokko
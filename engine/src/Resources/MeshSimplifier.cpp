@@ -0,0 +1,513 @@
+#include "Resources/MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "doctest/doctest.h"
+
+#include "Core/Core.hpp"
+#include "Core/Sort.hpp"
+
+#include "Resources/MeshAdjacency.hpp"
+
+namespace kokko
+{
+
+namespace
+{
+
+uint32_t FloatBits(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+uint64_t HashPosition(const Vec3f& p)
+{
+	uint64_t hash = FloatBits(p.x) * 0x9E3779B97F4A7C15ULL;
+	hash ^= FloatBits(p.y) * 0xC2B2AE3D27D4EB4FULL;
+	hash ^= FloatBits(p.z) * 0x165667B19E3779F9ULL;
+	return hash;
+}
+
+} // namespace
+
+MeshSimplifier::MeshSimplifier(Allocator* allocator) :
+	allocator(allocator),
+	positions(allocator),
+	quadrics(allocator),
+	locked(allocator),
+	touched(allocator),
+	adjacencyOffsets(allocator),
+	adjacencyTriangles(allocator),
+	collapses(allocator),
+	collapseSortBuffer(allocator),
+	remap(allocator),
+	positionKeys(allocator),
+	positionKeySortBuffer(allocator)
+{
+}
+
+uint32_t MeshSimplifier::Simplify(const Vec3f* positionsIn, uint32_t vertexCount,
+	const uint32_t* indices, uint32_t indexCount,
+	uint32_t targetIndexCount, float maxError,
+	uint32_t* indicesOut, float* errorOut)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	assert(indexCount % 3 == 0);
+
+	std::memcpy(indicesOut, indices, sizeof(uint32_t) * indexCount);
+	*errorOut = 0.0f;
+
+	if (indexCount <= targetIndexCount || vertexCount == 0)
+		return indexCount;
+
+	Reset(vertexCount);
+
+	// Work in a unit sized space so errors don't depend on the scale of the mesh
+
+	Vec3f boundsMin = positionsIn[0];
+	Vec3f boundsMax = positionsIn[0];
+	for (uint32_t i = 1; i < vertexCount; ++i)
+	{
+		for (size_t axis = 0; axis < 3; ++axis)
+		{
+			boundsMin[axis] = std::min(boundsMin[axis], positionsIn[i][axis]);
+			boundsMax[axis] = std::max(boundsMax[axis], positionsIn[i][axis]);
+		}
+	}
+
+	Vec3f extents = boundsMax - boundsMin;
+	float scale = std::max(extents.x, std::max(extents.y, extents.z));
+	if (scale <= 0.0f)
+		scale = 1.0f;
+
+	float invScale = 1.0f / scale;
+	for (uint32_t i = 0; i < vertexCount; ++i)
+		positions[i] = (positionsIn[i] - boundsMin) * invScale;
+
+	BuildVertexTriangleAdjacency(indicesOut, indexCount, vertexCount, adjacencyOffsets, adjacencyTriangles);
+	LockSeamVertices(vertexCount);
+	LockBorderVertices(indicesOut, indexCount);
+	AddTriangleQuadrics(indicesOut, indexCount);
+
+	const float maxErrorSq = (maxError * invScale) * (maxError * invScale);
+	float resultErrorSq = 0.0f;
+
+	// Each pass collapses the cheapest edges that don't affect each other
+
+	while (indexCount > targetIndexCount)
+	{
+		collapses.Clear();
+
+		for (uint32_t i = 0; i < indexCount; i += 3)
+		{
+			for (uint32_t e = 0; e < 3; ++e)
+			{
+				uint32_t a = indicesOut[i + e];
+				uint32_t b = indicesOut[i + (e + 1) % 3];
+
+				if (locked[a] == 0)
+				{
+					Quadric q = quadrics[a];
+					AddQuadric(q, quadrics[b]);
+					float error = q.weight > 0.0f ? EvaluateQuadric(q, positions[b]) / q.weight : 0.0f;
+					collapses.PushBack(Collapse{ a, b, error > 0.0f ? error : 0.0f });
+				}
+
+				if (locked[b] == 0)
+				{
+					Quadric q = quadrics[b];
+					AddQuadric(q, quadrics[a]);
+					float error = q.weight > 0.0f ? EvaluateQuadric(q, positions[a]) / q.weight : 0.0f;
+					collapses.PushBack(Collapse{ b, a, error > 0.0f ? error : 0.0f });
+				}
+			}
+		}
+
+		if (collapses.GetCount() == 0)
+			break;
+
+		// Errors are never negative, so their bit patterns sort in the same order
+		collapseSortBuffer.Resize(collapses.GetCount());
+		RadixSortAsc(collapses.GetData(), collapseSortBuffer.GetData(), collapses.GetCount(), GetCollapseSortKey);
+
+		std::memset(touched.GetData(), 0, vertexCount);
+
+		// An interior collapse removes two triangles
+		uint32_t trianglesToRemove = (indexCount - targetIndexCount + 2) / 3;
+		uint32_t collapseLimit = (trianglesToRemove + 1) / 2;
+		uint32_t collapseCount = 0;
+
+		for (const Collapse& collapse : collapses)
+		{
+			if (collapse.error > maxErrorSq)
+				break;
+
+			if (touched[collapse.from] != 0 || touched[collapse.to] != 0)
+				continue;
+
+			if (CollapseFlipsTriangle(indicesOut, collapse.from, collapse.to))
+				continue;
+
+			remap[collapse.from] = collapse.to;
+			AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+
+			// Neighbors are used to check for flipped triangles, so they can't move during this pass
+			for (uint32_t a = adjacencyOffsets[collapse.from], end = adjacencyOffsets[collapse.from + 1]; a != end; ++a)
+			{
+				const uint32_t* triangle = &indicesOut[adjacencyTriangles[a] * 3];
+				touched[triangle[0]] = 1;
+				touched[triangle[1]] = 1;
+				touched[triangle[2]] = 1;
+			}
+
+			touched[collapse.to] = 1;
+
+			resultErrorSq = std::max(resultErrorSq, collapse.error);
+
+			collapseCount += 1;
+			if (collapseCount == collapseLimit)
+				break;
+		}
+
+		if (collapseCount == 0)
+			break;
+
+		// Apply collapses and drop the triangles that became degenerate
+
+		uint32_t writeCount = 0;
+		for (uint32_t i = 0; i < indexCount; i += 3)
+		{
+			uint32_t a = remap[indicesOut[i + 0]];
+			uint32_t b = remap[indicesOut[i + 1]];
+			uint32_t c = remap[indicesOut[i + 2]];
+
+			if (a != b && b != c && c != a)
+			{
+				indicesOut[writeCount + 0] = a;
+				indicesOut[writeCount + 1] = b;
+				indicesOut[writeCount + 2] = c;
+				writeCount += 3;
+			}
+		}
+
+		indexCount = writeCount;
+
+		BuildVertexTriangleAdjacency(indicesOut, indexCount, vertexCount, adjacencyOffsets, adjacencyTriangles);
+	}
+
+	*errorOut = std::sqrt(resultErrorSq) * scale;
+
+	return indexCount;
+}
+
+void MeshSimplifier::Reset(uint32_t vertexCount)
+{
+	positions.Resize(vertexCount);
+	quadrics.Resize(vertexCount);
+	locked.Resize(vertexCount);
+	touched.Resize(vertexCount);
+	remap.Resize(vertexCount);
+
+	std::memset(quadrics.GetData(), 0, sizeof(Quadric) * vertexCount);
+	std::memset(locked.GetData(), 0, vertexCount);
+
+	for (uint32_t i = 0; i < vertexCount; ++i)
+		remap[i] = i;
+}
+
+void MeshSimplifier::LockSeamVertices(uint32_t vertexCount)
+{
+	// Vertices that share a position with another vertex have differing attributes.
+	// Moving only one of them would open a crack, so all of them are locked.
+
+	positionKeys.Resize(vertexCount);
+	positionKeySortBuffer.Resize(vertexCount);
+
+	for (uint32_t i = 0; i < vertexCount; ++i)
+		positionKeys[i] = PositionKey{ HashPosition(positions[i]), i };
+
+	RadixSortAsc(positionKeys.GetData(), positionKeySortBuffer.GetData(), vertexCount, GetPositionSortKey);
+
+	uint32_t runStart = 0;
+	while (runStart < vertexCount)
+	{
+		uint32_t runEnd = runStart + 1;
+		while (runEnd < vertexCount && positionKeys[runEnd].hash == positionKeys[runStart].hash)
+			runEnd += 1;
+
+		// Equal hashes don't guarantee equal positions
+		for (uint32_t i = runStart; i < runEnd; ++i)
+		{
+			for (uint32_t j = i + 1; j < runEnd; ++j)
+			{
+				uint32_t a = positionKeys[i].vertex;
+				uint32_t b = positionKeys[j].vertex;
+
+				if (positions[a].x == positions[b].x && positions[a].y == positions[b].y &&
+					positions[a].z == positions[b].z)
+				{
+					locked[a] = 1;
+					locked[b] = 1;
+				}
+			}
+		}
+
+		runStart = runEnd;
+	}
+}
+
+void MeshSimplifier::LockBorderVertices(const uint32_t* indices, uint32_t indexCount)
+{
+	// An edge is on the border if no triangle has the same edge in the opposite direction
+
+	for (uint32_t i = 0; i < indexCount; i += 3)
+	{
+		for (uint32_t e = 0; e < 3; ++e)
+		{
+			uint32_t a = indices[i + e];
+			uint32_t b = indices[i + (e + 1) % 3];
+
+			bool foundOpposite = false;
+
+			for (uint32_t adj = adjacencyOffsets[b], end = adjacencyOffsets[b + 1]; adj != end; ++adj)
+			{
+				const uint32_t* triangle = &indices[adjacencyTriangles[adj] * 3];
+
+				if ((triangle[0] == b && triangle[1] == a) ||
+					(triangle[1] == b && triangle[2] == a) ||
+					(triangle[2] == b && triangle[0] == a))
+				{
+					foundOpposite = true;
+					break;
+				}
+			}
+
+			if (foundOpposite == false)
+			{
+				locked[a] = 1;
+				locked[b] = 1;
+			}
+		}
+	}
+}
+
+void MeshSimplifier::AddTriangleQuadrics(const uint32_t* indices, uint32_t indexCount)
+{
+	for (uint32_t i = 0; i < indexCount; i += 3)
+	{
+		const Vec3f& p0 = positions[indices[i + 0]];
+		const Vec3f& p1 = positions[indices[i + 1]];
+		const Vec3f& p2 = positions[indices[i + 2]];
+
+		Vec3f normal = Vec3f::Cross(p1 - p0, p2 - p0);
+		float length = normal.Magnitude();
+
+		if (length <= 0.0f)
+			continue;
+
+		normal = normal * (1.0f / length);
+		float distance = -Vec3f::Dot(normal, p0);
+
+		// Larger triangles have more say in where the surface is
+		float weight = length * 0.5f;
+
+		Quadric q;
+		q.a00 = normal.x * normal.x * weight;
+		q.a11 = normal.y * normal.y * weight;
+		q.a22 = normal.z * normal.z * weight;
+		q.a10 = normal.y * normal.x * weight;
+		q.a20 = normal.z * normal.x * weight;
+		q.a21 = normal.z * normal.y * weight;
+		q.b0 = normal.x * distance * weight;
+		q.b1 = normal.y * distance * weight;
+		q.b2 = normal.z * distance * weight;
+		q.c = distance * distance * weight;
+		q.weight = weight;
+
+		AddQuadric(quadrics[indices[i + 0]], q);
+		AddQuadric(quadrics[indices[i + 1]], q);
+		AddQuadric(quadrics[indices[i + 2]], q);
+	}
+}
+
+bool MeshSimplifier::CollapseFlipsTriangle(const uint32_t* indices, uint32_t from, uint32_t to) const
+{
+	const Vec3f& target = positions[to];
+
+	for (uint32_t adj = adjacencyOffsets[from], end = adjacencyOffsets[from + 1]; adj != end; ++adj)
+	{
+		const uint32_t* triangle = &indices[adjacencyTriangles[adj] * 3];
+
+		// Triangles that contain the whole edge are removed by the collapse
+		if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+			continue;
+
+		const Vec3f& p0 = positions[triangle[0]];
+		const Vec3f& p1 = positions[triangle[1]];
+		const Vec3f& p2 = positions[triangle[2]];
+
+		const Vec3f& n0 = triangle[0] == from ? target : p0;
+		const Vec3f& n1 = triangle[1] == from ? target : p1;
+		const Vec3f& n2 = triangle[2] == from ? target : p2;
+
+		Vec3f before = Vec3f::Cross(p1 - p0, p2 - p0);
+		Vec3f after = Vec3f::Cross(n1 - n0, n2 - n0);
+
+		if (Vec3f::Dot(before, after) <= 0.0f)
+			return true;
+	}
+
+	return false;
+}
+
+void MeshSimplifier::AddQuadric(Quadric& q, const Quadric& other)
+{
+	q.a00 += other.a00;
+	q.a11 += other.a11;
+	q.a22 += other.a22;
+	q.a10 += other.a10;
+	q.a20 += other.a20;
+	q.a21 += other.a21;
+	q.b0 += other.b0;
+	q.b1 += other.b1;
+	q.b2 += other.b2;
+	q.c += other.c;
+	q.weight += other.weight;
+}
+
+uint64_t MeshSimplifier::GetCollapseSortKey(const Collapse& collapse)
+{
+	return FloatBits(collapse.error);
+}
+
+uint64_t MeshSimplifier::GetPositionSortKey(const PositionKey& key)
+{
+	return key.hash;
+}
+
+float MeshSimplifier::EvaluateQuadric(const Quadric& q, const Vec3f& p)
+{
+	float rx = q.a00 * p.x + q.a10 * p.y + q.a20 * p.z;
+	float ry = q.a10 * p.x + q.a11 * p.y + q.a21 * p.z;
+	float rz = q.a20 * p.x + q.a21 * p.y + q.a22 * p.z;
+
+	float r = rx * p.x + ry * p.y + rz * p.z;
+	r += 2.0f * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z);
+	r += q.c;
+
+	return r;
+}
+
+namespace
+{
+
+// Grid of quads on the XZ-plane, with heights from the height function
+template <typename HeightFn>
+void CreateTestGrid(uint32_t side, HeightFn height, Array<Vec3f>& positions, Array<uint32_t>& indices)
+{
+	for (uint32_t z = 0; z <= side; ++z)
+		for (uint32_t x = 0; x <= side; ++x)
+			positions.PushBack(Vec3f(static_cast<float>(x), height(x, z), static_cast<float>(z)));
+
+	for (uint32_t z = 0; z < side; ++z)
+	{
+		for (uint32_t x = 0; x < side; ++x)
+		{
+			uint32_t i = z * (side + 1) + x;
+			uint32_t quad[] = { i, i + side + 1, i + 1, i + 1, i + side + 1, i + side + 2 };
+			indices.InsertBack(quad, KOKKO_ARRAY_ITEMS(quad));
+		}
+	}
+}
+
+} // namespace
+
+TEST_CASE("MeshSimplifier.FlatGrid")
+{
+	Allocator* allocator = Allocator::GetDefault();
+	Array<Vec3f> positions(allocator);
+	Array<uint32_t> indices(allocator);
+	CreateTestGrid(16, [](uint32_t, uint32_t) { return 0.0f; }, positions, indices);
+
+	Array<uint32_t> result(allocator);
+	result.Resize(indices.GetCount());
+
+	MeshSimplifier simplifier(allocator);
+	float error = 1.0f;
+	uint32_t indexCount = simplifier.Simplify(positions.GetData(), static_cast<uint32_t>(positions.GetCount()),
+		indices.GetData(), static_cast<uint32_t>(indices.GetCount()), 0, 0.01f, result.GetData(), &error);
+
+	// Only the border vertices are left
+	CHECK(indexCount < indices.GetCount() / 4);
+	CHECK(indexCount % 3 == 0);
+	CHECK(error < 0.001f);
+
+	// The surface keeps facing up
+	for (uint32_t i = 0; i < indexCount; i += 3)
+	{
+		CHECK(result[i] < positions.GetCount());
+		Vec3f normal = Vec3f::Cross(positions[result[i + 1]] - positions[result[i]], positions[result[i + 2]] - positions[result[i]]);
+		CHECK(normal.y > 0.0f);
+	}
+}
+
+TEST_CASE("MeshSimplifier.TargetAndError")
+{
+	Allocator* allocator = Allocator::GetDefault();
+	Array<Vec3f> positions(allocator);
+	Array<uint32_t> indices(allocator);
+	CreateTestGrid(16, [](uint32_t x, uint32_t z) { return std::sin(x * 0.5f) * std::cos(z * 0.5f) * 2.0f; }, positions, indices);
+
+	Array<uint32_t> result(allocator);
+	result.Resize(indices.GetCount());
+
+	MeshSimplifier simplifier(allocator);
+	const uint32_t originalCount = static_cast<uint32_t>(indices.GetCount());
+
+	float halfError = 0.0f;
+	uint32_t halfCount = simplifier.Simplify(positions.GetData(), static_cast<uint32_t>(positions.GetCount()),
+		indices.GetData(), originalCount, originalCount / 2, 100.0f, result.GetData(), &halfError);
+
+	CHECK(halfCount <= originalCount / 2);
+	CHECK(halfCount > originalCount / 4);
+
+	// A tighter error limit keeps more detail
+	float looseError = 0.0f;
+	uint32_t looseCount = simplifier.Simplify(positions.GetData(), static_cast<uint32_t>(positions.GetCount()),
+		indices.GetData(), originalCount, 0, 0.5f, result.GetData(), &looseError);
+
+	float strictError = 0.0f;
+	uint32_t strictCount = simplifier.Simplify(positions.GetData(), static_cast<uint32_t>(positions.GetCount()),
+		indices.GetData(), originalCount, 0, 0.05f, result.GetData(), &strictError);
+
+	CHECK(looseCount < strictCount);
+	CHECK(strictCount < originalCount);
+	CHECK(looseError <= 0.5f);
+	CHECK(strictError <= 0.05f);
+}
+
+TEST_CASE("MeshSimplifier.SeamsAreLocked")
+{
+	// Two quads that share an edge, but not vertices
+	const Vec3f positions[] = {
+		Vec3f(0.0f, 0.0f, 0.0f), Vec3f(1.0f, 0.0f, 0.0f), Vec3f(0.0f, 1.0f, 0.0f), Vec3f(1.0f, 1.0f, 0.0f),
+		Vec3f(1.0f, 0.0f, 0.0f), Vec3f(2.0f, 0.0f, 0.0f), Vec3f(1.0f, 1.0f, 0.0f), Vec3f(2.0f, 1.0f, 0.0f)
+	};
+	const uint32_t indices[] = { 0, 1, 2, 2, 1, 3, 4, 5, 6, 6, 5, 7 };
+	uint32_t result[KOKKO_ARRAY_ITEMS(indices)];
+
+	MeshSimplifier simplifier(Allocator::GetDefault());
+	float error = 0.0f;
+	uint32_t indexCount = simplifier.Simplify(positions, KOKKO_ARRAY_ITEMS(positions),
+		indices, KOKKO_ARRAY_ITEMS(indices), 0, 1.0f, result, &error);
+
+	CHECK(indexCount == KOKKO_ARRAY_ITEMS(indices));
+}
+
+} // namespace kokko
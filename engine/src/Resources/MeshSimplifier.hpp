@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Core/Array.hpp"
+
+#include "Math/Vec3.hpp"
+
+namespace kokko
+{
+
+class Allocator;
+
+/*
+* Reduces the triangle count of an indexed triangle list by collapsing edges in the order
+* of least quadric error. Vertices are only moved onto other existing vertices, so the
+* simplified index list can be drawn with the original vertex buffer. Vertices on open
+* borders or attribute seams are kept in place, so the outline of the mesh doesn't crack.
+*/
+class MeshSimplifier
+{
+public:
+	explicit MeshSimplifier(Allocator* allocator);
+
+	// Writes at most indexCount indices to indicesOut and returns the number written.
+	// Stops when the index count reaches targetIndexCount or when the next collapse would
+	// move the surface further than maxError. The error of the result is written to errorOut.
+	uint32_t Simplify(const Vec3f* positions, uint32_t vertexCount,
+		const uint32_t* indices, uint32_t indexCount,
+		uint32_t targetIndexCount, float maxError,
+		uint32_t* indicesOut, float* errorOut);
+
+private:
+	// Sum of squared distances to the planes of the triangles around a vertex
+	struct Quadric
+	{
+		float a00, a11, a22;
+		float a10, a20, a21;
+		float b0, b1, b2;
+		float c;
+		float weight;
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		float error;
+	};
+
+	struct PositionKey
+	{
+		uint64_t hash;
+		uint32_t vertex;
+	};
+
+	void Reset(uint32_t vertexCount);
+	void LockSeamVertices(uint32_t vertexCount);
+	void LockBorderVertices(const uint32_t* indices, uint32_t indexCount);
+	void AddTriangleQuadrics(const uint32_t* indices, uint32_t indexCount);
+	bool CollapseFlipsTriangle(const uint32_t* indices, uint32_t from, uint32_t to) const;
+
+	static void AddQuadric(Quadric& q, const Quadric& other);
+	static float EvaluateQuadric(const Quadric& q, const Vec3f& p);
+
+	static uint64_t GetCollapseSortKey(const Collapse& collapse);
+	static uint64_t GetPositionSortKey(const PositionKey& key);
+
+	Allocator* allocator;
+
+	Array<Vec3f> positions;
+	Array<Quadric> quadrics;
+	Array<uint8_t> locked;
+	Array<uint8_t> touched; // Vertices changed in the current pass
+
+	// Triangles around each vertex, offsets has one extra item at the end
+	Array<uint32_t> adjacencyOffsets;
+	Array<uint32_t> adjacencyTriangles;
+
+	Array<Collapse> collapses;
+	Array<Collapse> collapseSortBuffer;
+	Array<uint32_t> remap;
+	Array<PositionKey> positionKeys;
+	Array<PositionKey> positionKeySortBuffer;
+};
+
+} // namespace kokko
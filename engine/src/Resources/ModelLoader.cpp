@@ -1,6 +1,9 @@
 #include "Resources/ModelLoader.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
 
 #include "cgltf/cgltf.h"
 #include "doctest/doctest.h"
@@ -19,6 +22,19 @@
 namespace
 {
 
+// Parts with fewer triangles are cheap enough to always draw at full detail
+constexpr uint32_t MinLodTriangleCount = 256;
+
+// Simplification stops when the surface would move further than this, relative to the mesh size
+constexpr float LodMaxRelativeError = 0.1f;
+
+// Half floats have a 10 bit mantissa, so between 1 and 2 the step is 1/1024 of the texture.
+// Texture coordinates further out would be off by multiple texels and are kept as floats.
+constexpr float HalfFloatMaxTexCoord = 2.0f;
+
+// Vertex data is aligned for the vertex fetch hardware
+constexpr size_t VertexAlignment = 4;
+
 struct CountResult
 {
 	size_t nodeCount = 0;
@@ -79,6 +95,111 @@ CountResult CountModelResources(cgltf_data* model, kokko::SortedArray<cgltf_buff
 	return result;
 }
 
+bool ReadPositions(const uint8_t* geometry, const kokko::ModelMeshPart& part, kokko::Array<kokko::Vec3f>& positionsOut)
+{
+	const kokko::VertexAttribute* posAttr = nullptr;
+	for (uint32_t attrIdx = 0; attrIdx < part.vertexFormat.attributeCount; ++attrIdx)
+	{
+		const kokko::VertexAttribute& attr = part.vertexFormat.attributes[attrIdx];
+		if (attr.attrIndex == kokko::VertexFormat::AttributeIndexPos && attr.elemCount >= 3 &&
+			attr.elemType == kokko::RenderVertexElemType::Float)
+			posAttr = &attr;
+	}
+
+	if (posAttr == nullptr)
+		return false;
+
+	size_t stride = posAttr->stride != 0 ? posAttr->stride : sizeof(float) * posAttr->elemCount;
+	const uint8_t* vertexData = geometry + posAttr->offset;
+
+	positionsOut.Resize(part.uniqueVertexCount);
+	for (uint32_t vertIdx = 0; vertIdx < part.uniqueVertexCount; ++vertIdx)
+		std::memcpy(&positionsOut[vertIdx], vertexData + vertIdx * stride, sizeof(kokko::Vec3f));
+
+	return true;
+}
+
+float ReadFloat(const uint8_t* data)
+{
+	float value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+uint16_t FloatToHalf(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000u;
+	int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFFu) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFFu;
+
+	if (exponent <= 0)
+	{
+		// Denormalized half float, or zero if the value is too small for that
+		if (exponent < -10)
+			return static_cast<uint16_t>(sign);
+
+		mantissa |= 0x800000u;
+		uint32_t shift = static_cast<uint32_t>(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1u)
+			half += 1;
+
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	if (exponent >= 31)
+		return static_cast<uint16_t>(sign | 0x7C00u);
+
+	// Rounding can carry over to the exponent, which gives the correct result
+	uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000u)
+		half += 1;
+
+	return static_cast<uint16_t>(half);
+}
+
+float HalfToFloat(uint16_t half)
+{
+	uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+	uint32_t exponent = (half >> 10) & 0x1Fu;
+	uint32_t mantissa = half & 0x3FFu;
+
+	if (exponent == 0)
+	{
+		float value = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+		return sign != 0 ? -value : value;
+	}
+
+	uint32_t bits = sign | ((exponent == 31 ? 255 : exponent - 15 + 127) << 23) | (mantissa << 13);
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// Signed normalized values in the layout of GL_INT_2_10_10_10_REV
+uint32_t PackSnorm10(const float* values, int count)
+{
+	uint32_t packed = 0;
+	for (int i = 0; i < count && i < 3; ++i)
+	{
+		float clamped = std::min(std::max(values[i], -1.0f), 1.0f);
+		int32_t value = static_cast<int32_t>(std::lround(clamped * 511.0f));
+		packed |= (static_cast<uint32_t>(value) & 0x3FFu) << (i * 10);
+	}
+
+	return packed;
+}
+
+float UnpackSnorm10(uint32_t packed, int index)
+{
+	// Shift the value to the top bits, so the sign is extended when shifting back
+	int32_t value = static_cast<int32_t>(packed << (22 - index * 10)) >> 22;
+	return std::max(static_cast<float>(value) / 511.0f, -1.0f);
+}
+
 } // namespace
 
 namespace kokko
@@ -104,7 +225,19 @@ void ModelData::ReleaseMemory(Allocator* allocator)
 ModelLoader::ModelLoader(Allocator* allocator) :
 	allocator(allocator),
 	uniqueGeometryBufferViews(allocator),
-	geometryBufferViewRangeMap(allocator)
+	geometryBufferViewRangeMap(allocator),
+	sourceGeometry(allocator),
+	optimizer(allocator),
+	partIndices(allocator),
+	optimizedIndices(allocator),
+	vertexRemap(allocator),
+	vertexOrder(allocator),
+	partPositions(allocator),
+	partAttributes(allocator),
+	simplifier(allocator),
+	lodPositions(allocator),
+	lodSourceIndices(allocator),
+	lodIndices(allocator)
 {
 }
 
@@ -149,11 +282,19 @@ bool ModelLoader::LoadRuntime(ModelData* modelOut, Array<uint8_t>* geometryBuffe
 	mesh.primitiveMode = createInfo.primitiveMode;
 	mesh.name = nullptr;
 	mesh.aabb = AABB();
+	mesh.lodCount = 1;
 
 	ModelMeshPart& meshPart = outputModel->meshParts[0];
 	meshPart.uniqueVertexCount = createInfo.vertexCount;
 	meshPart.indexOffset = vertexBytes;
 	meshPart.count = createInfo.indexType != RenderIndexType::None ? createInfo.indexCount : createInfo.vertexCount;
+
+	// Runtime meshes are usually simple or change often, so they are always drawn at full detail
+	for (uint32_t lod = 0; lod < ModelMesh::MaxLodCount; ++lod)
+	{
+		mesh.lodErrors[lod] = 0.0f;
+		meshPart.lods[lod] = ModelMeshLod{ meshPart.indexOffset, meshPart.count };
+	}
 	meshPart.vertexFormat.attributes = outputModel->attributes;
 	meshPart.vertexFormat.attributeCount = createInfo.vertexFormat.attributeCount;
 
@@ -192,7 +333,10 @@ bool ModelLoader::LoadGlbFromBuffer(
 			- Mesh parts each have their own vertex format and vertex array for now. In the future, we should try to
 			  merge these when possible to make it possible to render all parts in one draw call.
 			- Each vertex attribute can come from separate buffer view
-	5. Load each node in model
+	5. Rebuild the geometry of each mesh part, if enabled in the options
+		- Triangles and vertices are reordered and attributes are interleaved and optionally compressed
+	6. Generate simplified levels of detail for each mesh
+	7. Load each node in model
 	*/
 
 	KOKKO_PROFILE_FUNCTION();
@@ -200,10 +344,10 @@ bool ModelLoader::LoadGlbFromBuffer(
 	outputModel = modelOut;
 	geometryBuffer = geometryBufferOut;
 
-	cgltf_options options{};
+	cgltf_options parseOptions{};
 	cgltf_data* data = nullptr;
 
-	cgltf_result result = cgltf_parse(&options, buffer.GetData(), buffer.GetCount(), &data);
+	cgltf_result result = cgltf_parse(&parseOptions, buffer.GetData(), buffer.GetCount(), &data);
 	if (result != cgltf_result_success)
 	{
 		KK_LOG_ERROR("ModelLoader: Failed to load model, couldn't parse glTF");
@@ -211,7 +355,7 @@ bool ModelLoader::LoadGlbFromBuffer(
 	}
 	
 	// TODO: mesh path and callbacks
-	cgltf_result loadResult = cgltf_load_buffers(&options, data, nullptr);
+	cgltf_result loadResult = cgltf_load_buffers(&parseOptions, data, nullptr);
 	if (loadResult != cgltf_result_success)
 	{
 		KK_LOG_ERROR("ModelLoader: Failed to load model, couldn't load glTF buffers");
@@ -292,6 +436,12 @@ bool ModelLoader::LoadGlbFromBuffer(
 			outputModel->meshCount += 1;
 	}
 
+	if (options.reorderGeometry || options.compactVertexFormat)
+		RebuildGeometry();
+
+	for (uint32_t meshIdx = 0; meshIdx < outputModel->meshCount; ++meshIdx)
+		GenerateMeshLods(outputModel->meshes[meshIdx]);
+
 	// Load nodes
 
 	uint32_t lastSiblingIndex = 0;
@@ -323,6 +473,7 @@ void ModelLoader::Reset()
 	geometryBufferUsed = 0;
 	uniqueGeometryBufferViews.Clear();
 	geometryBufferViewRangeMap.Clear();
+	sourceGeometry.ClearAndRelease();
 }
 
 void ModelLoader::LoadGltfNode(
@@ -543,7 +694,9 @@ bool ModelLoader::LoadGltfMesh(cgltf_mesh* cgltfMesh, ModelMesh& modelMeshOut)
 				assert(false && "Index geometry buffer view not found in range map");
 		}
 
-		meshPart.vertexFormat = VertexFormat(attributesBegin, cgltfPrim.attributes_count);
+		// Some attributes might have been skipped
+		unsigned int attributeCount = static_cast<unsigned int>(&outputModel->attributes[outputModel->attributeCount] - attributesBegin);
+		meshPart.vertexFormat = VertexFormat(attributesBegin, attributeCount);
 
 		outputModel->meshPartCount += 1;
 		modelMeshOut.partCount += 1;
@@ -569,6 +722,267 @@ bool ModelLoader::LoadGltfMesh(cgltf_mesh* cgltfMesh, ModelMesh& modelMeshOut)
 	return true;
 }
 
+void ModelLoader::RebuildGeometry()
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	// Buffer views can be shared between mesh parts, so each part is written into a new buffer
+
+	sourceGeometry = std::move(*geometryBuffer);
+	geometryBufferUsed = 0;
+
+	for (uint32_t meshIdx = 0; meshIdx < outputModel->meshCount; ++meshIdx)
+	{
+		const ModelMesh& mesh = outputModel->meshes[meshIdx];
+
+		for (uint32_t partIdx = mesh.partOffset, end = mesh.partOffset + mesh.partCount; partIdx != end; ++partIdx)
+			RebuildMeshPart(mesh, outputModel->meshParts[partIdx]);
+	}
+
+	sourceGeometry.ClearAndRelease();
+}
+
+void ModelLoader::RebuildMeshPart(const ModelMesh& mesh, ModelMeshPart& part)
+{
+	const uint8_t* source = sourceGeometry.GetData();
+	const bool indexed = mesh.indexType != RenderIndexType::None;
+
+	uint32_t vertexCount = part.uniqueVertexCount;
+
+	if (indexed)
+	{
+		partIndices.Resize(part.count);
+		for (uint32_t idx = 0; idx < part.count; ++idx)
+			partIndices[idx] = kokko::ReadRenderIndex(source + part.indexOffset, mesh.indexType, idx);
+	}
+
+	if (options.reorderGeometry && indexed && mesh.primitiveMode == RenderPrimitiveMode::Triangles)
+	{
+		// Overdraw can only be optimized if the positions are known
+		const Vec3f* positions = nullptr;
+		if (ReadPositions(source, part, partPositions))
+			positions = partPositions.GetData();
+
+		optimizedIndices.Resize(part.count);
+		optimizer.OptimizeTriangleOrder(positions, vertexCount,
+			partIndices.GetData(), part.count, optimizedIndices.GetData());
+
+		vertexRemap.Resize(vertexCount);
+		uint32_t usedCount = optimizer.OptimizeVertexOrder(optimizedIndices.GetData(), part.count,
+			vertexCount, vertexRemap.GetData());
+
+		vertexOrder.Resize(usedCount);
+		for (uint32_t vertIdx = 0; vertIdx < vertexCount; ++vertIdx)
+			if (vertexRemap[vertIdx] != MeshOptimizer::UnusedVertex)
+				vertexOrder[vertexRemap[vertIdx]] = vertIdx;
+
+		vertexCount = usedCount;
+		std::memcpy(partIndices.GetData(), optimizedIndices.GetData(), sizeof(uint32_t) * part.count);
+	}
+	else
+	{
+		vertexOrder.Resize(vertexCount);
+		for (uint32_t vertIdx = 0; vertIdx < vertexCount; ++vertIdx)
+			vertexOrder[vertIdx] = vertIdx;
+	}
+
+	// Choose the output format and interleave the attributes
+
+	VertexFormat& vertexFormat = part.vertexFormat;
+	partAttributes.Resize(vertexFormat.attributeCount);
+
+	for (uint32_t attrIdx = 0; attrIdx < vertexFormat.attributeCount; ++attrIdx)
+	{
+		const VertexAttribute& attr = vertexFormat.attributes[attrIdx];
+		VertexAttribute& attrOut = partAttributes[attrIdx];
+		attrOut = attr;
+
+		if (options.compactVertexFormat == false || attr.elemType != RenderVertexElemType::Float)
+			continue;
+
+		if (attr.attrIndex == VertexFormat::AttributeIndexNor && attr.elemCount == 3)
+		{
+			attrOut.elemType = RenderVertexElemType::Snorm10_10_10_2;
+			attrOut.elemCount = 4;
+		}
+		else if (attr.attrIndex >= VertexFormat::AttributeIndexUV0 &&
+			attr.attrIndex <= VertexFormat::AttributeIndexUV2 && attr.elemCount == 2)
+		{
+			size_t stride = attr.stride != 0 ? attr.stride : sizeof(float) * attr.elemCount;
+
+			bool inRange = true;
+			for (uint32_t vertIdx = 0; vertIdx < vertexCount && inRange; ++vertIdx)
+			{
+				const uint8_t* value = source + attr.offset + vertexOrder[vertIdx] * stride;
+				for (int elemIdx = 0; elemIdx < attr.elemCount; ++elemIdx)
+					if (std::fabs(ReadFloat(value + elemIdx * sizeof(float))) > HalfFloatMaxTexCoord)
+						inRange = false;
+			}
+
+			if (inRange)
+				attrOut.elemType = RenderVertexElemType::HalfFloat;
+		}
+	}
+
+	VertexFormat interleavedFormat(partAttributes.GetData(), static_cast<unsigned int>(partAttributes.GetCount()));
+	interleavedFormat.CalcOffsetsAndSizeInterleaved();
+
+	size_t vertexStride = partAttributes.GetCount() != 0 ? partAttributes[0].stride : 0;
+	size_t vertexOffset = Math::RoundUpToMultiple(geometryBufferUsed, VertexAlignment);
+	geometryBufferUsed = vertexOffset + vertexStride * vertexCount;
+	geometryBuffer->Resize(geometryBufferUsed);
+
+	uint8_t* vertexData = geometryBuffer->GetData() + vertexOffset;
+
+	for (uint32_t attrIdx = 0; attrIdx < vertexFormat.attributeCount; ++attrIdx)
+	{
+		const VertexAttribute& attr = vertexFormat.attributes[attrIdx];
+		const VertexAttribute& attrOut = partAttributes[attrIdx];
+		size_t stride = attr.stride != 0 ? attr.stride : sizeof(float) * attr.elemCount;
+
+		for (uint32_t vertIdx = 0; vertIdx < vertexCount; ++vertIdx)
+		{
+			const uint8_t* src = source + attr.offset + vertexOrder[vertIdx] * stride;
+			uint8_t* dest = vertexData + vertIdx * vertexStride + attrOut.offset;
+
+			if (attrOut.elemType == RenderVertexElemType::Snorm10_10_10_2)
+			{
+				float values[3];
+				std::memcpy(values, src, sizeof(values));
+				uint32_t packed = PackSnorm10(values, attr.elemCount);
+				std::memcpy(dest, &packed, sizeof(packed));
+			}
+			else if (attrOut.elemType == RenderVertexElemType::HalfFloat)
+			{
+				for (int elemIdx = 0; elemIdx < attr.elemCount; ++elemIdx)
+				{
+					uint16_t half = FloatToHalf(ReadFloat(src + elemIdx * sizeof(float)));
+					std::memcpy(dest + elemIdx * sizeof(uint16_t), &half, sizeof(half));
+				}
+			}
+			else
+				std::memcpy(dest, src, sizeof(float) * attr.elemCount);
+		}
+	}
+
+	for (uint32_t attrIdx = 0; attrIdx < vertexFormat.attributeCount; ++attrIdx)
+	{
+		VertexAttribute& attr = vertexFormat.attributes[attrIdx];
+		attr = partAttributes[attrIdx];
+		attr.offset += vertexOffset;
+		attr.stride = static_cast<int>(vertexStride);
+	}
+
+	part.uniqueVertexCount = vertexCount;
+
+	if (indexed)
+		part.indexOffset = AppendIndices(partIndices.GetData(), part.count, mesh.indexType);
+}
+
+void ModelLoader::GenerateMeshLods(ModelMesh& mesh)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	// Every level starts out as the original mesh, so parts that can't be simplified keep drawing it
+
+	mesh.lodCount = 1;
+
+	for (uint32_t lod = 0; lod < ModelMesh::MaxLodCount; ++lod)
+		mesh.lodErrors[lod] = 0.0f;
+
+	for (uint32_t partIdx = mesh.partOffset, end = mesh.partOffset + mesh.partCount; partIdx != end; ++partIdx)
+	{
+		ModelMeshPart& part = outputModel->meshParts[partIdx];
+
+		for (uint32_t lod = 0; lod < ModelMesh::MaxLodCount; ++lod)
+			part.lods[lod] = ModelMeshLod{ part.indexOffset, part.count };
+	}
+
+	if (mesh.primitiveMode != RenderPrimitiveMode::Triangles || mesh.indexType == RenderIndexType::None)
+		return;
+
+	Vec3f meshSize = mesh.aabb.extents * 2.0f;
+	float maxError = std::max(meshSize.x, std::max(meshSize.y, meshSize.z)) * LodMaxRelativeError;
+
+	for (uint32_t partIdx = mesh.partOffset, end = mesh.partOffset + mesh.partCount; partIdx != end; ++partIdx)
+	{
+		ModelMeshPart& part = outputModel->meshParts[partIdx];
+
+		if (part.count / 3 < MinLodTriangleCount)
+			continue;
+
+		// Copy the geometry out, since appending the simplified indices can move the geometry buffer
+
+		if (ReadPositions(geometryBuffer->GetData(), part, lodPositions) == false)
+			continue;
+
+		const uint8_t* indexData = geometryBuffer->GetData() + part.indexOffset;
+
+		lodSourceIndices.Resize(part.count);
+		for (uint32_t idx = 0; idx < part.count; ++idx)
+			lodSourceIndices[idx] = kokko::ReadRenderIndex(indexData, mesh.indexType, idx);
+
+		lodIndices.Resize(part.count);
+
+		// Each level aims for half the triangles of the previous one
+		uint32_t previousCount = part.count;
+
+		for (uint32_t lod = 1; lod < ModelMesh::MaxLodCount; ++lod)
+		{
+			uint32_t targetCount = (part.count >> lod) / 3 * 3;
+
+			float error = 0.0f;
+			uint32_t lodCount = simplifier.Simplify(lodPositions.GetData(), part.uniqueVertexCount,
+				lodSourceIndices.GetData(), part.count, targetCount, maxError, lodIndices.GetData(), &error);
+
+			// Levels that barely reduce the triangle count aren't worth switching to
+			if (lodCount * 4 > previousCount * 3)
+				break;
+
+			uint32_t offset = AppendIndices(lodIndices.GetData(), lodCount, mesh.indexType);
+
+			for (uint32_t nextLod = lod; nextLod < ModelMesh::MaxLodCount; ++nextLod)
+				part.lods[nextLod] = ModelMeshLod{ offset, lodCount };
+
+			mesh.lodErrors[lod] = std::max(mesh.lodErrors[lod], error);
+			mesh.lodCount = std::max(mesh.lodCount, static_cast<uint8_t>(lod + 1));
+			previousCount = lodCount;
+		}
+	}
+
+	// Parts that stopped early draw their coarsest level, so errors can only grow
+	for (uint32_t lod = 1; lod < ModelMesh::MaxLodCount; ++lod)
+		mesh.lodErrors[lod] = std::max(mesh.lodErrors[lod], mesh.lodErrors[lod - 1]);
+}
+
+uint32_t ModelLoader::AppendIndices(const uint32_t* indices, uint32_t count, RenderIndexType indexType)
+{
+	size_t indexSize = indexType == RenderIndexType::UnsignedByte ? 1 :
+		indexType == RenderIndexType::UnsignedShort ? 2 : 4;
+
+	// Index data must be aligned to the size of an index
+	size_t offset = Math::RoundUpToMultiple(geometryBufferUsed, indexSize);
+	geometryBufferUsed = offset + indexSize * count;
+	geometryBuffer->Resize(geometryBufferUsed);
+
+	uint8_t* dest = geometryBuffer->GetData() + offset;
+
+	for (uint32_t idx = 0; idx < count; ++idx)
+	{
+		if (indexType == RenderIndexType::UnsignedByte)
+			dest[idx] = static_cast<uint8_t>(indices[idx]);
+		else if (indexType == RenderIndexType::UnsignedShort)
+		{
+			uint16_t value = static_cast<uint16_t>(indices[idx]);
+			std::memcpy(dest + idx * sizeof(value), &value, sizeof(value));
+		}
+		else
+			std::memcpy(dest + idx * sizeof(uint32_t), &indices[idx], sizeof(uint32_t));
+	}
+
+	return static_cast<uint32_t>(offset);
+}
+
 TEST_CASE("ModelLoader.RuntimeModelNonIndexed")
 {
 	Allocator* allocator = Allocator::GetDefault();
@@ -720,7 +1134,12 @@ TEST_CASE("ModelLoader.GlbModelIndexed")
 	Array<uint8_t> buffer(allocator);
 	CHECK(filesystem.ReadBinary("test/res/model/Box.glb", buffer) == true);
 
+	// Keep the geometry as it is in the file, so it can be compared directly
+	ModelLoadOptions loadOptions;
+	loadOptions.reorderGeometry = false;
+
 	ModelLoader modelLoader(allocator);
+	modelLoader.SetOptions(loadOptions);
 	ModelData model;
 	Array<uint8_t> geometryBuffer(allocator);
 	CHECK(modelLoader.LoadGlbFromBuffer(&model, &geometryBuffer, buffer.GetView()) == true);
@@ -741,6 +1160,11 @@ TEST_CASE("ModelLoader.GlbModelIndexed")
 	CHECK(model.meshParts[0].uniqueVertexCount == 24);
 	CHECK(model.meshParts[0].vertexFormat.attributeCount == 2);
 
+	// The box is too simple to have simplified levels
+	CHECK(model.meshes[0].lodCount == 1);
+	CHECK(model.meshParts[0].lods[0].indexOffset == model.meshParts[0].indexOffset);
+	CHECK(model.meshParts[0].lods[0].count == model.meshParts[0].count);
+
 	CHECK(model.meshParts[0].vertexFormat.attributes[0].elemCount == 3);
 	CHECK(model.meshParts[0].vertexFormat.attributes[0].elemType == RenderVertexElemType::Float);
 	CHECK(model.meshParts[0].vertexFormat.attributes[0].stride == 12);
@@ -796,7 +1220,12 @@ TEST_CASE("ModelLoader.GlbModelIndexedInterleaved")
 	Array<uint8_t> buffer(allocator);
 	CHECK(filesystem.ReadBinary("test/res/model/BoxInterleaved.glb", buffer) == true);
 
+	// Keep the geometry as it is in the file, so it can be compared directly
+	ModelLoadOptions loadOptions;
+	loadOptions.reorderGeometry = false;
+
 	ModelLoader modelLoader(allocator);
+	modelLoader.SetOptions(loadOptions);
 	ModelData model;
 	Array<uint8_t> geometryBuffer(allocator);
 	CHECK(modelLoader.LoadGlbFromBuffer(&model, &geometryBuffer, buffer.GetView()) == true);
@@ -865,4 +1294,181 @@ TEST_CASE("ModelLoader.GlbModelIndexedInterleaved")
 	model.ReleaseMemory(allocator);
 }
 
+namespace
+{
+
+struct TestVertex
+{
+	float position[3];
+	float normal[3];
+};
+
+void ReadTestVertex(const ModelData& model, const uint8_t* geometry, uint32_t vertex, TestVertex& vertexOut)
+{
+	const VertexFormat& format = model.meshParts[0].vertexFormat;
+	for (uint32_t aIdx = 0; aIdx != format.attributeCount; ++aIdx)
+	{
+		const VertexAttribute& attr = format.attributes[aIdx];
+		const uint8_t* data = &geometry[attr.offset + attr.stride * vertex];
+		float* values = attr.attrIndex == VertexFormat::AttributeIndexPos ? vertexOut.position : vertexOut.normal;
+
+		if (attr.elemType == RenderVertexElemType::Snorm10_10_10_2)
+		{
+			uint32_t packed;
+			std::memcpy(&packed, data, sizeof(packed));
+			for (int eIdx = 0; eIdx != 3; ++eIdx)
+				values[eIdx] = UnpackSnorm10(packed, eIdx);
+		}
+		else
+			std::memcpy(values, data, sizeof(float) * 3);
+	}
+}
+
+bool TestVerticesMatch(const TestVertex& lhs, const TestVertex& rhs, float normalTolerance)
+{
+	for (int eIdx = 0; eIdx != 3; ++eIdx)
+	{
+		if (lhs.position[eIdx] != rhs.position[eIdx] ||
+			std::fabs(lhs.normal[eIdx] - rhs.normal[eIdx]) > normalTolerance)
+			return false;
+	}
+
+	return true;
+}
+
+// Checks that the model draws the same triangles as the original Box.glb, in any order
+void CheckBoxTriangles(const ModelData& model, const Array<uint8_t>& geometryBuffer,
+	const Array<uint8_t>& fileBuffer, float normalTolerance)
+{
+	ArrayView<const uint8_t> binaryData = fileBuffer.GetSubView(1016, fileBuffer.GetCount());
+	const uint8_t* origGeom = binaryData.GetData();
+	auto originalIndices = reinterpret_cast<const uint16_t*>(&origGeom[576]);
+
+	const uint8_t* geom = geometryBuffer.GetData();
+	auto indices = reinterpret_cast<const uint16_t*>(&geom[model.meshParts[0].indexOffset]);
+
+	bool originalUsed[12] = {};
+
+	for (uint32_t triIdx = 0; triIdx != 12; ++triIdx)
+	{
+		TestVertex triangle[3];
+		for (uint32_t corner = 0; corner != 3; ++corner)
+			ReadTestVertex(model, geom, indices[triIdx * 3 + corner], triangle[corner]);
+
+		bool found = false;
+		for (uint32_t origIdx = 0; origIdx != 12 && found == false; ++origIdx)
+		{
+			if (originalUsed[origIdx])
+				continue;
+
+			TestVertex original[3];
+			for (uint32_t corner = 0; corner != 3; ++corner)
+			{
+				uint16_t vertex = originalIndices[origIdx * 3 + corner];
+				std::memcpy(original[corner].normal, &origGeom[12 * vertex], sizeof(float) * 3);
+				std::memcpy(original[corner].position, &origGeom[288 + 12 * vertex], sizeof(float) * 3);
+			}
+
+			// The first vertex can change, but the winding must stay the same
+			for (uint32_t rotation = 0; rotation != 3 && found == false; ++rotation)
+			{
+				found = TestVerticesMatch(triangle[0], original[rotation], normalTolerance) &&
+					TestVerticesMatch(triangle[1], original[(rotation + 1) % 3], normalTolerance) &&
+					TestVerticesMatch(triangle[2], original[(rotation + 2) % 3], normalTolerance);
+			}
+
+			if (found)
+				originalUsed[origIdx] = true;
+		}
+
+		CHECK(found);
+	}
+}
+
+} // namespace
+
+TEST_CASE("ModelLoader.GlbModelReordered")
+{
+	Allocator* allocator = Allocator::GetDefault();
+	Filesystem filesystem(allocator, nullptr);
+	Array<uint8_t> buffer(allocator);
+	CHECK(filesystem.ReadBinary("test/res/model/Box.glb", buffer) == true);
+
+	ModelLoader modelLoader(allocator);
+	ModelData model;
+	Array<uint8_t> geometryBuffer(allocator);
+	CHECK(modelLoader.LoadGlbFromBuffer(&model, &geometryBuffer, buffer.GetView()) == true);
+
+	CHECK(model.meshParts[0].count == 36);
+	CHECK(model.meshParts[0].uniqueVertexCount == 24);
+	CHECK(model.meshes[0].lodCount == 1);
+	CHECK(model.meshParts[0].lods[0].indexOffset == model.meshParts[0].indexOffset);
+
+	// Attributes are interleaved
+	CHECK(model.meshParts[0].vertexFormat.attributeCount == 2);
+	CHECK(model.meshParts[0].vertexFormat.attributes[0].stride == 24);
+	CHECK(model.meshParts[0].vertexFormat.attributes[1].stride == 24);
+
+	// Vertices are in the order they are first used
+	const uint8_t* geom = geometryBuffer.GetData();
+	auto indices = reinterpret_cast<const uint16_t*>(&geom[model.meshParts[0].indexOffset]);
+	uint32_t nextVertex = 0;
+	for (uint32_t idx = 0; idx != model.meshParts[0].count; ++idx)
+	{
+		CHECK(indices[idx] <= nextVertex);
+		if (indices[idx] == nextVertex)
+			nextVertex += 1;
+	}
+
+	CheckBoxTriangles(model, geometryBuffer, buffer, 0.0f);
+
+	model.ReleaseMemory(allocator);
+}
+
+TEST_CASE("ModelLoader.GlbModelCompactVertexFormat")
+{
+	Allocator* allocator = Allocator::GetDefault();
+	Filesystem filesystem(allocator, nullptr);
+	Array<uint8_t> buffer(allocator);
+	CHECK(filesystem.ReadBinary("test/res/model/Box.glb", buffer) == true);
+
+	ModelLoadOptions loadOptions;
+	loadOptions.compactVertexFormat = true;
+
+	ModelLoader modelLoader(allocator);
+	modelLoader.SetOptions(loadOptions);
+	ModelData model;
+	Array<uint8_t> geometryBuffer(allocator);
+	CHECK(modelLoader.LoadGlbFromBuffer(&model, &geometryBuffer, buffer.GetView()) == true);
+
+	CHECK(model.meshParts[0].vertexFormat.attributeCount == 2);
+
+	const VertexAttribute& normal = model.meshParts[0].vertexFormat.attributes[0];
+	CHECK(normal.attrIndex == VertexFormat::AttributeIndexNor);
+	CHECK(normal.elemType == RenderVertexElemType::Snorm10_10_10_2);
+	CHECK(normal.elemCount == 4);
+	CHECK(normal.stride == 16);
+
+	// Positions are used on the CPU as well, so they keep full precision
+	const VertexAttribute& position = model.meshParts[0].vertexFormat.attributes[1];
+	CHECK(position.attrIndex == VertexFormat::AttributeIndexPos);
+	CHECK(position.elemType == RenderVertexElemType::Float);
+	CHECK(position.stride == 16);
+
+	CheckBoxTriangles(model, geometryBuffer, buffer, 1.0f / 511.0f);
+
+	model.ReleaseMemory(allocator);
+}
+
+TEST_CASE("ModelLoader.HalfFloat")
+{
+	const float values[] = { 0.0f, 1.0f, -2.5f, 0.333333f, 1.0e-5f, 65504.0f };
+	for (float value : values)
+		CHECK(std::fabs(HalfToFloat(FloatToHalf(value)) - value) <= std::fabs(value) * (1.0f / 2048.0f) + 1.0e-7f);
+
+	CHECK(FloatToHalf(1.0f) == 0x3C00);
+	CHECK(FloatToHalf(-2.0f) == 0xC000);
+	CHECK(FloatToHalf(1.0e6f) == 0x7C00);
+}
+
 } // namespace kokko
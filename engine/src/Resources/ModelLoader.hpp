@@ -8,6 +8,14 @@
 #include "Core/SortedArray.hpp"
 #include "Core/Uid.hpp"
 
+#include "Math/Vec3.hpp"
+
+#include "Rendering/RenderTypes.hpp"
+#include "Rendering/VertexFormat.hpp"
+
+#include "Resources/MeshOptimizer.hpp"
+#include "Resources/MeshSimplifier.hpp"
+
 struct cgltf_buffer_view;
 struct cgltf_data;
 struct cgltf_mesh;
@@ -18,19 +26,35 @@ namespace kokko
 
 struct ModelData;
 struct ModelMesh;
+struct ModelMeshPart;
 struct ModelCreateInfo;
 
+struct ModelLoadOptions
+{
+	// Reorder triangles for the post-transform cache and overdraw, and vertices for fetch locality
+	bool reorderGeometry = true;
+
+	// Store normals as packed 10-bit values and texture coordinates as half floats when in range
+	bool compactVertexFormat = false;
+};
+
 class ModelLoader
 {
 public:
 	ModelLoader(Allocator* allocator);
 
+	// Options only affect models loaded from files
+	void SetOptions(const ModelLoadOptions& options) { this->options = options; }
+	const ModelLoadOptions& GetOptions() const { return options; }
+
 	bool LoadRuntime(ModelData* modelOut, Array<uint8_t>* geometryBufferOut, const ModelCreateInfo& createInfo);
 	bool LoadGlbFromBuffer(ModelData* modelOut, Array<uint8_t>* geometryBufferOut, ArrayView<const uint8_t> buffer);
 
 private:
 	Allocator* allocator;
 
+	ModelLoadOptions options;
+
 	ModelData* outputModel = nullptr;
 
 	ArrayView<char> textBuffer;
@@ -41,10 +65,32 @@ private:
 	SortedArray<cgltf_buffer_view*> uniqueGeometryBufferViews;
 	Array<Range<size_t>> geometryBufferViewRangeMap;
 
+	// Buffer views from the file, while geometry is rebuilt into geometryBuffer
+	Array<uint8_t> sourceGeometry;
+
+	MeshOptimizer optimizer;
+	Array<uint32_t> partIndices;
+	Array<uint32_t> optimizedIndices;
+	Array<uint32_t> vertexRemap;
+	Array<uint32_t> vertexOrder; // Source vertex of each output vertex
+	Array<Vec3f> partPositions;
+	Array<VertexAttribute> partAttributes;
+
+	MeshSimplifier simplifier;
+	Array<Vec3f> lodPositions;
+	Array<uint32_t> lodSourceIndices;
+	Array<uint32_t> lodIndices;
+
 	void Reset();
 	
 	void LoadGltfNode(int16_t parent, cgltf_data* data, cgltf_node* node);
 	bool LoadGltfMesh(cgltf_mesh* cgltfMesh, ModelMesh& modelMeshOut);
+
+	void RebuildGeometry();
+	void RebuildMeshPart(const ModelMesh& mesh, ModelMeshPart& part);
+
+	void GenerateMeshLods(ModelMesh& mesh);
+	uint32_t AppendIndices(const uint32_t* indices, uint32_t count, RenderIndexType indexType);
 };
 
 } // namespace kokko
@@ -1,8 +1,12 @@
 #include "Resources/ModelManager.hpp"
 
+#include <cstring>
+
 #include "Core/Array.hpp"
 #include "Core/Core.hpp"
 
+#include "Math/Math.hpp"
+
 #include "Resources/AssetLoader.hpp"
 #include "Resources/MeshId.hpp"
 
@@ -11,6 +15,38 @@
 namespace kokko
 {
 
+namespace
+{
+
+const ModelMeshOccluder EmptyOccluder = ModelMeshOccluder{ nullptr, nullptr, 0, 0 };
+
+const VertexAttribute* FindPositionAttribute(const VertexFormat& vertexFormat)
+{
+	for (uint32_t i = 0; i < vertexFormat.attributeCount; ++i)
+	{
+		const VertexAttribute& attr = vertexFormat.attributes[i];
+		if (attr.attrIndex == VertexFormat::AttributeIndexPos && attr.elemCount >= 3 &&
+			attr.elemType == RenderVertexElemType::Float)
+			return &attr;
+	}
+
+	return nullptr;
+}
+
+bool CanBeOccluder(const ModelData& model, const ModelMesh& mesh)
+{
+	if (mesh.primitiveMode != RenderPrimitiveMode::Triangles)
+		return false;
+
+	for (uint32_t partIdx = mesh.partOffset, end = mesh.partOffset + mesh.partCount; partIdx != end; ++partIdx)
+		if (FindPositionAttribute(model.meshParts[partIdx].vertexFormat) == nullptr)
+			return false;
+
+	return true;
+}
+
+} // namespace
+
 ModelManager::ModelManager(Allocator* allocator, AssetLoader* assetLoader, render::Device* renderDevice) :
 	allocator(allocator),
 	assetLoader(assetLoader),
@@ -52,6 +88,7 @@ ModelId ModelManager::FindModelByUid(const kokko::Uid& uid)
 		ModelData& model = data.model[id];
 		model.uid = uid;
 		model.hasUid = true;
+		model.loadOptions = modelLoader.GetOptions();
 
 		Array<uint8_t> geometryBuffer(allocator);
 
@@ -99,6 +136,7 @@ ModelId ModelManager::CreateModel(const ModelCreateInfo& info)
 
 	uint32_t id = AcquireSlot();
 	ModelData& model = data.model[id];
+	model.hasUid = false;
 
 	Array<uint8_t> geometryBuffer(allocator);
 
@@ -131,6 +169,11 @@ void ModelManager::RemoveModel(ModelId id)
 	ReleaseSlot(id.i);
 }
 
+void ModelManager::SetLoadOptions(const ModelLoadOptions& options)
+{
+	modelLoader.SetOptions(options);
+}
+
 void ModelManager::SetMeshAABB(MeshId id, const AABB& bounds)
 {
 	assert(id != MeshId::Null);
@@ -166,6 +209,56 @@ ArrayView<const ModelMeshPart> ModelManager::GetModelMeshParts(ModelId id) const
 	return ArrayView<const ModelMeshPart>(model.meshParts, model.meshPartCount);
 }
 
+void ModelManager::CreateMeshOccluder(MeshId id)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	assert(id != MeshId::Null);
+	ModelData& model = data.model[id.modelId.i];
+	assert(id.meshIndex < model.meshCount);
+
+	if (model.occludersCreated)
+		return;
+
+	// Don't try again even if loading fails
+	model.occludersCreated = true;
+
+	if (model.hasUid == false)
+		return;
+
+	Array<uint8_t> file(allocator);
+	if (assetLoader->LoadAsset(model.uid, file).success == false)
+		return;
+
+	ModelData sourceModel;
+	Array<uint8_t> geometryBuffer(allocator);
+
+	ModelLoadOptions currentOptions = modelLoader.GetOptions();
+	modelLoader.SetOptions(model.loadOptions);
+	bool loaded = modelLoader.LoadGlbFromBuffer(&sourceModel, &geometryBuffer, file.GetView());
+	modelLoader.SetOptions(currentOptions);
+
+	if (loaded)
+	{
+		assert(sourceModel.meshPartCount == model.meshPartCount);
+		CreateOccluderData(model, geometryBuffer);
+	}
+
+	sourceModel.ReleaseMemory(allocator);
+}
+
+const ModelMeshOccluder& ModelManager::GetMeshOccluder(MeshId id) const
+{
+	assert(id != MeshId::Null);
+	const ModelData& model = data.model[id.modelId.i];
+	assert(id.meshIndex < model.meshCount);
+
+	if (model.meshOccluders == nullptr)
+		return EmptyOccluder;
+
+	return model.meshOccluders[id.meshIndex];
+}
+
 uint32_t ModelManager::AcquireSlot()
 {
 	uint32_t id;
@@ -270,6 +363,10 @@ void ModelManager::CreateRenderData(ModelData& model, Array<uint8_t>& geometryBu
 			}
 		}
 	}
+
+	model.occluderBuffer = nullptr;
+	model.meshOccluders = nullptr;
+	model.occludersCreated = false;
 }
 
 void ModelManager::ReleaseRenderData(ModelData& model)
@@ -285,6 +382,101 @@ void ModelManager::ReleaseRenderData(ModelData& model)
 		renderDevice->DestroyBuffers(1, &model.bufferId);
 		model.bufferId = render::BufferId::Null;
 	}
+
+	ReleaseOccluderData(model);
+}
+
+void ModelManager::CreateOccluderData(ModelData& model, const Array<uint8_t>& geometryBuffer)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	// Copy the positions and indices of triangle meshes into a compact buffer
+
+	size_t totalVertexCount = 0;
+	size_t totalIndexCount = 0;
+
+	for (uint32_t meshIdx = 0; meshIdx < model.meshCount; ++meshIdx)
+	{
+		const ModelMesh& mesh = model.meshes[meshIdx];
+		if (CanBeOccluder(model, mesh) == false)
+			continue;
+
+		for (uint32_t partIdx = mesh.partOffset, end = mesh.partOffset + mesh.partCount; partIdx != end; ++partIdx)
+		{
+			totalVertexCount += model.meshParts[partIdx].uniqueVertexCount;
+			totalIndexCount += model.meshParts[partIdx].count;
+		}
+	}
+
+	if (totalIndexCount == 0 || model.meshCount == 0)
+		return;
+
+	const size_t alignment = 16;
+	const size_t occluderBytes = Math::RoundUpToMultiple(sizeof(ModelMeshOccluder) * model.meshCount, alignment);
+	const size_t positionBytes = Math::RoundUpToMultiple(sizeof(Vec3f) * totalVertexCount, alignment);
+	const size_t indexBytes = sizeof(uint32_t) * totalIndexCount;
+
+	uint8_t* buffer = static_cast<uint8_t*>(allocator->Allocate(
+		occluderBytes + positionBytes + indexBytes, "ModelManager.occluderBuffer"));
+
+	model.occluderBuffer = buffer;
+	model.meshOccluders = reinterpret_cast<ModelMeshOccluder*>(buffer);
+
+	Vec3f* positions = reinterpret_cast<Vec3f*>(buffer + occluderBytes);
+	uint32_t* indices = reinterpret_cast<uint32_t*>(buffer + occluderBytes + positionBytes);
+
+	const uint8_t* geometry = geometryBuffer.GetData();
+
+	for (uint32_t meshIdx = 0; meshIdx < model.meshCount; ++meshIdx)
+	{
+		const ModelMesh& mesh = model.meshes[meshIdx];
+		ModelMeshOccluder& occluder = model.meshOccluders[meshIdx];
+
+		if (CanBeOccluder(model, mesh) == false)
+		{
+			occluder = EmptyOccluder;
+			continue;
+		}
+
+		occluder.positions = positions;
+		occluder.indices = indices;
+		occluder.vertexCount = 0;
+		occluder.indexCount = 0;
+
+		for (uint32_t partIdx = mesh.partOffset, end = mesh.partOffset + mesh.partCount; partIdx != end; ++partIdx)
+		{
+			const ModelMeshPart& part = model.meshParts[partIdx];
+			const VertexAttribute* posAttr = FindPositionAttribute(part.vertexFormat);
+
+			size_t stride = posAttr->stride != 0 ? posAttr->stride : sizeof(float) * posAttr->elemCount;
+			const uint8_t* vertexData = geometry + posAttr->offset;
+
+			for (uint32_t vertIdx = 0; vertIdx < part.uniqueVertexCount; ++vertIdx)
+				std::memcpy(&positions[vertIdx], vertexData + vertIdx * stride, sizeof(Vec3f));
+
+			// Indices are relative to the part, so they need to be rebased
+			const uint8_t* indexData = geometry + part.indexOffset;
+			uint32_t vertexBase = occluder.vertexCount;
+
+			for (uint32_t idx = 0; idx < part.count; ++idx)
+				indices[idx] = vertexBase + ReadRenderIndex(indexData, mesh.indexType, idx);
+
+			positions += part.uniqueVertexCount;
+			indices += part.count;
+			occluder.vertexCount += part.uniqueVertexCount;
+			occluder.indexCount += part.count;
+		}
+	}
+}
+
+void ModelManager::ReleaseOccluderData(ModelData& model)
+{
+	if (model.occluderBuffer != nullptr)
+		allocator->Deallocate(model.occluderBuffer);
+
+	model.occluderBuffer = nullptr;
+	model.meshOccluders = nullptr;
+	model.occludersCreated = false;
 }
 
 }
@@ -9,6 +9,7 @@
 
 #include "Math/AABB.hpp"
 #include "Math/Mat4x4.hpp"
+#include "Math/Vec3.hpp"
 
 #include "Rendering/RenderTypes.hpp"
 #include "Rendering/RenderResourceId.hpp"
@@ -42,15 +43,29 @@ struct ModelNode
 
 struct ModelMesh
 {
+	// Level 0 is the original mesh, the rest are simplified versions of it
+	static constexpr uint32_t MaxLodCount = 4;
+
 	uint16_t partOffset;
 	uint16_t partCount;
 
 	RenderIndexType indexType;
 	RenderPrimitiveMode primitiveMode;
+	uint8_t lodCount;
 
 	const char* name;
 
 	AABB aabb;
+
+	// Largest distance of each level from the original surface, in mesh space
+	float lodErrors[MaxLodCount];
+};
+
+// Index range of a mesh part at one level of detail, all levels share the vertices of the part
+struct ModelMeshLod
+{
+	uint32_t indexOffset;
+	uint32_t count;
 };
 
 struct ModelMeshPart
@@ -59,10 +74,22 @@ struct ModelMeshPart
 	uint32_t indexOffset;
 	uint32_t count;
 
+	// The first level is the same range as indexOffset and count
+	ModelMeshLod lods[ModelMesh::MaxLodCount];
+
 	VertexFormat vertexFormat;
 	render::VertexArrayId vertexArrayId;
 };
 
+// Triangle list of a mesh kept in CPU memory, used for software occlusion culling
+struct ModelMeshOccluder
+{
+	const Vec3f* positions;
+	const uint32_t* indices;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+};
+
 struct ModelData
 {
 	void ReleaseMemory(Allocator* allocator);
@@ -76,6 +103,12 @@ struct ModelData
 	ModelMeshPart* meshParts = nullptr;
 	VertexAttribute* attributes = nullptr;
 
+	void* occluderBuffer = nullptr;
+	ModelMeshOccluder* meshOccluders = nullptr;
+
+	// Options the model was loaded with, so that the geometry can be loaded again identically
+	ModelLoadOptions loadOptions;
+
 	uint32_t nodeCount = 0;
 	uint32_t meshCount = 0;
 	uint32_t meshPartCount = 0;
@@ -84,6 +117,7 @@ struct ModelData
 	render::BufferId bufferId;
 
 	bool hasUid = false;
+	bool occludersCreated = false;
 };
 
 struct ModelCreateInfo
@@ -119,6 +153,9 @@ public:
 
 	void RemoveModel(ModelId id);
 
+	// Applies to models loaded after this call
+	void SetLoadOptions(const ModelLoadOptions& options);
+
 	// Model info setters
 
 	void SetMeshAABB(MeshId id, const AABB& bounds);
@@ -131,6 +168,14 @@ public:
 	ArrayView<const ModelMesh> GetModelMeshes(ModelId id) const;
 	ArrayView<const ModelMeshPart> GetModelMeshParts(ModelId id) const;
 
+	// Creates CPU copies of the triangles of the model's meshes, if they don't exist yet.
+	// Geometry is loaded again from the model asset, so runtime models can't be occluders.
+	void CreateMeshOccluder(MeshId id);
+
+	// Returns an empty occluder if CreateMeshOccluder hasn't been called for the model,
+	// or the mesh doesn't consist of triangles
+	const ModelMeshOccluder& GetMeshOccluder(MeshId id) const;
+
 private:
 	Allocator* allocator;
 	AssetLoader* assetLoader;
@@ -158,6 +203,9 @@ private:
 
 	void CreateRenderData(ModelData& model, Array<uint8_t>& geometryBuffer);
 	void ReleaseRenderData(ModelData& model);
+
+	void CreateOccluderData(ModelData& model, const Array<uint8_t>& geometryBuffer);
+	void ReleaseOccluderData(ModelData& model);
 };
 
 } // namespace kokko
@@ -0,0 +1,133 @@
+#include "Resources/ShaderBinaryCache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#include "Core/Core.hpp"
+#include "Core/Hash.hpp"
+
+#include "Engine/EngineConstants.hpp"
+
+#include "Rendering/RenderDevice.hpp"
+
+#include "System/Filesystem.hpp"
+
+namespace kokko
+{
+
+ShaderBinaryCache::ShaderBinaryCache(Allocator* allocator, Filesystem* filesystem, render::Device* renderDevice) :
+	filesystem(filesystem),
+	renderDevice(renderDevice),
+	driverHash(0),
+	driverHashValid(false),
+	directoryCreated(false),
+	fileBuffer(allocator)
+{
+}
+
+uint64_t ShaderBinaryCache::CalculateKey(ArrayView<const ConstStringView> stageSources)
+{
+	if (driverHashValid == false)
+	{
+		const RenderDeviceString strings[] = {
+			RenderDeviceString::Vendor,
+			RenderDeviceString::Renderer,
+			RenderDeviceString::Version
+		};
+
+		uint64_t hash = 0;
+		for (RenderDeviceString name : strings)
+		{
+			ConstStringView str = renderDevice->GetStringValue(name);
+			hash = HashValue64(str.str, str.len, hash);
+		}
+
+		driverHash = hash;
+		driverHashValid = true;
+	}
+
+	uint64_t key = driverHash;
+	for (const ConstStringView& source : stageSources)
+		key = HashValue64(source.str, source.len, key);
+
+	return key;
+}
+
+bool ShaderBinaryCache::LoadProgram(uint64_t key, unsigned int shaderProgram)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	char path[256];
+	GetCacheFilePath(key, path, sizeof(path));
+
+	fileBuffer.Clear();
+	if (filesystem->ReadBinary(path, fileBuffer) == false)
+		return false;
+
+	FileHeader header;
+	if (fileBuffer.GetCount() < sizeof(FileHeader))
+		return false;
+
+	std::memcpy(&header, fileBuffer.GetData(), sizeof(FileHeader));
+
+	if (header.magic != FileHeader::Magic ||
+		header.version != FileHeader::CurrentVersion ||
+		header.key != key ||
+		fileBuffer.GetCount() != sizeof(FileHeader) + header.binaryLength)
+	{
+		KK_LOG_WARN("Shader binary cache file {} is invalid", path);
+		return false;
+	}
+
+	renderDevice->SetShaderProgramBinary(shaderProgram, header.binaryFormat,
+		fileBuffer.GetData() + sizeof(FileHeader), static_cast<int>(header.binaryLength));
+
+	// Drivers are allowed to reject binaries for any reason, caller will fall back to compiling
+	return renderDevice->GetShaderProgramLinkStatus(shaderProgram);
+}
+
+void ShaderBinaryCache::StoreProgram(uint64_t key, unsigned int shaderProgram)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	int binaryLength = renderDevice->GetShaderProgramBinaryLength(shaderProgram);
+	if (binaryLength <= 0)
+		return;
+
+	fileBuffer.Resize(sizeof(FileHeader) + binaryLength);
+
+	FileHeader header;
+	header.magic = FileHeader::Magic;
+	header.version = FileHeader::CurrentVersion;
+	header.key = key;
+	header.binaryFormat = 0;
+	header.binaryLength = static_cast<uint32_t>(binaryLength);
+
+	renderDevice->GetShaderProgramBinary(shaderProgram, binaryLength,
+		&header.binaryFormat, fileBuffer.GetData() + sizeof(FileHeader));
+
+	std::memcpy(fileBuffer.GetData(), &header, sizeof(FileHeader));
+
+	if (directoryCreated == false)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(EngineConstants::ShaderCachePath, error);
+		directoryCreated = true;
+	}
+
+	char path[256];
+	GetCacheFilePath(key, path, sizeof(path));
+
+	if (filesystem->Write(path, fileBuffer.GetView(), false) == false)
+		KK_LOG_WARN("Couldn't write shader binary cache file {}", path);
+}
+
+void ShaderBinaryCache::GetCacheFilePath(uint64_t key, char* pathOut, size_t pathSize)
+{
+	std::snprintf(pathOut, pathSize, "%s/%016llx.bin", EngineConstants::ShaderCachePath,
+		static_cast<unsigned long long>(key));
+}
+
+} // namespace kokko
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Core/Array.hpp"
+#include "Core/ArrayView.hpp"
+#include "Core/StringView.hpp"
+
+namespace kokko
+{
+
+class Allocator;
+class Filesystem;
+
+namespace render
+{
+class Device;
+}
+
+// Stores linked shader program binaries on disk, so that unchanged shaders
+// don't have to be compiled again on the next run.
+class ShaderBinaryCache
+{
+public:
+	ShaderBinaryCache(Allocator* allocator, Filesystem* filesystem, render::Device* renderDevice);
+
+	// Key is calculated from the fully preprocessed stage sources and the driver description,
+	// so a driver update will invalidate all cached binaries
+	uint64_t CalculateKey(ArrayView<const ConstStringView> stageSources);
+
+	// Returns true if a binary was found and the program was successfully linked from it
+	bool LoadProgram(uint64_t key, unsigned int shaderProgram);
+
+	// Program must have been linked successfully
+	void StoreProgram(uint64_t key, unsigned int shaderProgram);
+
+private:
+	struct FileHeader
+	{
+		static const uint32_t Magic = 0x4248534B; // "KSHB"
+		static const uint32_t CurrentVersion = 1;
+
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint32_t binaryFormat;
+		uint32_t binaryLength;
+	};
+
+	void GetCacheFilePath(uint64_t key, char* pathOut, size_t pathSize);
+
+	Filesystem* filesystem;
+	render::Device* renderDevice;
+
+	uint64_t driverHash;
+	bool driverHashValid;
+	bool directoryCreated;
+
+	Array<uint8_t> fileBuffer;
+};
+
+} // namespace kokko
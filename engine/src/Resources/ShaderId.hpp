@@ -7,8 +7,8 @@ struct ShaderId
 {
 	unsigned int i;
 
-	bool operator==(const ShaderId& other) { return i == other.i; }
-	bool operator!=(const ShaderId& other) { return operator==(other) == false; }
+	bool operator==(const ShaderId& other) const { return i == other.i; }
+	bool operator!=(const ShaderId& other) const { return operator==(other) == false; }
 
 	static const ShaderId Null;
 };
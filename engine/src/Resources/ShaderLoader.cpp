@@ -22,6 +22,7 @@
 #include "Rendering/StaticUniformBuffer.hpp"
 #include "Rendering/Uniform.hpp"
 
+#include "Resources/ShaderBinaryCache.hpp"
 #include "Resources/ShaderManager.hpp"
 
 #include "System/Filesystem.hpp"
@@ -46,10 +47,14 @@ bool BufferUniformSortPredicate(const BufferUniform& a, const BufferUniform& b)
 	return aType.size > bType.size;
 }
 
+// If declareTextures is set, texture uniforms are declared for the shader. With bindlessTextures
+// they are declared as handles in the material uniform block, otherwise as regular uniforms.
 void AddUniformsAndShaderPath(
 	ShaderData& shaderOut,
 	ArrayView<const AddUniforms_UniformData> uniforms,
 	ConstStringView shaderPath,
+	bool declareTextures,
+	bool bindlessTextures,
 	Allocator* allocator)
 {
 	KOKKO_PROFILE_FUNCTION();
@@ -63,6 +68,12 @@ void AddUniformsAndShaderPath(
 	const size_t blockRowFixedMaxLen = std::strlen(blockRowFormat) - blockRowPlaceholdersLen;
 	const char* blockEnd = "};\n";
 	const size_t blockEndLen = std::strlen(blockEnd);
+	const char* bindlessExtension = "#extension GL_ARB_bindless_texture : require\n";
+	const size_t bindlessExtensionLen = std::strlen(bindlessExtension);
+	const char* textureRowFormat = "uniform {} {};\n";
+	const size_t textureRowFixedMaxLen = std::strlen(textureRowFormat) - blockRowPlaceholdersLen;
+
+	bindlessTextures = bindlessTextures && declareTextures;
 
 	// Calculate how much memory we need to store:
 	// - Uniform names
@@ -86,6 +97,9 @@ void AddUniformsAndShaderPath(
 		{
 			nameBytes += uniform.name.len + 1;
 			++textureUniformCount;
+
+			if (declareTextures)
+				uniformBlockBytes += uniform.name.len + type.typeNameLength + textureRowFixedMaxLen;
 		}
 		else
 		{
@@ -96,6 +110,9 @@ void AddUniformsAndShaderPath(
 		}
 	}
 
+	if (bindlessTextures)
+		uniformBlockBytes += bindlessExtensionLen;
+
 	const size_t shaderDataAlignment = 8;
 	nameBytes = Math::RoundUpToMultiple(nameBytes, shaderDataAlignment);
 	uniformBlockBytes = Math::RoundUpToMultiple(uniformBlockBytes, shaderDataAlignment);
@@ -138,6 +155,7 @@ void AddUniformsAndShaderPath(
 
 			// Since shader is not compiled at this point, we can't know the uniform location
 			uniform.uniformLocation = -1;
+			uniform.bufferObjectOffset = 0;
 			uniform.textureObject = kokko::render::TextureId();
 
 			++textureUniformsCopied;
@@ -213,22 +231,40 @@ void AddUniformsAndShaderPath(
 		}
 	}
 
+	// Bindless texture handles are placed after the other uniforms
+
+	if (bindlessTextures)
+	{
+		for (size_t i = 0; i < textureUniformCount; ++i)
+		{
+			TextureUniform& uniform = shaderOut.uniforms.textureUniforms[i];
+			const UniformTypeInfo& type = UniformTypeInfo::FromType(uniform.type);
+
+			bufferObjectOffset = Math::RoundUpToMultiple(bufferObjectOffset, type.alignment);
+			uniform.bufferObjectOffset = bufferObjectOffset;
+			bufferObjectOffset += type.size;
+		}
+	}
+
 	const unsigned int bufferSizeUnit = 16;
 
 	shaderOut.uniforms.uniformDataSize = dataBufferOffset;
 	shaderOut.uniforms.uniformBufferSize = Math::RoundUpToMultiple(bufferObjectOffset, bufferSizeUnit);
+	shaderOut.uniforms.textureHandlesInBuffer = bindlessTextures && textureUniformCount > 0;
 
 	// Generate uniform block definition
 
-	if (shaderOut.uniforms.bufferUniformCount == 0)
+	shaderOut.uniformBlockDefinition = ConstStringView(uniformBlockPtr, 0);
+
+	if (shaderOut.uniforms.textureHandlesInBuffer)
 	{
-		shaderOut.uniformBlockDefinition = ConstStringView();
+		StringCopyN(uniformBlockPtr, bindlessExtension, bindlessExtensionLen + 1);
+		uniformBlockPtr += bindlessExtensionLen;
 	}
-	else
+
+	if (shaderOut.uniforms.bufferUniformCount > 0 || shaderOut.uniforms.textureHandlesInBuffer)
 	{
 		{
-			shaderOut.uniformBlockDefinition.str = uniformBlockPtr;
-
 			auto bufLeft = shaderDataEnd - uniformBlockPtr;
 			uint32_t materialBind = UniformBlockBinding::Material;
 
@@ -251,11 +287,44 @@ void AddUniformsAndShaderPath(
 			uniformBlockPtr += formatRes.size;
 		}
 
+		if (shaderOut.uniforms.textureHandlesInBuffer)
+		{
+			for (size_t i = 0; i < textureUniformCount; ++i)
+			{
+				const TextureUniform& uniform = shaderOut.uniforms.textureUniforms[i];
+				const UniformTypeInfo& typeInfo = UniformTypeInfo::FromType(uniform.type);
+
+				auto bufLeft = shaderDataEnd - uniformBlockPtr;
+				auto formatRes = fmt::format_to_n(
+					uniformBlockPtr, bufLeft, blockRowFormat, typeInfo.typeName, uniform.name.str);
+				assert(static_cast<ptrdiff_t>(formatRes.size) <= bufLeft);
+				uniformBlockPtr += formatRes.size;
+			}
+		}
+
 		StringCopyN(uniformBlockPtr, blockEnd, blockEndLen + 1);
 		uniformBlockPtr += blockEndLen;
+	}
+
+	if (declareTextures && bindlessTextures == false)
+	{
+		for (size_t i = 0; i < textureUniformCount; ++i)
+		{
+			const TextureUniform& uniform = shaderOut.uniforms.textureUniforms[i];
+			const UniformTypeInfo& typeInfo = UniformTypeInfo::FromType(uniform.type);
 
-		shaderOut.uniformBlockDefinition.len = uniformBlockPtr - shaderOut.uniformBlockDefinition.str;
+			auto bufLeft = shaderDataEnd - uniformBlockPtr;
+			auto formatRes = fmt::format_to_n(
+				uniformBlockPtr, bufLeft, textureRowFormat, typeInfo.typeName, uniform.name.str);
+			assert(static_cast<ptrdiff_t>(formatRes.size) <= bufLeft);
+			uniformBlockPtr += formatRes.size;
+		}
 	}
+
+	shaderOut.uniformBlockDefinition.len = uniformBlockPtr - shaderOut.uniformBlockDefinition.str;
+
+	if (shaderOut.uniformBlockDefinition.len == 0)
+		shaderOut.uniformBlockDefinition = ConstStringView();
 }
 
 void UpdateTextureUniformLocations(
@@ -271,112 +340,104 @@ void UpdateTextureUniformLocations(
 	}
 }
 
-bool Compile(
-	ShaderData& shaderOut,
-	Allocator* allocator,
+void StartCompileAndLink(
+	ArrayView<const ShaderLoader::StageSource> stages,
 	kokko::render::Device* renderDevice,
-	RenderShaderStage stage,
-	ConstStringView source,
-	unsigned int& shaderIdOut)
+	ShaderBinaryCache* binaryCache,
+	PendingShaderProgram& pendingOut)
 {
 	KOKKO_PROFILE_FUNCTION();
 
-	unsigned int shaderId = renderDevice->CreateShaderStage(stage);
+	pendingOut.programId = renderDevice->CreateShaderProgram();
+	pendingOut.stageCount = 0;
+	pendingOut.cacheKey = 0;
+	pendingOut.loadedFromCache = false;
+
+	if (binaryCache != nullptr)
+	{
+		ConstStringView sources[ShaderLoader::MaxStageCount];
+		for (size_t i = 0, count = stages.GetCount(); i < count; ++i)
+			sources[i] = stages[i].source;
+
+		pendingOut.cacheKey = binaryCache->CalculateKey(ArrayView<const ConstStringView>(sources, stages.GetCount()));
 
-	renderDevice->SetShaderStageSource(shaderId, source.str, static_cast<int>(source.len));
-	renderDevice->CompileShaderStage(shaderId);
+		if (binaryCache->LoadProgram(pendingOut.cacheKey, pendingOut.programId))
+		{
+			pendingOut.loadedFromCache = true;
+			return;
+		}
+
+		renderDevice->SetShaderProgramBinaryRetrievable(pendingOut.programId);
+	}
 
-	// Check compile status
-	if (renderDevice->GetShaderStageCompileStatus(shaderId))
+	// Compile status is not checked here, because that would wait for the compilation to finish
+
+	for (size_t i = 0, count = stages.GetCount(); i < count; ++i)
 	{
-		shaderIdOut = shaderId;
-		return true;
+		unsigned int stageObject = renderDevice->CreateShaderStage(stages[i].stage);
+		renderDevice->SetShaderStageSource(stageObject, stages[i].source.str, static_cast<int>(stages[i].source.len));
+		renderDevice->CompileShaderStage(stageObject);
+		renderDevice->AttachShaderStageToProgram(pendingOut.programId, stageObject);
+
+		pendingOut.stageObjects[i] = stageObject;
 	}
-	else
+
+	pendingOut.stageCount = stages.GetCount();
+
+	renderDevice->LinkShaderProgram(pendingOut.programId);
+}
+
+void LogStageCompileErrors(
+	const PendingShaderProgram& pending,
+	Allocator* allocator,
+	kokko::render::Device* renderDevice,
+	ConstStringView debugName)
+{
+	for (size_t i = 0; i < pending.stageCount; ++i)
 	{
-		// Get info log length
-		int infoLogLength = renderDevice->GetShaderStageInfoLogLength(shaderId);
+		unsigned int stageObject = pending.stageObjects[i];
+
+		if (renderDevice->GetShaderStageCompileStatus(stageObject))
+			continue;
+
+		int infoLogLength = renderDevice->GetShaderStageInfoLogLength(stageObject);
 
 		if (infoLogLength > 0)
 		{
 			String infoLog(allocator);
 			infoLog.Resize(infoLogLength);
 
-			// Print out info log
-			renderDevice->GetShaderStageInfoLog(shaderId, infoLogLength, infoLog.GetData());
+			renderDevice->GetShaderStageInfoLog(stageObject, infoLogLength, infoLog.GetData());
 
-			KK_LOG_ERROR("Shader stage compilation failed:\n{}\nSource:\n{}", infoLog.GetCStr(), source.str);
+			KK_LOG_ERROR("Shader stage compilation failed in {}:\n{}",
+				String(allocator, debugName).GetCStr(), infoLog.GetCStr());
 		}
 	}
-
-	return false;
 }
 
-bool CompileAndLink(
+bool FinishLink(
 	ShaderData& shaderOut,
-	ArrayView<const ShaderLoader::StageSource> stages,
+	const PendingShaderProgram& pending,
 	Allocator* allocator,
 	kokko::render::Device* renderDevice,
+	ShaderBinaryCache* binaryCache,
 	ConstStringView debugName)
 {
 	KOKKO_PROFILE_FUNCTION();
 
-	unsigned int stageObjects[ShaderLoader::MaxStageCount] = { 0 };
-
-	for (size_t i = 0, count = stages.GetCount(); i < stages.GetCount(); ++i)
-	{
-		RenderShaderStage stageType = stages[i].stage;
-		ConstStringView source = stages[i].source;
-
-		unsigned int stageObject = 0;
-		bool compiled = Compile(shaderOut, allocator, renderDevice, stageType, source, stageObject);
+	unsigned int programId = pending.programId;
 
-		if (compiled == false)
-		{
-			for (size_t j = 0; j < i; ++j)
-				renderDevice->DestroyShaderStage(stageObjects[j]);
-
-			return false;
-		}
-
-		stageObjects[i] = stageObject;
-	}
-
-	// At this point we know that shader compilations were successful
-
-	unsigned int programId;
 	bool linkSucceeded;
 
 	{
-		KOKKO_PROFILE_SCOPE("Link program");
-
-		// Link the program
-		programId = renderDevice->CreateShaderProgram();
-
-		for (size_t i = 0, count = stages.GetCount(); i < stages.GetCount(); ++i)
-			renderDevice->AttachShaderStageToProgram(programId, stageObjects[i]);
-
-		renderDevice->LinkShaderProgram(programId);
-
-		// Release shaders
-		for (size_t i = 0, count = stages.GetCount(); i < stages.GetCount(); ++i)
-			renderDevice->DestroyShaderStage(stageObjects[i]);
+		KOKKO_PROFILE_SCOPE("Wait for link");
 
 		linkSucceeded = renderDevice->GetShaderProgramLinkStatus(programId);
 	}
 
-	// Check link status
-	if (linkSucceeded)
-	{
-		shaderOut.driverId = kokko::render::ShaderId(programId);
-
-		renderDevice->SetObjectLabel(RenderObjectType::Program, programId, debugName);
-
-		return true;
-	}
-	else
+	if (linkSucceeded == false)
 	{
-		shaderOut.driverId = kokko::render::ShaderId();
+		LogStageCompileErrors(pending, allocator, renderDevice, debugName);
 
 		int infoLogLength = renderDevice->GetShaderProgramInfoLogLength(programId);
 
@@ -392,6 +453,29 @@ bool CompileAndLink(
 		}
 		else
 			KK_LOG_ERROR("Shader program link failed");
+	}
+	else if (binaryCache != nullptr && pending.loadedFromCache == false)
+	{
+		binaryCache->StoreProgram(pending.cacheKey, programId);
+	}
+
+	// Release shaders
+	for (size_t i = 0; i < pending.stageCount; ++i)
+		renderDevice->DestroyShaderStage(pending.stageObjects[i]);
+
+	if (linkSucceeded)
+	{
+		shaderOut.driverId = kokko::render::ShaderId(programId);
+
+		renderDevice->SetObjectLabel(RenderObjectType::Program, programId, debugName);
+
+		return true;
+	}
+	else
+	{
+		shaderOut.driverId = kokko::render::ShaderId();
+
+		renderDevice->DestroyShaderProgram(programId);
 
 		return false;
 	}
@@ -406,10 +490,15 @@ bool CompileAndLink(
 const char* const ShaderLoader::LineBreakChars = "\r\n";
 const char* const ShaderLoader::WhitespaceChars = " \t\r\n";
 
-ShaderLoader::ShaderLoader(Allocator* allocator, Filesystem* filesystem, kokko::render::Device* renderDevice) :
+ShaderLoader::ShaderLoader(
+	Allocator* allocator,
+	Filesystem* filesystem,
+	kokko::render::Device* renderDevice,
+	ShaderBinaryCache* binaryCache) :
 	allocator(allocator),
 	filesystem(filesystem),
 	renderDevice(renderDevice),
+	binaryCache(binaryCache),
 	includeFileCache(allocator),
 	filesIncludedInStage(allocator),
 	pathString(allocator)
@@ -430,6 +519,22 @@ bool ShaderLoader::LoadFromFile(
 {
 	KOKKO_PROFILE_FUNCTION();
 
+	PendingShaderProgram pending;
+	if (StartLoadFromFile(shaderOut, shaderPath, shaderContent, debugName, pending) == false)
+		return false;
+
+	return FinishLoad(shaderOut, pending, debugName);
+}
+
+bool ShaderLoader::StartLoadFromFile(
+	ShaderData& shaderOut,
+	ConstStringView shaderPath,
+	ConstStringView shaderContent,
+	ConstStringView,
+	PendingShaderProgram& pendingOut)
+{
+	KOKKO_PROFILE_FUNCTION();
+
 	ConstStringView programSection;
 	StageSource stageSections[MaxStageCount];
 	size_t stageCount;
@@ -441,9 +546,23 @@ bool ShaderLoader::LoadFromFile(
 
 	ConstStringView versionStr("#version 450\n");
 	ArrayView<const StageSource> stages(stageSections, stageCount);
-	if (ProcessShaderStages(shaderOut, shaderPath, stages, versionStr, debugName) == false)
+	if (ProcessShaderStages(shaderOut, shaderPath, stages, versionStr, pendingOut) == false)
+		return false;
+
+	return true;
+}
+
+bool ShaderLoader::FinishLoad(
+	ShaderData& shaderInOut,
+	PendingShaderProgram& pending,
+	ConstStringView debugName)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	if (FinishLink(shaderInOut, pending, allocator, renderDevice, binaryCache, debugName) == false)
 		return false;
 
+	UpdateTextureUniformLocations(shaderInOut, renderDevice);
 	return true;
 }
 
@@ -595,8 +714,13 @@ void ShaderLoader::ProcessProgramProperties(
 		uniformCount += 1;
 	}
 
+	// Shaders with this directive get their texture uniforms declared by the engine,
+	// using bindless texture handles in the material uniform block when supported
+	bool declareTextures = programSection.FindFirst(ConstStringView("#bindless_textures")) >= 0;
+	bool bindlessTextures = declareTextures && renderDevice->IsBindlessTextureSupported();
+
 	ArrayView<const AddUniforms_UniformData> uniformBufferRef(uniforms, uniformCount);
-	AddUniformsAndShaderPath(shaderOut, uniformBufferRef, shaderPath, allocator);
+	AddUniformsAndShaderPath(shaderOut, uniformBufferRef, shaderPath, declareTextures, bindlessTextures, allocator);
 
 	// Set default value
 	shaderOut.transparencyType = TransparencyType::Opaque;
@@ -608,7 +732,7 @@ bool ShaderLoader::ProcessShaderStages(
 	ConstStringView shaderPath,
 	ArrayView<const StageSource> stages,
 	ConstStringView versionStr,
-	ConstStringView debugName)
+	PendingShaderProgram& pendingOut)
 {
 	KOKKO_PROFILE_FUNCTION();
 
@@ -632,10 +756,7 @@ bool ShaderLoader::ProcessShaderStages(
 
     ArrayView<const StageSource> stageSourceRef(stageSources, stages.GetCount());
 
-    if (CompileAndLink(shaderOut, stageSourceRef, allocator, renderDevice, debugName) == false)
-        return false;
-
-    UpdateTextureUniformLocations(shaderOut, renderDevice);
+    StartCompileAndLink(stageSourceRef, renderDevice, binaryCache, pendingOut);
     return true;
 }
 
@@ -16,6 +16,7 @@ namespace kokko
 
 class Allocator;
 class Filesystem;
+class ShaderBinaryCache;
 
 struct ShaderData;
 
@@ -24,6 +25,19 @@ namespace render
 class Device;
 }
 
+// Program whose compilation and linking has been issued to the driver,
+// but whose status hasn't been queried yet
+struct PendingShaderProgram
+{
+	static constexpr size_t MaxStageCount = 3;
+
+	unsigned int programId;
+	unsigned int stageObjects[MaxStageCount];
+	size_t stageCount;
+	uint64_t cacheKey;
+	bool loadedFromCache;
+};
+
 class ShaderLoader
 {
 public:
@@ -35,7 +49,8 @@ public:
 
 	ShaderLoader(Allocator* allocator,
 		Filesystem* filesystem,
-		kokko::render::Device* renderDevice);
+		kokko::render::Device* renderDevice,
+		ShaderBinaryCache* binaryCache);
 
 	~ShaderLoader();
 
@@ -45,7 +60,22 @@ public:
 		ConstStringView shaderContent,
 		ConstStringView debugName);
 
-	static constexpr size_t MaxStageCount = 3;
+	// Processes the shader and issues compile and link commands without waiting for them
+	// to finish. This allows the driver to compile multiple programs in parallel.
+	bool StartLoadFromFile(
+		ShaderData& shaderOut,
+		ConstStringView shaderPath,
+		ConstStringView shaderContent,
+		ConstStringView debugName,
+		PendingShaderProgram& pendingOut);
+
+	// Waits for the program to be linked and finishes initializing the shader data
+	bool FinishLoad(
+		ShaderData& shaderInOut,
+		PendingShaderProgram& pending,
+		ConstStringView debugName);
+
+	static constexpr size_t MaxStageCount = PendingShaderProgram::MaxStageCount;
 
 private:
 	static const char* const LineBreakChars;
@@ -54,6 +84,7 @@ private:
 	Allocator* allocator;
 	Filesystem* filesystem;
 	kokko::render::Device* renderDevice;
+	ShaderBinaryCache* binaryCache;
 
 	HashMap<uint32_t, kokko::String> includeFileCache;
 	SortedArray<uint32_t> filesIncludedInStage;
@@ -76,7 +107,7 @@ private:
 		ConstStringView shaderPath,
 		ArrayView<const StageSource> stages,
 		ConstStringView versionStr,
-		ConstStringView debugName);
+		PendingShaderProgram& pendingOut);
 
 	bool ProcessStage(
 		ConstStringView versionStr,
@@ -11,6 +11,7 @@
 #include "Memory/Allocator.hpp"
 
 #include "Resources/AssetLoader.hpp"
+#include "Resources/ShaderBinaryCache.hpp"
 #include "Resources/ShaderLoader.hpp"
 
 namespace kokko
@@ -27,9 +28,13 @@ ShaderManager::ShaderManager(
 	filesystem(filesystem),
 	assetLoader(assetLoader),
 	renderDevice(renderDevice),
+	binaryCache(nullptr),
 	freeListFirst(0),
-	uidMap(allocator)
+	uidMap(allocator),
+	pendingShaders(allocator)
 {
+	binaryCache = allocator->MakeNew<ShaderBinaryCache>(allocator, filesystem, renderDevice);
+
 	data = InstanceData{};
 	data.count = 1; // Reserve index 0 as Null instance
 
@@ -38,6 +43,11 @@ ShaderManager::ShaderManager(
 
 ShaderManager::~ShaderManager()
 {
+	while (pendingShaders.GetCount() > 0)
+		FinishPendingShader(pendingShaders.GetBack().id);
+
+	allocator->MakeDelete(binaryCache);
+
 	for (unsigned int i = 1; i < data.allocated; ++i)
 		allocator->Deallocate(data.shader[i].buffer);
 
@@ -105,6 +115,7 @@ ShaderId ShaderManager::CreateShader()
 	data.shader[id.i].transparencyType = TransparencyType::Opaque;
 	data.shader[id.i].driverId = kokko::render::ShaderId();
 	data.shader[id.i].uniforms = kokko::UniformList();
+	data.shader[id.i].loadFailed = false;
 
 	++data.count;
 
@@ -115,6 +126,8 @@ void ShaderManager::RemoveShader(ShaderId id)
 {
 	assert(id != ShaderId::Null);
 
+	FinishPendingShader(id);
+
 	auto mapPair = uidMap.Lookup(data.shader[id.i].uid);
 	if (mapPair != nullptr)
 		uidMap.Remove(mapPair);
@@ -141,7 +154,7 @@ ShaderId ShaderManager::FindShaderByUid(const kokko::Uid& uid)
 
 	auto* pair = uidMap.Lookup(uid);
 	if (pair != nullptr)
-		return pair->second;
+		return data.shader[pair->second.i].loadFailed ? ShaderId::Null : pair->second;
 
 	if (data.count == data.allocated)
 		this->Reallocate(data.count + 1);
@@ -157,15 +170,21 @@ ShaderId ShaderManager::FindShaderByUid(const kokko::Uid& uid)
 		ShaderData& shader = data.shader[id.i];
 
 		kokko::ConstStringView fileString(reinterpret_cast<char*>(file.GetData()), file.GetCount());
-		kokko::ShaderLoader loader(allocator, filesystem, renderDevice);
+		kokko::ShaderLoader loader(allocator, filesystem, renderDevice, binaryCache);
 
-		if (loader.LoadFromFile(shader, virtualPath.GetRef(), fileString, virtualPath.GetRef()))
+		PendingShader pending;
+		pending.id = id;
+
+		// Link status is checked when the shader data is first requested
+		if (loader.StartLoadFromFile(shader, virtualPath.GetRef(), fileString, virtualPath.GetRef(), pending.program))
 		{
 			data.shader[id.i].uid = uid;
 
 			pair = uidMap.Insert(uid);
 			pair->second = id;
 
+			pendingShaders.PushBack(pending);
+
 			return id;
 		}
 		else
@@ -181,6 +200,46 @@ ShaderId ShaderManager::FindShaderByUid(const kokko::Uid& uid)
 	return ShaderId::Null;
 }
 
+ShaderId ShaderManager::WaitForShader(ShaderId id)
+{
+	if (id == ShaderId::Null || FinishPendingShader(id) == false)
+		return ShaderId::Null;
+
+	return id;
+}
+
+bool ShaderManager::FinishPendingShader(ShaderId id)
+{
+	for (size_t i = 0, count = pendingShaders.GetCount(); i < count; ++i)
+	{
+		if (pendingShaders[i].id != id)
+			continue;
+
+		KOKKO_PROFILE_FUNCTION();
+
+		PendingShaderProgram program = pendingShaders[i].program;
+
+		// Swap with the last item to remove
+		pendingShaders[i] = pendingShaders.GetBack();
+		pendingShaders.PopBack();
+
+		ShaderData& shader = data.shader[id.i];
+
+		kokko::ShaderLoader loader(allocator, filesystem, renderDevice, binaryCache);
+		if (loader.FinishLoad(shader, program, shader.path) == false)
+		{
+			KK_LOG_ERROR("Shader failed to load correctly: {}", String(allocator, shader.path).GetCStr());
+
+			// Keep the shader in the UID map, so that later lookups don't try to compile it again
+			shader.loadFailed = true;
+		}
+
+		break;
+	}
+
+	return data.shader[id.i].loadFailed == false;
+}
+
 ShaderId ShaderManager::FindShaderByPath(kokko::ConstStringView path)
 {
 	KOKKO_PROFILE_FUNCTION();
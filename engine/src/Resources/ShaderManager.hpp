@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <cstdint>
 
+#include "Core/Array.hpp"
 #include "Core/HashMap.hpp"
 #include "Core/StringView.hpp"
 #include "Core/Uid.hpp"
@@ -12,6 +13,7 @@
 #include "Rendering/TransparencyType.hpp"
 
 #include "Resources/ShaderId.hpp"
+#include "Resources/ShaderLoader.hpp"
 
 namespace kokko
 {
@@ -19,6 +21,7 @@ namespace kokko
 class Allocator;
 class AssetLoader;
 class Filesystem;
+class ShaderBinaryCache;
 
 namespace render
 {
@@ -38,6 +41,8 @@ struct ShaderData
 	kokko::render::ShaderId driverId;
 
 	kokko::UniformList uniforms;
+
+	bool loadFailed;
 };
 
 class ShaderManager
@@ -47,6 +52,7 @@ private:
 	kokko::Filesystem* filesystem;
 	kokko::AssetLoader* assetLoader;
 	kokko::render::Device* renderDevice;
+	ShaderBinaryCache* binaryCache;
 
 	struct InstanceData
 	{
@@ -62,8 +68,20 @@ private:
 	unsigned int freeListFirst;
 	HashMap<kokko::Uid, ShaderId> uidMap;
 
+	struct PendingShader
+	{
+		ShaderId id;
+		PendingShaderProgram program;
+	};
+
+	// Shaders whose link status hasn't been checked yet
+	Array<PendingShader> pendingShaders;
+
 	void Reallocate(size_t required);
 
+	// Returns false if the shader failed to compile or link
+	bool FinishPendingShader(ShaderId id);
+
 public:
 	ShaderManager(
 		Allocator* allocator,
@@ -75,12 +93,23 @@ public:
 	ShaderId CreateShader();
 	void RemoveShader(ShaderId id);
 
+	// Shader programs are compiled asynchronously, so issue all lookups before using any of the shaders.
+	// Returns ShaderId::Null if the shader couldn't be loaded or has already failed to compile.
 	ShaderId FindShaderByUid(const kokko::Uid& uid);
 	ShaderId FindShaderByPath(kokko::ConstStringView path);
 
-	const ShaderData& GetShaderData(ShaderId id) const
+	// Waits for compilation to finish if needed, returns ShaderId::Null if the shader failed to compile
+	ShaderId WaitForShader(ShaderId id);
+
+	// Waits for compilation to finish if needed.
+	// Shaders that failed to compile return the same data as ShaderId::Null.
+	const ShaderData& GetShaderData(ShaderId id)
 	{
-		return data.shader[id.i];
+		if (pendingShaders.GetCount() > 0)
+			FinishPendingShader(id);
+
+		const ShaderData& shader = data.shader[id.i];
+		return shader.loadFailed ? data.shader[ShaderId::Null.i] : shader;
 	}
 };
 
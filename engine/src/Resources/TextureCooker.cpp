@@ -0,0 +1,370 @@
+#include "Resources/TextureCooker.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include "doctest/doctest.h"
+#include "stb_image/stb_image.h"
+
+#include "Core/Core.hpp"
+
+#include "Resources/BlockCompression.hpp"
+
+namespace kokko
+{
+
+namespace
+{
+
+using EncodeBlockFn = void(*)(const uint8_t*, uint8_t*);
+
+struct CompressionInfo
+{
+	EncodeBlockFn encode;
+	size_t blockSize;
+	bool colorData; // sRGB conversion applies
+};
+
+bool GetCompressionInfo(TextureCompression compression, CompressionInfo& infoOut)
+{
+	switch (compression)
+	{
+	case TextureCompression::BC1:
+		infoOut = CompressionInfo{ BlockCompression::EncodeBC1, 8, true };
+		return true;
+	case TextureCompression::BC3:
+		infoOut = CompressionInfo{ BlockCompression::EncodeBC3, 16, true };
+		return true;
+	case TextureCompression::BC4:
+		infoOut = CompressionInfo{ BlockCompression::EncodeBC4, 8, false };
+		return true;
+	case TextureCompression::BC5:
+		infoOut = CompressionInfo{ BlockCompression::EncodeBC5, 16, false };
+		return true;
+	case TextureCompression::BC7:
+		infoOut = CompressionInfo{ BlockCompression::EncodeBC7, 16, true };
+		return true;
+	default:
+		return false;
+	}
+}
+
+float SrgbToLinear(float value)
+{
+	return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float LinearToSrgb(float value)
+{
+	return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+uint8_t FloatToByte(float value)
+{
+	float scaled = value * 255.0f + 0.5f;
+	return static_cast<uint8_t>(scaled < 0.0f ? 0.0f : (scaled > 255.0f ? 255.0f : scaled));
+}
+
+// Box filter down to half size. Odd edges are clamped.
+void DownsampleLevel(const float* source, uint32_t width, uint32_t height, float* destOut)
+{
+	uint32_t destWidth = width > 1 ? width / 2 : 1;
+	uint32_t destHeight = height > 1 ? height / 2 : 1;
+
+	for (uint32_t y = 0; y < destHeight; ++y)
+	{
+		uint32_t y0 = y * 2;
+		uint32_t y1 = y0 + 1 < height ? y0 + 1 : y0;
+
+		for (uint32_t x = 0; x < destWidth; ++x)
+		{
+			uint32_t x0 = x * 2;
+			uint32_t x1 = x0 + 1 < width ? x0 + 1 : x0;
+
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				float sum = source[(y0 * width + x0) * 4 + c] + source[(y0 * width + x1) * 4 + c] +
+					source[(y1 * width + x0) * 4 + c] + source[(y1 * width + x1) * 4 + c];
+				destOut[(y * destWidth + x) * 4 + c] = sum * 0.25f;
+			}
+		}
+	}
+}
+
+// Blocks on the right and bottom edges are padded by repeating the last row and column
+void CompressLevel(const uint8_t* pixels, uint32_t width, uint32_t height,
+	const CompressionInfo& info, uint8_t* blocksOut)
+{
+	uint8_t blockPixels[BlockCompression::BlockPixelCount * 4];
+
+	for (uint32_t blockY = 0; blockY < height; blockY += BlockCompression::BlockWidth)
+	{
+		for (uint32_t blockX = 0; blockX < width; blockX += BlockCompression::BlockWidth)
+		{
+			for (uint32_t y = 0; y < BlockCompression::BlockWidth; ++y)
+			{
+				uint32_t sourceY = blockY + y < height ? blockY + y : height - 1;
+
+				for (uint32_t x = 0; x < BlockCompression::BlockWidth; ++x)
+				{
+					uint32_t sourceX = blockX + x < width ? blockX + x : width - 1;
+					std::memcpy(&blockPixels[(y * BlockCompression::BlockWidth + x) * 4],
+						&pixels[(sourceY * width + sourceX) * 4], 4);
+				}
+			}
+
+			info.encode(blockPixels, blocksOut);
+			blocksOut += info.blockSize;
+		}
+	}
+}
+
+uint32_t GetCompressedLevelSize(uint32_t width, uint32_t height, size_t blockSize)
+{
+	uint32_t blocksX = (width + BlockCompression::BlockWidth - 1) / BlockCompression::BlockWidth;
+	uint32_t blocksY = (height + BlockCompression::BlockWidth - 1) / BlockCompression::BlockWidth;
+	return static_cast<uint32_t>(blocksX * blocksY * blockSize);
+}
+
+bool CookFromPixels(Allocator* allocator, const uint8_t* pixels, uint32_t width, uint32_t height,
+	const TextureAssetMetadata& metadata, Array<uint8_t>& cookedOut)
+{
+	CompressionInfo info;
+	if (GetCompressionInfo(metadata.compression, info) == false)
+	{
+		KK_LOG_ERROR("TextureCooker: invalid compression format");
+		return false;
+	}
+
+	bool srgb = info.colorData && metadata.preferLinear == false;
+
+	uint32_t mipCount = 1;
+	if (metadata.generateMipmaps)
+	{
+		uint32_t larger = width > height ? width : height;
+		while ((larger >>= 1) > 0)
+			mipCount += 1;
+	}
+
+	CookedTextureHeader header;
+	header.magic = CookedTextureHeader::Magic;
+	header.version = CookedTextureHeader::CurrentVersion;
+	header.compression = metadata.compression;
+	header.srgb = srgb ? 1 : 0;
+	header.width = width;
+	header.height = height;
+	header.mipCount = mipCount;
+
+	size_t dataOffset = sizeof(CookedTextureHeader) + sizeof(CookedTextureMip) * mipCount;
+	size_t totalSize = dataOffset;
+
+	for (uint32_t level = 0; level < mipCount; ++level)
+	{
+		uint32_t levelWidth = width >> level > 0 ? width >> level : 1;
+		uint32_t levelHeight = height >> level > 0 ? height >> level : 1;
+		totalSize += GetCompressedLevelSize(levelWidth, levelHeight, info.blockSize);
+	}
+
+	cookedOut.Resize(totalSize);
+	uint8_t* cookedBytes = cookedOut.GetData();
+	std::memcpy(cookedBytes, &header, sizeof(header));
+
+	size_t pixelCount = static_cast<size_t>(width) * height;
+
+	// Filtering is done in linear space for color data
+	Array<float> levelValues(allocator);
+	Array<float> nextLevelValues(allocator);
+	Array<uint8_t> levelPixels(allocator);
+	levelValues.Resize(pixelCount * 4);
+	levelPixels.Resize(pixelCount * 4);
+
+	for (size_t i = 0; i < pixelCount * 4; ++i)
+	{
+		float value = pixels[i] / 255.0f;
+		levelValues[i] = (srgb && (i % 4) != 3) ? SrgbToLinear(value) : value;
+	}
+
+	uint32_t levelWidth = width;
+	uint32_t levelHeight = height;
+	size_t levelOffset = dataOffset;
+
+	for (uint32_t level = 0; level < mipCount; ++level)
+	{
+		size_t levelValueCount = static_cast<size_t>(levelWidth) * levelHeight * 4;
+
+		if (level == 0)
+			std::memcpy(levelPixels.GetData(), pixels, levelValueCount);
+		else
+		{
+			for (size_t i = 0; i < levelValueCount; ++i)
+			{
+				float value = levelValues[i];
+				levelPixels[i] = FloatToByte((srgb && (i % 4) != 3) ? LinearToSrgb(value) : value);
+			}
+		}
+
+		CookedTextureMip mip;
+		mip.width = levelWidth;
+		mip.height = levelHeight;
+		mip.offset = static_cast<uint32_t>(levelOffset);
+		mip.size = GetCompressedLevelSize(levelWidth, levelHeight, info.blockSize);
+
+		std::memcpy(&cookedBytes[sizeof(CookedTextureHeader) + sizeof(CookedTextureMip) * level], &mip, sizeof(mip));
+
+		CompressLevel(levelPixels.GetData(), levelWidth, levelHeight, info, &cookedBytes[levelOffset]);
+
+		levelOffset += mip.size;
+
+		if (level + 1 < mipCount)
+		{
+			uint32_t nextWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+			uint32_t nextHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+
+			nextLevelValues.Resize(static_cast<size_t>(nextWidth) * nextHeight * 4);
+			DownsampleLevel(levelValues.GetData(), levelWidth, levelHeight, nextLevelValues.GetData());
+
+			levelValues = std::move(nextLevelValues);
+			nextLevelValues = Array<float>(allocator);
+
+			levelWidth = nextWidth;
+			levelHeight = nextHeight;
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
+namespace TextureCooker
+{
+
+bool CookTexture(Allocator* allocator, ArrayView<const uint8_t> sourceBytes,
+	const TextureAssetMetadata& metadata, Array<uint8_t>& cookedOut)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	const uint8_t* sourcePtr = sourceBytes.GetData();
+	int sourceLength = static_cast<int>(sourceBytes.GetCount());
+
+	if (stbi_is_hdr_from_memory(sourcePtr, sourceLength))
+	{
+		KK_LOG_ERROR("TextureCooker: HDR images can't be block-compressed");
+		return false;
+	}
+
+	stbi_set_flip_vertically_on_load(true);
+	int width, height, nrComponents;
+	uint8_t* pixels;
+
+	{
+		KOKKO_PROFILE_SCOPE("stbi_load_from_memory()");
+		pixels = stbi_load_from_memory(sourcePtr, sourceLength, &width, &height, &nrComponents, 4);
+	}
+
+	if (pixels == nullptr)
+	{
+		KK_LOG_ERROR("TextureCooker: couldn't load texture file with stb_image");
+		return false;
+	}
+
+	bool result = CookFromPixels(allocator, pixels, static_cast<uint32_t>(width),
+		static_cast<uint32_t>(height), metadata, cookedOut);
+
+	stbi_image_free(pixels);
+
+	return result;
+}
+
+bool ParseCookedTextureHeader(ArrayView<const uint8_t> bytes, CookedTextureHeader& headerOut)
+{
+	if (bytes.GetCount() < sizeof(CookedTextureHeader))
+		return false;
+
+	std::memcpy(&headerOut, bytes.GetData(), sizeof(CookedTextureHeader));
+
+	if (headerOut.magic != CookedTextureHeader::Magic ||
+		headerOut.version != CookedTextureHeader::CurrentVersion ||
+		headerOut.mipCount == 0)
+		return false;
+
+	size_t tableEnd = sizeof(CookedTextureHeader) + sizeof(CookedTextureMip) * headerOut.mipCount;
+	if (bytes.GetCount() < tableEnd)
+		return false;
+
+	for (uint32_t level = 0; level < headerOut.mipCount; ++level)
+	{
+		CookedTextureMip mip = GetCookedTextureMip(bytes, level);
+		if (mip.offset < tableEnd || static_cast<size_t>(mip.offset) + mip.size > bytes.GetCount())
+			return false;
+	}
+
+	return true;
+}
+
+CookedTextureMip GetCookedTextureMip(ArrayView<const uint8_t> bytes, uint32_t level)
+{
+	CookedTextureMip mip;
+	size_t offset = sizeof(CookedTextureHeader) + sizeof(CookedTextureMip) * level;
+	std::memcpy(&mip, bytes.GetData() + offset, sizeof(mip));
+	return mip;
+}
+
+bool IsCookedTexture(ArrayView<const uint8_t> bytes)
+{
+	uint32_t magic;
+	if (bytes.GetCount() < sizeof(magic))
+		return false;
+
+	std::memcpy(&magic, bytes.GetData(), sizeof(magic));
+	return magic == CookedTextureHeader::Magic;
+}
+
+} // namespace TextureCooker
+
+TEST_CASE("TextureCooker.MipChain")
+{
+	Allocator* allocator = Allocator::GetDefault();
+
+	const uint32_t width = 10;
+	const uint32_t height = 6;
+	uint8_t pixels[width * height * 4];
+	for (size_t i = 0; i < sizeof(pixels); ++i)
+		pixels[i] = static_cast<uint8_t>(i * 7);
+
+	TextureAssetMetadata metadata;
+	metadata.compression = TextureCompression::BC7;
+
+	Array<uint8_t> cooked(allocator);
+	REQUIRE(CookFromPixels(allocator, pixels, width, height, metadata, cooked));
+
+	ArrayView<const uint8_t> cookedView(cooked.GetData(), cooked.GetCount());
+	CHECK(TextureCooker::IsCookedTexture(cookedView));
+
+	CookedTextureHeader header;
+	REQUIRE(TextureCooker::ParseCookedTextureHeader(cookedView, header));
+	CHECK(header.width == width);
+	CHECK(header.height == height);
+	CHECK(header.srgb == 1);
+	CHECK(header.mipCount == 4);
+
+	const uint32_t expectedWidths[] = { 10, 5, 2, 1 };
+	const uint32_t expectedHeights[] = { 6, 3, 1, 1 };
+	const uint32_t expectedSizes[] = { 3 * 2 * 16, 2 * 1 * 16, 16, 16 };
+
+	for (uint32_t level = 0; level < header.mipCount; ++level)
+	{
+		CookedTextureMip mip = TextureCooker::GetCookedTextureMip(cookedView, level);
+		CHECK(mip.width == expectedWidths[level]);
+		CHECK(mip.height == expectedHeights[level]);
+		CHECK(mip.size == expectedSizes[level]);
+	}
+
+	CookedTextureMip lastMip = TextureCooker::GetCookedTextureMip(cookedView, header.mipCount - 1);
+	CHECK(lastMip.offset + lastMip.size == cooked.GetCount());
+
+	// Truncated data fails validation
+	CHECK(TextureCooker::ParseCookedTextureHeader(cookedView.GetSubView(0, cooked.GetCount() - 1), header) == false);
+}
+
+} // namespace kokko
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Core/Array.hpp"
+#include "Core/ArrayView.hpp"
+
+#include "Resources/AssetType.hpp"
+
+namespace kokko
+{
+
+class Allocator;
+
+// Cooked texture container layout:
+// CookedTextureHeader, CookedTextureMip[mipCount], block data for every mip level
+
+struct CookedTextureHeader
+{
+	static const uint32_t Magic = 0x5845544B; // "KTEX"
+	static const uint16_t CurrentVersion = 1;
+
+	uint32_t magic;
+	uint16_t version;
+	TextureCompression compression;
+	uint8_t srgb;
+	uint32_t width;
+	uint32_t height;
+	uint32_t mipCount;
+};
+
+struct CookedTextureMip
+{
+	uint32_t width;
+	uint32_t height;
+	uint32_t offset; // From the beginning of the container
+	uint32_t size;
+};
+
+namespace TextureCooker
+{
+
+// Decodes the source image file, generates the mip chain if requested in the
+// metadata and block-compresses every level. Metadata compression must not be None.
+bool CookTexture(Allocator* allocator, ArrayView<const uint8_t> sourceBytes,
+	const TextureAssetMetadata& metadata, Array<uint8_t>& cookedOut);
+
+// Validates the container header and mip table
+bool ParseCookedTextureHeader(ArrayView<const uint8_t> bytes, CookedTextureHeader& headerOut);
+
+// The container isn't necessarily aligned in memory, so mip entries are copied out
+CookedTextureMip GetCookedTextureMip(ArrayView<const uint8_t> bytes, uint32_t level);
+
+bool IsCookedTexture(ArrayView<const uint8_t> bytes);
+
+} // namespace TextureCooker
+
+} // namespace kokko
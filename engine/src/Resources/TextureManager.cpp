@@ -13,6 +13,7 @@
 
 #include "Resources/AssetLoader.hpp"
 #include "Resources/ImageData.hpp"
+#include "Resources/TextureCooker.hpp"
 
 #include "System/IncludeOpenGL.hpp"
 
@@ -84,12 +85,37 @@ Optional<RenderTextureSizedFormat> SizedFormatFromBaseFormatAndType(
 	return Optional<RenderTextureSizedFormat>();
 }
 
+Optional<RenderTextureSizedFormat> SizedFormatFromCompression(TextureCompression compression, bool srgb)
+{
+	switch (compression)
+	{
+	case TextureCompression::BC1:
+		return srgb ? RenderTextureSizedFormat::BC1_SRGB_A : RenderTextureSizedFormat::BC1_RGBA;
+	case TextureCompression::BC3:
+		return srgb ? RenderTextureSizedFormat::BC3_SRGB_A : RenderTextureSizedFormat::BC3_RGBA;
+	case TextureCompression::BC4:
+		return RenderTextureSizedFormat::BC4_R;
+	case TextureCompression::BC5:
+		return RenderTextureSizedFormat::BC5_RG;
+	case TextureCompression::BC7:
+		return srgb ? RenderTextureSizedFormat::BC7_SRGB_A : RenderTextureSizedFormat::BC7_RGBA;
+	default:
+		KK_LOG_ERROR("Couldn't find compressed texture format");
+		return Optional<RenderTextureSizedFormat>();
+	}
+}
+
 } // namespace
 
 TextureId TextureId::Null = TextureId{ 0 };
 
-TextureManager::TextureManager(Allocator* allocator, kokko::AssetLoader* assetLoader, kokko::render::Device* renderDevice) :
+TextureManager::TextureManager(
+	Allocator* allocator,
+	Allocator* frameAllocator,
+	kokko::AssetLoader* assetLoader,
+	kokko::render::Device* renderDevice) :
 	allocator(allocator),
+	frameAllocator(frameAllocator),
 	assetLoader(assetLoader),
 	renderDevice(renderDevice),
 	uidMap(allocator)
@@ -274,7 +300,7 @@ TextureId TextureManager::FindTextureByUid(const kokko::Uid& uid)
 		TextureId id = CreateTexture();
 
 		auto assetView = buffer.GetSubView(loadResult.assetStart, loadResult.assetStart + loadResult.assetSize);
-		if (LoadWithStbImage(id, assetView, metadata))
+		if (LoadTextureAsset(id, assetView, metadata))
 		{
 			data.texture[id.i].uid = uid;
 
@@ -309,6 +335,55 @@ TextureId TextureManager::FindTextureByPath(kokko::ConstStringView path)
 	return TextureId::Null;
 }
 
+bool TextureManager::LoadTextureAsset(TextureId id, ArrayView<const uint8_t> bytes, TextureAssetMetadata metadata)
+{
+	// Asset loaders may provide an offline-cooked container instead of the source image
+	if (TextureCooker::IsCookedTexture(bytes))
+		return LoadCookedTexture(id, bytes);
+	else
+		return LoadWithStbImage(id, bytes, metadata);
+}
+
+bool TextureManager::LoadCookedTexture(TextureId id, ArrayView<const uint8_t> bytes)
+{
+	KOKKO_PROFILE_FUNCTION();
+
+	CookedTextureHeader header;
+	if (TextureCooker::ParseCookedTextureHeader(bytes, header) == false)
+	{
+		KK_LOG_ERROR("Invalid cooked texture data");
+		return false;
+	}
+
+	Optional<RenderTextureSizedFormat> format = SizedFormatFromCompression(header.compression, header.srgb != 0);
+	if (format.HasValue() == false)
+		return false;
+
+	int width = static_cast<int>(header.width);
+	int height = static_cast<int>(header.height);
+	int mipLevels = static_cast<int>(header.mipCount);
+
+	kokko::render::TextureId textureObjectId;
+	renderDevice->CreateTextures(RenderTextureTarget::Texture2d, 1, &textureObjectId);
+	renderDevice->SetTextureStorage2D(textureObjectId, mipLevels, format.GetValue(), width, height);
+
+	for (int level = 0; level < mipLevels; ++level)
+	{
+		CookedTextureMip mip = TextureCooker::GetCookedTextureMip(bytes, static_cast<uint32_t>(level));
+
+		renderDevice->SetTextureSubImageCompressed2D(textureObjectId, level, 0, 0,
+			static_cast<int>(mip.width), static_cast<int>(mip.height), format.GetValue(),
+			static_cast<int>(mip.size), bytes.GetData() + mip.offset);
+	}
+
+	TextureData& textureData = data.texture[id.i];
+	textureData.textureSize = Vec2i(width, height);
+	textureData.textureObjectId = textureObjectId;
+	textureData.textureTarget = RenderTextureTarget::Texture2d;
+
+	return true;
+}
+
 bool TextureManager::LoadWithStbImage(TextureId id, ArrayView<const uint8_t> bytes, TextureAssetMetadata metadata)
 {
 	stbi_set_flip_vertically_on_load(true);
@@ -539,7 +614,7 @@ void TextureManager::AllocateTextureStorage(TextureId id, RenderTextureTarget ta
 
 void TextureManager::Update()
 {
-	Array<uint8_t> buffer(allocator);
+	Array<uint8_t> buffer(frameAllocator);
 
 	Uid uid;
 	while (assetLoader->GetNextUpdatedAssetUid(AssetType::Texture, uid))
@@ -565,9 +640,8 @@ void TextureManager::Update()
 				if (loadResult.metadataSize == sizeof(metadata))
 					memcpy(&metadata, buffer.GetData(), loadResult.metadataSize);
 
-				bool preferLinear = false;
 				auto assetView = buffer.GetSubView(loadResult.assetStart, loadResult.assetStart + loadResult.assetSize);
-				if (LoadWithStbImage(id, assetView, metadata) == false)
+				if (LoadTextureAsset(id, assetView, metadata) == false)
 				{
 					KK_LOG_ERROR("Texture failed to update");
 				}
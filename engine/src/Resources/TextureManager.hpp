@@ -39,6 +39,7 @@ class TextureManager
 {
 private:
 	Allocator* allocator;
+	Allocator* frameAllocator;
 	AssetLoader* assetLoader;
 	render::Device* renderDevice;
 
@@ -70,7 +71,7 @@ private:
 	void Reallocate(unsigned int required);
 
 public:
-	TextureManager(Allocator* allocator, AssetLoader* assetLoader, render::Device* renderDevice);
+	TextureManager(Allocator* allocator, Allocator* frameAllocator, AssetLoader* assetLoader, render::Device* renderDevice);
 	~TextureManager();
 
 	void Initialize();
@@ -96,6 +97,8 @@ public:
 	void Update();
 
 private:
+	bool LoadTextureAsset(TextureId id, ArrayView<const uint8_t> bytes, TextureAssetMetadata metadata);
+	bool LoadCookedTexture(TextureId id, ArrayView<const uint8_t> bytes);
 	bool LoadWithStbImage(TextureId id, ArrayView<const uint8_t> bytes, TextureAssetMetadata metadata);
 };
 
@@ -1,11 +1,14 @@
 #include <filesystem>
 #include <thread>
 
+#include "ryml.hpp"
+
 #include "webp/decode.h"
 #include "webp/encode.h"
 
 #include "Core/Array.hpp"
 #include "Core/Core.hpp"
+#include "Core/Hash.hpp"
 
 #include "Debug/Instrumentation.hpp"
 
@@ -21,6 +24,7 @@
 #include "Rendering/CommandEncoder.hpp"
 #include "Rendering/RenderDevice.hpp"
 #include "Rendering/Framebuffer.hpp"
+#include "Rendering/RenderDebugSettings.hpp"
 
 #include "Resources/AssetLibrary.hpp"
 
@@ -32,6 +36,72 @@
 
 #include "TestRunnerAssetLoader.hpp"
 
+namespace
+{
+
+struct TestSettings
+{
+	kokko::RenderDebugSettings renderDebug;
+	int frameCount = 1;
+};
+
+// Reads the optional settings.yml of a test, missing values keep their defaults
+bool ParseTestSettings(kokko::String& content, TestSettings& settingsOut)
+{
+	ryml::Tree tree = ryml::parse_in_place(ryml::substr(content.GetData(), content.GetLength()));
+	ryml::NodeRef root = tree.rootref();
+
+	auto resolutionNode = root.find_child("ssao_resolution");
+	if (resolutionNode.valid() && resolutionNode.has_val())
+	{
+		auto resolutionStr = resolutionNode.val();
+		uint32_t resolutionHash = kokko::HashString(resolutionStr.str, resolutionStr.len);
+
+		switch (resolutionHash)
+		{
+		case "full"_hash:
+			settingsOut.renderDebug.SetSsaoResolution(kokko::SsaoResolution::Full);
+			break;
+
+		case "half"_hash:
+			settingsOut.renderDebug.SetSsaoResolution(kokko::SsaoResolution::Half);
+			break;
+
+		case "quarter"_hash:
+			settingsOut.renderDebug.SetSsaoResolution(kokko::SsaoResolution::Quarter);
+			break;
+
+		default:
+			KK_LOG_ERROR("Unknown SSAO resolution in test settings");
+			return false;
+		}
+	}
+
+	auto temporalNode = root.find_child("ssao_temporal_accumulation");
+	if (temporalNode.valid() && temporalNode.has_val())
+	{
+		bool temporal = false;
+		temporalNode >> temporal;
+		settingsOut.renderDebug.SetFeatureEnabled(kokko::RenderDebugFeatureFlag::SsaoTemporalAccumulation, temporal);
+	}
+
+	auto frameCountNode = root.find_child("frame_count");
+	if (frameCountNode.valid() && frameCountNode.has_val())
+	{
+		frameCountNode >> settingsOut.frameCount;
+
+		if (settingsOut.frameCount < 1)
+		{
+			KK_LOG_ERROR("Test settings frame_count must be at least 1");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+} // namespace
+
 int main(int argc, char** argv)
 {
 	// Setup RootAllocator and logging
@@ -98,6 +168,7 @@ int main(int argc, char** argv)
 	namespace fs = std::filesystem;
 	const auto testsRoot = fs::absolute("render-test/tests");
 	const auto testFilename = fs::path("test.level");
+	const auto settingsFilename = fs::path("settings.yml");
 
 	std::error_code testItrError;
 	auto testItr = fs::recursive_directory_iterator(testsRoot, testItrError);
@@ -132,6 +203,7 @@ int main(int argc, char** argv)
 
 	kokko::Array<uint8_t> expectationFileArray(defaultAlloc);
 	kokko::String testLevelContent(defaultAlloc);
+	kokko::String testSettingsContent(defaultAlloc);
 
 	int failedTests = 0;
 	int erroredTests = 0;
@@ -164,6 +236,23 @@ int main(int argc, char** argv)
 		{
 			KOKKO_PROFILE_SCOPE(testNameStr.c_str());
 
+			TestSettings settings;
+
+			{
+				KOKKO_PROFILE_SCOPE("Load test settings");
+
+				const auto settingsPathStr = (testFolderPath / settingsFilename).u8string();
+
+				if (fs::exists(testFolderPath / settingsFilename) &&
+					(filesystem.ReadText(settingsPathStr.c_str(), testSettingsContent) == false ||
+					ParseTestSettings(testSettingsContent, settings) == false))
+				{
+					KK_LOG_ERROR("Test settings couldn't be loaded: {}", settingsPathStr.c_str());
+					erroredTests += 1;
+					continue;
+				}
+			}
+
 			kokko::World* world = engine.GetWorld();
 			world->ClearAllEntities();
 
@@ -183,10 +272,29 @@ int main(int argc, char** argv)
 			{
 				KOKKO_PROFILE_SCOPE("Run render test");
 
-				engine.StartFrame();
-				engine.Update();
-				engine.Render(kokko::Optional<kokko::CameraParameters>(), framebuffer);
-				engine.EndFrame();
+				kokko::RenderDebugSettings& renderDebug = engine.GetSettings()->renderDebug;
+
+				// Render one frame without temporal accumulation to discard history from previous tests
+				if (settings.renderDebug.IsFeatureEnabled(kokko::RenderDebugFeatureFlag::SsaoTemporalAccumulation))
+				{
+					renderDebug = settings.renderDebug;
+					renderDebug.SetFeatureEnabled(kokko::RenderDebugFeatureFlag::SsaoTemporalAccumulation, false);
+
+					engine.StartFrame();
+					engine.Update();
+					engine.Render(kokko::Optional<kokko::CameraParameters>(), framebuffer);
+					engine.EndFrame();
+				}
+
+				renderDebug = settings.renderDebug;
+
+				for (int frame = 0; frame < settings.frameCount; ++frame)
+				{
+					engine.StartFrame();
+					engine.Update();
+					engine.Render(kokko::Optional<kokko::CameraParameters>(), framebuffer);
+					engine.EndFrame();
+				}
 			}
 
 			{
@@ -255,6 +363,7 @@ int main(int argc, char** argv)
 				else
 				{
 					KK_LOG_ERROR("Reading test expectation failed: {}", expectationPathStr.c_str());
+					erroredTests += 1;
 				}
 			}
 
@@ -264,8 +373,21 @@ int main(int argc, char** argv)
 			{
 				KOKKO_PROFILE_SCOPE("Decode expectation from WebP");
 
-				uint8_t* output = expectationPixelArray.GetData();
-				expectationPixels = WebPDecodeRGBInto(expectWebpData, expectWebpSize, output, imageBytes, stride);
+				int expectWidth = 0;
+				int expectHeight = 0;
+
+				if (WebPGetInfo(expectWebpData, expectWebpSize, &expectWidth, &expectHeight) != 0 &&
+					expectWidth == width && expectHeight == height)
+				{
+					uint8_t* output = expectationPixelArray.GetData();
+					expectationPixels = WebPDecodeRGBInto(expectWebpData, expectWebpSize, output, imageBytes, stride);
+				}
+
+				if (expectationPixels == nullptr)
+				{
+					KK_LOG_ERROR("Decoding test expectation failed, or its size is not {}x{}", width, height);
+					erroredTests += 1;
+				}
 			}
 
 			if (expectationPixels != nullptr)